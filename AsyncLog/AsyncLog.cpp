@@ -0,0 +1,378 @@
+#include "AsyncLog.h"
+#include <ctime>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+
+// 线程私有环形缓冲区, 单生产者(日志线程)单消费者(后台写入线程), 无锁
+// 记录格式: [Header 16字节][日志内容, 按16字节对齐], Header 不会跨越缓冲区尾部
+class AsyncLog::ThreadBuffer
+{
+    struct Header
+    {
+        uint32_t len;
+        uint32_t severity;
+        int64_t timestamp;
+    };
+    static constexpr uint64_t HEADER_SIZE = sizeof(Header);
+
+public:
+    explicit ThreadBuffer(const size_t capacity)
+    {
+        m_capacity = 4096;
+        while (m_capacity < capacity)
+        {
+            m_capacity *= 2;
+        }
+        m_mask = m_capacity - 1;
+        m_data.reset(new char[m_capacity]);
+    }
+
+    // 生产者调用, 空间不足时返回 false
+    bool Push(const int severity, const time_t timestamp, const char *message, const size_t len) noexcept
+    {
+        const uint64_t total = HEADER_SIZE + Align(len);
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        const uint64_t tail = m_tail.load(std::memory_order_acquire);
+        if (total > m_capacity - (head - tail))
+        {
+            return false;
+        }
+
+        Header header{(uint32_t)len, (uint32_t)severity, (int64_t)timestamp};
+        memcpy(&m_data[head & m_mask], &header, HEADER_SIZE);
+        CopyIn(head + HEADER_SIZE, message, len);
+        m_head.store(head + total, std::memory_order_release);
+        return true;
+    }
+
+    // 消费者调用, 取出所有日志按级别追加到 vecBatch, vecTimestamp 记录各级别最新的日志时间
+    void PopAll(std::vector<std::string> &vecBatch, std::vector<time_t> &vecTimestamp)
+    {
+        const uint64_t head = m_head.load(std::memory_order_acquire);
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        while (tail != head)
+        {
+            Header header;
+            memcpy(&header, &m_data[tail & m_mask], HEADER_SIZE);
+            const size_t severity = std::min<size_t>(header.severity, vecBatch.size() - 1);
+            CopyOut(tail + HEADER_SIZE, header.len, vecBatch[severity]);
+            vecTimestamp[severity] = std::max<time_t>(vecTimestamp[severity], header.timestamp);
+            tail += HEADER_SIZE + Align(header.len);
+        }
+        m_tail.store(tail, std::memory_order_release);
+    }
+
+    // 所属线程退出
+    void Close() noexcept { m_closed.store(true, std::memory_order_release); }
+    bool IsClosed() const noexcept { return m_closed.load(std::memory_order_acquire); }
+
+private:
+    static uint64_t Align(const uint64_t len) noexcept { return (len + HEADER_SIZE - 1) & ~(HEADER_SIZE - 1); }
+
+    void CopyIn(const uint64_t offset, const char *src, const size_t len) noexcept
+    {
+        const size_t pos = offset & m_mask;
+        const size_t first = std::min<size_t>(len, m_capacity - pos);
+        memcpy(&m_data[pos], src, first);
+        memcpy(&m_data[0], src + first, len - first);
+    }
+
+    void CopyOut(const uint64_t offset, const size_t len, std::string &dst) const
+    {
+        const size_t pos = offset & m_mask;
+        const size_t first = std::min<size_t>(len, m_capacity - pos);
+        dst.append(&m_data[pos], first);
+        dst.append(&m_data[0], len - first);
+    }
+
+private:
+    uint64_t m_capacity;
+    uint64_t m_mask;
+    std::unique_ptr<char[]> m_data;
+    std::atomic<bool> m_closed = false;
+
+    alignas(64) std::atomic<uint64_t> m_head = 0; // 写入位置, 生产者修改
+    alignas(64) std::atomic<uint64_t> m_tail = 0; // 读取位置, 消费者修改
+};
+
+// 替换 glog 日志文件的 Logger
+// glog 调用 Write 时已持有全局日志锁, 这里只做拷贝, 文件写入由后台线程完成.
+// force_flush 为 true 时(日志级别 > FLAGS_logbuflevel)唤醒后台线程立即写入, 请求线程不等待文件IO;
+// 显式 Flush(如 google::FlushLogFiles) 与 FATAL 日志同步写入.
+class AsyncLog::AsyncLogger final : public google::base::Logger
+{
+public:
+    AsyncLogger(AsyncLog *owner, const int severity, google::base::Logger *origin)
+        : m_owner(owner), m_severity(severity), m_origin(origin) {}
+
+    virtual void Write(bool force_flush, time_t timestamp, const char *message, int message_len) override
+    {
+        // FATAL 日志文件只会收到 FATAL 日志, 之后进程会 abort, 同步写入
+        if (m_severity == google::GLOG_FATAL)
+        {
+            m_owner->WriteSync(m_severity, timestamp, message, message_len);
+            return;
+        }
+        if (message_len > 0)
+        {
+            m_owner->Append(m_severity, timestamp, message, message_len);
+        }
+        if (force_flush)
+        {
+            m_owner->Wakeup();
+        }
+    }
+
+    virtual void Flush() override
+    {
+        m_owner->Flush();
+    }
+
+    virtual google::uint32 LogSize() override
+    {
+        return m_origin->LogSize();
+    }
+
+private:
+    AsyncLog *m_owner;
+    const int m_severity;
+    google::base::Logger *m_origin;
+};
+
+namespace
+{
+    // 线程缓冲区持有者, 线程退出时通知后台线程回收
+    struct ThreadBufferHolder
+    {
+        std::shared_ptr<AsyncLog::ThreadBuffer> spBuffer = nullptr;
+        long generation = -1;
+
+        ~ThreadBufferHolder()
+        {
+            if (spBuffer != nullptr)
+            {
+                spBuffer->Close();
+            }
+        }
+    };
+    thread_local ThreadBufferHolder t_bufferHolder;
+}
+
+bool AsyncLog::Init(
+    const size_t thread_buffer_size,
+    const int flush_interval_ms,
+    const int report_interval_s)
+{
+    if (m_init)
+    {
+        // 重复初始化
+        return false;
+    }
+
+    m_vecOriginLogger.assign(google::NUM_SEVERITIES, nullptr);
+    for (int severity = 0; severity < google::NUM_SEVERITIES; severity++)
+    {
+        m_vecOriginLogger[severity] = google::base::GetLogger(severity);
+        if (m_vecOriginLogger[severity] == nullptr)
+        {
+            LOG(ERROR) << "AsyncLog::Init() GetLogger failed, severity = " << severity;
+            return false;
+        }
+    }
+
+    m_bufferSize = thread_buffer_size;
+    m_flushIntervalMs = std::max(flush_interval_ms, 1);
+    m_reportIntervalS = report_interval_s;
+    m_vecBatch.assign(google::NUM_SEVERITIES, std::string());
+    m_vecTimestamp.assign(google::NUM_SEVERITIES, 0);
+    m_generation++;
+
+    // 先启动写入线程, 再替换 Logger
+    m_init = true;
+    m_writerThread = std::thread(std::bind(&AsyncLog::WriterFunc, this));
+
+    for (int severity = 0; severity < google::NUM_SEVERITIES; severity++)
+    {
+        auto logger = new AsyncLogger(this, severity, m_vecOriginLogger[severity]);
+        m_vecAsyncLogger.emplace_back(logger);
+        google::base::SetLogger(severity, logger);
+    }
+
+    return true;
+}
+
+void AsyncLog::ShutDown()
+{
+    if (!m_init)
+    {
+        return;
+    }
+
+    // 恢复原 Logger, SetLogger 持有 glog 日志锁, 返回后不会再有 Append
+    for (int severity = 0; severity < google::NUM_SEVERITIES; severity++)
+    {
+        google::base::SetLogger(severity, m_vecOriginLogger[severity]);
+    }
+
+    {
+        std::lock_guard<std::mutex> lg(m_writerMutex);
+        m_init = false;
+    }
+    m_writerCond.notify_all();
+    if (m_writerThread.joinable())
+    {
+        m_writerThread.join();
+    }
+
+    Drain(true);
+
+    for (auto logger : m_vecAsyncLogger)
+    {
+        delete logger;
+    }
+    m_vecAsyncLogger.clear();
+
+    std::lock_guard<std::mutex> lg(m_bufferMutex);
+    m_vecBuffer.clear();
+}
+
+void AsyncLog::Flush()
+{
+    if (m_init)
+    {
+        Drain(true);
+    }
+}
+
+void AsyncLog::Wakeup()
+{
+    // 后台线程写入前才清除标记, 写入期间的强制落盘日志合并为一次唤醒
+    if (!m_wakeup.exchange(true))
+    {
+        {
+            std::lock_guard<std::mutex> lg(m_writerMutex);
+        }
+        m_writerCond.notify_one();
+    }
+}
+
+bool AsyncLog::Append(const int severity, const time_t timestamp, const char *message, const size_t len)
+{
+    ThreadBuffer *buffer = GetThreadBuffer();
+    if (buffer == nullptr || !buffer->Push(severity, timestamp, message, len))
+    {
+        m_dropped.add(1);
+        return false;
+    }
+    return true;
+}
+
+void AsyncLog::WriteSync(const int severity, const time_t timestamp, const char *message, const size_t len)
+{
+    Drain(false);
+
+    auto origin = m_vecOriginLogger[severity];
+    origin->Write(true, timestamp, message, len);
+    origin->Flush();
+}
+
+AsyncLog::ThreadBuffer *AsyncLog::GetThreadBuffer()
+{
+    auto &holder = t_bufferHolder;
+    const long generation = m_generation.load(std::memory_order_relaxed);
+    if (holder.generation != generation)
+    {
+        // 首次写日志, 或者 ShutDown 后重新 Init
+        auto spBuffer = std::make_shared<ThreadBuffer>(m_bufferSize);
+        {
+            std::lock_guard<std::mutex> lg(m_bufferMutex);
+            m_vecBuffer.emplace_back(spBuffer);
+        }
+        holder.spBuffer = spBuffer;
+        holder.generation = generation;
+    }
+    return holder.spBuffer.get();
+}
+
+void AsyncLog::Drain(const bool flush)
+{
+    std::lock_guard<std::mutex> drain_lg(m_drainMutex);
+
+    std::vector<std::shared_ptr<ThreadBuffer>> vecBuffer;
+    {
+        std::lock_guard<std::mutex> lg(m_bufferMutex);
+        vecBuffer = m_vecBuffer;
+    }
+
+    // 先判断是否关闭再取数据, 关闭后不会再写入, 取完即可回收
+    bool hasClosed = false;
+    for (auto &spBuffer : vecBuffer)
+    {
+        const bool closed = spBuffer->IsClosed();
+        spBuffer->PopAll(m_vecBatch, m_vecTimestamp);
+        hasClosed = hasClosed || closed;
+    }
+
+    for (size_t severity = 0; severity < m_vecBatch.size(); severity++)
+    {
+        auto &batch = m_vecBatch[severity];
+        if (!batch.empty())
+        {
+            // 合并写入使用批次内最新的日志时间, 原 Logger 按该时间判断是否切换文件
+            m_vecOriginLogger[severity]->Write(false, m_vecTimestamp[severity], batch.data(), batch.size());
+            m_vecOriginLogger[severity]->Flush();
+            batch.clear();
+            m_vecTimestamp[severity] = 0;
+        }
+        else if (flush)
+        {
+            m_vecOriginLogger[severity]->Flush();
+        }
+    }
+
+    if (hasClosed)
+    {
+        std::lock_guard<std::mutex> lg(m_bufferMutex);
+        m_vecBuffer.erase(
+            std::remove_if(m_vecBuffer.begin(), m_vecBuffer.end(),
+                           [](const std::shared_ptr<ThreadBuffer> &spBuffer)
+                           { return spBuffer->IsClosed(); }),
+            m_vecBuffer.end());
+    }
+}
+
+void AsyncLog::WriterFunc()
+{
+    long last_report_ms = Common::mono_ms();
+    int64_t last_dropped = 0;
+    int64_t last_suppressed = 0;
+    while (m_init)
+    {
+        {
+            std::unique_lock<std::mutex> ul(m_writerMutex);
+            m_writerCond.wait_for(ul, std::chrono::milliseconds(m_flushIntervalMs),
+                                  [this]()
+                                  { return !m_init || m_wakeup; });
+        }
+        m_wakeup = false;
+
+        Drain(false);
+
+        // 定时输出丢弃统计
+        if (m_reportIntervalS > 0 && Common::mono_ms() - last_report_ms >= m_reportIntervalS * 1000L)
+        {
+            last_report_ms = Common::mono_ms();
+            const int64_t dropped = GetDroppedCount();
+            const int64_t suppressed = GetSuppressedCount();
+            if (dropped != last_dropped || suppressed != last_suppressed)
+            {
+                LOG(WARNING) << "AsyncLog::WriterFunc() log dropped"
+                             << ", buffer full = " << dropped - last_dropped
+                             << ", rate limited = " << suppressed - last_suppressed;
+                last_dropped = dropped;
+                last_suppressed = suppressed;
+            }
+        }
+    }
+}
@@ -0,0 +1,167 @@
+#pragma once
+#include <ctime>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <ostream>
+#include <condition_variable>
+#include "glog/logging.h"
+#include "Common/Singleton.h"
+#include "Common/Clock.h"
+#include "Common/ShardedCounter.h"
+
+// 单调用点限流日志
+// 每个调用点每秒最多输出 max_per_second 条, 超出的直接丢弃(不格式化), 下一条输出的日志前附带丢弃条数.
+// 用于下游故障时会大量重复的错误日志.
+//
+// Example:
+// LOG_LIMIT(ERROR, 10) << "CallBackScoreFunc() Request Failed, ModelName = " << model_name;
+// 输出: [suppressed 1234 lines] CallBackScoreFunc() Request Failed, ModelName = ...
+//
+// 注意: 宏展开包含静态变量定义, 不能用于不带括号的 if/else 分支.
+#define LOG_LIMIT(severity, max_per_second)                                                \
+    static LogLimiter LOG_EVERY_N_VARNAME(log_limiter_, __LINE__)(max_per_second);         \
+    if (LOG_EVERY_N_VARNAME(log_limiter_, __LINE__).pass())                                \
+    LOG(severity) << LOG_EVERY_N_VARNAME(log_limiter_, __LINE__)
+
+class LogLimiter
+{
+public:
+    explicit LogLimiter(const int max_per_second) : m_max(max_per_second) {}
+    LogLimiter(const LogLimiter &) = delete;
+    LogLimiter &operator=(const LogLimiter &) = delete;
+
+    // 是否允许输出
+    bool pass() noexcept
+    {
+        const long second = Common::mono_ns() / 1000000000;
+        long window = m_window.load(std::memory_order_relaxed);
+        if (window != second && m_window.compare_exchange_strong(window, second, std::memory_order_relaxed))
+        {
+            m_count.store(0, std::memory_order_relaxed);
+        }
+
+        if (m_count.fetch_add(1, std::memory_order_relaxed) < m_max)
+        {
+            return true;
+        }
+        m_suppressed.fetch_add(1, std::memory_order_relaxed);
+        TotalSuppressed().add(1);
+        return false;
+    }
+
+    // 所有调用点累计丢弃的日志条数
+    static Common::ShardedCounter &TotalSuppressed()
+    {
+        static Common::ShardedCounter counter;
+        return counter;
+    }
+
+    // 输出并清零上次输出后丢弃的条数
+    friend std::ostream &operator<<(std::ostream &os, LogLimiter &limiter)
+    {
+        const long suppressed = limiter.m_suppressed.exchange(0, std::memory_order_relaxed);
+        if (suppressed > 0)
+        {
+            os << "[suppressed " << suppressed << " lines] ";
+        }
+        return os;
+    }
+
+private:
+    const int m_max;
+    std::atomic<long> m_window = 0;     // 当前秒
+    std::atomic<int> m_count = 0;       // 当前秒已输出条数
+    std::atomic<long> m_suppressed = 0; // 上次输出后丢弃条数
+};
+
+// 异步日志
+// 替换 glog 各级别日志文件的 Logger, 请求线程只把格式化好的日志行拷贝到线程私有的无锁环形缓冲区,
+// 后台线程定时汇总所有缓冲区, 按级别合并成一次 Write 写入原 Logger 并 Flush, 文件IO不再阻塞请求线程.
+// 缓冲区满时直接丢弃并计数, 不阻塞请求线程. FATAL 日志同步写入, 保证进程退出前落盘.
+//
+// 注意:
+// 1. 需要在 google::InitGoogleLogging 及日志目录设置完成后调用 Init.
+// 2. 不同线程的日志按批次写入, 文件内只保证同一线程内有序.
+// 3. glog 对 >= FLAGS_stderrthreshold 的日志仍会同步写 stderr, 不需要时可调高该阈值.
+// 4. 级别 > FLAGS_logbuflevel 的日志(默认 WARNING/ERROR)唤醒后台线程立即写入, 不再等待写入间隔,
+//    请求线程不做文件IO; 显式 Flush 与 FATAL 日志同步写入.
+// 5. glog 在调用 Logger::Write 前已持有全局日志锁, 请求线程之间仍按该锁串行, 这里去掉的只是锁内的文件IO.
+//
+// 调用顺序:
+// 1. Init
+// 2. ShutDown
+class AsyncLog : public Singleton<AsyncLog>
+{
+public:
+    AsyncLog(token) {}
+    virtual ~AsyncLog() { ShutDown(); }
+    AsyncLog(AsyncLog &) = delete;
+    AsyncLog &operator=(const AsyncLog &) = delete;
+
+    // [in] thread_buffer_size: 每个线程的缓冲区大小, 向上取整为2的幂
+    // [in] flush_interval_ms: 后台线程写入间隔
+    // [in] report_interval_s: 丢弃统计输出间隔, 0 表示不输出
+    bool Init(
+        const size_t thread_buffer_size = 1 << 20,
+        const int flush_interval_ms = 100,
+        const int report_interval_s = 60);
+
+    // 写入所有缓冲数据并恢复 glog 原 Logger
+    void ShutDown();
+
+    // 立即写入所有缓冲数据并 Flush
+    void Flush();
+
+    // 缓冲区满丢弃的日志条数
+    int64_t GetDroppedCount() const { return m_dropped.sum(); }
+
+    // 限流丢弃的日志条数
+    int64_t GetSuppressedCount() const { return LogLimiter::TotalSuppressed().sum(); }
+
+public:
+    class ThreadBuffer;
+    class AsyncLogger;
+
+    // 追加一条日志到当前线程缓冲区, 缓冲区满时返回 false
+    bool Append(const int severity, const time_t timestamp, const char *message, const size_t len);
+
+    // 唤醒后台线程立即写入所有缓冲数据, 不等待写入完成
+    void Wakeup();
+
+    // 同步写入, 先写入所有缓冲数据保证顺序
+    void WriteSync(const int severity, const time_t timestamp, const char *message, const size_t len);
+
+protected:
+    ThreadBuffer *GetThreadBuffer();
+    void Drain(const bool flush);
+    void WriterFunc();
+
+private:
+    std::atomic<bool> m_init = false;
+    size_t m_bufferSize = 1 << 20;
+    int m_flushIntervalMs = 100;
+    int m_reportIntervalS = 60;
+    std::atomic<long> m_generation = 0; // 每次 Init 递增, 线程缓冲区按代注册
+
+    // 原 Logger 与替换后的 Logger
+    std::vector<google::base::Logger *> m_vecOriginLogger;
+    std::vector<AsyncLogger *> m_vecAsyncLogger;
+
+    // 线程缓冲区
+    std::mutex m_bufferMutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> m_vecBuffer;
+
+    // 后台写入
+    std::mutex m_drainMutex;
+    std::vector<std::string> m_vecBatch;  // 按级别合并的待写入数据
+    std::vector<time_t> m_vecTimestamp;   // 各级别待写入数据中最新的日志时间
+    std::mutex m_writerMutex;
+    std::condition_variable m_writerCond;
+    std::atomic<bool> m_wakeup = false; // 有强制落盘的日志, 后台线程立即写入
+    std::thread m_writerThread;
+
+    Common::ShardedCounter m_dropped;
+};
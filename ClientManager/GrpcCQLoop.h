@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <thread>
+#include "grpcpp/grpcpp.h"
+
+// Grpc CompletionQueue 轮询线程, C++17 即可使用
+// GrpcCQLoop 持有 CompletionQueue 及轮询线程, 异步调用完成后在轮询线程上调用标签的 Proceed.
+// 调用方不再需要每次请求新建 CQ, 也不需要阻塞线程在 Next() 上; 协程接口见 GrpcCoroutine.h.
+
+// CQ 事件标签, 轮询线程取出后调用 Proceed
+class GrpcCQTag
+{
+public:
+    virtual ~GrpcCQTag() {}
+    virtual void Proceed(bool ok) = 0;
+};
+
+class GrpcCQLoop
+{
+public:
+    GrpcCQLoop() {}
+    ~GrpcCQLoop() { ShutDown(); }
+    GrpcCQLoop(const GrpcCQLoop &) = delete;
+    GrpcCQLoop &operator=(const GrpcCQLoop &) = delete;
+
+    // [in] thread_count: CQ轮询线程数, 1个线程即可支撑上千并发请求
+    bool Init(const int thread_count = 1)
+    {
+        if (!m_vecThread.empty() || thread_count <= 0)
+        {
+            return false;
+        }
+        m_spCQ = std::make_unique<grpc::CompletionQueue>();
+        for (int idx = 0; idx < thread_count; idx++)
+        {
+            m_vecThread.emplace_back(&GrpcCQLoop::ThreadFunc, this);
+        }
+        return true;
+    }
+
+    // 等待所有未完成的请求结束后退出
+    void ShutDown()
+    {
+        if (m_spCQ == nullptr)
+        {
+            return;
+        }
+        m_spCQ->Shutdown();
+        for (auto &thread : m_vecThread)
+        {
+            if (thread.joinable())
+            {
+                thread.join();
+            }
+        }
+        m_vecThread.clear();
+        m_spCQ = nullptr;
+    }
+
+    grpc::CompletionQueue *GetCQ() const noexcept { return m_spCQ.get(); }
+
+private:
+    void ThreadFunc()
+    {
+        void *got_tag = nullptr;
+        bool ok = false;
+        while (m_spCQ->Next(&got_tag, &ok))
+        {
+            static_cast<GrpcCQTag *>(got_tag)->Proceed(ok);
+        }
+    }
+
+private:
+    std::unique_ptr<grpc::CompletionQueue> m_spCQ = nullptr;
+    std::vector<std::thread> m_vecThread;
+};
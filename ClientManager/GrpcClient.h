@@ -2,6 +2,7 @@
 #include <string>
 #include <unordered_map>
 #include <shared_mutex>
+#include "Common/Lock.h"
 #include "grpcpp/grpcpp.h"
 #include "Protobuf/proxy/Common.grpc.pb.h"
 #include "MurmurHash3/MurmurHash3.h"
@@ -88,6 +89,17 @@ public:
         return false;
     }
 
+    // 按负载均衡元素选择发送器, 供异步/协程接口使用
+    T *PickClient(const std::string &loadBalanceElement)
+    {
+        return GetRandClient(loadBalanceElement);
+    }
+
+    T *PickClientByAddr(const std::string &addr)
+    {
+        return GetClientByAddr(addr);
+    }
+
 private:
     bool AddClient(const std::string &addr, const int service_weight, const int connect_mode)
     {
@@ -106,7 +118,7 @@ private:
         client->Init(addr, channel);
 
         // 写锁, 出作用域自动释放
-        std::unique_lock<std::shared_mutex> ul(client_list_rwmutex_);
+        std::unique_lock<Common::distributed_shared_mutex> ul(client_list_rwmutex_);
         client_list_[addr] = client;
 
         return true;
@@ -115,7 +127,7 @@ private:
     T *GetClientByAddr(const std::string &addr)
     {
         // 读锁, 出作用域自动释放
-        std::shared_lock<std::shared_mutex> sl(client_list_rwmutex_);
+        std::shared_lock<Common::distributed_shared_mutex> sl(client_list_rwmutex_);
 
         auto iter = client_list_.find(addr);
         if (iter != client_list_.end())
@@ -129,7 +141,7 @@ private:
     T *GetRandClient(const std::string &loadBalanceElement)
     {
         // 读锁, 出作用域自动释放
-        std::shared_lock<std::shared_mutex> sl(client_list_rwmutex_);
+        std::shared_lock<Common::distributed_shared_mutex> sl(client_list_rwmutex_);
 
         if (client_list_.empty())
         {
@@ -180,7 +192,7 @@ private:
     void GetOnlineClient(std::vector<T *> onlineList)
     {
         // 读锁, 出作用域自动释放
-        std::shared_lock<std::shared_mutex> sl(client_list_rwmutex_);
+        std::shared_lock<Common::distributed_shared_mutex> sl(client_list_rwmutex_);
 
         if (!client_list_.empty())
         {
@@ -198,7 +210,7 @@ private:
     bool updateSwitch(const std::string &addr, const int service_weight, const int connect_mode, bool status)
     {
         // 写锁, 出作用域自动释放
-        std::unique_lock<std::shared_mutex> ul(client_list_rwmutex_);
+        std::unique_lock<Common::distributed_shared_mutex> ul(client_list_rwmutex_);
 
         auto iter = client_list_.find(addr);
         if (iter != client_list_.end())
@@ -217,7 +229,7 @@ private:
 private:
     // 写时读取可能会有Rehash问题导致迭代器失效,
     // 读写锁只保证map读取&写入时安全
-    std::shared_mutex client_list_rwmutex_;
+    Common::distributed_shared_mutex client_list_rwmutex_;
 
     // 客户端列表
     std::unordered_map<std::string, std::shared_ptr<T>> client_list_;
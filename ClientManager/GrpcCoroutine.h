@@ -0,0 +1,154 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include "grpcpp/grpcpp.h"
+#include "Common/Coroutine.h"
+#include "ClientManager/GrpcCQLoop.h"
+#include "ClientManager/GrpcSender.h"
+#include "ClientManager/GrpcClient.h"
+
+// Grpc 协程接口, 需要 C++20
+// GrpcCoLoop 持有 CompletionQueue 及轮询线程, 异步调用完成后恢复等待的协程.
+// 调用方不再需要每次请求新建 CQ, 也不需要阻塞线程在 Next() 上.
+
+// CQ 轮询线程见 GrpcCQLoop.h, 协程接口沿用原名称
+using GrpcCoTag = GrpcCQTag;
+using GrpcCoLoop = GrpcCQLoop;
+
+template <typename Response>
+struct GrpcCoReply
+{
+    grpc::Status status;
+    Response response;
+};
+
+// 一元RPC等待器
+// PrepareFunc: (grpc::ClientContext *, grpc::CompletionQueue *) -> std::unique_ptr<grpc::ClientAsyncResponseReader<Response>>
+template <typename Response, typename PrepareFunc>
+class GrpcUnaryAwaiter final : public GrpcCoTag
+{
+public:
+    GrpcUnaryAwaiter(GrpcCoLoop &loop, const long timeout_ms, PrepareFunc prepare)
+        : m_loop(loop), m_timeout_ms(timeout_ms), m_prepare(std::move(prepare)) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> h)
+    {
+        m_handle = h;
+        m_scheduler = Common::CoScheduler::Current();
+
+        if (m_timeout_ms > 0)
+        {
+            gpr_timespec timespec;
+            timespec.tv_sec = m_timeout_ms / 1000;
+            timespec.tv_nsec = (m_timeout_ms % 1000) * 1000 * 1000;
+            timespec.clock_type = GPR_TIMESPAN;
+            m_context.set_deadline(timespec);
+        }
+
+        m_reader = m_prepare(&m_context, m_loop.GetCQ());
+        m_reader->StartCall();
+        m_reader->Finish(&m_reply.response, &m_reply.status, static_cast<GrpcCoTag *>(this));
+    }
+
+    GrpcCoReply<Response> await_resume() { return std::move(m_reply); }
+
+    void Proceed(bool ok) override
+    {
+        if (!ok && m_reply.status.ok())
+        {
+            m_reply.status = grpc::Status(grpc::StatusCode::CANCELLED, "completion queue shutdown");
+        }
+        Common::CoResume(m_scheduler, m_handle);
+    }
+
+private:
+    GrpcCoLoop &m_loop;
+    const long m_timeout_ms;
+    PrepareFunc m_prepare;
+
+    grpc::ClientContext m_context;
+    std::unique_ptr<grpc::ClientAsyncResponseReader<Response>> m_reader;
+    GrpcCoReply<Response> m_reply;
+    std::coroutine_handle<> m_handle = nullptr;
+    Common::CoScheduler *m_scheduler = nullptr;
+};
+
+template <typename Response, typename PrepareFunc>
+inline GrpcUnaryAwaiter<Response, PrepareFunc> CoGrpcCall(
+    GrpcCoLoop &loop, const long timeout_ms, PrepareFunc prepare)
+{
+    return GrpcUnaryAwaiter<Response, PrepareFunc>(loop, timeout_ms, std::move(prepare));
+}
+
+// GrpcSender 协程调用, 错误码与 GrpcSender::CallService 保持一致
+struct GrpcCoSendReply
+{
+    bool succ = false;
+    int result = GrpcProtos::ResultType::ERR_Unknown;
+    std::string response;
+    std::string addr;
+};
+
+inline Common::Task<GrpcCoSendReply> CoCallService(
+    GrpcCoLoop &loop,
+    GrpcSender *sender,
+    const int cmd,
+    std::string request,
+    const long timeout_ms)
+{
+    GrpcCoSendReply reply;
+    if (sender == nullptr)
+    {
+        reply.result = GrpcProtos::ResultType::ERR_NO_Server;
+        reply.response = "No online service";
+        co_return reply;
+    }
+
+    reply.addr = sender->addr_;
+    if (!sender->grpc_switch_)
+    {
+        reply.result = GrpcProtos::ResultType::ERR_Grpc_Closed;
+        reply.response = "grpc switch closed";
+        co_return reply;
+    }
+
+    GrpcProtos::UnifiedRequest unifiedRequest;
+    unifiedRequest.set_cmd(cmd);
+    unifiedRequest.set_request(std::move(request));
+
+    auto prepare = [sender, &unifiedRequest](grpc::ClientContext *context, grpc::CompletionQueue *cq)
+    {
+        return sender->PrepareAsyncCallService(context, unifiedRequest, cq);
+    };
+    auto rpc = co_await CoGrpcCall<GrpcProtos::UnifiedResponse>(loop, timeout_ms, prepare);
+    if (!rpc.status.ok())
+    {
+        reply.result = (rpc.status.error_code() == grpc::StatusCode::DEADLINE_EXCEEDED)
+                           ? GrpcProtos::ResultType::ERR_Service_Timeout
+                           : GrpcProtos::ResultType::ERR_Call_Service;
+        reply.response = rpc.status.error_message();
+        co_return reply;
+    }
+
+    reply.succ = true;
+    reply.result = rpc.response.result();
+    reply.response = std::move(*rpc.response.mutable_response());
+    co_return reply;
+}
+
+// GrpcClient 协程发送, 按负载均衡元素选择客户端
+template <typename T>
+inline Common::Task<GrpcCoSendReply> CoSend(
+    GrpcCoLoop &loop,
+    GrpcClient<T> &client,
+    const int cmd,
+    const std::string &loadBalanceElement,
+    std::string request,
+    const long timeout_ms)
+{
+    return CoCallService(loop, client.PickClient(loadBalanceElement), cmd, std::move(request), timeout_ms);
+}
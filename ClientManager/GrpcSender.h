@@ -76,6 +76,15 @@ public:
         return true;
     }
 
+    // 准备异步调用, 由调用方 StartCall 并在 cq 上等待结果
+    std::unique_ptr<grpc::ClientAsyncResponseReader<GrpcProtos::UnifiedResponse>> PrepareAsyncCallService(
+        grpc::ClientContext *context,
+        const GrpcProtos::UnifiedRequest &request,
+        grpc::CompletionQueue *cq)
+    {
+        return stub_->PrepareAsyncCallService(context, request, cq);
+    }
+
 public:
     std::string addr_;   // 发送器地址
     bool grpc_switch_;   // grpc开关
@@ -0,0 +1,160 @@
+#pragma once
+#include <cassert>
+#include <cmath>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include "Common/Lock.h"
+#include "Common/Clock.h"
+
+// 自适应并发限制器 (Vegas 算法)
+// 不设固定QPS, 根据请求耗时和在途请求数动态调整并发上限:
+// 1. 记录无排队时的最小耗时 rtt_noload
+// 2. 每个统计窗口计算平均耗时 rtt, 估算排队长度 queue = limit * (1 - rtt_noload / rtt)
+// 3. 排队少则增大上限, 排队多或请求超时则减小上限
+// 超过上限的请求在 try_acquire 直接拒绝, 避免排队把所有请求都拖到超时.
+//
+// AdaptiveLimiter limiter(200);
+// if (!limiter.try_acquire()) { return ERR_Rate_Limit; }
+// ... 处理请求 ...
+// limiter.release(cost_ns, !timeout);
+class AdaptiveLimiter
+{
+    static constexpr long NS_PER_MS = 1000000;
+    static constexpr int MIN_WINDOW_SAMPLES = 10; // 窗口最少样本数
+    static constexpr int PROBE_WINDOWS = 600;     // 每隔多少个窗口重新探测 rtt_noload
+
+public:
+    // [in] max_limit: 并发上限的最大值
+    // [in] min_limit: 并发上限的最小值
+    // [in] init_limit: 初始并发上限
+    // [in] window_ms: 统计窗口时长
+    AdaptiveLimiter(int max_limit, int min_limit = 1, int init_limit = 20, long window_ms = 100)
+        : m_MaxLimit(max_limit),
+          m_MinLimit(min_limit),
+          m_WindowTime(window_ms * NS_PER_MS),
+          m_EstimatedLimit(std::clamp(init_limit, min_limit, max_limit)),
+          m_Limit(std::clamp(init_limit, min_limit, max_limit))
+    {
+        assert(min_limit > 0);
+        assert(max_limit >= min_limit);
+        m_WindowStart = Common::mono_ns();
+    }
+
+    AdaptiveLimiter(const AdaptiveLimiter &) = delete;
+    AdaptiveLimiter(const AdaptiveLimiter &&) = delete;
+    AdaptiveLimiter &operator=(const AdaptiveLimiter &) = delete;
+
+    // 尝试进入, 返回false说明超过并发上限, 应当直接拒绝
+    bool try_acquire()
+    {
+        auto inflight = m_InFlight.fetch_add(1, std::memory_order_relaxed);
+        if (inflight >= m_Limit.load(std::memory_order_relaxed))
+        {
+            m_InFlight.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    // 请求结束, 必须与成功的 try_acquire 成对调用
+    // [in] rtt_ns: 请求耗时, 单位纳秒
+    // [in] succ: false 表示请求超时, 作为过载信号
+    void release(const long rtt_ns, const bool succ = true)
+    {
+        auto inflight = m_InFlight.fetch_sub(1, std::memory_order_relaxed);
+
+        std::lock_guard<Common::spin_lock> lg(m_SpinLock);
+        m_WindowRttSum += rtt_ns;
+        m_WindowRttMin = m_WindowCount == 0 ? rtt_ns : std::min(m_WindowRttMin, rtt_ns);
+        m_WindowCount++;
+        m_WindowMaxInFlight = std::max(m_WindowMaxInFlight, inflight);
+        m_WindowDrop = m_WindowDrop || !succ;
+
+        auto cur = Common::mono_ns();
+        if (cur - m_WindowStart < m_WindowTime || m_WindowCount < MIN_WINDOW_SAMPLES)
+        {
+            return;
+        }
+
+        updateLimit(m_WindowRttSum / m_WindowCount, m_WindowRttMin, m_WindowMaxInFlight, m_WindowDrop);
+
+        m_WindowStart = cur;
+        m_WindowRttSum = 0;
+        m_WindowCount = 0;
+        m_WindowMaxInFlight = 0;
+        m_WindowDrop = false;
+    }
+
+    int limit() const { return m_Limit.load(std::memory_order_relaxed); }
+    int inflight() const { return m_InFlight.load(std::memory_order_relaxed); }
+
+private:
+    // [in] rtt: 窗口平均耗时
+    // [in] min_rtt: 窗口最小耗时, 用于更新 rtt_noload
+    void updateLimit(const long rtt, const long min_rtt, const int max_inflight, const bool drop)
+    {
+        // 定期重新探测, 避免下游变快/变慢后基准失真
+        if (++m_Windows >= PROBE_WINDOWS)
+        {
+            m_Windows = 0;
+            m_RttNoLoad = 0;
+        }
+
+        if (m_RttNoLoad == 0 || min_rtt < m_RttNoLoad)
+        {
+            m_RttNoLoad = std::max(min_rtt, 1L);
+        }
+
+        const double limit = m_EstimatedLimit;
+        const double log_limit = std::max(1.0, std::log10(limit));
+        double newLimit = limit;
+        if (drop)
+        {
+            newLimit = limit - log_limit;
+        }
+        else if (max_inflight * 2 < limit || rtt <= 0)
+        {
+            // 流量不足以打满上限, 耗时不能反映容量, 不调整
+            return;
+        }
+        else
+        {
+            const double queue = std::ceil(limit * (1.0 - (double)m_RttNoLoad / rtt));
+            if (queue <= log_limit)
+            {
+                newLimit = limit + 6 * log_limit;
+            }
+            else if (queue < 3 * log_limit)
+            {
+                newLimit = limit + log_limit;
+            }
+            else if (queue > 6 * log_limit)
+            {
+                newLimit = limit - log_limit;
+            }
+        }
+
+        m_EstimatedLimit = std::clamp(newLimit, (double)m_MinLimit, (double)m_MaxLimit);
+        m_Limit.store((int)m_EstimatedLimit, std::memory_order_relaxed);
+    }
+
+private:
+    const int m_MaxLimit;     // 并发上限最大值
+    const int m_MinLimit;     // 并发上限最小值
+    const long m_WindowTime;  // 统计窗口时长, 单位纳秒
+    double m_EstimatedLimit;  // 估算的并发上限
+    long m_RttNoLoad = 0;     // 无排队耗时
+    int m_Windows = 0;        // 已统计窗口数
+
+    long m_WindowStart;           // 窗口开始时间
+    long m_WindowRttSum = 0;      // 窗口耗时和
+    long m_WindowRttMin = 0;      // 窗口最小耗时
+    int m_WindowCount = 0;        // 窗口样本数
+    int m_WindowMaxInFlight = 0;  // 窗口最大在途请求数
+    bool m_WindowDrop = false;    // 窗口内是否有超时
+    Common::spin_lock m_SpinLock; // 自旋锁
+
+    alignas(64) std::atomic<int> m_Limit;        // 当前并发上限
+    alignas(64) std::atomic<int> m_InFlight = 0; // 在途请求数
+};
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+
+// 请求级内存池
+// 一次请求内创建的大量小对象(RankItem 的 map/vector 节点等)从同一块单调内存中分配,
+// 释放时什么也不做, 请求结束时随内存池整体释放.
+//
+// 使用方式: 请求入口创建 MonotonicArena 并用 ArenaScope 设为当前线程的内存池,
+// 作用域内默认构造的 RankItem 等容器会自动使用该内存池.
+// 注意: 这些对象不能存活到 MonotonicArena 析构之后, 不能放入跨请求的缓存.
+//
+// Example:
+// Common::MonotonicArena arena;
+// Common::ArenaScope scope(&arena);
+// std::vector<RankItem> vec_rank_item; // RankItem 内部容器从 arena 分配
+namespace Common
+{
+    class MonotonicArena
+    {
+    public:
+        // [in] initial_size: 首块内存大小, 不足时按倍数向上游申请
+        // [in] upstream: 上游内存资源
+        explicit MonotonicArena(
+            const size_t initial_size = 64 * 1024,
+            std::pmr::memory_resource *upstream = std::pmr::new_delete_resource())
+            : m_resource(initial_size, upstream) {}
+        virtual ~MonotonicArena() {}
+
+        MonotonicArena(const MonotonicArena &) = delete;
+        MonotonicArena &operator=(const MonotonicArena &) = delete;
+
+        std::pmr::memory_resource *resource() noexcept { return &m_resource; }
+
+    private:
+        std::pmr::monotonic_buffer_resource m_resource;
+    };
+
+    namespace detail
+    {
+        inline thread_local MonotonicArena *t_current_arena = nullptr;
+    }
+
+    // 当前线程的请求内存池, 没有时返回 nullptr
+    inline MonotonicArena *CurrentArena() noexcept
+    {
+        return detail::t_current_arena;
+    }
+
+    // 当前线程的内存资源, 没有请求内存池时使用 pmr 默认内存资源(未设置时为 new/delete)
+    inline std::pmr::memory_resource *CurrentResource() noexcept
+    {
+        auto arena = detail::t_current_arena;
+        return arena != nullptr ? arena->resource() : std::pmr::get_default_resource();
+    }
+
+    // 设置当前线程的请求内存池, 出作用域恢复
+    class ArenaScope
+    {
+    public:
+        explicit ArenaScope(MonotonicArena *arena) noexcept
+            : m_prev(detail::t_current_arena)
+        {
+            detail::t_current_arena = arena;
+        }
+        ~ArenaScope() { detail::t_current_arena = m_prev; }
+
+        ArenaScope(const ArenaScope &) = delete;
+        ArenaScope &operator=(const ArenaScope &) = delete;
+
+    private:
+        MonotonicArena *m_prev;
+    };
+}
@@ -0,0 +1,158 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <time.h>
+#include "Common/Time.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define COMMON_CLOCK_HAS_TSC 1
+#else
+#define COMMON_CLOCK_HAS_TSC 0
+#endif
+
+// 低开销单调时钟, 用于热路径上的耗时统计
+// CPU 支持 invariant TSC 时直接读取 rdtsc 并换算为纳秒, 否则回退到 vDSO clock_gettime(CLOCK_MONOTONIC).
+// 只能用于计算时间间隔, 需要时间戳(日志/过期时间)的地方仍使用 Time.h.
+//
+// Example:
+// Common::Stopwatch sw;
+// ...
+// double cost_ms = sw.elapsed_ms();
+namespace Common
+{
+    class TscClock
+    {
+        static constexpr long CALIBRATE_NS = 10 * 1000 * 1000; // 校准时长 10ms
+
+    public:
+        static const TscClock &Instance()
+        {
+            static TscClock instance;
+            return instance;
+        }
+
+        // 是否使用 TSC, false 表示回退到 clock_gettime
+        bool tsc() const noexcept { return m_tsc; }
+
+        // 每纳秒 tick 数
+        double ticks_per_ns() const noexcept { return m_ticksPerNs; }
+
+        inline long now_ns() const noexcept
+        {
+#if COMMON_CLOCK_HAS_TSC
+            if (m_tsc)
+            {
+                // 不同核的 TSC 可能有微小偏差, 读数早于校准时刻时按 0 处理, 避免无符号回绕
+                int64_t delta = (int64_t)(__rdtsc() - m_baseTsc);
+                if (delta < 0)
+                {
+                    delta = 0;
+                }
+                return m_baseNs + (long)(((unsigned __int128)delta * m_mult) >> 32);
+            }
+#endif
+            return get_mono_ns();
+        }
+
+    private:
+        TscClock()
+        {
+#if COMMON_CLOCK_HAS_TSC
+            if (!invariant_tsc())
+            {
+                return;
+            }
+
+            // 与 CLOCK_MONOTONIC 对齐, 校准 tick 与纳秒的比例
+            long ns0 = get_mono_ns();
+            uint64_t tsc0 = __rdtsc();
+            long ns1 = ns0;
+            uint64_t tsc1 = tsc0;
+            while (ns1 - ns0 < CALIBRATE_NS)
+            {
+                ns1 = get_mono_ns();
+                tsc1 = __rdtsc();
+            }
+            if (tsc1 <= tsc0)
+            {
+                return;
+            }
+
+            m_ticksPerNs = double(tsc1 - tsc0) / double(ns1 - ns0);
+            m_mult = (uint64_t)((double(ns1 - ns0) / double(tsc1 - tsc0)) * 4294967296.0);
+            m_baseTsc = tsc1;
+            m_baseNs = ns1;
+            m_tsc = true;
+#endif
+        }
+
+#if COMMON_CLOCK_HAS_TSC
+        // CPUID.80000007H:EDX[8], TSC 频率恒定且在深度睡眠状态下不停止
+        static bool invariant_tsc() noexcept
+        {
+            unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+            if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007)
+            {
+                return false;
+            }
+            __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+            return (edx & (1u << 8)) != 0;
+        }
+#endif
+
+    private:
+        bool m_tsc = false;         // 是否使用 TSC
+        double m_ticksPerNs = 0.0;  // 每纳秒 tick 数
+        uint64_t m_mult = 0;        // 纳秒/tick, 32位定点数
+        uint64_t m_baseTsc = 0;     // 校准时的 tick
+        long m_baseNs = 0;          // 校准时的 CLOCK_MONOTONIC 纳秒
+    };
+
+    // 单调时钟纳秒数
+    inline long mono_ns() noexcept
+    {
+        return TscClock::Instance().now_ns();
+    }
+
+    // 单调时钟毫秒数
+    inline double mono_ms() noexcept
+    {
+        return mono_ns() * 1e-6;
+    }
+
+    // 计时器, 构造时开始计时
+    class Stopwatch
+    {
+    public:
+        Stopwatch() noexcept : m_start(mono_ns()) {}
+
+        void reset() noexcept { m_start = mono_ns(); }
+
+        long elapsed_ns() const noexcept { return mono_ns() - m_start; }
+        double elapsed_ms() const noexcept { return elapsed_ns() * 1e-6; }
+
+    private:
+        long m_start;
+    };
+
+    // 作用域计时器, 析构时将耗时(毫秒)传给回调
+    // Common::ScopedStopwatch sw([&](double ms) { PushRequestTime(ms); });
+    template <typename Func>
+    class ScopedStopwatch
+    {
+    public:
+        explicit ScopedStopwatch(Func func) noexcept : m_func(std::move(func)) {}
+        ~ScopedStopwatch() { m_func(m_stopwatch.elapsed_ms()); }
+
+        ScopedStopwatch(const ScopedStopwatch &) = delete;
+        ScopedStopwatch &operator=(const ScopedStopwatch &) = delete;
+
+        const Stopwatch &stopwatch() const noexcept { return m_stopwatch; }
+
+    private:
+        Func m_func;
+        Stopwatch m_stopwatch;
+    };
+}
@@ -5,7 +5,7 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <shared_mutex>
-#include <atomic>
+#include "Common/Lock.h"
 
 // 公共缓存, 支持Hash, Vector, Single三种缓存方案
 // 如果需要可以按规则拓展...Set这样的
@@ -116,7 +116,7 @@ public:
     {
         // 20220912 tkxiong 尝试获取锁, 获取失败时不查找, 以免引起阻塞
         // owns_lock() Checks whether *this owns a locked mutex or not.
-        std::shared_lock<std::shared_mutex> sl(m_rwLock, std::try_to_lock);
+        std::shared_lock<Common::distributed_shared_mutex> sl(m_rwLock, std::try_to_lock);
         if (sl.owns_lock())
         {
             if (const auto it = m_rwCache.find(key); it != m_rwCache.end())
@@ -140,21 +140,21 @@ public:
     // 将数据copy到读写锁缓存中
     void AddRWBufCacheData(const Key &key, const Value &value) noexcept
     {
-        std::unique_lock<std::shared_mutex> ul(m_rwLock);
+        std::unique_lock<Common::distributed_shared_mutex> ul(m_rwLock);
         m_rwCache[key] = value;
     }
 
     // 将数据copy到读写锁缓存中
     void AddRWBufCacheData(const Key &key, Value &&value) noexcept
     {
-        std::unique_lock<std::shared_mutex> ul(m_rwLock);
+        std::unique_lock<Common::distributed_shared_mutex> ul(m_rwLock);
         m_rwCache[key] = std::move(value);
     }
 
     // 将数据copy到读写锁缓存中
     void AddRWBufCacheData(const std::unordered_map<Key, Value> &cacheData) noexcept
     {
-        std::unique_lock<std::shared_mutex> ul(m_rwLock);
+        std::unique_lock<Common::distributed_shared_mutex> ul(m_rwLock);
         for (const auto &item : cacheData)
         {
             m_rwCache[item.first] = item.second;
@@ -164,7 +164,7 @@ public:
     // 将数据move到读写锁缓存中
     void AddRWBufCacheData(std::unordered_map<Key, Value> &&cacheData) noexcept
     {
-        std::unique_lock<std::shared_mutex> ul(m_rwLock);
+        std::unique_lock<Common::distributed_shared_mutex> ul(m_rwLock);
         if (m_rwCache.size() < cacheData.size())
         {
             cacheData.insert(m_rwCache.begin(), m_rwCache.end());
@@ -185,7 +185,7 @@ public:
 
     void ClearRWBuf() noexcept
     {
-        std::unique_lock<std::shared_mutex> ul(m_rwLock);
+        std::unique_lock<Common::distributed_shared_mutex> ul(m_rwLock);
         m_rwCache.clear();
     }
 
@@ -258,7 +258,7 @@ public:
     void RefreshCache() noexcept
     {
         // 将读写锁内数据移动到双缓冲, 清空读写锁内数据
-        std::unique_lock<std::shared_mutex> ul(m_rwLock);
+        std::unique_lock<Common::distributed_shared_mutex> ul(m_rwLock);
         AddDBufCacheData(std::move(m_rwCache));
     }
 
@@ -277,7 +277,7 @@ public:
     // 获取读写锁内key数量
     const int GetRWBufSize() const noexcept
     {
-        std::shared_lock<std::shared_mutex> sl(m_rwLock);
+        std::shared_lock<Common::distributed_shared_mutex> sl(m_rwLock);
         return m_rwCache.size();
     }
 
@@ -318,7 +318,7 @@ public:
     std::unordered_set<Key> m_DbufContainKey; // 记录当前双缓存内的key
 
     // 读写锁
-    mutable std::shared_mutex m_rwLock;
+    mutable Common::distributed_shared_mutex m_rwLock;
     std::unordered_map<Key, Value> m_rwCache;
 };
 
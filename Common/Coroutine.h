@@ -0,0 +1,419 @@
+#pragma once
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+// C++20 协程运行时, 需要 -std=c++20
+// 仅提供最小集合:
+// 1. Task<T>      惰性协程, co_await 时才开始执行, 结束后对称转移回调用方
+// 2. CoScheduler  单线程调度器, 其他线程(CQ轮询线程/curl工作线程)通过 Post 唤醒协程
+// 3. SyncWait     在普通线程中阻塞等待一个 Task 执行完毕
+//
+// Example:
+// Common::Task<int> Foo() { auto reply = co_await CoPostRequest(...); co_return reply.code; }
+// Common::CoScheduler scheduler;
+// scheduler.Init();
+// scheduler.Spawn(Foo());
+namespace Common
+{
+    class CoScheduler;
+
+    template <typename T>
+    class Task;
+
+    namespace detail
+    {
+        // 协程结束时, 切换回等待者; 没有等待者(Spawn)时自行销毁
+        // 游离协程的异常没有人接收, 在 noexcept 中重新抛出, 由 std::terminate 输出异常信息, 不静默丢弃
+        struct FinalAwaiter
+        {
+            bool await_ready() const noexcept { return false; }
+
+            template <typename Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept
+            {
+                auto &promise = h.promise();
+                if (promise.continuation)
+                {
+                    return promise.continuation;
+                }
+                if (promise.detached)
+                {
+                    if (promise.exception)
+                    {
+                        std::rethrow_exception(promise.exception);
+                    }
+                    h.destroy();
+                }
+                return std::noop_coroutine();
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        struct PromiseBase
+        {
+            std::coroutine_handle<> continuation = nullptr;
+            std::exception_ptr exception = nullptr;
+            bool detached = false;
+
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            FinalAwaiter final_suspend() const noexcept { return {}; }
+            void unhandled_exception() noexcept { exception = std::current_exception(); }
+        };
+    }
+
+    template <typename T = void>
+    class [[nodiscard]] Task
+    {
+    public:
+        struct promise_type : detail::PromiseBase
+        {
+            std::optional<T> value;
+
+            Task get_return_object() noexcept
+            {
+                return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            template <typename U>
+            void return_value(U &&v) { value.emplace(std::forward<U>(v)); }
+        };
+
+        Task(Task &&other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+        Task(const Task &) = delete;
+        Task &operator=(const Task &) = delete;
+        ~Task()
+        {
+            if (m_handle)
+            {
+                m_handle.destroy();
+            }
+        }
+
+        bool await_ready() const noexcept { return !m_handle || m_handle.done(); }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+        {
+            m_handle.promise().continuation = awaiting;
+            return m_handle;
+        }
+
+        T await_resume()
+        {
+            auto &promise = m_handle.promise();
+            if (promise.exception)
+            {
+                std::rethrow_exception(promise.exception);
+            }
+            return std::move(*promise.value);
+        }
+
+        // 交出协程句柄所有权, 由调用方负责销毁
+        std::coroutine_handle<promise_type> release() noexcept
+        {
+            return std::exchange(m_handle, nullptr);
+        }
+
+    private:
+        explicit Task(std::coroutine_handle<promise_type> h) noexcept : m_handle(h) {}
+
+        std::coroutine_handle<promise_type> m_handle;
+    };
+
+    template <>
+    class [[nodiscard]] Task<void>
+    {
+    public:
+        struct promise_type : detail::PromiseBase
+        {
+            Task get_return_object() noexcept
+            {
+                return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            void return_void() noexcept {}
+        };
+
+        Task(Task &&other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+        Task(const Task &) = delete;
+        Task &operator=(const Task &) = delete;
+        ~Task()
+        {
+            if (m_handle)
+            {
+                m_handle.destroy();
+            }
+        }
+
+        bool await_ready() const noexcept { return !m_handle || m_handle.done(); }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+        {
+            m_handle.promise().continuation = awaiting;
+            return m_handle;
+        }
+
+        void await_resume()
+        {
+            auto &promise = m_handle.promise();
+            if (promise.exception)
+            {
+                std::rethrow_exception(promise.exception);
+            }
+        }
+
+        std::coroutine_handle<promise_type> release() noexcept
+        {
+            return std::exchange(m_handle, nullptr);
+        }
+
+    private:
+        explicit Task(std::coroutine_handle<promise_type> h) noexcept : m_handle(h) {}
+
+        std::coroutine_handle<promise_type> m_handle;
+    };
+
+    // 单线程协程调度器
+    // 所有被 Spawn 的协程以及它们 co_await 的异步IO, 都在调度线程上恢复执行,
+    // 协程内部访问共享数据无需加锁. 单个线程即可同时挂起成百上千个请求.
+    class CoScheduler
+    {
+    public:
+        CoScheduler() {}
+        ~CoScheduler() { ShutDown(); }
+        CoScheduler(const CoScheduler &) = delete;
+        CoScheduler &operator=(const CoScheduler &) = delete;
+
+        bool Init()
+        {
+            std::lock_guard<std::mutex> lg(m_mutex);
+            if (m_thread.joinable())
+            {
+                return false;
+            }
+            m_shutdown = false;
+            m_thread = std::thread(&CoScheduler::ThreadFunc, this);
+            return true;
+        }
+
+        // 等待所有已投递的协程恢复完毕后退出
+        void ShutDown()
+        {
+            {
+                std::lock_guard<std::mutex> lg(m_mutex);
+                m_shutdown = true;
+            }
+            m_cv.notify_one();
+            if (m_thread.joinable())
+            {
+                m_thread.join();
+            }
+        }
+
+        // 线程安全, 在调度线程上恢复协程
+        void Post(std::coroutine_handle<> h)
+        {
+            {
+                std::lock_guard<std::mutex> lg(m_mutex);
+                m_ready.push_back(h);
+            }
+            m_cv.notify_one();
+        }
+
+        // 启动一个游离协程, 协程结束后自动销毁
+        // 协程抛出未捕获的异常时调用 std::terminate, 需要在协程内部处理异常
+        void Spawn(Task<void> &&task)
+        {
+            auto h = task.release();
+            h.promise().detached = true;
+            Post(h);
+        }
+
+        // 当前线程所属调度器, 不在调度线程上时返回 nullptr
+        static CoScheduler *Current() noexcept { return t_current; }
+
+        // 挂起当前协程, 切换到调度线程上继续执行
+        auto Schedule() noexcept
+        {
+            struct ScheduleAwaiter
+            {
+                CoScheduler *scheduler;
+                bool await_ready() const noexcept { return scheduler == Current(); }
+                void await_suspend(std::coroutine_handle<> h) { scheduler->Post(h); }
+                void await_resume() const noexcept {}
+            };
+            return ScheduleAwaiter{this};
+        }
+
+    private:
+        void ThreadFunc()
+        {
+            t_current = this;
+            std::deque<std::coroutine_handle<>> ready;
+            for (;;)
+            {
+                {
+                    std::unique_lock<std::mutex> ul(m_mutex);
+                    m_cv.wait(ul, [this]
+                              { return m_shutdown || !m_ready.empty(); });
+                    if (m_ready.empty() && m_shutdown)
+                    {
+                        break;
+                    }
+                    ready.swap(m_ready);
+                }
+
+                while (!ready.empty())
+                {
+                    auto h = ready.front();
+                    ready.pop_front();
+                    h.resume();
+                }
+            }
+            t_current = nullptr;
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::deque<std::coroutine_handle<>> m_ready;
+        bool m_shutdown = true;
+        std::thread m_thread;
+        inline static thread_local CoScheduler *t_current = nullptr;
+    };
+
+    // IO完成后恢复协程: 挂起时在调度线程上, 则投递回调度线程; 否则直接在完成线程上恢复
+    inline void CoResume(CoScheduler *scheduler, std::coroutine_handle<> h)
+    {
+        if (scheduler != nullptr)
+        {
+            scheduler->Post(h);
+        }
+        else
+        {
+            h.resume();
+        }
+    }
+
+    namespace detail
+    {
+        // SyncWait 辅助协程, 结束时通知等待线程
+        struct SyncWaitEvent
+        {
+            std::mutex mutex;
+            std::condition_variable cv;
+            bool done = false;
+
+            void set()
+            {
+                std::lock_guard<std::mutex> lg(mutex);
+                done = true;
+                cv.notify_one();
+            }
+
+            void wait()
+            {
+                std::unique_lock<std::mutex> ul(mutex);
+                cv.wait(ul, [this]
+                        { return done; });
+            }
+        };
+
+        struct SyncWaitTask
+        {
+            struct promise_type
+            {
+                SyncWaitEvent *event = nullptr;
+
+                SyncWaitTask get_return_object() noexcept
+                {
+                    return SyncWaitTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+                }
+                std::suspend_always initial_suspend() const noexcept { return {}; }
+                auto final_suspend() const noexcept
+                {
+                    struct Notify
+                    {
+                        bool await_ready() const noexcept { return false; }
+                        void await_suspend(std::coroutine_handle<promise_type> h) const noexcept
+                        {
+                            h.promise().event->set();
+                        }
+                        void await_resume() const noexcept {}
+                    };
+                    return Notify{};
+                }
+                void return_void() noexcept {}
+                void unhandled_exception() noexcept { std::terminate(); }
+            };
+
+            std::coroutine_handle<promise_type> handle;
+        };
+
+        template <typename T>
+        SyncWaitTask MakeSyncWaitTask(Task<T> &task, std::optional<T> &result, std::exception_ptr &exception)
+        {
+            try
+            {
+                result.emplace(co_await task);
+            }
+            catch (...)
+            {
+                exception = std::current_exception();
+            }
+        }
+
+        inline SyncWaitTask MakeSyncWaitTask(Task<void> &task, std::exception_ptr &exception)
+        {
+            try
+            {
+                co_await task;
+            }
+            catch (...)
+            {
+                exception = std::current_exception();
+            }
+        }
+    }
+
+    // 阻塞当前线程直到 task 完成, 不能在调度线程上调用
+    template <typename T>
+    T SyncWait(Task<T> task)
+    {
+        detail::SyncWaitEvent event;
+        std::exception_ptr exception = nullptr;
+        if constexpr (std::is_void_v<T>)
+        {
+            auto wrapper = detail::MakeSyncWaitTask(task, exception);
+            wrapper.handle.promise().event = &event;
+            wrapper.handle.resume();
+            event.wait();
+            wrapper.handle.destroy();
+            if (exception)
+            {
+                std::rethrow_exception(exception);
+            }
+        }
+        else
+        {
+            std::optional<T> result;
+            auto wrapper = detail::MakeSyncWaitTask(task, result, exception);
+            wrapper.handle.promise().event = &event;
+            wrapper.handle.resume();
+            event.wait();
+            wrapper.handle.destroy();
+            if (exception)
+            {
+                std::rethrow_exception(exception);
+            }
+            return std::move(*result);
+        }
+    }
+}
@@ -2,6 +2,7 @@
 #include <vector>
 #include <string>
 #include <set>
+#include <unordered_map>
 #include <sstream>
 #include <algorithm>
 #include <sys/time.h>
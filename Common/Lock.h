@@ -1,6 +1,15 @@
 #pragma once
 #include <atomic>
 #include <mutex>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <climits>
+#include <algorithm>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 namespace Common
 {
@@ -59,4 +68,449 @@ namespace Common
     private:
         std::atomic<bool> lock_ = false;
     };
+    namespace detail
+    {
+        // 自旋次数上限, 超过后挂起线程等待唤醒, 避免临界区较长或线程数超过核数时空耗CPU.
+        // 单核时持有者不可能与等待者同时运行, 自旋没有意义, 直接挂起.
+        inline int lock_spin_limit() noexcept
+        {
+            static const int limit = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? (1 << 10) : 0;
+            return limit;
+        }
+
+        inline void futex_wait(std::atomic<uint32_t> *addr, const uint32_t val, const timespec *timeout = nullptr) noexcept
+        {
+            syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAIT_PRIVATE, val, timeout, nullptr, 0);
+        }
+
+        inline void futex_wake(std::atomic<uint32_t> *addr, const int count) noexcept
+        {
+            syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+        }
+
+        // 排队锁的等待节点, 每个等待者只在自己关注的节点上自旋, 独占缓存行
+        struct alignas(64) QueueNode
+        {
+            enum : uint32_t
+            {
+                GRANTED = 0, // 已获得锁
+                WAITING = 1, // 自旋等待中
+                PARKED = 2,  // 已挂起, 需要唤醒
+            };
+            std::atomic<QueueNode *> next = nullptr;
+            std::atomic<uint32_t> state = GRANTED;
+        };
+
+        // 等待 state 变为 GRANTED, 先自旋, 超过上限后挂起
+        inline void queue_node_wait(std::atomic<uint32_t> &state) noexcept
+        {
+            const int spin_limit = lock_spin_limit();
+            for (int spin = 0; spin < spin_limit; spin++)
+            {
+                if (state.load(std::memory_order_acquire) == QueueNode::GRANTED)
+                {
+                    return;
+                }
+                __builtin_ia32_pause();
+            }
+
+            uint32_t expect = QueueNode::WAITING;
+            if (state.compare_exchange_strong(expect, QueueNode::PARKED, std::memory_order_acquire))
+            {
+                while (state.load(std::memory_order_acquire) == QueueNode::PARKED)
+                {
+                    futex_wait(&state, QueueNode::PARKED);
+                }
+            }
+        }
+
+        // 将 state 置为 GRANTED, 等待者已挂起时唤醒
+        inline void queue_node_grant(std::atomic<uint32_t> &state) noexcept
+        {
+            if (state.exchange(QueueNode::GRANTED, std::memory_order_release) == QueueNode::PARKED)
+            {
+                futex_wake(&state, 1);
+            }
+        }
+
+        // 线程私有的节点缓存, 线程退出时释放
+        class QueueNodeCache
+        {
+        public:
+            ~QueueNodeCache()
+            {
+                for (auto node : m_free)
+                {
+                    delete node;
+                }
+            }
+
+            static QueueNode *get()
+            {
+                auto &free = local().m_free;
+                if (free.empty())
+                {
+                    return new QueueNode();
+                }
+                QueueNode *node = free.back();
+                free.pop_back();
+                return node;
+            }
+
+            static void put(QueueNode *node)
+            {
+                local().m_free.emplace_back(node);
+            }
+
+        private:
+            static QueueNodeCache &local()
+            {
+                thread_local QueueNodeCache cache;
+                return cache;
+            }
+
+            std::vector<QueueNode *> m_free;
+        };
+    }
+
+    // MCS 排队自旋锁
+    // 等待者按到达顺序排队, 每个等待者只在自己的节点上自旋, 释放锁时只有下一个等待者的缓存行失效,
+    // 高并发下不会像 spin_lock 一样所有线程争抢同一个缓存行. 自旋超过上限后挂起.
+    // 满足 BasicLockable / Lockable, 可作为 LRUCache/LFUCache/ARCCache 的 Lock 模板参数.
+    // 注意: 严格按顺序交接, 线程数超过核数时下一个等待者可能未被调度, 吞吐会低于 std::mutex,
+    // 适用于竞争线程数不超过核数的场景(如绑核的工作线程).
+    //
+    // Common::LRUCache<long, std::string, Common::mcs_lock> cache(10000);
+    class mcs_lock
+    {
+    public:
+        mcs_lock() {}
+        ~mcs_lock() {}
+        mcs_lock(const mcs_lock &) = delete;
+        mcs_lock &operator=(const mcs_lock &) = delete;
+
+        void lock() noexcept
+        {
+            auto node = detail::QueueNodeCache::get();
+            node->next.store(nullptr, std::memory_order_relaxed);
+            node->state.store(detail::QueueNode::WAITING, std::memory_order_relaxed);
+
+            auto prev = m_tail.exchange(node, std::memory_order_acq_rel);
+            if (prev != nullptr)
+            {
+                prev->next.store(node, std::memory_order_release);
+                detail::queue_node_wait(node->state);
+            }
+            m_holder = node;
+        }
+
+        bool try_lock() noexcept
+        {
+            auto node = detail::QueueNodeCache::get();
+            node->next.store(nullptr, std::memory_order_relaxed);
+
+            detail::QueueNode *expect = nullptr;
+            if (m_tail.compare_exchange_strong(expect, node, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                m_holder = node;
+                return true;
+            }
+            detail::QueueNodeCache::put(node);
+            return false;
+        }
+
+        void unlock() noexcept
+        {
+            auto node = m_holder;
+            auto next = node->next.load(std::memory_order_acquire);
+            if (next == nullptr)
+            {
+                // 没有等待者, 直接释放
+                auto expect = node;
+                if (m_tail.compare_exchange_strong(expect, nullptr, std::memory_order_release, std::memory_order_relaxed))
+                {
+                    detail::QueueNodeCache::put(node);
+                    return;
+                }
+
+                // 有线程已加入队尾但还未链接到当前节点
+                while ((next = node->next.load(std::memory_order_acquire)) == nullptr)
+                {
+                    __builtin_ia32_pause();
+                }
+            }
+            detail::queue_node_grant(next->state);
+            detail::QueueNodeCache::put(node);
+        }
+
+    private:
+        alignas(64) std::atomic<detail::QueueNode *> m_tail = nullptr;
+        detail::QueueNode *m_holder = nullptr; // 持有锁的节点, 只由持有者读写
+    };
+
+    // CLH 排队自旋锁
+    // 与 MCS 相同按到达顺序排队, 等待者在前驱节点上自旋, 释放时只修改自己的节点, 不需要等待后继链接.
+    // 获得锁后前驱节点归当前线程复用, 自己的节点交给后继者.
+    // 只满足 BasicLockable, 不提供 try_lock: 入队后无法撤销, 而检查锁空闲与入队之间前驱节点可能被其他线程复用并重新入队,
+    // 无法保证不等待. 需要 try_lock(或 std::scoped_lock/std::lock 同时锁多把锁)时使用 mcs_lock.
+    class clh_lock
+    {
+    public:
+        clh_lock()
+        {
+            // 初始哨兵节点, 表示锁空闲
+            m_tail.store(new detail::QueueNode(), std::memory_order_relaxed);
+        }
+        ~clh_lock() { delete m_tail.load(std::memory_order_relaxed); }
+        clh_lock(const clh_lock &) = delete;
+        clh_lock &operator=(const clh_lock &) = delete;
+
+        void lock() noexcept
+        {
+            auto node = detail::QueueNodeCache::get();
+            node->state.store(detail::QueueNode::WAITING, std::memory_order_relaxed);
+
+            auto prev = m_tail.exchange(node, std::memory_order_acq_rel);
+            detail::queue_node_wait(prev->state);
+            m_holder = node;
+            m_prev = prev;
+        }
+
+        void unlock() noexcept
+        {
+            auto node = m_holder;
+            auto prev = m_prev;
+            detail::queue_node_grant(node->state);
+            detail::QueueNodeCache::put(prev);
+        }
+
+    private:
+        alignas(64) std::atomic<detail::QueueNode *> m_tail;
+        detail::QueueNode *m_holder = nullptr; // 持有锁的节点
+        detail::QueueNode *m_prev = nullptr;   // 持有者的前驱节点, 释放后归持有者复用
+    };
+
+    // 分布式读写锁
+    // 读者计数按线程分散到多个独占缓存行的槽位, 读锁只修改本线程槽位, 读多写少时读者之间不再争抢同一个缓存行.
+    // 写锁需要等待所有槽位读者清零, 代价高于 std::shared_mutex, 适用于读远多于写的场景(服务地址表/客户端表等).
+    // 接口与 std::shared_mutex 一致, 可配合 std::shared_lock / std::unique_lock 使用.
+    //
+    // writer_preference = true: 写者到达后新读者让路, 写者不会饿死(默认)
+    // writer_preference = false: 写者等待读者全部退出后才加锁, 持续读时写者可能长时间等待
+    //
+    // 注意: 与 std::shared_mutex 一样不支持同一线程重入读锁.
+    class distributed_shared_mutex
+    {
+        static constexpr size_t MAX_SLOT_NUM = 64;
+
+        enum : uint32_t
+        {
+            WRITER_NONE = 0,   // 无写者
+            WRITER_ACTIVE = 1, // 写者等待或持有
+            WRITER_PARKED = 2, // 写者等待或持有, 且有读者挂起
+        };
+
+        struct alignas(64) Slot
+        {
+            std::atomic<int64_t> readers = 0;
+        };
+
+    public:
+        explicit distributed_shared_mutex(const bool writer_preference = true)
+            : m_writerPreference(writer_preference)
+        {
+            size_t limit = std::min<size_t>(std::max<long>(sysconf(_SC_NPROCESSORS_ONLN), 1), MAX_SLOT_NUM);
+            m_slotNum = 1;
+            while (m_slotNum < limit)
+            {
+                m_slotNum *= 2;
+            }
+            m_slots.reset(new Slot[m_slotNum]);
+        }
+        ~distributed_shared_mutex() {}
+        distributed_shared_mutex(const distributed_shared_mutex &) = delete;
+        distributed_shared_mutex &operator=(const distributed_shared_mutex &) = delete;
+
+        void lock_shared() noexcept
+        {
+            auto &readers = m_slots[slotIndex()].readers;
+            for (;;)
+            {
+                readers.fetch_add(1, std::memory_order_seq_cst);
+                if (m_writer.load(std::memory_order_seq_cst) == WRITER_NONE)
+                {
+                    return;
+                }
+
+                // 有写者, 退出后等待写者释放
+                readers.fetch_sub(1, std::memory_order_seq_cst);
+                notifyWriter();
+                waitWriter();
+            }
+        }
+
+        bool try_lock_shared() noexcept
+        {
+            auto &readers = m_slots[slotIndex()].readers;
+            readers.fetch_add(1, std::memory_order_seq_cst);
+            if (m_writer.load(std::memory_order_seq_cst) == WRITER_NONE)
+            {
+                return true;
+            }
+            readers.fetch_sub(1, std::memory_order_seq_cst);
+            notifyWriter();
+            return false;
+        }
+
+        void unlock_shared() noexcept
+        {
+            m_slots[slotIndex()].readers.fetch_sub(1, std::memory_order_seq_cst);
+            notifyWriter();
+        }
+
+        void lock() noexcept
+        {
+            m_writerMutex.lock();
+            if (m_writerPreference)
+            {
+                // 先阻止新读者, 再等待已有读者退出
+                m_writer.store(WRITER_ACTIVE, std::memory_order_seq_cst);
+                waitReaders();
+                return;
+            }
+
+            for (;;)
+            {
+                waitReaders();
+                m_writer.store(WRITER_ACTIVE, std::memory_order_seq_cst);
+                if (noReaders())
+                {
+                    return;
+                }
+
+                // 设置标记前有读者进入, 让读者先完成
+                releaseWriter();
+            }
+        }
+
+        bool try_lock() noexcept
+        {
+            if (!m_writerMutex.try_lock())
+            {
+                return false;
+            }
+            m_writer.store(WRITER_ACTIVE, std::memory_order_seq_cst);
+            if (noReaders())
+            {
+                return true;
+            }
+            releaseWriter();
+            m_writerMutex.unlock();
+            return false;
+        }
+
+        void unlock() noexcept
+        {
+            releaseWriter();
+            m_writerMutex.unlock();
+        }
+
+    private:
+        // 读者槽位按线程固定(线程首次使用时所在CPU), 保证加解锁在同一槽位
+        size_t slotIndex() const noexcept
+        {
+            thread_local size_t idx = (size_t)std::max(sched_getcpu(), 0);
+            return idx & (m_slotNum - 1);
+        }
+
+        bool noReaders() const noexcept
+        {
+            for (size_t idx = 0; idx < m_slotNum; idx++)
+            {
+                if (m_slots[idx].readers.load(std::memory_order_seq_cst) != 0)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // 写者等待所有读者退出, 先自旋, 超过上限后挂起, 由退出的读者唤醒
+        // 读者优先模式下等待时还未设置写者标记, 读者不会唤醒, 依靠超时重新检查
+        void waitReaders() noexcept
+        {
+            const int spin_limit = detail::lock_spin_limit();
+            for (int spin = 0; spin < spin_limit; spin++)
+            {
+                if (noReaders())
+                {
+                    return;
+                }
+                __builtin_ia32_pause();
+            }
+
+            static const timespec timeout = {0, 1000000}; // 1ms
+            for (;;)
+            {
+                uint32_t epoch = m_readerEpoch.load(std::memory_order_seq_cst);
+                if (noReaders())
+                {
+                    return;
+                }
+                detail::futex_wait(&m_readerEpoch, epoch, &timeout);
+            }
+        }
+
+        // 读者退出时, 有写者等待则唤醒
+        void notifyWriter() noexcept
+        {
+            if (m_writer.load(std::memory_order_seq_cst) != WRITER_NONE)
+            {
+                m_readerEpoch.fetch_add(1, std::memory_order_seq_cst);
+                detail::futex_wake(&m_readerEpoch, 1);
+            }
+        }
+
+        // 读者等待写者释放, 先自旋, 超过上限后挂起
+        void waitWriter() noexcept
+        {
+            const int spin_limit = detail::lock_spin_limit();
+            for (int spin = 0; spin < spin_limit; spin++)
+            {
+                if (m_writer.load(std::memory_order_acquire) == WRITER_NONE)
+                {
+                    return;
+                }
+                __builtin_ia32_pause();
+            }
+
+            uint32_t state = m_writer.load(std::memory_order_acquire);
+            while (state != WRITER_NONE)
+            {
+                if (state == WRITER_PARKED ||
+                    m_writer.compare_exchange_weak(state, WRITER_PARKED, std::memory_order_acquire))
+                {
+                    detail::futex_wait(&m_writer, WRITER_PARKED);
+                }
+                state = m_writer.load(std::memory_order_acquire);
+            }
+        }
+
+        void releaseWriter() noexcept
+        {
+            if (m_writer.exchange(WRITER_NONE, std::memory_order_release) == WRITER_PARKED)
+            {
+                detail::futex_wake(&m_writer, INT_MAX);
+            }
+        }
+
+    private:
+        const bool m_writerPreference;
+        size_t m_slotNum;
+        std::unique_ptr<Slot[]> m_slots;
+
+        std::mutex m_writerMutex;                                 // 写者之间互斥
+        alignas(64) std::atomic<uint32_t> m_writer = WRITER_NONE; // 写者状态
+        alignas(64) std::atomic<uint32_t> m_readerEpoch = 0;      // 读者退出计数, 用于唤醒写者
+    };
 }
\ No newline at end of file
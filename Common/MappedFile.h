@@ -0,0 +1,351 @@
+#pragma once
+#include <string>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <iterator>
+#include <algorithm>
+#include <string_view>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include "Common/Tokenizer.h"
+
+// 只读内存映射文件
+// FastReadFile 需要把整个文件拷贝到 std::string, 大文件会多一次完整拷贝和多次扩容;
+// MappedFile 直接把文件映射到内存, 配合 LineRange/FieldRange 按 std::string_view 遍历, 全程零拷贝.
+//
+// 注意:
+// 1. string_view 指向映射内存, 只在 MappedFile 生命周期内有效, 需要保存的内容要自行拷贝.
+// 2. 映射期间文件被截断, 访问超出部分会触发 SIGBUS, 模型文件需要先写临时文件再 rename 替换.
+//
+// Example:
+// Common::MappedFile file;
+// if (file.Open(path))
+// {
+//     for (std::string_view line : file.lines())
+//     {
+//         for (std::string_view field : Common::FieldRange(line, ' '))
+//         {
+//         }
+//     }
+// }
+namespace Common
+{
+    // 按 '\n' 遍历行, 行内容不包含 '\n', 与 getline 一致: 末尾的 '\n' 之后不再产生空行
+    class LineRange
+    {
+    public:
+        class iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::string_view;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const std::string_view *;
+            using reference = const std::string_view &;
+
+            iterator() = default;
+            iterator(std::string_view rest) : m_rest(rest), m_end(rest.empty()) { next(); }
+
+            reference operator*() const noexcept { return m_line; }
+            pointer operator->() const noexcept { return &m_line; }
+            iterator &operator++()
+            {
+                next();
+                return *this;
+            }
+            iterator operator++(int)
+            {
+                iterator tmp = *this;
+                next();
+                return tmp;
+            }
+            bool operator==(const iterator &other) const noexcept
+            {
+                return m_end == other.m_end && (m_end || m_line.data() == other.m_line.data());
+            }
+            bool operator!=(const iterator &other) const noexcept { return !(*this == other); }
+
+        private:
+            void next() noexcept
+            {
+                if (m_rest.empty())
+                {
+                    m_end = true;
+                    return;
+                }
+                const size_t pos = m_rest.find('\n');
+                if (pos == std::string_view::npos)
+                {
+                    m_line = m_rest;
+                    m_rest = std::string_view();
+                }
+                else
+                {
+                    m_line = m_rest.substr(0, pos);
+                    m_rest.remove_prefix(pos + 1);
+                }
+            }
+
+        private:
+            std::string_view m_rest;
+            std::string_view m_line;
+            bool m_end = true;
+        };
+
+    public:
+        explicit LineRange(std::string_view data) : m_data(data) {}
+        iterator begin() const { return iterator(m_data); }
+        iterator end() const { return iterator(); }
+
+    private:
+        std::string_view m_data;
+    };
+
+    // 按分隔符遍历字段, 与 SplitString 一致: 连续分隔符产生空字段, 空字符串产生一个空字段
+    class FieldRange
+    {
+    public:
+        class iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::string_view;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const std::string_view *;
+            using reference = const std::string_view &;
+
+            iterator() = default;
+            iterator(std::string_view rest, char sep) : m_rest(rest), m_sep(sep), m_last(false), m_end(false) { next(); }
+
+            reference operator*() const noexcept { return m_field; }
+            pointer operator->() const noexcept { return &m_field; }
+            iterator &operator++()
+            {
+                next();
+                return *this;
+            }
+            iterator operator++(int)
+            {
+                iterator tmp = *this;
+                next();
+                return tmp;
+            }
+            bool operator==(const iterator &other) const noexcept
+            {
+                return m_end == other.m_end && (m_end || m_field.data() == other.m_field.data());
+            }
+            bool operator!=(const iterator &other) const noexcept { return !(*this == other); }
+
+        private:
+            void next() noexcept
+            {
+                if (m_last)
+                {
+                    m_end = true;
+                    return;
+                }
+                const size_t pos = FindChar(m_rest, m_sep);
+                if (pos == std::string_view::npos)
+                {
+                    m_field = m_rest;
+                    m_last = true;
+                }
+                else
+                {
+                    m_field = m_rest.substr(0, pos);
+                    m_rest.remove_prefix(pos + 1);
+                }
+            }
+
+        private:
+            std::string_view m_rest;
+            std::string_view m_field;
+            char m_sep = ' ';
+            bool m_last = true;
+            bool m_end = true;
+        };
+
+    public:
+        FieldRange(std::string_view data, char sep) : m_data(data), m_sep(sep) {}
+        iterator begin() const { return iterator(m_data, m_sep); }
+        iterator end() const { return iterator(); }
+
+    private:
+        std::string_view m_data;
+        char m_sep;
+    };
+
+    // 按行边界把数据切分为 chunk_num 块, 每块都以完整行结束, 用于并行解析
+    inline std::vector<std::string_view> SplitByLine(std::string_view data, size_t chunk_num)
+    {
+        std::vector<std::string_view> vecChunk;
+        chunk_num = std::max<size_t>(chunk_num, 1);
+        const size_t chunk_size = data.size() / chunk_num + 1;
+        while (!data.empty())
+        {
+            size_t pos = chunk_size < data.size() ? data.find('\n', chunk_size - 1) : std::string_view::npos;
+            pos = pos == std::string_view::npos ? data.size() : pos + 1;
+            vecChunk.emplace_back(data.substr(0, pos));
+            data.remove_prefix(pos);
+        }
+        return vecChunk;
+    }
+
+    // 并行遍历所有行
+    // [in] data: 数据
+    // [in] thread_num: 线程数, 数据按行边界切分为 thread_num 块, 每个线程处理一块
+    // [in] func: bool(size_t chunk_idx, std::string_view line), 返回 false 时该块停止遍历
+    // [ret] 所有行都处理成功返回 true
+    // 每块内按顺序遍历, chunk_idx 可用于每个线程写入各自的局部结果, 结束后再按块顺序合并
+    template <typename Func>
+    inline bool ParallelForEachLine(std::string_view data, int thread_num, Func &&func)
+    {
+        const auto vecChunk = SplitByLine(data, std::max(thread_num, 1));
+        std::atomic<bool> succ = true;
+        auto worker = [&](size_t chunk_idx)
+        {
+            for (std::string_view line : LineRange(vecChunk[chunk_idx]))
+            {
+                if (!succ.load(std::memory_order_relaxed) || !func(chunk_idx, line))
+                {
+                    succ = false;
+                    return;
+                }
+            }
+        };
+
+        std::vector<std::thread> vecThread;
+        for (size_t idx = 1; idx < vecChunk.size(); idx++)
+        {
+            vecThread.emplace_back(worker, idx);
+        }
+        if (!vecChunk.empty())
+        {
+            worker(0);
+        }
+        for (auto &thread : vecThread)
+        {
+            thread.join();
+        }
+        return succ;
+    }
+
+    class MappedFile
+    {
+    public:
+        MappedFile() {}
+        ~MappedFile() { Close(); }
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+        MappedFile(MappedFile &&other) noexcept { *this = std::move(other); }
+        MappedFile &operator=(MappedFile &&other) noexcept
+        {
+            if (this != &other)
+            {
+                Close();
+                std::swap(m_data, other.m_data);
+                std::swap(m_size, other.m_size);
+            }
+            return *this;
+        }
+
+        // 映射文件
+        // [in] filePath: 文件路径
+        // [in] sequential: 顺序读取, madvise(SEQUENTIAL|WILLNEED) 提示内核预读, 读取后的页可以尽快回收
+        //                  随机访问(如二进制模型查表)传 false, 使用 MADV_RANDOM 关闭预读
+        // [in] lock: 映射前加共享锁检查, 加锁失败返回失败, 与 FastReadFile 一致
+        // [ret] 返回成功or失败, 空文件返回成功, data() 为空
+        bool Open(const std::string &filePath, const bool sequential = true, const bool lock = false)
+        {
+            Close();
+
+            int fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+            {
+                return false;
+            }
+
+            struct stat st;
+            if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+            {
+                close(fd);
+                return false;
+            }
+
+            // 共享锁/不阻塞, 映射完成后即可释放, 与 FastReadFile 读取期间加锁语义一致
+            if (lock && flock(fd, LOCK_SH | LOCK_NB) != 0)
+            {
+                close(fd);
+                return false;
+            }
+
+            bool succ = true;
+            if (st.st_size > 0)
+            {
+                void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (addr == MAP_FAILED)
+                {
+                    succ = false;
+                }
+                else
+                {
+                    m_data = static_cast<char *>(addr);
+                    m_size = st.st_size;
+                    Advise(sequential);
+                }
+            }
+
+            if (lock)
+            {
+                flock(fd, LOCK_UN);
+            }
+            close(fd); // 映射不依赖 fd
+            return succ;
+        }
+
+        // 修改访问方式提示, 如先按顺序读取文件头, 确认格式后改为随机访问
+        void Advise(const bool sequential) noexcept
+        {
+            if (m_data == nullptr)
+            {
+                return;
+            }
+            if (sequential)
+            {
+                madvise(m_data, m_size, MADV_SEQUENTIAL);
+                madvise(m_data, m_size, MADV_WILLNEED);
+            }
+            else
+            {
+                madvise(m_data, m_size, MADV_RANDOM);
+            }
+        }
+
+        void Close() noexcept
+        {
+            if (m_data != nullptr)
+            {
+                munmap(m_data, m_size);
+                m_data = nullptr;
+                m_size = 0;
+            }
+        }
+
+        std::string_view data() const noexcept { return std::string_view(m_data, m_size); }
+        size_t size() const noexcept { return m_size; }
+        bool empty() const noexcept { return m_size == 0; }
+
+        LineRange lines() const noexcept { return LineRange(data()); }
+
+        // 按行边界切分, 见 SplitByLine
+        std::vector<std::string_view> chunks(const size_t chunk_num) const { return SplitByLine(data(), chunk_num); }
+
+    private:
+        char *m_data = nullptr;
+        size_t m_size = 0;
+    };
+}
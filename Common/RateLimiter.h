@@ -5,6 +5,7 @@
 #include "Common/Lock.h"
 #include "Common/Function.h"
 #include "Common/AtomicSequence.h"
+#include "Common/Clock.h"
 
 // 限流器
 // RateLimiter r(100);
@@ -24,7 +25,7 @@ public:
         assert(qps >= 0);
         assert(cache >= 0);
 
-        m_LastAddTokenTime = Common::get_ns_timestamp();
+        m_LastAddTokenTime = Common::mono_ns();
     }
 
     RateLimiter(const RateLimiter &) = delete;
@@ -55,7 +56,7 @@ private:
     // 更新令牌桶中的令牌
     void supplyTokens()
     {
-        auto cur = Common::get_ns_timestamp();
+        auto cur = Common::mono_ns();
         if (cur - m_LastAddTokenTime < m_SupplyUnitTime)
         {
             return;
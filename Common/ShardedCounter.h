@@ -0,0 +1,115 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <sched.h>
+#include "Common/Clock.h"
+#include "Common/AtomicSequence.h"
+
+// 分片计数器
+// 计数按CPU拆分到多个独占缓存行的分片, 各线程只修改所在CPU的分片, 避免所有线程争抢同一个原子变量.
+// 适用于写多读少的统计场景(请求数/耗时累计/在途数等), 不适用于需要唯一递增序号的场景(使用 AtomicSequence).
+// add 支持负数, 也可以当作 Gauge 使用.
+//
+// Common::ShardedCounter counter;
+// counter.add(1);
+// counter.sum();      // 精确值, 汇总所有分片
+// counter.approx();   // 近似值, 1ms 内重复读取直接返回缓存
+// counter.exchange(); // 读取并清零, 用于定时上报增量
+namespace Common
+{
+    class ShardedCounter
+    {
+        static constexpr size_t MAX_SHARD_NUM = 64;
+        static constexpr long APPROX_REFRESH_NS = 1000000; // 近似值缓存时间 1ms
+
+        struct alignas(CACHELINE_SIZE_BYTES) Slot
+        {
+            std::atomic<int64_t> value = 0;
+        };
+
+    public:
+        ShardedCounter()
+        {
+            size_t limit = std::min<size_t>(std::thread::hardware_concurrency(), MAX_SHARD_NUM);
+            m_SlotNum = 1;
+            while (m_SlotNum < limit)
+            {
+                m_SlotNum *= 2;
+            }
+            m_SlotMask = m_SlotNum - 1;
+            m_Slots.reset(new Slot[m_SlotNum]);
+        }
+
+        ShardedCounter(const ShardedCounter &) = delete;
+        ShardedCounter &operator=(const ShardedCounter &) = delete;
+
+        inline void add(const int64_t delta = 1) noexcept
+        {
+            m_Slots[slotIndex()].value.fetch_add(delta, std::memory_order_relaxed);
+        }
+
+        inline void sub(const int64_t delta = 1) noexcept
+        {
+            add(-delta);
+        }
+
+        // 精确读取, 汇总所有分片
+        int64_t sum() const noexcept
+        {
+            int64_t total = 0;
+            for (size_t idx = 0; idx < m_SlotNum; idx++)
+            {
+                total += m_Slots[idx].value.load(std::memory_order_relaxed);
+            }
+            return total;
+        }
+
+        // 近似读取, 缓存时间内直接返回上次汇总的结果
+        int64_t approx() const noexcept
+        {
+            long cur = mono_ns();
+            if (cur - m_ApproxTime.load(std::memory_order_relaxed) < APPROX_REFRESH_NS)
+            {
+                return m_ApproxValue.load(std::memory_order_relaxed);
+            }
+            int64_t total = sum();
+            m_ApproxValue.store(total, std::memory_order_relaxed);
+            m_ApproxTime.store(cur, std::memory_order_relaxed);
+            return total;
+        }
+
+        // 读取并清零, 返回清零前的汇总值, 并发的 add 不会丢失
+        int64_t exchange() noexcept
+        {
+            int64_t total = 0;
+            for (size_t idx = 0; idx < m_SlotNum; idx++)
+            {
+                total += m_Slots[idx].value.exchange(0, std::memory_order_relaxed);
+            }
+            return total;
+        }
+
+    private:
+        // 当前线程所在CPU对应的分片
+        size_t slotIndex() const noexcept
+        {
+            int cpu = sched_getcpu();
+            if (cpu < 0)
+            {
+                static std::atomic<size_t> next = 0;
+                thread_local size_t idx = next.fetch_add(1);
+                return idx & m_SlotMask;
+            }
+            return (size_t)cpu & m_SlotMask;
+        }
+
+    private:
+        size_t m_SlotNum;
+        size_t m_SlotMask;
+        std::unique_ptr<Slot[]> m_Slots;
+
+        alignas(CACHELINE_SIZE_BYTES) mutable std::atomic<int64_t> m_ApproxValue = 0; // 近似值缓存
+        mutable std::atomic<long> m_ApproxTime = 0;                                   // 近似值刷新时间
+    };
+}
@@ -0,0 +1,227 @@
+#pragma once
+#include <cassert>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <sched.h>
+#include "Common/Clock.h"
+#include "Common/AtomicSequence.h"
+
+// 分片限流器
+// 令牌桶按CPU拆分为多个分片, 各线程优先从所在CPU的分片取令牌, 避免所有线程争抢同一个计数器.
+// 补充令牌使用单调时钟 + CAS, 无锁; 本分片令牌耗尽时从其他分片借用, 补充时也会把多余令牌分给其他分片.
+// acquire 在没有令牌时睡眠到下一个令牌产生, 不会空转占用CPU.
+// cache 为 0 时按 1 处理: 容量为 0 的桶永远取不到令牌, pass 会一直阻塞.
+//
+// ShardedRateLimiter r(100, 100);
+// r.pass();
+// r.try_pass();
+// r.acquire(10);
+class ShardedRateLimiter
+{
+    static constexpr long NS_PER_SECOND = 1000000000;
+    static constexpr long NS_PER_MS = 1000000;
+    static constexpr size_t MAX_SHARD_NUM = 64;
+    static constexpr long MAX_PARK_NS = 10 * NS_PER_MS; // 单次最长睡眠时间
+
+    struct alignas(CACHELINE_SIZE_BYTES) Shard
+    {
+        std::atomic<int64_t> tokens = 0; // 剩下的token数
+        int64_t capacity = 0;            // 分片容量
+    };
+
+public:
+    ShardedRateLimiter(const int64_t qps, const int64_t cache)
+        : m_CacheSize(std::max<int64_t>(cache, 1)),
+          m_SupplyUnitTime(NS_PER_SECOND / qps)
+    {
+        assert(qps <= NS_PER_SECOND);
+        assert(qps > 0);
+        assert(cache >= 0);
+
+        // 分片数取2的幂, 不超过CPU核数和桶大小, 保证每个分片至少有1个令牌容量
+        size_t limit = std::min<size_t>(std::thread::hardware_concurrency(), MAX_SHARD_NUM);
+        limit = std::min<size_t>(limit, m_CacheSize);
+        m_ShardNum = 1;
+        while (m_ShardNum * 2 <= limit)
+        {
+            m_ShardNum *= 2;
+        }
+        m_ShardMask = m_ShardNum - 1;
+
+        m_Shards.reset(new Shard[m_ShardNum]);
+        for (size_t idx = 0; idx < m_ShardNum; idx++)
+        {
+            m_Shards[idx].capacity = m_CacheSize / m_ShardNum + ((int64_t)idx < m_CacheSize % (int64_t)m_ShardNum ? 1 : 0);
+        }
+
+        m_LastAddTokenTime.store(Common::mono_ns());
+    }
+
+    ShardedRateLimiter(const ShardedRateLimiter &) = delete;
+    ShardedRateLimiter(ShardedRateLimiter &&) = delete;
+    ShardedRateLimiter &operator=(const ShardedRateLimiter &) = delete;
+
+    // 对外接口，能返回true说明流量在限定值内, 阻塞直到获得令牌
+    bool pass()
+    {
+        return acquire(-1);
+    }
+
+    bool try_pass(const int try_times = 1)
+    {
+        for (int i = 0; i < try_times; ++i)
+        {
+            if (tryGetToken())
+            {
+                return true;
+            }
+            std::this_thread::yield();
+        }
+        return false;
+    }
+
+    // 阻塞获得令牌, 没有令牌时睡眠等待
+    // [in] timeout_ms: 最长等待时间, 小于0表示一直等待
+    bool acquire(const long timeout_ms = -1)
+    {
+        if (tryGetToken())
+        {
+            return true;
+        }
+
+        const long deadline = timeout_ms >= 0 ? Common::mono_ns() + timeout_ms * NS_PER_MS : 0;
+        for (;;)
+        {
+            long cur = Common::mono_ns();
+            if (timeout_ms >= 0 && cur >= deadline)
+            {
+                return false;
+            }
+
+            // 睡眠到下一个令牌产生的时间
+            long park = m_LastAddTokenTime.load(std::memory_order_relaxed) + m_SupplyUnitTime - cur;
+            park = std::max(park, 1000L);
+            park = std::min(park, MAX_PARK_NS);
+            if (timeout_ms >= 0)
+            {
+                park = std::min(park, deadline - cur);
+            }
+            std::this_thread::sleep_for(std::chrono::nanoseconds(park));
+
+            if (tryGetToken())
+            {
+                return true;
+            }
+        }
+    }
+
+private:
+    // 当前线程所在CPU对应的分片
+    size_t shardIndex() const
+    {
+        int cpu = sched_getcpu();
+        if (cpu < 0)
+        {
+            static std::atomic<size_t> next = 0;
+            thread_local size_t idx = next.fetch_add(1);
+            return idx & m_ShardMask;
+        }
+        return (size_t)cpu & m_ShardMask;
+    }
+
+    // 从分片取一个令牌, 先读再CAS, 令牌耗尽时不写缓存行
+    static bool takeToken(Shard &shard)
+    {
+        int64_t token = shard.tokens.load(std::memory_order_relaxed);
+        while (token > 0)
+        {
+            if (shard.tokens.compare_exchange_weak(token, token - 1, std::memory_order_acquire))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 向分片补充令牌, 返回实际补充的数量
+    static int64_t addTokens(Shard &shard, const int64_t num)
+    {
+        int64_t token = shard.tokens.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            int64_t add = std::min(num, shard.capacity - token);
+            if (add <= 0)
+            {
+                return 0;
+            }
+            if (shard.tokens.compare_exchange_weak(token, token + add, std::memory_order_release))
+            {
+                return add;
+            }
+        }
+    }
+
+    // 更新令牌桶中的令牌, 只有CAS成功的线程负责补充
+    void supplyTokens(const size_t home)
+    {
+        auto cur = Common::mono_ns();
+        int64_t last = m_LastAddTokenTime.load(std::memory_order_relaxed);
+        if (cur - last < m_SupplyUnitTime)
+        {
+            return;
+        }
+
+        int64_t newTokens = (cur - last) / m_SupplyUnitTime;
+
+        // 更新令牌补充时间, 不能直接=cur, 否则会导致时间丢失
+        if (!m_LastAddTokenTime.compare_exchange_strong(last, last + newTokens * m_SupplyUnitTime))
+        {
+            return;
+        }
+
+        // 先补充本分片, 剩余令牌依次分给其他分片, 桶满后多余令牌丢弃
+        newTokens = std::min(newTokens, m_CacheSize);
+        for (size_t i = 0; i < m_ShardNum && newTokens > 0; ++i)
+        {
+            newTokens -= addTokens(m_Shards[(home + i) & m_ShardMask], newTokens);
+        }
+    }
+
+    // 尝试获得令牌
+    bool tryGetToken()
+    {
+        const size_t home = shardIndex();
+        if (takeToken(m_Shards[home]))
+        {
+            return true;
+        }
+
+        supplyTokens(home);
+        if (takeToken(m_Shards[home]))
+        {
+            return true;
+        }
+
+        // 本分片耗尽, 从其他分片借用
+        for (size_t i = 1; i < m_ShardNum; ++i)
+        {
+            if (takeToken(m_Shards[(home + i) & m_ShardMask]))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    const int64_t m_CacheSize;      // 令牌桶大小
+    const int64_t m_SupplyUnitTime; // 补充令牌的单位时间
+    size_t m_ShardNum;              // 分片数量
+    size_t m_ShardMask;             // 分片掩码
+    std::unique_ptr<Shard[]> m_Shards;
+
+    alignas(CACHELINE_SIZE_BYTES) std::atomic<int64_t> m_LastAddTokenTime; // 上次补充令牌的时间，单调时钟纳秒
+};
@@ -0,0 +1,429 @@
+#pragma once
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <condition_variable>
+#include "Common/Clock.h"
+
+// 启动编排
+// 各组件声明依赖关系, 没有依赖关系的组件并行初始化, 缩短服务冷启动时间.
+// 依赖的组件全部成功后才会开始初始化, 依赖失败时跳过.
+// 所有必需组件成功后进入就绪状态, 健康检查/注册上线可以通过 IsReady/WaitReady 判断.
+//
+// Example:
+// Common::Startup startup;
+// startup.Add("ModelConfig", []() { return ModelConfig::GetInstance()->Init(path); });
+// startup.Add("SENetConfig", []() { return SENetConfig::GetInstance()->Init(path); });
+// startup.Add("HTTPClient", []() { return HTTPClient::GetInstance()->Init(); });
+// startup.Add("Cache", []() { return cache.Init(param) == Common::OK; }, {"ModelConfig"});
+// startup.Add("Kafka", []() { return kafka_pool.Init(2, conf); }, {}, false); // 非必需
+// startup.Add("Register", []() { return RegisterCenter::GetInstance()->Init(...); }, {"Cache", "HTTPClient"});
+// bool succ = startup.Run(4);
+// LOG(INFO) << startup.Report();
+namespace Common
+{
+    class Startup
+    {
+    public:
+        using InitFunc = std::function<bool()>;
+
+        enum class Status
+        {
+            Pending = 0, // 未开始
+            Running = 1, // 初始化中
+            Succ = 2,    // 成功
+            Failed = 3,  // 失败
+            Skipped = 4, // 依赖失败, 跳过
+        };
+
+        // 组件耗时统计
+        struct Timing
+        {
+            std::string name;
+            Status status = Status::Pending;
+            bool required = true;
+            long start_ms = 0; // 相对 Run 开始的时间
+            long cost_ms = 0;
+        };
+
+    public:
+        Startup() {}
+        Startup(const Startup &) = delete;
+        Startup &operator=(const Startup &) = delete;
+
+        // 添加组件, Run 之前调用
+        // [in] name: 组件名称, 不能重复
+        // [in] func: 初始化函数, 返回是否成功
+        // [in] depends: 依赖的组件名称
+        // [in] required: 是否必需, 非必需组件失败不影响就绪状态
+        bool Add(
+            const std::string &name,
+            const InitFunc &func,
+            const std::vector<std::string> &depends = {},
+            const bool required = true)
+        {
+            if (m_started || name.empty() || func == nullptr || m_mapIndex.count(name) > 0)
+            {
+                return false;
+            }
+
+            Component component;
+            component.func = func;
+            component.depends = depends;
+            component.timing.name = name;
+            component.timing.required = required;
+            m_mapIndex[name] = m_vecComponent.size();
+            m_vecComponent.emplace_back(std::move(component));
+            return true;
+        }
+
+        // 并行初始化所有组件, 阻塞到全部结束
+        // [in] max_parallel: 最大并行数
+        // 返回所有必需组件是否初始化成功; 依赖不存在或存在环时不执行任何初始化, 返回 false
+        bool Run(const int max_parallel = 4)
+        {
+            if (m_started.exchange(true))
+            {
+                return false;
+            }
+
+            if (!BuildGraph())
+            {
+                Finish(false);
+                return false;
+            }
+
+            m_beginMs = mono_ms();
+            for (size_t idx = 0; idx < m_vecComponent.size(); idx++)
+            {
+                if (m_vecComponent[idx].waiting == 0)
+                {
+                    m_readyQueue.emplace_back(idx);
+                }
+            }
+
+            std::vector<std::thread> vecThread;
+            const int thread_num = std::max(1, std::min<int>(max_parallel, m_vecComponent.size()));
+            for (int idx = 0; idx < thread_num; idx++)
+            {
+                vecThread.emplace_back(&Startup::WorkerFunc, this);
+            }
+            for (auto &thread : vecThread)
+            {
+                thread.join();
+            }
+            m_totalMs = mono_ms() - m_beginMs;
+
+            bool succ = true;
+            for (const auto &component : m_vecComponent)
+            {
+                if (component.timing.required && component.timing.status != Status::Succ)
+                {
+                    succ = false;
+                }
+            }
+            Finish(succ);
+            return succ;
+        }
+
+        // 就绪门: 所有必需组件初始化成功
+        bool IsReady() const noexcept
+        {
+            return m_ready.load();
+        }
+
+        // 等待 Run 结束, 返回是否就绪
+        // [in] timeout_ms: 超时时间, <= 0 表示一直等待
+        bool WaitReady(const int timeout_ms = 0)
+        {
+            std::unique_lock<std::mutex> ul(m_finishMutex);
+            if (timeout_ms <= 0)
+            {
+                m_finishCond.wait(ul, [this]()
+                                  { return m_finished; });
+            }
+            else
+            {
+                m_finishCond.wait_for(ul, std::chrono::milliseconds(timeout_ms), [this]()
+                                      { return m_finished; });
+            }
+            return m_ready.load();
+        }
+
+        // 依赖检查失败原因
+        const std::string &GetError() const noexcept
+        {
+            return m_error;
+        }
+
+        // 各组件耗时, Run 结束后调用
+        const std::vector<Timing> GetTiming() const
+        {
+            std::vector<Timing> vecTiming;
+            for (const auto &component : m_vecComponent)
+            {
+                vecTiming.emplace_back(component.timing);
+            }
+            return vecTiming;
+        }
+
+        // 耗时报告, Run 结束后调用
+        // 包含总耗时, 串行耗时之和, 关键路径(决定总耗时的依赖链)与各组件明细
+        const std::string Report() const
+        {
+            long serial_ms = 0;
+            for (const auto &component : m_vecComponent)
+            {
+                serial_ms += component.timing.cost_ms;
+            }
+
+            std::ostringstream oss;
+            oss << "Startup Report: total = " << m_totalMs << "ms"
+                << ", serial = " << serial_ms << "ms"
+                << ", critical path = " << CriticalPath()
+                << ", ready = " << (m_ready ? "true" : "false");
+
+            std::vector<const Component *> vecSorted;
+            for (const auto &component : m_vecComponent)
+            {
+                vecSorted.emplace_back(&component);
+            }
+            std::stable_sort(vecSorted.begin(), vecSorted.end(),
+                             [](const Component *a, const Component *b)
+                             { return a->timing.start_ms < b->timing.start_ms; });
+            for (const auto component : vecSorted)
+            {
+                const auto &timing = component->timing;
+                oss << "\n  " << std::left << std::setw(24) << timing.name
+                    << " " << std::setw(8) << StatusName(timing.status)
+                    << " start = " << std::setw(6) << timing.start_ms
+                    << " cost = " << timing.cost_ms
+                    << (timing.required ? "" : " (optional)");
+            }
+            return oss.str();
+        }
+
+        static const char *StatusName(const Status status)
+        {
+            switch (status)
+            {
+            case Status::Pending:
+                return "Pending";
+            case Status::Running:
+                return "Running";
+            case Status::Succ:
+                return "Succ";
+            case Status::Failed:
+                return "Failed";
+            case Status::Skipped:
+                return "Skipped";
+            }
+            return "Unknown";
+        }
+
+    private:
+        struct Component
+        {
+            InitFunc func;
+            std::vector<std::string> depends;
+            std::vector<size_t> dependents; // 依赖当前组件的组件
+            size_t waiting = 0;             // 未完成的依赖数量
+            bool depend_failed = false;     // 有依赖失败
+            Timing timing;
+        };
+
+        // 解析依赖, 检查依赖是否存在及是否有环
+        bool BuildGraph()
+        {
+            for (size_t idx = 0; idx < m_vecComponent.size(); idx++)
+            {
+                auto &component = m_vecComponent[idx];
+                for (const auto &depend : component.depends)
+                {
+                    auto iter = m_mapIndex.find(depend);
+                    if (iter == m_mapIndex.end() || iter->second == idx)
+                    {
+                        m_error = "component " + component.timing.name + " depends on unknown component " + depend;
+                        return false;
+                    }
+                    m_vecComponent[iter->second].dependents.emplace_back(idx);
+                    component.waiting++;
+                }
+            }
+
+            // 拓扑排序检查环
+            std::vector<size_t> vecWaiting;
+            std::vector<size_t> vecQueue;
+            for (size_t idx = 0; idx < m_vecComponent.size(); idx++)
+            {
+                vecWaiting.emplace_back(m_vecComponent[idx].waiting);
+                if (vecWaiting[idx] == 0)
+                {
+                    vecQueue.emplace_back(idx);
+                }
+            }
+            for (size_t pos = 0; pos < vecQueue.size(); pos++)
+            {
+                for (auto dependent : m_vecComponent[vecQueue[pos]].dependents)
+                {
+                    if (--vecWaiting[dependent] == 0)
+                    {
+                        vecQueue.emplace_back(dependent);
+                    }
+                }
+            }
+            if (vecQueue.size() != m_vecComponent.size())
+            {
+                m_error = "component dependency cycle detected";
+                return false;
+            }
+            return true;
+        }
+
+        void WorkerFunc()
+        {
+            std::unique_lock<std::mutex> ul(m_mutex);
+            while (true)
+            {
+                m_cond.wait(ul, [this]()
+                            { return !m_readyQueue.empty() || m_done == m_vecComponent.size(); });
+                if (m_readyQueue.empty())
+                {
+                    return;
+                }
+
+                const size_t idx = m_readyQueue.front();
+                m_readyQueue.erase(m_readyQueue.begin());
+                auto &component = m_vecComponent[idx];
+
+                Status status = Status::Skipped;
+                component.timing.start_ms = mono_ms() - m_beginMs;
+                if (!component.depend_failed)
+                {
+                    component.timing.status = Status::Running;
+                    ul.unlock();
+                    status = CallInit(component.func) ? Status::Succ : Status::Failed;
+                    ul.lock();
+                }
+                component.timing.cost_ms = mono_ms() - m_beginMs - component.timing.start_ms;
+                component.timing.status = status;
+
+                // 通知依赖当前组件的组件
+                for (auto dependent : component.dependents)
+                {
+                    auto &next = m_vecComponent[dependent];
+                    next.depend_failed = next.depend_failed || status != Status::Succ;
+                    if (--next.waiting == 0)
+                    {
+                        m_readyQueue.emplace_back(dependent);
+                    }
+                }
+                m_done++;
+                m_cond.notify_all();
+            }
+        }
+
+        static bool CallInit(const InitFunc &func)
+        {
+            try
+            {
+                return func();
+            }
+            catch (...)
+            {
+                return false;
+            }
+        }
+
+        void Finish(const bool ready)
+        {
+            {
+                std::lock_guard<std::mutex> lg(m_finishMutex);
+                m_ready = ready;
+                m_finished = true;
+            }
+            m_finishCond.notify_all();
+        }
+
+        // 关键路径: 按依赖关系累加耗时最长的一条链
+        const std::string CriticalPath() const
+        {
+            const size_t size = m_vecComponent.size();
+            std::vector<long> vecFinish(size, -1);
+            std::vector<long> vecPrev(size, -1);
+            std::function<long(size_t)> finish = [&](size_t idx) -> long
+            {
+                if (vecFinish[idx] >= 0)
+                {
+                    return vecFinish[idx];
+                }
+                long begin = 0;
+                for (const auto &depend : m_vecComponent[idx].depends)
+                {
+                    const size_t depend_idx = m_mapIndex.at(depend);
+                    const long depend_finish = finish(depend_idx);
+                    if (vecPrev[idx] < 0 || depend_finish > begin)
+                    {
+                        begin = depend_finish;
+                        vecPrev[idx] = depend_idx;
+                    }
+                }
+                return vecFinish[idx] = begin + m_vecComponent[idx].timing.cost_ms;
+            };
+
+            if (size == 0 || !m_error.empty())
+            {
+                return m_error;
+            }
+
+            size_t last = 0;
+            for (size_t idx = 0; idx < size; idx++)
+            {
+                if (finish(idx) > finish(last))
+                {
+                    last = idx;
+                }
+            }
+
+            std::vector<std::string> vecPath;
+            for (long idx = last; idx >= 0; idx = vecPrev[idx])
+            {
+                vecPath.emplace_back(m_vecComponent[idx].timing.name);
+            }
+            std::string path;
+            for (auto iter = vecPath.rbegin(); iter != vecPath.rend(); iter++)
+            {
+                path.append(path.empty() ? "" : " -> ").append(*iter);
+            }
+            return path + " (" + std::to_string(vecFinish[last]) + "ms)";
+        }
+
+    private:
+        std::vector<Component> m_vecComponent;
+        std::unordered_map<std::string, size_t> m_mapIndex;
+        std::string m_error; // 依赖检查错误
+
+        std::atomic<bool> m_started = false;
+        long m_beginMs = 0;
+        long m_totalMs = 0;
+
+        // 调度
+        std::mutex m_mutex;
+        std::condition_variable m_cond;
+        std::vector<size_t> m_readyQueue;
+        size_t m_done = 0;
+
+        // 就绪门
+        std::mutex m_finishMutex;
+        std::condition_variable m_finishCond;
+        bool m_finished = false;
+        std::atomic<bool> m_ready = false;
+    };
+}
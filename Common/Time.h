@@ -2,8 +2,21 @@
 #pragma once
 #include <string>
 #include <sys/time.h>
+#include <time.h>
 namespace Common
 {
+    // 获取单调时钟纳秒数, 不受系统时间调整影响, 只能用于计算时间间隔
+    inline long get_mono_ns() noexcept
+    {
+        constexpr long NS_PER_SECOND = 1000000000;
+        struct timespec ts;
+        if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+        {
+            return ts.tv_sec * NS_PER_SECOND + ts.tv_nsec;
+        }
+        return 0;
+    }
+
     // 获取当前时间戳
     inline double get_ms_time() noexcept
     {
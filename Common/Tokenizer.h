@@ -0,0 +1,211 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <charconv>
+#include <type_traits>
+#include <string_view>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// 零分配的字符串切分与数值解析
+// SplitString 每行返回 vector<string>, 再用 atof/atol 解析, 每个字段都有一次分配和拷贝;
+// 这里全部基于 std::string_view, 切分结果指向原数据, 数值使用 std::from_chars 直接从 string_view 解析.
+//
+// Example:
+// std::vector<std::string_view> vecField;
+// Common::SplitView(line, ' ', vecField);  // vecField 可复用, 容量足够后不再分配
+// long index = 0;
+// if (!Common::ParseNumber(vecField[0], index)) { ... }
+//
+// Common::Tokenizer tokenizer(line, ' ');
+// std::string_view token;
+// while (tokenizer.next(token)) { ... }
+namespace Common
+{
+    // 查找字符, 返回位置, 找不到返回 end
+    // 模型文件的字段通常只有十几个字节, memchr 的函数调用与对齐处理开销占比很高,
+    // 支持 SSE2 时每次比较16字节并内联展开, 否则退化为 memchr.
+    inline const char *FindChar(const char *begin, const char *end, const char c) noexcept
+    {
+#if defined(__SSE2__)
+        const __m128i target = _mm_set1_epi8(c);
+        while (end - begin >= 16)
+        {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+            const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, target));
+            if (mask != 0)
+            {
+                return begin + __builtin_ctz(mask);
+            }
+            begin += 16;
+        }
+        while (begin < end && *begin != c)
+        {
+            begin++;
+        }
+        return begin;
+#else
+        const void *pos = memchr(begin, c, end - begin);
+        return pos == nullptr ? end : static_cast<const char *>(pos);
+#endif
+    }
+
+    inline size_t FindChar(std::string_view str, const char c, const size_t pos = 0) noexcept
+    {
+        if (pos >= str.size())
+        {
+            return std::string_view::npos;
+        }
+        const char *end = str.data() + str.size();
+        const char *found = FindChar(str.data() + pos, end, c);
+        return found == end ? std::string_view::npos : found - str.data();
+    }
+
+    // 逐个取出字段, 语义与 SplitString 一致: 连续分隔符产生空字段, 空字符串产生一个空字段
+    class Tokenizer
+    {
+    public:
+        Tokenizer(std::string_view str, const char sep) noexcept
+            : m_cur(str.data()), m_end(str.data() + str.size()), m_sep(sep) {}
+
+        // 取下一个字段, 没有字段时返回 false
+        bool next(std::string_view &token) noexcept
+        {
+            if (m_done)
+            {
+                return false;
+            }
+            const char *pos = FindChar(m_cur, m_end, m_sep);
+            token = std::string_view(m_cur, pos - m_cur);
+            if (pos == m_end)
+            {
+                m_done = true;
+            }
+            else
+            {
+                m_cur = pos + 1;
+            }
+            return true;
+        }
+
+        // 未取出的剩余部分
+        std::string_view rest() const noexcept
+        {
+            return m_done ? std::string_view() : std::string_view(m_cur, m_end - m_cur);
+        }
+
+    private:
+        const char *m_cur;
+        const char *m_end;
+        const char m_sep;
+        bool m_done = false;
+    };
+
+    // 切分字符串, 返回字段数
+    // [in] str: 源字符串, 结果指向其内部, 需保证 str 的数据在使用期间有效
+    // [in] sep: 分隔符
+    // [out] vecField: 切分结果, 会先清空, 容量复用
+    inline size_t SplitView(std::string_view str, const char sep, std::vector<std::string_view> &vecField)
+    {
+        vecField.clear();
+        Tokenizer tokenizer(str, sep);
+        std::string_view token;
+        while (tokenizer.next(token))
+        {
+            vecField.emplace_back(token);
+        }
+        return vecField.size();
+    }
+
+    // 去掉行尾的 '\r', 兼容 Windows 换行的文件
+    inline std::string_view StripCR(std::string_view line) noexcept
+    {
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.remove_suffix(1);
+        }
+        return line;
+    }
+
+    namespace detail
+    {
+        // 拷贝到栈上用 strtod 解析, 用于旧版本标准库及 from_chars 超出范围的情况
+        inline bool ParseDoubleStrtod(std::string_view str, double &value) noexcept
+        {
+            char buffer[64];
+            if (str.size() >= sizeof(buffer))
+            {
+                return false;
+            }
+            memcpy(buffer, str.data(), str.size());
+            buffer[str.size()] = '\0';
+            char *ptr = nullptr;
+            value = strtod(buffer, &ptr);
+            return ptr == buffer + str.size();
+        }
+    }
+
+    // 解析数值, 整个字符串都必须是合法数值, 失败时不修改 value
+    // 与 atoi/atof 不同, 空字符串/非法字符/整数溢出都会返回 false, 便于加载时校验数据.
+    // 浮点数先按 double 解析再转换, 与 atof 一致, 超出范围的值得到 0 或 inf 而不是失败.
+    // 允许前导 '+', 不允许前后空白.
+    template <typename T>
+    inline bool ParseNumber(std::string_view str, T &value) noexcept
+    {
+        static_assert(std::is_arithmetic<T>::value, "ParseNumber requires arithmetic type");
+        if (!str.empty() && str.front() == '+')
+        {
+            str.remove_prefix(1);
+            if (!str.empty() && str.front() == '-')
+            {
+                return false;
+            }
+        }
+        if (str.empty())
+        {
+            return false;
+        }
+
+        const char *end = str.data() + str.size();
+        if constexpr (std::is_integral<T>::value)
+        {
+            T result = 0;
+            auto [ptr, ec] = std::from_chars(str.data(), end, result);
+            if (ec != std::errc() || ptr != end)
+            {
+                return false;
+            }
+            value = result;
+        }
+        else
+        {
+            double result = 0;
+#if defined(__cpp_lib_to_chars) || (defined(_GLIBCXX_RELEASE) && _GLIBCXX_RELEASE >= 11)
+            auto [ptr, ec] = std::from_chars(str.data(), end, result);
+            if (ptr != end || (ec != std::errc() && (ec != std::errc::result_out_of_range || !detail::ParseDoubleStrtod(str, result))))
+            {
+                return false;
+            }
+#else
+            if (!detail::ParseDoubleStrtod(str, result))
+            {
+                return false;
+            }
+#endif
+            value = static_cast<T>(result);
+        }
+        return true;
+    }
+
+    // 解析数值, 失败返回默认值
+    template <typename T>
+    inline T ToNumber(std::string_view str, const T default_value = T()) noexcept
+    {
+        T value = default_value;
+        ParseNumber(str, value);
+        return value;
+    }
+}
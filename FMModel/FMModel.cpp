@@ -1,52 +1,50 @@
 #include "FMModel.h"
 #include <cmath>
-#include "Common/Function.h"
+#include "Common/Tokenizer.h"
+#include "Common/MappedFile.h"
 #include "glog/logging.h"
 
 bool DBufFMModelData::Init(int num_factor, const std::string &model_file_path)
 {
-    m_dataIdx = 1;
-    m_modelData[0].m_numFactor = num_factor;
-    m_modelData[1].m_numFactor = num_factor;
     return LoadModelFile(num_factor, model_file_path);
 }
 
 //加载模型文件
 bool DBufFMModelData::LoadModelFile(int num_factor, const std::string &model_file_path)
 {
-    std::string buffer;
-    if (true == Common::FastReadFile(model_file_path, buffer, false))
+    Common::MappedFile file;
+    if (true == file.Open(model_file_path))
     {
-        return LoadModelBuffer(num_factor, buffer);
+        return LoadModelBuffer(num_factor, file.data());
     }
     else
     {
-        LOG(ERROR) << "DBufFMModelData::LoadModelFile FastReadFile Failed"
+        LOG(ERROR) << "DBufFMModelData::LoadModelFile MappedFile Open Failed"
                    << ", num_factor = " << num_factor
                    << ", model_file_path = " << model_file_path;
     }
     return false;
 }
 
-bool DBufFMModelData::LoadModelBuffer(int num_factor, const std::string &buffer)
+bool DBufFMModelData::LoadModelBuffer(int num_factor, std::string_view buffer)
 {
-    int dataIdx = (m_dataIdx + 1) % 2;
-    auto &data = m_modelData[dataIdx];
+    auto spData = std::make_shared<FMModelData>();
+    auto &data = *spData;
 
-    std::string line;
-    std::stringstream ss(buffer);
-
-    if (!getline(ss, line, '\n'))
+    Common::LineRange lines(buffer);
+    auto iter = lines.begin();
+    if (iter == lines.end())
     {
-        LOG(ERROR) << "DBufFMModelData::LoadModelBuffer Failed, getline line = " << line;
+        LOG(ERROR) << "DBufFMModelData::LoadModelBuffer Failed, buffer empty";
         return false;
     }
 
     size_t tmpSize = (3 * num_factor + 4);
-    std::vector<std::string> strVec;
+    std::vector<std::string_view> strVec;
     strVec.reserve(tmpSize);
 
-    Common::SplitString(line, ' ', strVec);
+    std::string_view line = Common::StripCR(*iter);
+    Common::SplitView(line, ' ', strVec);
     if (strVec.size() != 4)
     {
         LOG(ERROR) << "DBufFMModelData::LoadModelBuffer Failed, getline strVec.size() != 4, strVec.size() = " << strVec.size();
@@ -54,15 +52,16 @@ bool DBufFMModelData::LoadModelBuffer(int num_factor, const std::string &buffer)
     }
 
     data.m_numFactor = num_factor;
-    data.m_w0 = std::atof(strVec[1].c_str());
+    if (!Common::ParseNumber(strVec[1], data.m_w0))
+    {
+        LOG(ERROR) << "DBufFMModelData::LoadModelBuffer Failed, w0 invalid, line = " << line;
+        return false;
+    }
 
-    // 清理一下数据, 不然可能会有上次留下来的脏数据
-    data.m_w1.clear();
-    data.m_w2.clear();
-    while (getline(ss, line, '\n'))
+    for (++iter; iter != lines.end(); ++iter)
     {
-        strVec.clear();
-        Common::SplitString(line, ' ', strVec);
+        line = Common::StripCR(*iter);
+        Common::SplitView(line, ' ', strVec);
         if (strVec.size() != tmpSize)
         {
             LOG(ERROR) << "DBufFMModelData::LoadModelBuffer Failed, getline strVec.size() != tmpSize"
@@ -71,19 +70,24 @@ bool DBufFMModelData::LoadModelBuffer(int num_factor, const std::string &buffer)
             return false;
         }
 
-        int index = std::atoi(strVec[0].c_str());
-        data.m_w1[index] = std::atof(strVec[1].c_str());
-
-        std::vector<score_type> tmp_w2_value;
-        tmp_w2_value.reserve(num_factor);
-        for (int i = 2, end = num_factor + 2; i < end; i++)
+        int index = 0;
+        score_type w1 = 0;
+        std::vector<score_type> tmp_w2_value(num_factor, 0);
+        bool valid = Common::ParseNumber(strVec[0], index) && Common::ParseNumber(strVec[1], w1);
+        for (int i = 0; valid && i < num_factor; i++)
+        {
+            valid = Common::ParseNumber(strVec[i + 2], tmp_w2_value[i]);
+        }
+        if (!valid)
         {
-            tmp_w2_value.emplace_back(std::atof(strVec[i].c_str()));
+            LOG(ERROR) << "DBufFMModelData::LoadModelBuffer Failed, number invalid, line = " << line;
+            return false;
         }
+        data.m_w1[index] = w1;
         data.m_w2[index] = std::move(tmp_w2_value);
     }
 
-    m_dataIdx = dataIdx;
+    std::atomic_store(&m_spModelData, std::shared_ptr<const FMModelData>(std::move(spData)));
     return true;
 }
 
@@ -115,16 +119,17 @@ bool FMModel::UpdateModel(int num_factor, const std::string &buffer)
 // [in] buffer: 模型文件内容
 bool FMModel::UpdateModel(const std::string &buffer)
 {
-    const auto &model_data = m_fmModelData.GetCurModelData();
-    return m_fmModelData.LoadModelBuffer(model_data.m_numFactor, buffer);
+    const auto spModelData = m_fmModelData.GetCurModelData();
+    return m_fmModelData.LoadModelBuffer(spModelData->m_numFactor, buffer);
 }
 
 // 预测函数(计算函数)
 score_type FMModel::predict(
     const VecRankFeature &x) const noexcept
 {
-    // 确定辅助空间大小
-    const auto &model_data = m_fmModelData.GetCurModelData();
+    // 确定辅助空间大小, 计算期间持有当前版本
+    const auto spModelData = m_fmModelData.GetCurModelData();
+    const auto &model_data = *spModelData;
     const int num_factor = model_data.m_numFactor;
     std::vector<score_type> tmp_vec_sum(num_factor, 0.0);
     std::vector<score_type> tmp_vec_sum_sqr(num_factor, 0.0);
@@ -1,41 +1,43 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
-#include <atomic>
+#include <memory>
 #include <unordered_map>
 
 using score_type = float;
 using VecRankFeature = std::vector<std::pair<int, score_type>>;
 
-//把模型数据抽象出来，实现双buffer
+//把模型数据抽象出来, 每次加载生成一份新的只读数据
 struct FMModelData
 {
-    int m_numFactor;
-    score_type m_w0;
+    int m_numFactor = 0;
+    score_type m_w0 = 0;
     std::unordered_map<int, score_type> m_w1;
     std::unordered_map<int, std::vector<score_type>> m_w2;
 };
 
+// 新数据加载到独立的 FMModelData 后整体替换指针, 预测线程持有自己取到的版本直到计算结束,
+// 不会像原来两块交替复用那样, 在下一次更新时读到正在被覆盖的数据
 struct DBufFMModelData
 {
 public:
-    DBufFMModelData() : m_dataIdx(0) {}
+    DBufFMModelData() : m_spModelData(std::make_shared<const FMModelData>()) {}
     bool Init(int num_factor, const std::string &model_file_path);
 
 public:
-    const FMModelData &GetCurModelData() const noexcept
+    std::shared_ptr<const FMModelData> GetCurModelData() const noexcept
     {
-        return m_modelData[m_dataIdx];
+        return std::atomic_load(&m_spModelData);
     }
 
 public:
     //加载模型文件
     bool LoadModelFile(int num_factor, const std::string &model_file_path);
-    bool LoadModelBuffer(int num_factor, const std::string &buffer);
+    bool LoadModelBuffer(int num_factor, std::string_view buffer);
 
 private:
-    FMModelData m_modelData[2];
-    std::atomic<int> m_dataIdx;
+    std::shared_ptr<const FMModelData> m_spModelData; // 经 std::atomic_load/atomic_store 读写
 };
 
 class FMModel final
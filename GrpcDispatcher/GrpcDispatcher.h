@@ -2,9 +2,11 @@
 #include <string>
 #include <unordered_map>
 #include <any>
-#include "Common/RateLimiter.h"
+#include "Common/ShardedRateLimiter.h"
+#include "Common/AdaptiveLimiter.h"
 #include "Common/DynamicThreadPool.h"
 #include "GrpcDispatcher/AsyncDefine.h"
+#include "GrpcDispatcher/RequestArena.h"
 #include "GrpcDispatcher/AsyncReceiver.h"
 
 using OnGrpcFunc = std::function<
@@ -22,7 +24,9 @@ public:
     int32_t cmd;
     std::any obj; // 传递的都是this指针, 故不存在值拷贝问题
     OnGrpcFunc func;
-    RateLimiter *p_rate_limiter; // 接口限速器
+    ShardedRateLimiter *p_rate_limiter; // 接口限速器
+    AdaptiveLimiter *p_adaptive_limiter; // 接口自适应并发限制器
+    bool request_arena;                  // 是否开启请求内存池
 };
 
 // 本类仅在注册时初始化命令信息列表, 无需加锁
@@ -41,17 +45,29 @@ public:
         const int cmd,
         OnGrpcFunc func,
         int64_t limit_qps = 0,
-        int64_t limit_cache = 0)
+        int64_t limit_cache = 0,
+        int max_concurrency = 0,
+        bool request_arena = false)
     {
         CmdInfo &info = cmd_info_list_[cmd];
         info.cmd = cmd;
         info.obj = obj;
         info.func = func;
 
+        // 开启后处理函数内默认构造的 RankItem 及 RequestArena::CreateMessage 创建的消息
+        // 从请求内存池分配, 不能在请求结束后继续持有
+        info.request_arena = request_arena;
+
         // 传0表示不限制QPS
         if (limit_qps > 0)
         {
-            info.p_rate_limiter = new RateLimiter(limit_qps, limit_cache);
+            info.p_rate_limiter = new ShardedRateLimiter(limit_qps, limit_cache);
+        }
+
+        // 传0表示不开启自适应并发限制, 否则并发上限在 [1, max_concurrency] 之间根据耗时自动调整
+        if (max_concurrency > 0)
+        {
+            info.p_adaptive_limiter = new AdaptiveLimiter(max_concurrency);
         }
     }
 
@@ -77,7 +93,20 @@ public:
                 return false;
             }
         }
-        return info.func(info.obj, info.cmd, deadline_ms, request, result, response);
+
+        if (info.p_adaptive_limiter != nullptr)
+        {
+            if (!info.p_adaptive_limiter->try_acquire())
+            {
+                result = GrpcProtos::ResultType::ERR_Rate_Limit;
+                response = "concurrency limit";
+                return false;
+            }
+
+            AdaptiveLimiterGuard guard(info.p_adaptive_limiter, Common::mono_ns(), deadline_ms);
+            return CallFunc(info, deadline_ms, request, result, response);
+        }
+        return CallFunc(info, deadline_ms, request, result, response);
     }
 
     // grpc 异步请求分发
@@ -118,14 +147,36 @@ public:
             }
         }
 
+        // 排队等待线程池的时间也计入耗时
+        if (info.p_adaptive_limiter != nullptr)
+        {
+            if (!info.p_adaptive_limiter->try_acquire())
+            {
+                int result = GrpcProtos::ResultType::ERR_Rate_Limit;
+                std::string response = "concurrency limit";
+
+                ResponseProto resp_proto;
+                resp_proto.set_cmd(cmd);
+                resp_proto.set_result(result);
+                resp_proto.set_response(std::move(response));
+                receiver->Response(resp_proto);
+                return false;
+            }
+        }
+        const long begin = Common::mono_ns();
+
         auto proc_func = [](const CmdInfo &info,
                             const long deadline_ms,
                             const std::string &request,
-                            AsyncReceiver *receiver)
+                            AsyncReceiver *receiver,
+                            const long begin)
         {
             int result = GrpcProtos::ResultType::ERR_Unknown;
             std::string response;
-            info.func(info.obj, info.cmd, deadline_ms, request, result, response);
+            {
+                AdaptiveLimiterGuard guard(info.p_adaptive_limiter, begin, deadline_ms);
+                CallFunc(info, deadline_ms, request, result, response);
+            }
 
             ResponseProto resp_proto;
             resp_proto.set_cmd(info.cmd);
@@ -133,10 +184,49 @@ public:
             resp_proto.set_response(std::move(response));
             receiver->Response(resp_proto);
         };
-        DynamicThreadPool::GetInstance()->Add(proc_func, info, deadline_ms, request, receiver);
+        DynamicThreadPool::GetInstance()->Add(proc_func, info, deadline_ms, request, receiver, begin);
         return true;
     }
 
 private:
+    // 自适应并发限制器名额, 析构时归还, 处理函数抛出异常时同样归还
+    // 请求结束时超过 deadline 视为过载信号
+    class AdaptiveLimiterGuard
+    {
+    public:
+        AdaptiveLimiterGuard(AdaptiveLimiter *limiter, const long begin, const long deadline_ms)
+            : limiter_(limiter), begin_(begin), deadline_ms_(deadline_ms) {}
+        AdaptiveLimiterGuard(const AdaptiveLimiterGuard &) = delete;
+        AdaptiveLimiterGuard &operator=(const AdaptiveLimiterGuard &) = delete;
+
+        ~AdaptiveLimiterGuard()
+        {
+            if (limiter_ != nullptr)
+            {
+                bool succ = Common::get_ms_timestamp() <= deadline_ms_;
+                limiter_->release(Common::mono_ns() - begin_, succ);
+            }
+        }
+
+    private:
+        AdaptiveLimiter *limiter_;
+        const long begin_;
+        const long deadline_ms_;
+    };
+
+    // 调用处理函数, 按需为本次请求设置内存池
+    static bool CallFunc(const CmdInfo &info, const long deadline_ms, const std::string &request,
+                         int &result, std::string &response)
+    {
+        if (!info.request_arena)
+        {
+            return info.func(info.obj, info.cmd, deadline_ms, request, result, response);
+        }
+
+        RequestArena arena;
+        Common::ArenaScope scope(&arena);
+        return info.func(info.obj, info.cmd, deadline_ms, request, result, response);
+    }
+
     std::unordered_map<int32_t, CmdInfo> cmd_info_list_; // 命令信息列表
 };
@@ -0,0 +1,33 @@
+#pragma once
+#include "google/protobuf/arena.h"
+#include "Common/Arena.h"
+
+// Grpc 请求内存池
+// 在 Common::MonotonicArena 基础上增加 protobuf Arena, 请求处理函数中的 protobuf 消息
+// 可以通过 CreateMessage 分配, 与 RankItem 等容器一起在请求结束时整体释放.
+//
+// Example:
+// auto arena = RequestArena::Current();
+// auto *msg = arena != nullptr ? arena->CreateMessage<Proto>() : &local_msg;
+class RequestArena final : public Common::MonotonicArena
+{
+public:
+    RequestArena() {}
+
+    // 当前线程正在处理的请求内存池, 没有时返回 nullptr
+    static RequestArena *Current() noexcept
+    {
+        return dynamic_cast<RequestArena *>(Common::CurrentArena());
+    }
+
+    google::protobuf::Arena *proto_arena() noexcept { return &m_protoArena; }
+
+    template <typename T>
+    T *CreateMessage()
+    {
+        return google::protobuf::Arena::CreateMessage<T>(&m_protoArena);
+    }
+
+private:
+    google::protobuf::Arena m_protoArena;
+};
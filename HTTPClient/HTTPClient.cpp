@@ -162,7 +162,7 @@ bool HTTPClient::add_post_request(
         return false;
     }
 
-    CURL *handle = curl_easy_init();
+    CURL *handle = create_post_handle(url, vecHeader, post_msg, timeout_ms, spResult.get());
     if (handle == nullptr)
     {
         spCode->set_value(CURLE_FAILED_INIT);
@@ -170,6 +170,68 @@ bool HTTPClient::add_post_request(
         return false;
     }
 
+    if (!add_wait_task(handle, timeout_ms, spCode, spResult))
+    {
+        spCode->set_value(CURLE_FAILED_INIT);
+        spResult->assign("add_wait_task failed");
+        return false;
+    }
+    return true;
+}
+
+bool HTTPClient::add_post_request(
+    const std::string &url,
+    const std::vector<std::string> vecHeader,
+    const std::string &post_msg,
+    const int timeout_ms,
+    HttpCallBackFunc func,
+    std::shared_ptr<std::string> &spResult)
+{
+    if (func == nullptr || spResult == nullptr)
+    {
+        return false;
+    }
+
+    if (!g_init)
+    {
+        spResult->assign("HTTPClient init failed");
+        return false;
+    }
+
+    CURL *handle = create_post_handle(url, vecHeader, post_msg, timeout_ms, spResult.get());
+    if (handle == nullptr)
+    {
+        spResult->assign("curl_easy_init failed");
+        return false;
+    }
+
+    auto spTaskData = std::make_shared<HttpTaskData>();
+    spTaskData->func = std::move(func);
+    spTaskData->spResult = spResult;
+    spTaskData->handle = handle;
+    spTaskData->ms_timestamp = Common::get_ms_timestamp() + timeout_ms;
+    if (!add_wait_task(spTaskData))
+    {
+        curl_easy_cleanup(handle);
+        spResult->assign("add_wait_task failed");
+        return false;
+    }
+    return true;
+}
+
+CURL *HTTPClient::create_post_handle(
+    const std::string &url,
+    const std::vector<std::string> &vecHeader,
+    const std::string &post_msg,
+    const int timeout_ms,
+    std::string *result)
+{
+    CURL *handle = curl_easy_init();
+    if (handle == nullptr)
+    {
+        return nullptr;
+    }
+
     // 请求头
     struct curl_slist *header_list = NULL;
     if (vecHeader.empty())
@@ -192,7 +254,7 @@ bool HTTPClient::add_post_request(
     curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE, post_msg.size());    // 设置要POST的JSON数据长度
     curl_easy_setopt(handle, CURLOPT_HTTPHEADER, this->header_list);     // 设置Header
     curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, curl_write_func);    // 处理返回数据函数
-    curl_easy_setopt(handle, CURLOPT_WRITEDATA, spResult.get());         // 接收返回数据参数
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, result);                 // 接收返回数据参数
     curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS, timeout_ms);            // 接收数据时超时设置
     curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1);                 // 返回头部有Location, 则继续请求Location对应的数据
     curl_easy_setopt(handle, CURLOPT_MAXREDIRS, 1);                      // 查找次数，防止查找太深
@@ -212,13 +274,7 @@ bool HTTPClient::add_post_request(
     curl_easy_setopt(handle, CURLOPT_MAXLIFETIME_CONN, 30L); // 重用缓存连接的最长时间, Curl-Ver 7.80.0
     curl_easy_setopt(handle, CURLOPT_MAXAGE_CONN, 30L);      // 连接处于空闲状态的最长时间, Curl-Ver 7.65.0
 
-    if (!add_wait_task(handle, timeout_ms, spCode, spResult))
-    {
-        spCode->set_value(CURLE_FAILED_INIT);
-        spResult->assign("add_wait_task failed");
-        return false;
-    }
-    return true;
+    return handle;
 }
 
 bool HTTPClient::add_wait_task(
@@ -236,14 +292,18 @@ bool HTTPClient::add_wait_task(
     spTaskData->spResult = spResult;
     spTaskData->handle = handle;
     spTaskData->ms_timestamp = Common::get_ms_timestamp() + timeout_ms;
+    return add_wait_task(spTaskData);
+}
 
+bool HTTPClient::add_wait_task(const SPHttpTaskData &spTaskData)
+{
     // 随机分配一个线程
     const int idx = rand() % ThreadCount;
 
     int cur_wait_count = 0;
     {
         std::lock_guard<std::mutex> lg(g_workThread[idx].wait_task_mutex);
-        g_workThread[idx].wait_task_queue.push(std::move(spTaskData));
+        g_workThread[idx].wait_task_queue.push(spTaskData);
         cur_wait_count = g_workThread[idx].wait_task_queue.size();
     }
 
@@ -293,8 +353,8 @@ int HTTPClient::add_request_task(
         auto &spTask = vec_wait_task[idx];
         if (cur_timestamp > spTask->ms_timestamp)
         {
-            spTask->spCode->set_value(CURLE_OPERATION_TIMEDOUT);
             curl_easy_cleanup(spTask->handle);
+            spTask->finish(CURLE_OPERATION_TIMEDOUT);
             continue;
         }
 
@@ -370,14 +430,21 @@ void HTTPClient::thread_work_func(const int thread_idx)
             // P.s> 这里说明可以在单次任务完成后添加新句柄
             if (msg->msg == CURLMSG_DONE)
             {
+                SPHttpTaskData spTask = nullptr;
                 auto it = map_running_task.find(msg->easy_handle);
                 if (it != map_running_task.end())
                 {
-                    it->second->spCode->set_value(msg->data.result);
+                    spTask = std::move(it->second);
                     map_running_task.erase(it);
                 }
                 curl_multi_remove_handle(multi_handle, msg->easy_handle);
                 curl_easy_cleanup(msg->easy_handle);
+
+                // 先释放句柄再通知, 回调返回后 post_msg 可能已被调用方释放
+                if (spTask != nullptr)
+                {
+                    spTask->finish(msg->data.result);
+                }
             }
             add_request_task(thread_idx, multi_handle, map_running_task);
         }
@@ -6,16 +6,34 @@
 #include <memory>
 #include <thread>
 #include <queue>
+#include <functional>
 #include <unordered_map>
 #include "Common/Singleton.h"
 #include "curl/curl.h"
 
+// 请求完成回调, 在HTTPClient工作线程中执行, 不能阻塞
+using HttpCallBackFunc = std::function<void(const int32_t code)>;
+
 struct HttpTaskData
 {
     CURL *handle = nullptr;
     std::shared_ptr<std::promise<int32_t>> spCode = nullptr;
+    HttpCallBackFunc func = nullptr; // spCode 与 func 二选一
     std::shared_ptr<std::string> spResult = nullptr;
     long ms_timestamp = 0; // 超时时间判断
+
+    // 通知请求结果
+    void finish(const int32_t code)
+    {
+        if (spCode != nullptr)
+        {
+            spCode->set_value(code);
+        }
+        if (func != nullptr)
+        {
+            func(code);
+        }
+    }
 };
 
 using SPHttpTaskData = std::shared_ptr<HttpTaskData>;
@@ -48,7 +66,24 @@ public:
         std::shared_ptr<std::promise<int32_t>> &spCode,
         std::shared_ptr<std::string> &spResult);
 
+    // 回调方式, 请求完成(成功/失败/超时)后在工作线程中调用 func
+    // 注意: post_msg 的生命周期必须覆盖到 func 被调用
+    bool add_post_request(
+        const std::string &url,
+        const std::vector<std::string> vecHeader,
+        const std::string &post_msg,
+        const int timeout_ms,
+        HttpCallBackFunc func,
+        std::shared_ptr<std::string> &spResult);
+
 protected:
+    CURL *create_post_handle(
+        const std::string &url,
+        const std::vector<std::string> &vecHeader,
+        const std::string &post_msg,
+        const int timeout_ms,
+        std::string *result);
+
     // 生产者 - grpc线程
     bool add_wait_task(
         CURL *handle,
@@ -56,6 +91,8 @@ protected:
         std::shared_ptr<std::promise<int32_t>> &spCode,
         std::shared_ptr<std::string> &spResult);
 
+    bool add_wait_task(const SPHttpTaskData &spTaskData);
+
     // 消费者 - 工作线程
     void thread_work_func(const int thread_idx);
 
@@ -0,0 +1,83 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include "Common/Coroutine.h"
+#include "HTTPClient/HTTPClient.h"
+
+// HTTPClient 协程接口, 需要 C++20
+// 请求由 HTTPClient 工作线程的 curl-multi 驱动, 完成后恢复等待的协程,
+// 等待期间不占用调用线程.
+//
+// Example:
+// Common::Task<void> Foo()
+// {
+//     std::string post_msg = "...";
+//     auto reply = co_await CoPostRequest(url, {}, post_msg, 300);
+//     if (reply.code == CURLE_OK) { ... reply.result ... }
+// }
+
+struct HttpCoReply
+{
+    int32_t code = CURLE_FAILED_INIT; // CURLcode
+    std::string result;               // 返回内容 Or 失败原因
+};
+
+class HttpPostAwaiter
+{
+public:
+    // post_msg 的生命周期必须覆盖 co_await 表达式
+    HttpPostAwaiter(
+        const std::string &url,
+        const std::vector<std::string> &vecHeader,
+        const std::string &post_msg,
+        const int timeout_ms)
+        : m_url(url), m_vecHeader(vecHeader), m_post_msg(post_msg), m_timeout_ms(timeout_ms),
+          m_spResult(std::make_shared<std::string>()) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> h)
+    {
+        m_handle = h;
+        m_scheduler = Common::CoScheduler::Current();
+        auto func = [this](const int32_t code)
+        {
+            m_code = code;
+            Common::CoResume(m_scheduler, m_handle);
+        };
+
+        // 加入失败时不挂起, 直接返回失败原因
+        // 加入成功后回调可能已在工作线程中执行, 不能再访问成员
+        return HTTPClient::GetInstance()->add_post_request(
+            m_url, m_vecHeader, m_post_msg, m_timeout_ms, func, m_spResult);
+    }
+
+    HttpCoReply await_resume()
+    {
+        HttpCoReply reply;
+        reply.code = m_code;
+        reply.result = std::move(*m_spResult);
+        return reply;
+    }
+
+private:
+    const std::string &m_url;
+    const std::vector<std::string> &m_vecHeader;
+    const std::string &m_post_msg;
+    const int m_timeout_ms;
+
+    int32_t m_code = CURLE_FAILED_INIT;
+    std::shared_ptr<std::string> m_spResult;
+    std::coroutine_handle<> m_handle = nullptr;
+    Common::CoScheduler *m_scheduler = nullptr;
+};
+
+inline HttpPostAwaiter CoPostRequest(
+    const std::string &url,
+    const std::vector<std::string> &vecHeader,
+    const std::string &post_msg,
+    const int timeout_ms)
+{
+    return HttpPostAwaiter(url, vecHeader, post_msg, timeout_ms);
+}
@@ -1,5 +1,6 @@
 #include "PrometheusClient.h"
 #include "Common/Function.h"
+#include "Common/Clock.h"
 #include "glog/logging.h"
 #include "assert.h"
 
@@ -24,7 +25,7 @@ void PrometheusReport::start(const std::string &path)
     {
         vec_call_path.emplace_back(vec_call_path.back() + "|" + path);
     }
-    vec_start_time.emplace_back(Common::get_ms_time());
+    vec_start_time.emplace_back(Common::mono_ns());
 }
 
 void PrometheusReport::end(const int32_t code)
@@ -34,13 +35,12 @@ void PrometheusReport::end(const int32_t code)
     assert(vec_call_path.size() == vec_start_time.size());
 
     const std::string &path = vec_call_path.back();
-    double start_time = vec_start_time.back();
-    double end_time = Common::get_ms_time();
+    double cost_ms = (Common::mono_ns() - vec_start_time.back()) * 1e-6;
 
     // 上报Prometheus
     auto prom_client = PrometheusClient::GetInstance();
     prom_client->cmd_counter_inc(path, code);
-    prom_client->cmd_durations_observer(path, end_time - start_time);
+    prom_client->cmd_durations_observer(path, cost_ms);
 
     vec_call_path.pop_back();
     vec_start_time.pop_back();
@@ -237,6 +237,11 @@ void PrometheusClient::ShutDown()
         m_pRoomCountFamily = nullptr;
         m_pInvertIndexCountFamily = nullptr;
 
+        {
+            std::unique_lock<Common::distributed_shared_mutex> lock(m_counterMutex);
+            m_cmdCounter.clear();
+        }
+
         m_spPushGateway = nullptr;
         m_spRegistry = nullptr;
 
@@ -248,11 +253,47 @@ void PrometheusClient::cmd_counter_inc(
     const std::string &path,
     const int32_t code)
 {
-    if (m_report && m_pCounterFamily != nullptr)
+    if (!m_report || m_pCounterFamily == nullptr)
+    {
+        return;
+    }
+
+    const std::string code_str = std::to_string(code);
+    std::string key;
+    key.reserve(path.size() + code_str.size() + 1);
+    key.append(path).append(1, '\x01').append(code_str);
+
+    {
+        std::shared_lock<Common::distributed_shared_mutex> lock(m_counterMutex);
+        auto iter = m_cmdCounter.find(key);
+        if (iter != m_cmdCounter.end())
+        {
+            iter->second->count.add(1);
+            return;
+        }
+    }
+
+    // 首次出现的 path + code, 创建计数器
+    std::unique_lock<Common::distributed_shared_mutex> lock(m_counterMutex);
+    auto &spCounter = m_cmdCounter[key];
+    if (spCounter == nullptr)
+    {
+        spCounter = std::make_unique<CmdCounter>();
+        spCounter->pCounter = &m_pCounterFamily->Add({{"path", path}, {"code", code_str}});
+    }
+    spCounter->count.add(1);
+}
+
+void PrometheusClient::FlushCounter()
+{
+    std::shared_lock<Common::distributed_shared_mutex> lock(m_counterMutex);
+    for (auto &[key, spCounter] : m_cmdCounter)
     {
-        m_pCounterFamily
-            ->Add({{"path", path}, {"code", std::to_string(code)}})
-            .Increment();
+        int64_t delta = spCounter->count.exchange();
+        if (delta > 0)
+        {
+            spCounter->pCounter->Increment(delta);
+        }
     }
 }
 
@@ -511,6 +552,7 @@ void PrometheusClient::TimerPushFunc()
                 {
                     task();
                 }
+                FlushCounter();
 
                 int push_code = m_spPushGateway->Push();
                 if (push_code != 200)
@@ -2,10 +2,15 @@
 #include <memory>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <atomic>
+#include <mutex>
+#include <shared_mutex>
 #include <thread>
 #include <functional>
 #include "Common/Singleton.h"
+#include "Common/Lock.h"
+#include "Common/ShardedCounter.h"
 
 namespace prometheus
 {
@@ -64,7 +69,7 @@ public:
 
 private:
     std::vector<std::string> vec_call_path;
-    std::vector<double> vec_start_time;
+    std::vector<long> vec_start_time; // 单调时钟纳秒
 };
 
 using PrometheusReportPtr = std::shared_ptr<PrometheusReport>;
@@ -136,6 +141,7 @@ public:
 protected:
     bool ProcPidStat();   // 进程状态获取函数
     bool ProcPidFd();     // 进程Fd获取函数
+    void FlushCounter();  // 本地计数写入 prometheus::Counter
     void TimerPushFunc(); // 定时推送函数
 
 private:
@@ -158,6 +164,16 @@ private:
     prometheus::HistogramFamily *m_pHistogramFamily; // 直方图
     prometheus::SummaryFamily *m_pSummaryFamily;     // 采样点分位图
 
+    // CMD请求次数先累加到本地分片计数器, Push 前再写入 prometheus::Counter,
+    // 避免热点路径上每次都查找 Family 并争抢同一个 Counter
+    struct CmdCounter
+    {
+        Common::ShardedCounter count;
+        prometheus::Counter *pCounter = nullptr;
+    };
+    Common::distributed_shared_mutex m_counterMutex;
+    std::unordered_map<std::string, std::unique_ptr<CmdCounter>> m_cmdCounter; // key: path + \x01 + code
+
     // 采集机器信息
     prometheus::GaugeFamily *m_pMachineCPUFamily;    // 采集机器CPU数量
     prometheus::GaugeFamily *m_pMachineMemoryFamily; // 采集机器内存大小
@@ -1,13 +1,15 @@
 #include "RegisterCenter.h"
 #include <thread>
+#include <climits>
 #include "glog/logging.h"
 #include "timer/timer.h"
 #include "semver/semver.hpp"
 #include "Common/Function.h"
+#include "Common/Clock.h"
 #include "GrpcDispatcher/GrpcDispatcher.h"
 #include "UnifiedClient.h"
 
-long RegisterCenter::m_LastCheckTime = 0;
+long RegisterCenter::m_LastCheckTime = LONG_MIN / 2; // 首次定时即检查, 之后按单调时钟计时
 long RegisterCenter::m_PingInterval = 3000;
 long RegisterCenter::m_CheckInterval = 30000;
 
@@ -677,7 +679,7 @@ void RegisterCenter::OnTimer()
 
         DoPing();
 
-        long timeStamp = Common::get_ms_timestamp();
+        long timeStamp = Common::mono_ns() / 1000000;
         if (timeStamp - m_LastCheckTime > m_CheckInterval)
         {
             m_LastCheckTime = timeStamp;
@@ -3,6 +3,7 @@
 #include "glog/logging.h"
 #include "semver/semver.hpp"
 #include "Common/Function.h"
+#include "Common/Clock.h"
 
 void UnifiedClient::Init(
     const std::string &helloRequest,
@@ -19,33 +20,23 @@ void UnifiedClient::Init(
 
 void UnifiedClient::PushRequestTime(const double &requestTime)
 {
-    m_RequestTimeQueue.push_back(requestTime);
+    m_RequestTimeSum.add((int64_t)(requestTime * 1000));
+    m_RequestCount.add(1);
 }
 
 void UnifiedClient::HandleRequestTime()
 {
-    size_t batchSize = 100;
-
-    double sumTime = 0.0;
-    size_t sumCount = 0;
-
     int cacheCount = 0;
     while (m_Terminate)
     {
-        std::vector<double> vecRequestTime;
-        vecRequestTime.reserve(batchSize);
-        if (this->m_RequestTimeQueue.pop_front(vecRequestTime, batchSize, 10, m_Terminate))
-        {
-            for (double &requestTime : vecRequestTime)
-            {
-                sumTime += requestTime;
-                sumCount++;
-            }
-        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
 
         cacheCount++;
         if (cacheCount >= 10)
         {
+            // 取出并清零本周期的累计值
+            double sumTime = m_RequestTimeSum.exchange() / 1000.0;
+            int64_t sumCount = m_RequestCount.exchange();
             double avgRequestTime = sumTime / sumCount;
 
             if (sumCount > 0)
@@ -61,8 +52,6 @@ void UnifiedClient::HandleRequestTime()
             m_dataIdx = newDataIdx;
 
             cacheCount = 0;
-            sumTime = 0.0;
-            sumCount = 0;
         }
     }
 }
@@ -97,7 +86,7 @@ bool UnifiedClient::CallRemoteServer(
     int &result,
     std::string &response)
 {
-    double start_time = Common::get_ms_time();
+    Common::Stopwatch stopwatch;
     std::string addr;
     if (!Send(cmd, loadBalanceElement, request, tiemout, addr, result, response))
     {
@@ -105,7 +94,7 @@ bool UnifiedClient::CallRemoteServer(
         if (GrpcProtos::ResultType::ERR_Call_Service == result)
         {
             {
-                std::unique_lock<std::shared_mutex> ul(m_AddrToHelloStatusMapRWMutex);
+                std::unique_lock<Common::distributed_shared_mutex> ul(m_AddrToHelloStatusMapRWMutex);
                 if (!m_AddrToHelloStatusMap[addr].load())
                 {
                     m_AddrToHelloStatusMap[addr].store(true);
@@ -119,7 +108,7 @@ bool UnifiedClient::CallRemoteServer(
                 addrList.push_back(addr);
                 DoHello(addrList);
 
-                std::unique_lock<std::shared_mutex> ul(m_AddrToHelloStatusMapRWMutex);
+                std::unique_lock<Common::distributed_shared_mutex> ul(m_AddrToHelloStatusMapRWMutex);
                 m_AddrToHelloStatusMap[addr].store(false);
             }
         }
@@ -128,13 +117,12 @@ bool UnifiedClient::CallRemoteServer(
                      << ", addr = " << addr
                      << ", result = " << result
                      << ", response = " << response
-                     << ", tiemout = " << Common::get_ms_time() - start_time << "ms";
+                     << ", tiemout = " << stopwatch.elapsed_ms() << "ms";
 
         return false;
     }
 
-    double deal_time = Common::get_ms_time() - start_time;
-    PushRequestTime(deal_time);
+    PushRequestTime(stopwatch.elapsed_ms());
 
     return true;
 }
@@ -145,7 +133,7 @@ bool UnifiedClient::UpdateByAddr(const GrpcProtos::ServiceInfo &serviceInfo)
 
     {
         // 写锁, 出作用域自动释放
-        std::unique_lock<std::shared_mutex> ul(m_AddrToServiceMapRWMutex);
+        std::unique_lock<Common::distributed_shared_mutex> ul(m_AddrToServiceMapRWMutex);
         auto iter = m_AddrToServiceMap.find(addr);
         if (iter != m_AddrToServiceMap.end())
         {
@@ -168,7 +156,7 @@ bool UnifiedClient::UpdateByAddr(const GrpcProtos::ServiceInfo &serviceInfo)
     }
 
     {
-        std::unique_lock<std::shared_mutex> ul(m_AddrToHelloStatusMapRWMutex);
+        std::unique_lock<Common::distributed_shared_mutex> ul(m_AddrToHelloStatusMapRWMutex);
         auto iter = m_AddrToHelloStatusMap.find(addr);
         if (iter == m_AddrToHelloStatusMap.end())
         {
@@ -227,7 +215,7 @@ void UnifiedClient::DoHello(const std::vector<std::string> &addrList)
 
 bool UnifiedClient::OpenByAddr(const std::string &addr)
 {
-    std::unique_lock<std::shared_mutex> ul(m_AddrToServiceMapRWMutex);
+    std::unique_lock<Common::distributed_shared_mutex> ul(m_AddrToServiceMapRWMutex);
 
     auto iter = m_AddrToServiceMap.find(addr);
     if (iter != m_AddrToServiceMap.end())
@@ -251,7 +239,7 @@ bool UnifiedClient::OpenByAddr(const std::string &addr)
 
 bool UnifiedClient::CloseByAddr(const std::string &addr)
 {
-    std::unique_lock<std::shared_mutex> ul(m_AddrToServiceMapRWMutex);
+    std::unique_lock<Common::distributed_shared_mutex> ul(m_AddrToServiceMapRWMutex);
 
     auto iter = m_AddrToServiceMap.find(addr);
     if (iter != m_AddrToServiceMap.end())
@@ -268,7 +256,7 @@ void UnifiedClient::GetWatchServiceInfo(GrpcProtos::WatchServiceInfo *watchServi
     watchServiceInfo->set_service_type(m_ServiceType);
 
     // 读锁, 出作用域自动释放
-    std::shared_lock<std::shared_mutex> sl(m_AddrToServiceMapRWMutex);
+    std::shared_lock<Common::distributed_shared_mutex> sl(m_AddrToServiceMapRWMutex);
     for (auto iter = m_AddrToServiceMap.begin(); iter != m_AddrToServiceMap.end(); ++iter)
     {
         watchServiceInfo->add_service_list()->CopyFrom(iter->second);
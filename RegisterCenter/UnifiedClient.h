@@ -6,7 +6,7 @@
 #include "ClientManager/GrpcSender.h"
 #include "ClientManager/GrpcClient.h"
 
-#include "Common/SafeQueue.h"
+#include "Common/ShardedCounter.h"
 
 class UnifiedClient final
     : public GrpcClient<GrpcSender>
@@ -60,18 +60,19 @@ private:
     std::unordered_map<std::string, GrpcProtos::ServiceInfo> m_AddrToServiceMap;
 
     // 服务列表读写锁
-    std::shared_mutex m_AddrToServiceMapRWMutex;
+    Common::distributed_shared_mutex m_AddrToServiceMapRWMutex;
 
     // Hello状态
     std::unordered_map<std::string, std::atomic<bool>> m_AddrToHelloStatusMap;
 
     // Hello状态读写锁
-    std::shared_mutex m_AddrToHelloStatusMapRWMutex;
+    Common::distributed_shared_mutex m_AddrToHelloStatusMapRWMutex;
 
     bool m_Terminate = false;
 
-    // 下级服务请求时间
-    SafeQueue<double> m_RequestTimeQueue;
+    // 下级服务请求时间, 分片累计, 由 HandleRequestTime 定时汇总
+    Common::ShardedCounter m_RequestTimeSum; // 请求耗时和, 单位微秒
+    Common::ShardedCounter m_RequestCount;   // 请求次数
     std::shared_ptr<std::thread> m_RequestTimeThreadPtr;
 
     // 双缓冲
@@ -0,0 +1,85 @@
+# -*- coding:utf-8 -*-
+# 从 TensorFlow checkpoint 导出 DNNModel 模型文件, 格式见 TDPredict/DNNModel/DNNModelData.h
+#
+# 示例(DeepFM, 两层隐藏层):
+# python export_dnn_model.py --checkpoint ./ckpt/model.ckpt-1000 --output ./dnn_model \
+#     --type deepfm --fields 40 \
+#     --embedding embedding/weights --linear linear/weights --bias linear/bias \
+#     --dense dense/kernel,dense/bias,relu \
+#     --dense dense_1/kernel,dense_1/bias,relu \
+#     --dense dense_2/kernel,dense_2/bias,none
+# 导出后与 feature_trans 一起放在 TFSModelFolder/ServiceName/ModelName/version/ 下
+import argparse
+
+
+def to_list(value):
+    return value.tolist() if hasattr(value, 'tolist') else value
+
+
+def write_row(out, row):
+    out.write(' '.join('%.9g' % float(v) for v in row))
+    out.write('\n')
+
+
+def write_dnn_model(path, model_type, fields, embedding, dense, output='sigmoid', linear=None, bias=0.0):
+    """ embedding: [vocab, emb_size]; linear: [vocab] 或 [vocab, 1]; dense: [(kernel [in, out], bias [out], activation)] """
+    embedding = to_list(embedding)
+    vocab = len(embedding)
+    emb_size = len(embedding[0])
+    with open(path, 'w') as out:
+        out.write('dnn 1\n')
+        out.write('type %s\n' % model_type)
+        out.write('input %d %d %d\n' % (fields, emb_size, vocab))
+        out.write('output %s\n' % output)
+        if model_type == 'deepfm':
+            linear = [v[0] if isinstance(v, list) else v for v in to_list(linear)]
+            if len(linear) != vocab:
+                raise ValueError('linear size %d != vocab %d' % (len(linear), vocab))
+            bias = to_list(bias)
+            if isinstance(bias, list):
+                bias = bias[0]
+            out.write('bias %.9g\n' % float(bias))
+        out.write('embedding\n')
+        for idx in range(vocab):
+            row = embedding[idx]
+            if model_type == 'deepfm':
+                row = [linear[idx]] + list(row)
+            write_row(out, row)
+        for kernel, dense_bias, activation in dense:
+            kernel = to_list(kernel)
+            out.write('dense %d %d %s\n' % (len(kernel), len(kernel[0]), activation))
+            for row in kernel:
+                write_row(out, row)
+            write_row(out, to_list(dense_bias))
+        out.write('end\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='export TensorFlow checkpoint to DNNModel file')
+    parser.add_argument('--checkpoint', required=True, help='checkpoint 路径')
+    parser.add_argument('--output', required=True, help='输出模型文件')
+    parser.add_argument('--type', choices=['mlp', 'deepfm'], default='mlp')
+    parser.add_argument('--fields', type=int, required=True, help='输入维度, 与 feature_trans 第一行一致')
+    parser.add_argument('--embedding', required=True, help='embedding 变量名 [vocab, emb_size]')
+    parser.add_argument('--linear', help='deepfm 一阶权重变量名 [vocab, 1], deepfm 必填')
+    parser.add_argument('--bias', help='deepfm 一阶偏置变量名')
+    parser.add_argument('--dense', action='append', required=True, help='kernel变量名,bias变量名,激活函数; 按层顺序重复')
+    parser.add_argument('--output-activation', default='sigmoid', choices=['sigmoid', 'none', 'relu', 'tanh'])
+    args = parser.parse_args()
+    if args.type == 'deepfm' and not args.linear:
+        parser.error('--type deepfm requires --linear')
+
+    import tensorflow as tf
+    reader = tf.train.load_checkpoint(args.checkpoint)
+    dense = []
+    for item in args.dense:
+        kernel_name, bias_name, activation = item.split(',')
+        dense.append((reader.get_tensor(kernel_name), reader.get_tensor(bias_name), activation))
+    linear = reader.get_tensor(args.linear) if args.type == 'deepfm' else None
+    bias = reader.get_tensor(args.bias) if args.type == 'deepfm' and args.bias else 0.0
+    write_dnn_model(args.output, args.type, args.fields, reader.get_tensor(args.embedding), dense,
+                    args.output_activation, linear, bias)
+
+
+if __name__ == '__main__':
+    main()
@@ -10,6 +10,7 @@ namespace TDPredict
     class SENet;
     class FMModel;
     class TFModel;
+    class DNNModel;
     class SENetModel;
 
     // FM 模型配置
@@ -21,6 +22,8 @@ namespace TDPredict
         std::string Version = "latest";                // 模型版本号, latest标识自动获取最新版本
         std::string ModelFileName = "fm_model";        // 模型文件名
         std::string FilterFileName = "feature_filter"; // 特征筛选文件名 - feature_filter
+        FMPrecision Precision = FMPrecision::FP32;     // 隐向量存储精度 - FP32/FP16/INT8
+        std::string GoldenFileName;                    // 样例请求文件名, 更新前回放校验, 为空不回放
     };
 
     // TensorFlow 模型配置
@@ -37,6 +40,19 @@ namespace TDPredict
         TFModelMethodType RequestMethod = Restful;     // 模型请求调用方案
         std::string OutputName = "predictions";        // 模型读取返回值名称
         bool UseUserType = false;                      // 是否使用UserType字段
+        TFBatchPolicy BatchPolicy;                     // GRPC 分批策略
+        TFHedgePolicy HedgePolicy;                     // GRPC 对冲请求策略
+        TFMergePolicy MergePolicy;                     // GRPC 跨请求合并策略
+    };
+
+    // 进程内 DNN 模型配置, 与 TF Serving 模型放在同一目录下(TFSModelFolder)
+    struct DNNModelConfigData
+    {
+        std::string ServiceName;                     // 服务名称
+        std::string ModelName;                       // 模型名称
+        std::string Version = "latest";              // 模型版本号, latest标识自动获取最新版本
+        std::string ModelFileName = "dnn_model";     // 模型文件名, 由 Script/export_dnn_model.py 导出
+        std::string TransFileName = "feature_trans"; // 转换文件名 - feature_trans
     };
 
     struct SENetItemConfigData
@@ -72,17 +88,20 @@ namespace TDPredict
         std::vector<FMModelConfigData> vecFMModelData;       // FMModel 配置
         std::vector<TFModelConfigData> vecTFModelData;       // TFModel 配置
         std::vector<SENetModelConfigData> vecSENetModelData; // SENetModel 配置
+        std::vector<DNNModelConfigData> vecDNNModelData;     // DNNModel 配置
 
     public:
         // 模型
         std::unordered_map<std::string, std::shared_ptr<FMModel>> mapFMModel;
         std::unordered_map<std::string, std::shared_ptr<TFModel>> mapTFModel;
         std::unordered_map<std::string, std::shared_ptr<SENetModel>> mapSENetModel;
+        std::unordered_map<std::string, std::shared_ptr<DNNModel>> mapDNNModel;
 
         // 模型对应文件路径
         std::unordered_map<std::string, std::string> mapFMModel2ModelFilePath;
         std::unordered_map<std::string, std::string> mapFMModel2FilterFilePath;
         std::unordered_map<std::string, std::string> mapTFModel2TransFilePath;
+        std::unordered_map<std::string, std::string> mapDNNModel2ModelFilePath;
 
     public:
         void clear()
@@ -93,14 +112,17 @@ namespace TDPredict
             vecFMModelData.clear();
             vecTFModelData.clear();
             vecSENetModelData.clear();
+            vecDNNModelData.clear();
 
             mapFMModel.clear();
             mapTFModel.clear();
             mapSENetModel.clear();
+            mapDNNModel.clear();
 
             mapFMModel2ModelFilePath.clear();
             mapFMModel2FilterFilePath.clear();
             mapTFModel2TransFilePath.clear();
+            mapDNNModel2ModelFilePath.clear();
         }
     };
 
@@ -6,6 +6,7 @@
 #include "../TFModel/TFModel.h"
 #include "../TFModel/SENet.h"
 #include "../TFModel/SENetModel.h"
+#include "../DNNModel/DNNModel.h"
 
 using namespace TDPredict::Config;
 
@@ -71,6 +72,7 @@ const std::shared_ptr<TDPredict::ModelInterface> ModelConfig::GetModel(
     static const std::string Platform_FMModel = "FMModel";
     static const std::string Platform_TensorFlow = "TensorFlow";
     static const std::string Platform_SENetModel = "SENetModel";
+    static const std::string Platform_DNNModel = "DNNModel";
 
     if (platform == Platform_FMModel)
     {
@@ -99,6 +101,15 @@ const std::shared_ptr<TDPredict::ModelInterface> ModelConfig::GetModel(
             return it->second;
         }
     }
+    else if (platform == Platform_DNNModel)
+    {
+        auto &data = m_data[m_dataIdx];
+        auto it = data.mapDNNModel.find(model_name);
+        if (it != data.mapDNNModel.end())
+        {
+            return it->second;
+        }
+    }
 
     return nullptr;
 }
@@ -167,14 +178,28 @@ int32_t ModelConfig::DecodeJsonData(const std::string &jsonData)
         return cfgErr;
     }
 
+    cfgErr = DecodeDNNModel(doc, data_idx);
+    if (cfgErr != ModelConfig::Error::OK)
+    {
+        m_lastErrorInfo = "DecodeJsonData() DecodeDNNModel Error.";
+        return cfgErr;
+    }
+
     // 配置读取完毕后, 初始化模型
     cfgErr = UpdateModel(data_idx);
     if (cfgErr != ModelConfig::Error::OK)
     {
+        m_vecStagedPublish.clear(); // 丢弃已加载的新版本, 所有模型继续服务原版本
         m_lastErrorInfo = "DecodeJsonData() UpdateModel Error.";
         return cfgErr;
     }
 
+    // 所有模型加载校验成功后, 新版本与配置一起切换
+    for (const auto &publish : m_vecStagedPublish)
+    {
+        publish();
+    }
+    m_vecStagedPublish.clear();
     m_dataIdx = data_idx;
     return ModelConfig::Error::OK;
 }
@@ -352,6 +377,39 @@ int32_t ModelConfig::DecodeFMModel(
                        << ", idx = " << idx;
             return ModelConfig::Error::DecodeFMModelError;
         }
+
+        // 隐向量存储精度, 可选
+        if (item.HasMember("Precision") && item["Precision"].IsString())
+        {
+            const std::string precision = std::string(item["Precision"].GetString(),
+                                                      item["Precision"].GetStringLength());
+            if ("FP32" == precision)
+            {
+                model_data.Precision = FMPrecision::FP32;
+            }
+            else if ("FP16" == precision)
+            {
+                model_data.Precision = FMPrecision::FP16;
+            }
+            else if ("INT8" == precision)
+            {
+                model_data.Precision = FMPrecision::INT8;
+            }
+            else
+            {
+                LOG(ERROR) << "DecodeFMModel() Precision Not equal"
+                           << ", precision = " << precision
+                           << ", idx = " << idx;
+                return ModelConfig::Error::DecodeFMModelError;
+            }
+        }
+
+        // 样例请求文件名, 可选
+        if (item.HasMember("GoldenFileName") && item["GoldenFileName"].IsString())
+        {
+            model_data.GoldenFileName = std::string(item["GoldenFileName"].GetString(),
+                                                    item["GoldenFileName"].GetStringLength());
+        }
     }
     return ModelConfig::Error::OK;
 }
@@ -505,6 +563,95 @@ int32_t ModelConfig::DecodeTFModel(
                                                 item["OutputName"].GetStringLength());
         }
 
+        // GRPC 分批策略, 未配置的字段使用默认值
+        if (item.HasMember("BatchPolicy") && item["BatchPolicy"].IsObject())
+        {
+            const auto &policy_item = item["BatchPolicy"];
+            auto &policy = model_data.BatchPolicy;
+            const std::pair<const char *, int *> fields[] = {
+                {"MinBatchSize", &policy.MinBatchSize},
+                {"MaxBatchSize", &policy.MaxBatchSize},
+                {"MaxInFlight", &policy.MaxInFlight},
+                {"TargetBatchMs", &policy.TargetBatchMs},
+            };
+            for (const auto &field : fields)
+            {
+                if (policy_item.HasMember(field.first) && policy_item[field.first].IsInt())
+                {
+                    *field.second = policy_item[field.first].GetInt();
+                }
+            }
+
+            if (policy.MinBatchSize <= 0 || policy.MaxBatchSize < policy.MinBatchSize ||
+                policy.MaxInFlight <= 0 || policy.TargetBatchMs < 0)
+            {
+                LOG(ERROR) << "DecodeTFModel() BatchPolicy Invalid"
+                           << ", ModelName = " << model_data.ModelName
+                           << ", MinBatchSize = " << policy.MinBatchSize
+                           << ", MaxBatchSize = " << policy.MaxBatchSize
+                           << ", MaxInFlight = " << policy.MaxInFlight
+                           << ", TargetBatchMs = " << policy.TargetBatchMs;
+                return ModelConfig::Error::DecodeTFModelError;
+            }
+        }
+
+        // GRPC 对冲请求策略, 未配置时不对冲
+        if (item.HasMember("HedgePolicy") && item["HedgePolicy"].IsObject())
+        {
+            const auto &policy_item = item["HedgePolicy"];
+            auto &policy = model_data.HedgePolicy;
+            const std::pair<const char *, int *> fields[] = {
+                {"Percentile", &policy.Percentile},
+                {"MinDelayMs", &policy.MinDelayMs},
+                {"BudgetPercent", &policy.BudgetPercent},
+            };
+            for (const auto &field : fields)
+            {
+                if (policy_item.HasMember(field.first) && policy_item[field.first].IsInt())
+                {
+                    *field.second = policy_item[field.first].GetInt();
+                }
+            }
+
+            if (policy.Percentile < 0 || policy.Percentile > 100 ||
+                policy.MinDelayMs < 0 || policy.BudgetPercent < 0 || policy.BudgetPercent > 100)
+            {
+                LOG(ERROR) << "DecodeTFModel() HedgePolicy Invalid"
+                           << ", ModelName = " << model_data.ModelName
+                           << ", Percentile = " << policy.Percentile
+                           << ", MinDelayMs = " << policy.MinDelayMs
+                           << ", BudgetPercent = " << policy.BudgetPercent;
+                return ModelConfig::Error::DecodeTFModelError;
+            }
+        }
+
+        // GRPC 跨请求合并策略, 未配置时不合并
+        if (item.HasMember("MergePolicy") && item["MergePolicy"].IsObject())
+        {
+            const auto &policy_item = item["MergePolicy"];
+            auto &policy = model_data.MergePolicy;
+            const std::pair<const char *, int *> fields[] = {
+                {"WindowUs", &policy.WindowUs},
+                {"MaxMergeItems", &policy.MaxMergeItems},
+            };
+            for (const auto &field : fields)
+            {
+                if (policy_item.HasMember(field.first) && policy_item[field.first].IsInt())
+                {
+                    *field.second = policy_item[field.first].GetInt();
+                }
+            }
+
+            if (policy.WindowUs < 0 || policy.MaxMergeItems <= 0)
+            {
+                LOG(ERROR) << "DecodeTFModel() MergePolicy Invalid"
+                           << ", ModelName = " << model_data.ModelName
+                           << ", WindowUs = " << policy.WindowUs
+                           << ", MaxMergeItems = " << policy.MaxMergeItems;
+                return ModelConfig::Error::DecodeTFModelError;
+            }
+        }
+
         // 如果配置TFS地址为空, 则采用默认地址
         if (model_data.TFSAddrList.empty())
         {
@@ -603,11 +750,95 @@ int32_t ModelConfig::DecodeSENetModel(const rapidjson::Document &doc, const int
     return ModelConfig::Error::OK;
 }
 
+int32_t ModelConfig::DecodeDNNModel(const rapidjson::Document &doc, const int data_idx)
+{
+    if (!doc.HasMember("DNNModel"))
+    {
+        return ModelConfig::Error::OK;
+    }
+
+    if (!doc["DNNModel"].IsArray())
+    {
+        LOG(ERROR) << "DecodeDNNModel() Parse jsonData DNNModel Not Array.";
+        return ModelConfig::Error::DecodeDNNModelError;
+    }
+
+    auto &data = m_data[data_idx];
+    auto array = doc["DNNModel"].GetArray();
+    auto array_size = array.Size();
+    data.vecDNNModelData.clear();
+    data.vecDNNModelData.resize(array_size);
+    for (rapidjson::SizeType idx = 0; idx < array_size; idx++)
+    {
+        if (!array[idx].IsObject())
+        {
+            LOG(ERROR) << "DecodeDNNModel() Parse jsonData"
+                       << ", DNNModel Not Object"
+                       << ", idx = " << idx;
+            return ModelConfig::Error::DecodeDNNModelError;
+        }
+
+        auto item = array[idx].GetObject();
+        auto &model_data = data.vecDNNModelData[idx];
+
+        // 服务名称
+        if (item.HasMember("ServiceName") && item["ServiceName"].IsString())
+        {
+            model_data.ServiceName = std::string(item["ServiceName"].GetString(),
+                                                 item["ServiceName"].GetStringLength());
+        }
+        else
+        {
+            LOG(ERROR) << "DecodeDNNModel() Parse jsonData"
+                       << ", DNNModel Not Find ServiceName"
+                       << ", idx = " << idx;
+            return ModelConfig::Error::DecodeDNNModelError;
+        }
+
+        // 模型名称
+        if (item.HasMember("ModelName") && item["ModelName"].IsString())
+        {
+            model_data.ModelName = std::string(item["ModelName"].GetString(),
+                                               item["ModelName"].GetStringLength());
+        }
+        else
+        {
+            LOG(ERROR) << "DecodeDNNModel() Parse jsonData"
+                       << ", DNNModel Not Find ModelName"
+                       << ", idx = " << idx;
+            return ModelConfig::Error::DecodeDNNModelError;
+        }
+
+        // 模型版本号
+        if (item.HasMember("Version") && item["Version"].IsString())
+        {
+            model_data.Version = std::string(item["Version"].GetString(),
+                                             item["Version"].GetStringLength());
+        }
+
+        // 模型文件名
+        if (item.HasMember("ModelFileName") && item["ModelFileName"].IsString())
+        {
+            model_data.ModelFileName = std::string(item["ModelFileName"].GetString(),
+                                                   item["ModelFileName"].GetStringLength());
+        }
+
+        // 转换文件名
+        if (item.HasMember("TransFileName") && item["TransFileName"].IsString())
+        {
+            model_data.TransFileName = std::string(item["TransFileName"].GetString(),
+                                                   item["TransFileName"].GetStringLength());
+        }
+    }
+    return ModelConfig::Error::OK;
+}
+
 int32_t ModelConfig::UpdateModel(const int dataIdx)
 {
     static const std::string latest = "latest"; // 最新版本号
 
     auto &data = m_data[dataIdx];
+    m_vecStagedPublish.clear();
 
     // 更新FM模型
     for (const auto &model : data.vecFMModelData)
@@ -672,12 +903,15 @@ int32_t ModelConfig::UpdateModel(const int dataIdx)
             return ModelConfig::Error::UpdateModelError;
         }
 
-        // 找到 FMModel
+        // 找到 FMModel: DecodeJsonData 已清空 data, 沿用正在服务的同名模型,
+        // 由其版本发布保证切换安全, 并保留漂移校验的对照版本与回滚版本
         std::shared_ptr<FMModel> spModel = nullptr;
-        auto it = data.mapFMModel.find(model.ModelName);
-        if (it != data.mapFMModel.end())
+        const auto &serving = m_data[m_dataIdx].mapFMModel;
+        auto it = serving.find(model.ModelName);
+        if (it != serving.end())
         {
             spModel = it->second;
+            data.mapFMModel[model.ModelName] = spModel;
         }
 
         if (spModel == nullptr)
@@ -686,8 +920,27 @@ int32_t ModelConfig::UpdateModel(const int dataIdx)
             data.mapFMModel[model.ModelName] = spModel;
         }
 
-        // 更新FMModel
-        if (!spModel->Update(model.Factor, model_filePath, filter_filePath))
+        // 样例请求在模型目录下, 只随新版本校验与发布
+        std::shared_ptr<const std::vector<FMGoldenRequest>> spGolden = nullptr;
+        if (!model.GoldenFileName.empty())
+        {
+            std::filesystem::path golden_filePath = model_dir;
+            golden_filePath.append(model.GoldenFileName);
+            std::vector<FMGoldenRequest> vecGolden;
+            if (!FMModel::ReadGoldenFile(golden_filePath, vecGolden))
+            {
+                LOG(ERROR) << "ModelConfig::UpdateModel() FMModel ReadGoldenFile Failed"
+                           << ", FMModel.ServiceName = " << model.ServiceName
+                           << ", FMModel.ModelName = " << model.ModelName
+                           << ", golden_filePath = " << golden_filePath;
+                return ModelConfig::Error::UpdateModelError;
+            }
+            spGolden = std::make_shared<const std::vector<FMGoldenRequest>>(std::move(vecGolden));
+        }
+
+        // 加载并校验FMModel新版本, 整个配置成功后才发布(见 DecodeJsonData), 失败时沿用的模型继续服务原版本
+        auto spVersion = spModel->Stage(model.Factor, model_filePath, filter_filePath, model.Precision, std::move(spGolden));
+        if (spVersion == nullptr)
         {
             LOG(ERROR) << "ModelConfig::UpdateModel() FMModel Update Failed"
                        << ", FMModel.ServiceName = " << model.ServiceName
@@ -704,6 +957,9 @@ int32_t ModelConfig::UpdateModel(const int dataIdx)
                       << ", model_filePath = " << model_filePath
                       << ", filter_filePath = " << filter_filePath;
 
+            m_vecStagedPublish.emplace_back([spModel, spVersion]()
+                                            { spModel->Publish(spVersion); });
+
             // 记录模型名称对应文件地址
             data.mapFMModel2ModelFilePath[model.ModelName] = model_filePath;
             data.mapFMModel2FilterFilePath[model.FilterFileName] = filter_filePath;
@@ -785,7 +1041,8 @@ int32_t ModelConfig::UpdateModel(const int dataIdx)
                              model.Timeout, trans_filePath,
                              model.UseDropoutKeep, version,
                              model.RequestMethod, model.OutputName,
-                             model.UseUserType))
+                             model.UseUserType, model.BatchPolicy,
+                             model.HedgePolicy, model.MergePolicy))
         {
             LOG(ERROR) << "ModelConfig::UpdateModel() TFModel Update Failed"
                        << ", model.ServiceName = " << model.ServiceName
@@ -843,5 +1100,98 @@ int32_t ModelConfig::UpdateModel(const int dataIdx)
         }
     }
 
+    // 更新DNNModel, 模型文件与转换文件在 TFS 模型目录下
+    for (const auto &model : data.vecDNNModelData)
+    {
+        std::filesystem::path model_filePath;
+        std::filesystem::path trans_filePath;
+        for (const auto &folder : data.vecTFSModelFolder)
+        {
+            std::filesystem::path model_dir(folder);
+            model_dir.append(model.ServiceName);
+            model_dir.append(model.ModelName);
+
+            // 获取版本号
+            if (model.Version == latest)
+            {
+                std::string version;
+                if (!TDPredict::GetLatestVersion(model_dir, version))
+                {
+                    LOG(ERROR) << "ModelConfig::UpdateModel() GetLatestVersion Failed"
+                               << ", DNNModel.ServiceName = " << model.ServiceName
+                               << ", DNNModel.ModelName = " << model.ModelName
+                               << ", model_dir = " << model_dir;
+                    continue;
+                }
+                model_dir.append(version);
+            }
+            else
+            {
+                model_dir.append(model.Version);
+            }
+
+            model_filePath = model_dir / model.ModelFileName;
+            trans_filePath = model_dir / model.TransFileName;
+            if (std::filesystem::is_regular_file(model_filePath) &&
+                std::filesystem::is_regular_file(trans_filePath))
+            {
+                break; // 找到文件了, break出去
+            }
+            model_filePath.clear();
+            trans_filePath.clear();
+        }
+        if (model_filePath.empty() || trans_filePath.empty())
+        {
+            LOG(ERROR) << "ModelConfig::UpdateModel() DNNModel File Not Found"
+                       << ", DNNModel.ServiceName = " << model.ServiceName
+                       << ", DNNModel.ModelName = " << model.ModelName
+                       << ", DNNModel.Version = " << model.Version
+                       << ", DNNModel.ModelFileName = " << model.ModelFileName
+                       << ", DNNModel.TransFileName = " << model.TransFileName;
+            return ModelConfig::Error::UpdateModelError;
+        }
+
+        // 找到 DNNModel: 同 FMModel, 沿用正在服务的同名模型
+        std::shared_ptr<DNNModel> spModel = nullptr;
+        const auto &serving = m_data[m_dataIdx].mapDNNModel;
+        auto it = serving.find(model.ModelName);
+        if (it != serving.end())
+        {
+            spModel = it->second;
+            data.mapDNNModel[model.ModelName] = spModel;
+        }
+        if (spModel == nullptr)
+        {
+            spModel = std::make_shared<DNNModel>(model.ModelName);
+            data.mapDNNModel[model.ModelName] = spModel;
+        }
+
+        // 加载并校验DNNModel新版本, 同 FMModel 整个配置成功后才发布, 失败时沿用的模型继续服务原版本
+        auto spVersion = spModel->Stage(model_filePath, trans_filePath);
+        if (spVersion == nullptr)
+        {
+            LOG(ERROR) << "ModelConfig::UpdateModel() DNNModel Update Failed"
+                       << ", DNNModel.ServiceName = " << model.ServiceName
+                       << ", DNNModel.ModelName = " << model.ModelName
+                       << ", model_filePath = " << model_filePath
+                       << ", trans_filePath = " << trans_filePath;
+            return ModelConfig::Error::UpdateModelError;
+        }
+        else
+        {
+            LOG(INFO) << "ModelConfig::UpdateModel() DNNModel Update Succ"
+                      << ", DNNModel.ServiceName = " << model.ServiceName
+                      << ", DNNModel.ModelName = " << model.ModelName
+                      << ", model_filePath = " << model_filePath
+                      << ", trans_filePath = " << trans_filePath;
+
+            m_vecStagedPublish.emplace_back([spModel, spVersion]()
+                                            { spModel->Publish(spVersion); });
+
+            // 记录模型名称对应文件地址
+            data.mapDNNModel2ModelFilePath[model.ModelName] = model_filePath;
+        }
+    }
+
     return ModelConfig::Error::OK;
 }
@@ -3,6 +3,7 @@
 #include <atomic>
 #include <vector>
 #include <string>
+#include <functional>
 #include "Common/Singleton.h"
 #include "rapidjson/document.h"
 
@@ -62,6 +63,7 @@ namespace TDPredict
                 DecodeTFModelError,
                 DecodeSENetModelError,
                 UpdateModelError,
+                DecodeDNNModelError,
             } Error;
 
             int32_t LoadJson(const std::string &filename);
@@ -71,6 +73,7 @@ namespace TDPredict
             int32_t DecodeFMModel(const rapidjson::Document &doc, const int data_idx);
             int32_t DecodeTFModel(const rapidjson::Document &doc, const int data_idx);
             int32_t DecodeSENetModel(const rapidjson::Document &doc, const int data_idx);
+            int32_t DecodeDNNModel(const rapidjson::Document &doc, const int data_idx);
             int32_t UpdateModel(const int dataIdx);
 
         public:
@@ -86,6 +89,9 @@ namespace TDPredict
             std::string m_lastErrorInfo;                          // 最后一次更新的具体失败原因
             std::vector<std::string> m_vecDefaultRestfulAddrList; // 默认Restful协议调用地址
             std::vector<std::string> m_vecDefaultGRPCAddrList;    // 默认GRPC协议调用地址
+
+            // UpdateModel 已加载校验的模型新版本, 整个配置成功后与 m_dataIdx 一起发布
+            std::vector<std::function<void()>> m_vecStagedPublish;
         };
 
     } // namespace Config
@@ -0,0 +1,225 @@
+#include "DNNModel.h"
+#include "../TFModel/TFSCommon.hpp"
+#include <new>
+#include <shared_mutex>
+#include "glog/logging.h"
+#include "Common/Clock.h"
+#include "Common/Arena.h"
+using namespace TDPredict;
+
+bool DNNModel::Init(const std::string &model_file_path, const std::string &trans_file_path)
+{
+    return Update(model_file_path, trans_file_path);
+}
+
+bool DNNModel::Update(const std::string &model_file_path, const std::string &trans_file_path)
+{
+    std::lock_guard<std::mutex> lg(m_updateModelLock);
+
+    Common::Stopwatch sw;
+    auto spVersion = Stage(model_file_path, trans_file_path);
+    if (spVersion == nullptr)
+    {
+        return false;
+    }
+    Publish(std::move(spVersion));
+
+    LOG(INFO) << "DNNModel::Update() Succ"
+              << ", model_name = " << GetName()
+              << ", model_file_path = " << model_file_path
+              << ", cost_ms = " << sw.elapsed_ms();
+    return true;
+}
+
+std::shared_ptr<const DNNModel::Version> DNNModel::Stage(const std::string &model_file_path, const std::string &trans_file_path) const
+{
+    auto spVersion = std::make_shared<Version>();
+    if (!spVersion->model_data.LoadModelFile(model_file_path))
+    {
+        LOG(ERROR) << "DNNModel::Stage() LoadModelFile Failed"
+                   << ", model_name = " << GetName()
+                   << ", model_file_path = " << model_file_path;
+        return nullptr;
+    }
+    if (!spVersion->trans_data.LoadTransFile(trans_file_path))
+    {
+        LOG(ERROR) << "DNNModel::Stage() LoadTransFile Failed"
+                   << ", model_name = " << GetName()
+                   << ", trans_file_path = " << trans_file_path;
+        return nullptr;
+    }
+
+    // 转换文件与模型须是同一次导出: 输入维度一致, 转换后的行号都在 embedding 内
+    const auto &model_data = spVersion->model_data;
+    const auto &trans_data = spVersion->trans_data;
+    if (trans_data.all_field_count != model_data.m_fields)
+    {
+        LOG(ERROR) << "DNNModel::Stage() Failed, all_field_count != fields"
+                   << ", model_name = " << GetName()
+                   << ", all_field_count = " << trans_data.all_field_count
+                   << ", fields = " << model_data.m_fields;
+        return nullptr;
+    }
+    for (const auto &pr : trans_data.trans_mapping)
+    {
+        if (pr.second < 0 || pr.second >= model_data.vocab())
+        {
+            LOG(ERROR) << "DNNModel::Stage() Failed, trans index out of vocab"
+                       << ", model_name = " << GetName()
+                       << ", field_value = " << pr.first
+                       << ", index = " << pr.second
+                       << ", vocab = " << model_data.vocab();
+            return nullptr;
+        }
+    }
+
+    return spVersion;
+}
+
+bool DNNModel::Publish(std::shared_ptr<const Version> spVersion)
+{
+    if (spVersion == nullptr)
+    {
+        LOG(ERROR) << "DNNModel::Publish() Failed, spVersion == nullptr"
+                   << ", model_name = " << GetName();
+        return false;
+    }
+
+    // 旧版本在这里或最后一个使用它的请求结束时释放
+    {
+        std::unique_lock<Common::distributed_shared_mutex> lock(m_versionLock);
+        m_spVersion.swap(spVersion);
+    }
+    spVersion.reset();
+    return true;
+}
+
+std::shared_ptr<const DNNModel::Version> DNNModel::Acquire() const noexcept
+{
+    std::shared_lock<Common::distributed_shared_mutex> lock(m_versionLock);
+    return m_spVersion;
+}
+
+bool DNNModel::GenerateInput(
+    const std::vector<RankItem> &vec_rank_item,
+    const TFTransData &trans_data,
+    int *index,
+    score_type *value) noexcept
+{
+    const int field_count = trans_data.all_field_count;
+    auto &item_0 = vec_rank_item[0];
+    if (item_0.spFeatureData == nullptr)
+    {
+        LOG(ERROR) << "GenerateInput() item_0.spFeatureData == nullptr";
+        return false;
+    }
+
+    // 计算common部分, 写入第一行后拷贝给其他行
+    std::fill(index, index + field_count, 0);
+    std::fill(value, value + field_count, score_type(0));
+    TransTFSFeature(item_0.spFeatureData->common_feature, trans_data, index, value);
+
+    const size_t vec_rank_item_size = vec_rank_item.size();
+    for (size_t idx = 1; idx < vec_rank_item_size; idx++)
+    {
+        std::copy(index, index + field_count, index + idx * field_count);
+        std::copy(value, value + field_count, value + idx * field_count);
+    }
+
+    // 计算rank部分
+    for (size_t idx = 0; idx < vec_rank_item_size; idx++)
+    {
+        auto &item = vec_rank_item[idx];
+        if (item.spFeatureData == nullptr)
+        {
+            LOG(ERROR) << "GenerateInput() item.spFeatureData == nullptr, idx = " << idx;
+            return false;
+        }
+        TransTFSFeature(item.spFeatureData->rank_feature, trans_data,
+                        index + idx * field_count, value + idx * field_count);
+    }
+    return true;
+}
+
+bool DNNModel::predict(RankItem &item) const noexcept
+{
+    if (item.spFeatureData == nullptr)
+    {
+        LOG(ERROR) << "predict() item.spFeatureData == nullptr";
+        return false;
+    }
+
+    const auto spVersion = Acquire();
+    if (spVersion == nullptr)
+    {
+        LOG(ERROR) << "predict() model not ready, model_name = " << GetName();
+        return false;
+    }
+    const auto &model_data = spVersion->model_data;
+    const auto &trans_data = spVersion->trans_data;
+    const int field_count = trans_data.all_field_count;
+
+    score_type score = 0;
+    try
+    {
+        // 输入缓冲与 Forward 的线程私有缓冲扩容失败时抛出 std::bad_alloc, predict 是 noexcept, 这里转为失败返回
+        std::pmr::memory_resource *mr = Common::CurrentResource();
+        std::pmr::vector<int> index(field_count, 0, mr);
+        std::pmr::vector<score_type> value(field_count, 0, mr);
+        TransTFSFeature(item.spFeatureData->common_feature, trans_data, index.data(), value.data());
+        TransTFSFeature(item.spFeatureData->rank_feature, trans_data, index.data(), value.data());
+        model_data.Forward(index.data(), value.data(), 1, &score);
+    }
+    catch (const std::bad_alloc &e)
+    {
+        LOG(ERROR) << "predict() Forward Failed, bad_alloc, model_name = " << GetName();
+        return false;
+    }
+    item.setModelScore(GetName(), score);
+    return true;
+}
+
+bool DNNModel::predict(std::vector<RankItem> &vec_rank_item) const noexcept
+{
+    if (vec_rank_item.empty())
+    {
+        return true;
+    }
+
+    const auto spVersion = Acquire();
+    if (spVersion == nullptr)
+    {
+        LOG(ERROR) << "predict() model not ready, model_name = " << GetName();
+        return false;
+    }
+    const auto &model_data = spVersion->model_data;
+    const auto &trans_data = spVersion->trans_data;
+    const size_t vec_rank_item_size = vec_rank_item.size();
+    const size_t input_size = vec_rank_item_size * trans_data.all_field_count;
+
+    try
+    {
+        std::pmr::memory_resource *mr = Common::CurrentResource();
+        std::pmr::vector<int> index(input_size, mr);
+        std::pmr::vector<score_type> value(input_size, mr);
+        std::pmr::vector<score_type> score(vec_rank_item_size, mr);
+        if (!GenerateInput(vec_rank_item, trans_data, index.data(), value.data()))
+        {
+            LOG(ERROR) << "predict() GenerateInput Failed, model_name = " << GetName();
+            return false;
+        }
+
+        model_data.Forward(index.data(), value.data(), vec_rank_item_size, score.data());
+        for (size_t idx = 0; idx < vec_rank_item_size; idx++)
+        {
+            vec_rank_item[idx].setModelScore(GetName(), score[idx]);
+        }
+    }
+    catch (const std::bad_alloc &e)
+    {
+        LOG(ERROR) << "predict() Forward Failed, bad_alloc, model_name = " << GetName()
+                   << ", vec_rank_item_size = " << vec_rank_item_size;
+        return false;
+    }
+    return true;
+}
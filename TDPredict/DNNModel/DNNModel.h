@@ -0,0 +1,68 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include "../Interface/ModelInterface.h"
+#include "../TFModel/TFTrans.h"
+#include "Common/Lock.h"
+#include "DNNModelData.h"
+
+namespace TDPredict
+{
+    // 进程内 DNN 模型, 在当前线程用 Eigen 完成前向计算, 不经过 TF Serving
+    // 适用于输入只有 index/value 的 MLP/DeepFM 类小模型, 特征转换与 TFModel 使用同一份转换文件,
+    // 同样的特征得到与 TF Serving 一致的输入; 不支持 use_dropout_keep(推理时恒为 1)与 use_user_type.
+    class DNNModel final : public ModelInterface
+    {
+    public:
+        DNNModel(const std::string &model_name) : ModelInterface(model_name) {}
+        ~DNNModel() {}
+
+        // 预测函数
+        virtual bool predict(RankItem &item) const noexcept override;
+
+        // 批量预测函数, 公共特征取 item0, 与 TFModel 一致
+        virtual bool predict(std::vector<RankItem> &vec_rank_item) const noexcept override;
+
+    public:
+        // 初始化函数
+        // [in] model_file_path: 模型文件地址, 格式见 DNNModelData.h
+        // [in] trans_file_path: 转换文件地址, 与 TF Serving 模型的 feature_trans 相同
+        bool Init(const std::string &model_file_path, const std::string &trans_file_path);
+
+        // 更新模型文件, 加载并校验成功后整体替换, 正在预测的请求继续使用旧版本
+        bool Update(const std::string &model_file_path, const std::string &trans_file_path);
+
+        // 一个完整的模型版本, 发布后只读
+        struct Version
+        {
+            DNNModelData model_data;
+            TFTransData trans_data;
+        };
+
+        // 只加载并校验新版本, 不发布, 用于多个模型整体切换(同 FMModel::Stage)
+        // [ret] 新版本, 失败返回 nullptr
+        std::shared_ptr<const Version> Stage(const std::string &model_file_path, const std::string &trans_file_path) const;
+
+        // 发布 Stage 得到的版本
+        bool Publish(std::shared_ptr<const Version> spVersion);
+
+    private:
+
+        // 获取当前版本, 持有期间该版本不会被释放
+        std::shared_ptr<const Version> Acquire() const noexcept;
+
+        // 生成 [item, all_field_count] 的输入
+        static bool GenerateInput(
+            const std::vector<RankItem> &vec_rank_item,
+            const TFTransData &trans_data,
+            int *index,
+            score_type *value) noexcept;
+
+    private:
+        std::mutex m_updateModelLock; // 更新锁
+        mutable Common::distributed_shared_mutex m_versionLock;
+        std::shared_ptr<const Version> m_spVersion;
+    };
+}
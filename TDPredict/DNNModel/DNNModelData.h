@@ -0,0 +1,531 @@
+#pragma once
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include "../Interface/ModelInterface.h"
+#include "glog/logging.h"
+#include "Common/Tokenizer.h"
+#include "Common/MappedFile.h"
+
+namespace TDPredict
+{
+    // 网络结构
+    enum class DNNType
+    {
+        MLP = 0,    // embedding 拼接后接全连接层
+        DeepFM = 1, // 一阶项 + FM 二阶项 + 全连接层
+    };
+
+    // 激活函数
+    enum class DNNActivation
+    {
+        None = 0,
+        ReLU = 1,
+        Sigmoid = 2,
+        Tanh = 3,
+    };
+
+    using DNNMatrix = Eigen::Matrix<score_type, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+    using DNNVector = Eigen::Matrix<score_type, 1, Eigen::Dynamic>;
+
+    // 全连接层: output = activation(input * kernel + bias)
+    struct DNNDenseLayer
+    {
+        DNNMatrix kernel; // [in, out]
+        DNNVector bias;   // [out]
+        DNNActivation activation = DNNActivation::None;
+    };
+
+    // 每次前向计算的最大行数, 控制中间结果大小
+    inline constexpr int DNN_BLOCK_ROWS = 256;
+
+    // 进程内 DNN 模型参数与前向计算
+    // 输入与 TF Serving 模型一致: 每个 item 有 fields 个 (index, value), 由 TFTransData 按转换文件生成,
+    // 缺失特征为 (0, 0). embedding 取 E[index] * value, 按域顺序拼接为 [fields * emb_size] 送入全连接层.
+    //
+    // 模型文件(文本, 由 Script/export_dnn_model.py 从 TensorFlow checkpoint 导出):
+    //   dnn 1                        文件头与格式版本
+    //   type deepfm                  mlp | deepfm
+    //   input 40 8 100000            域数量(须与转换文件第一行一致) embedding维度 embedding行数
+    //   output sigmoid               最终输出的激活函数
+    //   bias 0.01                    deepfm 一阶项偏置, mlp 没有这一行
+    //   embedding                    之后 embedding行数 行: deepfm 为 "一阶权重 e1 ... eK", mlp 为 "e1 ... eK"
+    //   dense 320 128 relu           全连接层 输入维度 输出维度 激活函数, 之后 输入维度 行 kernel, 1 行 bias
+    //   ...                          可有多个全连接层, 最后一层输出维度须为 1
+    //   end                          文件结束标记, 用于发现截断的文件
+    struct DNNModelData
+    {
+        DNNType m_type = DNNType::MLP;
+        int m_fields = 0;                               // 输入域数量
+        int m_embSize = 0;                              // embedding 维度
+        DNNActivation m_output = DNNActivation::Sigmoid; // 输出激活函数
+        score_type m_bias = 0;                          // deepfm 一阶项偏置
+        DNNMatrix m_embedding;                          // [vocab, emb_size]
+        DNNVector m_linear;                             // [vocab], deepfm 一阶权重
+        std::vector<DNNDenseLayer> m_vecDense;
+
+        int vocab() const noexcept { return m_embedding.rows(); }
+
+        void Clear()
+        {
+            m_type = DNNType::MLP;
+            m_fields = 0;
+            m_embSize = 0;
+            m_output = DNNActivation::Sigmoid;
+            m_bias = 0;
+            m_embedding.resize(0, 0);
+            m_linear.resize(0);
+            m_vecDense.clear();
+        }
+
+        // 各部分维度是否一致
+        bool Check() const
+        {
+            if (m_fields <= 0 || m_embSize <= 0 || vocab() <= 0 || m_embedding.cols() != m_embSize)
+            {
+                LOG(ERROR) << "DNNModelData::Check() Failed, input invalid"
+                           << ", fields = " << m_fields
+                           << ", emb_size = " << m_embSize
+                           << ", vocab = " << vocab();
+                return false;
+            }
+            if (m_type == DNNType::DeepFM && m_linear.cols() != vocab())
+            {
+                LOG(ERROR) << "DNNModelData::Check() Failed, linear size != vocab"
+                           << ", linear = " << m_linear.cols()
+                           << ", vocab = " << vocab();
+                return false;
+            }
+            if (m_vecDense.empty())
+            {
+                LOG(ERROR) << "DNNModelData::Check() Failed, no dense layer";
+                return false;
+            }
+            long in = (long)m_fields * m_embSize;
+            for (size_t idx = 0; idx < m_vecDense.size(); idx++)
+            {
+                const auto &layer = m_vecDense[idx];
+                if (layer.kernel.rows() != in || layer.kernel.cols() <= 0 || layer.bias.cols() != layer.kernel.cols())
+                {
+                    LOG(ERROR) << "DNNModelData::Check() Failed, dense shape invalid"
+                               << ", layer = " << idx
+                               << ", expect_in = " << in
+                               << ", kernel = [" << layer.kernel.rows() << ", " << layer.kernel.cols() << "]"
+                               << ", bias = " << layer.bias.cols();
+                    return false;
+                }
+                in = layer.kernel.cols();
+            }
+            if (in != 1)
+            {
+                LOG(ERROR) << "DNNModelData::Check() Failed, last dense out != 1, out = " << in;
+                return false;
+            }
+            return true;
+        }
+
+        // 加载模型文件
+        bool LoadModelFile(const std::string &model_file_path)
+        {
+            Common::MappedFile file;
+            if (!file.Open(model_file_path))
+            {
+                LOG(ERROR) << "DNNModelData::LoadModelFile() MappedFile Open Failed"
+                           << ", model_file_path = " << model_file_path;
+                return false;
+            }
+            if (!LoadModelBuffer(file.data()))
+            {
+                LOG(ERROR) << "DNNModelData::LoadModelFile() LoadModelBuffer Failed"
+                           << ", model_file_path = " << model_file_path;
+                return false;
+            }
+            return true;
+        }
+
+        bool LoadModelBuffer(std::string_view buffer)
+        {
+            Clear();
+
+            Common::LineRange lines(buffer);
+            auto iter = lines.begin();
+            std::vector<std::string_view> strVec;
+            std::string_view line;
+            // 读取下一个非空行并按空格切分
+            auto next_line = [&]()
+            {
+                while (iter != lines.end())
+                {
+                    line = Common::StripCR(*iter);
+                    ++iter;
+                    if (!line.empty())
+                    {
+                        Common::SplitView(line, ' ', strVec);
+                        return true;
+                    }
+                }
+                line = std::string_view();
+                strVec.clear();
+                return false;
+            };
+            auto load_failed = [&](const char *reason)
+            {
+                LOG(ERROR) << "DNNModelData::LoadModelBuffer() Failed, " << reason
+                           << ", line = " << line;
+                Clear();
+                return false;
+            };
+            // 一行 count 个数, 写入 out
+            auto parse_row = [&](const int count, score_type *out)
+            {
+                if (!next_line() || (int)strVec.size() != count)
+                {
+                    return false;
+                }
+                for (int idx = 0; idx < count; idx++)
+                {
+                    if (!Common::ParseNumber(strVec[idx], out[idx]))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            };
+
+            int version = 0;
+            if (!next_line() || strVec.size() != 2 || strVec[0] != "dnn" ||
+                !Common::ParseNumber(strVec[1], version) || version != 1)
+            {
+                return load_failed("header invalid");
+            }
+
+            if (!next_line() || strVec.size() != 2 || strVec[0] != "type" || !ParseType(strVec[1], m_type))
+            {
+                return load_failed("type invalid");
+            }
+
+            int vocab = 0;
+            if (!next_line() || strVec.size() != 4 || strVec[0] != "input" ||
+                !Common::ParseNumber(strVec[1], m_fields) ||
+                !Common::ParseNumber(strVec[2], m_embSize) ||
+                !Common::ParseNumber(strVec[3], vocab) ||
+                m_fields <= 0 || m_embSize <= 0 || vocab <= 0)
+            {
+                return load_failed("input invalid");
+            }
+
+            if (!next_line() || strVec.size() != 2 || strVec[0] != "output" || !ParseActivation(strVec[1], m_output))
+            {
+                return load_failed("output invalid");
+            }
+
+            if (m_type == DNNType::DeepFM &&
+                (!next_line() || strVec.size() != 2 || strVec[0] != "bias" || !Common::ParseNumber(strVec[1], m_bias)))
+            {
+                return load_failed("bias invalid");
+            }
+
+            if (!next_line() || strVec.size() != 1 || strVec[0] != "embedding")
+            {
+                return load_failed("embedding section missing");
+            }
+            m_embedding.resize(vocab, m_embSize);
+            if (m_type == DNNType::DeepFM)
+            {
+                m_linear.resize(vocab);
+                std::vector<score_type> row(m_embSize + 1);
+                for (int idx = 0; idx < vocab; idx++)
+                {
+                    if (!parse_row(m_embSize + 1, row.data()))
+                    {
+                        return load_failed("embedding row invalid");
+                    }
+                    m_linear[idx] = row[0];
+                    std::copy(row.begin() + 1, row.end(), m_embedding.row(idx).data());
+                }
+            }
+            else
+            {
+                for (int idx = 0; idx < vocab; idx++)
+                {
+                    if (!parse_row(m_embSize, m_embedding.row(idx).data()))
+                    {
+                        return load_failed("embedding row invalid");
+                    }
+                }
+            }
+
+            while (next_line() && strVec[0] == "dense")
+            {
+                int in = 0;
+                int out = 0;
+                DNNDenseLayer layer;
+                if (strVec.size() != 4 ||
+                    !Common::ParseNumber(strVec[1], in) ||
+                    !Common::ParseNumber(strVec[2], out) ||
+                    in <= 0 || out <= 0 ||
+                    !ParseActivation(strVec[3], layer.activation))
+                {
+                    return load_failed("dense invalid");
+                }
+                layer.kernel.resize(in, out);
+                layer.bias.resize(out);
+                for (int idx = 0; idx < in; idx++)
+                {
+                    if (!parse_row(out, layer.kernel.row(idx).data()))
+                    {
+                        return load_failed("dense kernel row invalid");
+                    }
+                }
+                if (!parse_row(out, layer.bias.data()))
+                {
+                    return load_failed("dense bias invalid");
+                }
+                m_vecDense.emplace_back(std::move(layer));
+            }
+
+            if (strVec.size() != 1 || strVec[0] != "end")
+            {
+                return load_failed("end missing");
+            }
+            if (!Check())
+            {
+                return load_failed("shape invalid");
+            }
+            return true;
+        }
+
+        // 保存模型文件, 浮点数按 %.9g 输出, 重新加载后逐位一致
+        bool SaveModelFile(const std::string &model_file_path) const
+        {
+            if (!Check())
+            {
+                return false;
+            }
+            FILE *pFile = fopen(model_file_path.c_str(), "w");
+            if (pFile == nullptr)
+            {
+                LOG(ERROR) << "DNNModelData::SaveModelFile() fopen Failed"
+                           << ", model_file_path = " << model_file_path;
+                return false;
+            }
+            auto write_row = [&](const score_type *row, const int count)
+            {
+                for (int idx = 0; idx < count; idx++)
+                {
+                    fprintf(pFile, idx == 0 ? "%.9g" : " %.9g", row[idx]);
+                }
+                fprintf(pFile, "\n");
+            };
+
+            fprintf(pFile, "dnn 1\n");
+            fprintf(pFile, "type %s\n", m_type == DNNType::DeepFM ? "deepfm" : "mlp");
+            fprintf(pFile, "input %d %d %d\n", m_fields, m_embSize, vocab());
+            fprintf(pFile, "output %s\n", ActivationName(m_output));
+            if (m_type == DNNType::DeepFM)
+            {
+                fprintf(pFile, "bias %.9g\n", m_bias);
+            }
+            fprintf(pFile, "embedding\n");
+            for (int idx = 0; idx < vocab(); idx++)
+            {
+                if (m_type == DNNType::DeepFM)
+                {
+                    fprintf(pFile, "%.9g ", m_linear[idx]);
+                }
+                write_row(m_embedding.row(idx).data(), m_embSize);
+            }
+            for (const auto &layer : m_vecDense)
+            {
+                fprintf(pFile, "dense %ld %ld %s\n", (long)layer.kernel.rows(), (long)layer.kernel.cols(),
+                        ActivationName(layer.activation));
+                for (int idx = 0; idx < layer.kernel.rows(); idx++)
+                {
+                    write_row(layer.kernel.row(idx).data(), layer.kernel.cols());
+                }
+                write_row(layer.bias.data(), layer.bias.cols());
+            }
+            fprintf(pFile, "end\n");
+            const bool succ = (ferror(pFile) == 0);
+            fclose(pFile);
+            if (!succ)
+            {
+                LOG(ERROR) << "DNNModelData::SaveModelFile() write Failed"
+                           << ", model_file_path = " << model_file_path;
+            }
+            return succ;
+        }
+
+        // 批量前向计算
+        // [in] index: [batch, fields] embedding 行号, 越界按缺失特征处理
+        // [in] value: [batch, fields] 特征权重
+        // [in] batch: item 数量
+        // [out] score: [batch] 输出分数
+        // 中间结果使用线程私有缓冲, 只在首次或 batch/模型变大时扩容, 扩容失败抛出 std::bad_alloc
+        void Forward(const int *index, const score_type *value, const int batch, score_type *score) const
+        {
+            thread_local std::vector<score_type> input;
+            thread_local std::vector<score_type> hidden[2];
+            thread_local std::vector<score_type> fm_sum;
+            thread_local std::vector<score_type> fm_sqr;
+
+            const int width = m_fields * m_embSize;
+            const int vocab_size = vocab();
+            for (int begin = 0; begin < batch; begin += DNN_BLOCK_ROWS)
+            {
+                const int rows = std::min(DNN_BLOCK_ROWS, batch - begin);
+                const int *block_index = index + (long)begin * m_fields;
+                const score_type *block_value = value + (long)begin * m_fields;
+
+                // 1. embedding 查表并拼接
+                input.resize((size_t)rows * width);
+                Eigen::Map<DNNMatrix> x(input.data(), rows, width);
+                for (int row = 0; row < rows; row++)
+                {
+                    for (int field = 0; field < m_fields; field++)
+                    {
+                        const int pos = row * m_fields + field;
+                        const int idx = block_index[pos];
+                        auto segment = x.row(row).segment(field * m_embSize, m_embSize);
+                        if ((unsigned)idx < (unsigned)vocab_size)
+                        {
+                            segment = m_embedding.row(idx) * block_value[pos];
+                        }
+                        else
+                        {
+                            segment.setZero();
+                        }
+                    }
+                }
+
+                // 2. 全连接层, 中间结果在两块缓冲之间交替
+                const score_type *prev = input.data();
+                int prev_cols = width;
+                for (size_t layer_idx = 0; layer_idx < m_vecDense.size(); layer_idx++)
+                {
+                    const auto &layer = m_vecDense[layer_idx];
+                    const int out = layer.kernel.cols();
+                    auto &buffer = hidden[layer_idx & 1];
+                    buffer.resize((size_t)rows * out);
+                    Eigen::Map<const DNNMatrix> h_in(prev, rows, prev_cols);
+                    Eigen::Map<DNNMatrix> h_out(buffer.data(), rows, out);
+                    h_out.noalias() = h_in * layer.kernel;
+                    h_out.rowwise() += layer.bias;
+                    Activate(layer.activation, h_out);
+                    prev = buffer.data();
+                    prev_cols = out;
+                }
+
+                // 3. deepfm 加上一阶项与 FM 二阶项, 二阶项由拼接后的 embedding 计算, 按列求和结果写入预分配缓冲
+                fm_sum.resize(m_embSize);
+                fm_sqr.resize(m_embSize);
+                Eigen::Map<DNNVector> sum(fm_sum.data(), m_embSize);
+                Eigen::Map<DNNVector> sqr(fm_sqr.data(), m_embSize);
+                for (int row = 0; row < rows; row++)
+                {
+                    score_type logit = prev[row];
+                    if (m_type == DNNType::DeepFM)
+                    {
+                        score_type first = m_bias;
+                        for (int field = 0; field < m_fields; field++)
+                        {
+                            const int pos = row * m_fields + field;
+                            const int idx = block_index[pos];
+                            if ((unsigned)idx < (unsigned)vocab_size)
+                            {
+                                first += m_linear[idx] * block_value[pos];
+                            }
+                        }
+                        Eigen::Map<const DNNMatrix> emb(x.row(row).data(), m_fields, m_embSize);
+                        sum.noalias() = emb.colwise().sum();
+                        sqr.noalias() = emb.array().square().colwise().sum().matrix();
+                        logit += first + 0.5f * (sum.array().square() - sqr.array()).sum();
+                    }
+                    score[begin + row] = Activate(m_output, logit);
+                }
+            }
+        }
+
+        template <typename T>
+        static void Activate(const DNNActivation activation, T &&h) noexcept
+        {
+            switch (activation)
+            {
+            case DNNActivation::ReLU:
+                h = h.cwiseMax(score_type(0));
+                break;
+            case DNNActivation::Sigmoid:
+                h = (1 + (-h.array()).exp()).inverse().matrix();
+                break;
+            case DNNActivation::Tanh:
+                h = h.array().tanh().matrix();
+                break;
+            default:
+                break;
+            }
+        }
+
+        static score_type Activate(const DNNActivation activation, const score_type x) noexcept
+        {
+            switch (activation)
+            {
+            case DNNActivation::ReLU:
+                return std::max(x, score_type(0));
+            case DNNActivation::Sigmoid:
+                return 1.0 / (1.0 + exp(-x));
+            case DNNActivation::Tanh:
+                return std::tanh(x);
+            default:
+                return x;
+            }
+        }
+
+        static bool ParseType(std::string_view str, DNNType &type) noexcept
+        {
+            if (str == "mlp")
+            {
+                type = DNNType::MLP;
+                return true;
+            }
+            if (str == "deepfm")
+            {
+                type = DNNType::DeepFM;
+                return true;
+            }
+            return false;
+        }
+
+        static bool ParseActivation(std::string_view str, DNNActivation &activation) noexcept
+        {
+            static constexpr DNNActivation all[] = {DNNActivation::None, DNNActivation::ReLU,
+                                                    DNNActivation::Sigmoid, DNNActivation::Tanh};
+            for (DNNActivation item : all)
+            {
+                if (str == ActivationName(item))
+                {
+                    activation = item;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        static const char *ActivationName(const DNNActivation activation) noexcept
+        {
+            switch (activation)
+            {
+            case DNNActivation::ReLU:
+                return "relu";
+            case DNNActivation::Sigmoid:
+                return "sigmoid";
+            case DNNActivation::Tanh:
+                return "tanh";
+            default:
+                return "none";
+            }
+        }
+    };
+}
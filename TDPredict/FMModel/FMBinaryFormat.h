@@ -0,0 +1,211 @@
+#pragma once
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "FMEmbeddingTable.h"
+#include "glog/logging.h"
+#include "Common/MappedFile.h"
+
+namespace TDPredict
+{
+    // FM 二进制模型格式
+    // 文本格式加载时需要逐行切分并解析每个数字, 大模型加载需要几十秒, 解析过程中新旧两份模型同时在堆上.
+    // 二进制格式直接保存 FMEmbeddingTable 的索引与行数据, 加载时 mmap 文件, 校验后直接用于预测, 不做解析与拷贝.
+    //
+    // 文件布局(小端, 各段起始按 64 字节对齐):
+    //   [FMBinaryHeader]  128 字节
+    //   [索引]            slot_count 个 FMEmbeddingTable::Slot, 开放寻址哈希表, 空槽 row = UINT32_MAX
+    //   [行数据]          rows * stride 个 float, 行布局见 FMKernel::RowStride, FP32 时每行 [w2[0], ..., w2[factor - 1], w1, 填充]
+    //
+    // 索引按 FMEmbeddingTable 的哈希函数与线性探测生成, 修改哈希函数或布局时需要升级 version.
+    // version 2 增加隐向量存储精度 precision(原 reserved0, version 1 文件中为 0, 即 FP32), 两个版本都可以加载.
+    // 映射期间文件不能被修改, 更新模型需要先写临时文件再 rename 替换(WriteFMBinary 已按此方式写入).
+    inline constexpr char FM_BINARY_MAGIC[8] = {'T', 'D', 'F', 'M', 'B', 'I', 'N', '\0'};
+    inline constexpr uint32_t FM_BINARY_VERSION = 2;
+
+    struct FMBinaryHeader
+    {
+        char magic[8];         // FM_BINARY_MAGIC
+        uint32_t version;      // FM_BINARY_VERSION
+        uint32_t header_size;  // sizeof(FMBinaryHeader)
+        int32_t factor;        // 隐向量维度
+        uint32_t stride;       // 每行 float 数
+        score_type w0;         // 偏置
+        uint32_t precision;    // FMPrecision
+        uint64_t rows;         // 行数
+        uint64_t slot_count;   // 索引槽数, 2 的幂
+        uint64_t slot_offset;  // 索引起始偏移
+        uint64_t row_offset;   // 行数据起始偏移
+        uint64_t file_size;    // 文件总长度
+        uint8_t reserved[56];  //
+    };
+    static_assert(sizeof(FMBinaryHeader) == 128, "FMBinaryHeader must be 128 bytes");
+
+    inline constexpr uint64_t FMBinaryAlign(const uint64_t offset) noexcept
+    {
+        return (offset + FMEmbeddingTable::ALIGN_BYTES - 1) / FMEmbeddingTable::ALIGN_BYTES * FMEmbeddingTable::ALIGN_BYTES;
+    }
+
+    // 判断数据是否为二进制模型
+    inline bool IsFMBinary(std::string_view data) noexcept
+    {
+        return data.size() >= sizeof(FM_BINARY_MAGIC) && memcmp(data.data(), FM_BINARY_MAGIC, sizeof(FM_BINARY_MAGIC)) == 0;
+    }
+
+    // 写入二进制模型, 先写 file_path.tmp 再 rename, 正在映射该文件的进程不受影响
+    // [in] file_path: 文件路径
+    // [in] w0: 偏置
+    // [in] table: 模型参数
+    // [ret] 返回成功or失败
+    inline bool WriteFMBinary(const std::string &file_path, const score_type w0, const FMEmbeddingTable &table)
+    {
+        FMBinaryHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, FM_BINARY_MAGIC, sizeof(FM_BINARY_MAGIC));
+        header.version = FM_BINARY_VERSION;
+        header.header_size = sizeof(FMBinaryHeader);
+        header.factor = table.factor();
+        header.stride = table.stride();
+        header.w0 = w0;
+        header.precision = static_cast<uint32_t>(table.precision());
+        header.rows = table.size();
+        header.slot_count = table.SlotCount();
+        header.slot_offset = FMBinaryAlign(sizeof(FMBinaryHeader));
+        header.row_offset = FMBinaryAlign(header.slot_offset + header.slot_count * sizeof(FMEmbeddingTable::Slot));
+        header.file_size = header.row_offset + header.rows * header.stride * sizeof(score_type);
+
+        const std::string tmp_path = file_path + ".tmp";
+        FILE *pFile = fopen(tmp_path.c_str(), "wb");
+        if (pFile == nullptr)
+        {
+            LOG(ERROR) << "WriteFMBinary() fopen Failed, file_path = " << tmp_path;
+            return false;
+        }
+
+        static const char padding[FMEmbeddingTable::ALIGN_BYTES] = {0};
+        uint64_t offset = 0;
+        auto write = [&](const void *data, const uint64_t size)
+        {
+            offset += size;
+            return size == 0 || fwrite(data, size, 1, pFile) == 1;
+        };
+        auto write_padding = [&](const uint64_t target)
+        {
+            return write(padding, target - offset);
+        };
+
+        bool succ = write(&header, sizeof(header)) &&
+                    write_padding(header.slot_offset) &&
+                    write(table.Slots(), header.slot_count * sizeof(FMEmbeddingTable::Slot)) &&
+                    write_padding(header.row_offset) &&
+                    write(table.Data(), header.rows * header.stride * sizeof(score_type));
+        succ = (fclose(pFile) == 0) && succ;
+        if (!succ || rename(tmp_path.c_str(), file_path.c_str()) != 0)
+        {
+            LOG(ERROR) << "WriteFMBinary() write Failed, file_path = " << file_path;
+            remove(tmp_path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    // 映射二进制模型, 校验通过后 table 直接引用映射内存
+    // [in] file: 已打开的映射文件, 成功后由 table 持有
+    // [in] factor: 配置的隐向量维度, 须与文件一致
+    // [in] precision: 配置的存储精度, 须与文件一致
+    // [out] w0: 偏置
+    // [out] table: 模型参数
+    // [ret] 返回成功or失败
+    inline bool MapFMBinary(
+        Common::MappedFile &&file,
+        const int factor,
+        const FMPrecision precision,
+        score_type &w0,
+        FMEmbeddingTable &table)
+    {
+        using Slot = FMEmbeddingTable::Slot;
+        if (file.size() < sizeof(FMBinaryHeader) || !IsFMBinary(file.data()))
+        {
+            LOG(ERROR) << "MapFMBinary() Failed, magic invalid, size = " << file.size();
+            return false;
+        }
+
+        FMBinaryHeader header;
+        memcpy(&header, file.data().data(), sizeof(header));
+        if (header.version < 1 || header.version > FM_BINARY_VERSION || header.header_size != sizeof(FMBinaryHeader))
+        {
+            LOG(ERROR) << "MapFMBinary() Failed, version unsupported"
+                       << ", version = " << header.version
+                       << ", header_size = " << header.header_size;
+            return false;
+        }
+        if (header.factor != factor ||
+            header.precision != static_cast<uint32_t>(precision) ||
+            header.stride != FMEmbeddingTable::Stride(factor, precision))
+        {
+            LOG(ERROR) << "MapFMBinary() Failed, factor or precision mismatch"
+                       << ", factor = " << factor
+                       << ", precision = " << static_cast<uint32_t>(precision)
+                       << ", header.factor = " << header.factor
+                       << ", header.precision = " << header.precision
+                       << ", header.stride = " << header.stride;
+            return false;
+        }
+
+        // 各段位置与长度, 乘法先按上限检查, 避免溢出
+        const uint64_t max_count = file.size() / sizeof(score_type);
+        const bool layout_valid =
+            header.file_size == file.size() &&
+            header.rows < FMEmbeddingTable::EMPTY_ROW &&
+            header.rows <= max_count / header.stride &&
+            header.slot_count >= 16 && (header.slot_count & (header.slot_count - 1)) == 0 &&
+            header.slot_count >= header.rows * 2 &&
+            header.slot_count <= file.size() / sizeof(Slot) &&
+            header.slot_offset == FMBinaryAlign(sizeof(FMBinaryHeader)) &&
+            header.row_offset == FMBinaryAlign(header.slot_offset + header.slot_count * sizeof(Slot)) &&
+            header.row_offset + header.rows * header.stride * sizeof(score_type) == header.file_size;
+        if (!layout_valid)
+        {
+            LOG(ERROR) << "MapFMBinary() Failed, layout invalid"
+                       << ", file_size = " << file.size()
+                       << ", header.file_size = " << header.file_size
+                       << ", rows = " << header.rows
+                       << ", slot_count = " << header.slot_count
+                       << ", slot_offset = " << header.slot_offset
+                       << ", row_offset = " << header.row_offset;
+            return false;
+        }
+
+        // 索引中的行号必须有效, 否则查找会越界, 顺序扫描一遍索引(约为行数据的 1/3 ~ 1/2)
+        const Slot *slots = reinterpret_cast<const Slot *>(file.data().data() + header.slot_offset);
+        uint64_t used = 0;
+        for (uint64_t pos = 0; pos < header.slot_count; pos++)
+        {
+            if (slots[pos].row != FMEmbeddingTable::EMPTY_ROW)
+            {
+                if (slots[pos].row >= header.rows)
+                {
+                    LOG(ERROR) << "MapFMBinary() Failed, slot row invalid"
+                               << ", pos = " << pos
+                               << ", row = " << slots[pos].row;
+                    return false;
+                }
+                used++;
+            }
+        }
+        if (used != header.rows)
+        {
+            LOG(ERROR) << "MapFMBinary() Failed, slot count mismatch"
+                       << ", used = " << used
+                       << ", rows = " << header.rows;
+            return false;
+        }
+
+        const score_type *data = reinterpret_cast<const score_type *>(file.data().data() + header.row_offset);
+        w0 = header.w0;
+        table.Attach(factor, header.rows, slots, header.slot_count, data, std::move(file), precision);
+        return true;
+    }
+}
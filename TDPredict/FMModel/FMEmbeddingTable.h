@@ -0,0 +1,377 @@
+#pragma once
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include "../Interface/ModelInterface.h"
+#include "Common/MappedFile.h"
+#include "FMKernel.h"
+
+namespace TDPredict
+{
+    // FM 模型参数表
+    // 原方案 m_w1/m_w2 是两个 unordered_map, 每个特征要两次哈希查找, 并且 w2 是单独分配的 vector,
+    // 查找要经过 桶->节点->vector->堆内存 多次跳转.
+    // 这里使用一个开放寻址哈希表把特征映射到行号, 每行的 w2 与 w1 连续存放在同一块按缓存行对齐的内存中:
+    //   row = [w2[0], ..., w2[factor - 1], w1, 填充到 16 个 float 的整数倍]
+    // 每个特征只需要一次查找, factor <= 15 时一行正好是一个缓存行.
+    // 隐向量可选 FP16 / INT8 存储(行布局见 FMKernel::RowStride), factor = 64 时每行从 320 字节降为 192 / 128 字节.
+    //
+    // 只在加载时写入, 加载完成后只读, 多线程读取无需加锁.
+    // 索引与行数据也可以直接指向二进制模型文件的映射内存(见 FMBinaryFormat.h), 此时不再占用堆内存.
+    class FMEmbeddingTable
+    {
+    public:
+        static constexpr size_t ALIGN_BYTES = 64;
+        static constexpr size_t ALIGN_FLOATS = ALIGN_BYTES / sizeof(score_type);
+        static constexpr uint32_t EMPTY_ROW = UINT32_MAX;
+
+        // 索引槽, 同时是二进制文件中的索引格式, 布局固定为 16 字节
+        struct Slot
+        {
+            int64_t key = 0;
+            uint32_t row = EMPTY_ROW;
+            uint32_t reserved = 0;
+        };
+        static_assert(sizeof(Slot) == 16, "FMEmbeddingTable::Slot must be 16 bytes");
+
+        // 每行 float 数
+        static constexpr size_t Stride(const int factor, const FMPrecision precision = FMPrecision::FP32) noexcept
+        {
+            return FMKernel::RowStride(factor, precision);
+        }
+
+    private:
+        struct FreeDeleter
+        {
+            void operator()(score_type *ptr) const noexcept { free(ptr); }
+        };
+
+    public:
+        FMEmbeddingTable() {}
+        FMEmbeddingTable(const FMEmbeddingTable &) = delete;
+        FMEmbeddingTable &operator=(const FMEmbeddingTable &) = delete;
+
+        // 清空并按预计行数预分配
+        // [in] factor: 隐向量维度
+        // [in] expect_rows: 预计行数, 加载前可以用文件行数估算, 超出后自动扩容
+        // [in] precision: 隐向量存储精度
+        void Reset(const int factor, const size_t expect_rows = 0, const FMPrecision precision = FMPrecision::FP32)
+        {
+            m_factor = std::max(factor, 0);
+            m_precision = precision;
+            m_stride = Stride(m_factor, m_precision);
+            m_w1Offset = FMKernel::W1Offset(m_factor, m_precision);
+            m_rows = 0;
+            m_capacity = 0;
+            m_slab.reset();
+            m_vecSlot.clear();
+            m_mask = 0;
+            m_mapped.Close();
+            m_slots = nullptr;
+            m_data = nullptr;
+            ReserveRows(std::max<size_t>(expect_rows, 16));
+            Rehash(expect_rows);
+        }
+
+        void Clear()
+        {
+            Reset(0);
+        }
+
+        // 使用映射内存中的索引与行数据, 不拷贝
+        // [in] factor: 隐向量维度
+        // [in] rows: 行数
+        // [in] slots: 索引, 长度 slot_count, 须为 2 的幂, 且由同一哈希与线性探测生成
+        // [in] slot_count: 索引槽数
+        // [in] data: 行数据, rows * Stride(factor, precision) 个 float, 64 字节对齐
+        // [in] file: 映射文件, 由本表持有, Reset/Clear 时释放
+        // [in] precision: 隐向量存储精度
+        void Attach(
+            const int factor,
+            const size_t rows,
+            const Slot *slots,
+            const size_t slot_count,
+            const score_type *data,
+            Common::MappedFile &&file,
+            const FMPrecision precision = FMPrecision::FP32)
+        {
+            Reset(factor, 0, precision);
+            m_slab.reset();
+            m_vecSlot.clear();
+            m_vecSlot.shrink_to_fit();
+            m_capacity = 0;
+            m_rows = rows;
+            m_slots = slots;
+            m_mask = slot_count - 1;
+            m_data = data;
+            m_mapped = std::move(file);
+        }
+
+        // 写入一行, 特征已存在时覆盖(与 map[key] = value 一致)
+        // [in] key: 特征 field_value
+        // [in] w1: 一阶权重
+        // [in] w2: 隐向量, 长度为 factor, 按存储精度量化
+        // [ret] 映射文件的表只读, 返回 false 且不修改表, 需要写入时先 Reset
+        bool Add(const long key, const score_type w1, const score_type *w2)
+        {
+            if (mapped())
+            {
+                return false;
+            }
+            if ((m_rows + 1) * 2 > m_vecSlot.size())
+            {
+                Rehash(m_rows + 1);
+            }
+
+            Slot &slot = Probe(key);
+            if (slot.row == EMPTY_ROW)
+            {
+                if (m_rows == m_capacity)
+                {
+                    ReserveRows(m_capacity * 2);
+                }
+                slot.key = key;
+                slot.row = m_rows++;
+            }
+
+            score_type *row = m_slab.get() + (size_t)slot.row * m_stride;
+            Encode(w2, row);
+            row[m_w1Offset] = w1;
+            return true;
+        }
+
+        // 查找特征, 返回该行起始地址, 不存在返回 nullptr
+        // FP32 时即 w2, 其他精度需要按 FMKernel 的行布局读取, 或用 Decode 反量化
+        inline const score_type *Find(const long key) const noexcept
+        {
+            if (m_rows == 0)
+            {
+                return nullptr;
+            }
+            size_t pos = Hash(key) & m_mask;
+            while (true)
+            {
+                const Slot &slot = m_slots[pos];
+                if (slot.row == EMPTY_ROW)
+                {
+                    return nullptr;
+                }
+                if (slot.key == key)
+                {
+                    return m_data + (size_t)slot.row * m_stride;
+                }
+                pos = (pos + 1) & m_mask;
+            }
+        }
+
+        // 预取特征所在的哈希槽, 批量查找时提前发起内存访问
+        inline void Prefetch(const long key) const noexcept
+        {
+            if (m_rows != 0)
+            {
+                __builtin_prefetch(&m_slots[Hash(key) & m_mask]);
+            }
+        }
+
+        // 行内的一阶权重
+        inline score_type W1(const score_type *row) const noexcept
+        {
+            return row[m_w1Offset];
+        }
+
+        // 行内的隐向量反量化为 float
+        // [in] row: 行起始地址
+        // [out] w2: 长度 factor
+        void Decode(const score_type *row, score_type *w2) const noexcept
+        {
+            switch (m_precision)
+            {
+            case FMPrecision::FP16:
+                for (int f_idx = 0; f_idx < m_factor; f_idx++)
+                {
+                    w2[f_idx] = FMKernel::HalfToFloat(reinterpret_cast<const uint16_t *>(row)[f_idx]);
+                }
+                break;
+            case FMPrecision::INT8:
+                for (int f_idx = 0; f_idx < m_factor; f_idx++)
+                {
+                    w2[f_idx] = (score_type)reinterpret_cast<const int8_t *>(row)[f_idx] * row[m_w1Offset + 1];
+                }
+                break;
+            default:
+                memcpy(w2, row, m_factor * sizeof(score_type));
+                break;
+            }
+        }
+
+        // 行号对应的行起始地址, 用于遍历 [0, size())
+        inline const score_type *Row(const size_t row) const noexcept
+        {
+            return m_data + row * m_stride;
+        }
+
+        // 行号对应的特征, 用于遍历或导出
+        std::vector<long> Keys() const
+        {
+            std::vector<long> vecKey(m_rows, 0);
+            for (size_t pos = 0; pos < SlotCount(); pos++)
+            {
+                const Slot &slot = m_slots[pos];
+                if (slot.row != EMPTY_ROW)
+                {
+                    vecKey[slot.row] = slot.key;
+                }
+            }
+            return vecKey;
+        }
+
+        int factor() const noexcept { return m_factor; }
+        size_t size() const noexcept { return m_rows; }
+        size_t stride() const noexcept { return m_stride; }
+        FMPrecision precision() const noexcept { return m_precision; }
+        bool empty() const noexcept { return m_rows == 0; }
+        bool mapped() const noexcept { return !m_mapped.empty(); }
+
+        // 索引, 用于导出二进制文件
+        const Slot *Slots() const noexcept { return m_slots; }
+        size_t SlotCount() const noexcept { return m_slots == nullptr ? 0 : m_mask + 1; }
+
+        // 行数据, size() * stride() 个 float
+        const score_type *Data() const noexcept
+        {
+            return m_data;
+        }
+
+        // 占用堆内存字节数, 映射时为 0
+        size_t MemoryBytes() const noexcept
+        {
+            return m_capacity * m_stride * sizeof(score_type) + m_vecSlot.size() * sizeof(Slot);
+        }
+
+    private:
+        // 按存储精度写入隐向量
+        // INT8 每行取 max(|w2|) / 127 作为缩放系数, 四舍五入到最近的整数
+        void Encode(const score_type *w2, score_type *row) const noexcept
+        {
+            switch (m_precision)
+            {
+            case FMPrecision::FP16:
+                for (int f_idx = 0; f_idx < m_factor; f_idx++)
+                {
+                    reinterpret_cast<uint16_t *>(row)[f_idx] = FMKernel::FloatToHalf(w2[f_idx]);
+                }
+                break;
+            case FMPrecision::INT8:
+            {
+                score_type max_abs = 0;
+                for (int f_idx = 0; f_idx < m_factor; f_idx++)
+                {
+                    max_abs = std::max(max_abs, std::fabs(w2[f_idx]));
+                }
+                const score_type scale = max_abs / 127;
+                for (int f_idx = 0; f_idx < m_factor; f_idx++)
+                {
+                    const long q = scale > 0 ? lrintf(w2[f_idx] / scale) : 0;
+                    reinterpret_cast<int8_t *>(row)[f_idx] = (int8_t)std::clamp(q, -127L, 127L);
+                }
+                row[m_w1Offset + 1] = scale;
+                break;
+            }
+            default:
+                memcpy(row, w2, m_factor * sizeof(score_type));
+                break;
+            }
+        }
+
+        static inline size_t Hash(const long key) noexcept
+        {
+            // murmur3 fmix64, field_value 高32位是 field, 低位是连续的 value, 需要充分打散
+            uint64_t h = (uint64_t)key;
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ULL;
+            h ^= h >> 33;
+            return h;
+        }
+
+        Slot &Probe(const long key) noexcept
+        {
+            size_t pos = Hash(key) & m_mask;
+            while (m_vecSlot[pos].row != EMPTY_ROW && m_vecSlot[pos].key != key)
+            {
+                pos = (pos + 1) & m_mask;
+            }
+            return m_vecSlot[pos];
+        }
+
+        // 扩展行存储, 保留已有数据
+        void ReserveRows(const size_t rows)
+        {
+            if (rows <= m_capacity)
+            {
+                return;
+            }
+            const size_t bytes = rows * m_stride * sizeof(score_type);
+            score_type *ptr = static_cast<score_type *>(aligned_alloc(ALIGN_BYTES, std::max(bytes, ALIGN_BYTES)));
+            if (ptr == nullptr)
+            {
+                throw std::bad_alloc();
+            }
+            memset(ptr, 0, bytes);
+            if (m_rows > 0)
+            {
+                memcpy(ptr, m_slab.get(), m_rows * m_stride * sizeof(score_type));
+            }
+            m_slab.reset(ptr);
+            m_data = ptr;
+            m_capacity = rows;
+        }
+
+        // 重建索引, 负载因子不超过 0.5
+        void Rehash(const size_t rows)
+        {
+            size_t slots = 16;
+            while (slots < rows * 2)
+            {
+                slots *= 2;
+            }
+            if (slots <= m_vecSlot.size())
+            {
+                return;
+            }
+
+            std::vector<Slot> vecOld;
+            vecOld.swap(m_vecSlot);
+            m_vecSlot.assign(slots, Slot());
+            m_slots = m_vecSlot.data();
+            m_mask = slots - 1;
+            for (const auto &slot : vecOld)
+            {
+                if (slot.row != EMPTY_ROW)
+                {
+                    Probe(slot.key) = slot;
+                }
+            }
+        }
+
+    private:
+        int m_factor = 0;
+        FMPrecision m_precision = FMPrecision::FP32;
+        size_t m_stride = ALIGN_FLOATS; // 每行 float 数
+        size_t m_w1Offset = 0;          // w1 在行内的位置
+        size_t m_rows = 0;
+        size_t m_capacity = 0;
+        std::unique_ptr<score_type, FreeDeleter> m_slab;
+        std::vector<Slot> m_vecSlot;
+        size_t m_mask = 0;
+
+        // 查找使用的索引与行数据, 指向上面的堆内存或 m_mapped
+        Common::MappedFile m_mapped;
+        const Slot *m_slots = nullptr;
+        const score_type *m_data = nullptr;
+    };
+}
@@ -0,0 +1,385 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "../Interface/ModelInterface.h"
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace TDPredict
+{
+    // FM 二阶项累加内核
+    // 对每个命中的特征 i, 以及每个维度 f:
+    //   d = w2[i][f] * x[i]
+    //   sum[f] += d
+    //   sqr[f] += d * d
+    // 常用维度(8/16/32/64)按模板特化, 累加结果整批保存在寄存器中, 只在开始和结束时读写 sum/sqr.
+    // 运行时按 CPU 支持情况选择 AVX-512 / AVX2 实现, 其他维度或不支持的 CPU 使用标量实现.
+    //
+    // 隐向量按 FMPrecision 存储, 内核读取时先反量化为 float 再累加:
+    //   FP16: w2 = half_to_float(h)
+    //   INT8: w2 = (float)q * scale, scale 为每行的缩放系数
+    //
+    // 精度: SIMD 实现逐维度按相同顺序做乘法和加法, 不使用 FMA(FMA 少一次舍入, 结果会与标量不同),
+    // 因此与标量实现逐位一致. 标量实现需按默认的 x86-64 基础指令集编译, 开启 -mfma/-march=native 时
+    // 编译器可能把标量乘加合并为 FMA, 此时两者相差在 1 ulp 量级.
+    // AVX-512 在部分 CPU 上会降频, factor = 8 只需要一个 256 位寄存器, 始终使用 AVX2.
+    namespace FMKernel
+    {
+        // 行布局(字节), 每行按 64 字节对齐:
+        //   [w2: factor 个元素][对齐到 4 字节][w1: float][scale: float, 仅 INT8][填充]
+        // FP32 时与 [w2[0], ..., w2[factor - 1], w1, 填充] 一致
+        inline constexpr size_t ElementBytes(const FMPrecision precision) noexcept
+        {
+            return precision == FMPrecision::FP16 ? 2 : (precision == FMPrecision::INT8 ? 1 : sizeof(score_type));
+        }
+
+        // w1 在行内的位置(float 下标), INT8 的 scale 紧随其后
+        inline constexpr size_t W1Offset(const int factor, const FMPrecision precision) noexcept
+        {
+            return (std::max(factor, 0) * ElementBytes(precision) + sizeof(score_type) - 1) / sizeof(score_type);
+        }
+
+        // 每行 float 数, 64 字节的整数倍
+        inline constexpr size_t RowStride(const int factor, const FMPrecision precision) noexcept
+        {
+            const size_t floats = W1Offset(factor, precision) + (precision == FMPrecision::INT8 ? 2 : 1);
+            return (floats + 15) / 16 * 16;
+        }
+
+        // float 转半精度, 就近舍入到偶数, 与 F16C vcvtps2ph 一致
+        inline uint16_t FloatToHalf(const float value) noexcept
+        {
+            uint32_t bits = 0;
+            memcpy(&bits, &value, sizeof(bits));
+            const uint16_t sign = (bits >> 16) & 0x8000;
+            uint32_t abs = bits & 0x7FFFFFFF;
+            if (abs >= 0x7F800000) // inf / nan
+            {
+                return sign | 0x7C00 | (abs > 0x7F800000 ? 0x200 : 0);
+            }
+            if (abs >= 0x477FF000) // 舍入后超出半精度范围
+            {
+                return sign | 0x7C00;
+            }
+            if (abs < 0x38800000) // 半精度非规格化数, 单位 2^-24
+            {
+                float abs_value = 0;
+                memcpy(&abs_value, &abs, sizeof(abs_value));
+                return sign | (uint16_t)lrintf(abs_value * 16777216.0f);
+            }
+            abs += 0xC8000FFF + ((abs >> 13) & 1); // 指数偏移 127 -> 15, 并就近舍入到偶数
+            return sign | (uint16_t)(abs >> 13);
+        }
+
+        // 半精度转 float, 结果精确
+        inline float HalfToFloat(const uint16_t half) noexcept
+        {
+            const uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+            const uint32_t exp = (half >> 10) & 0x1F;
+            const uint32_t mant = half & 0x3FF;
+            uint32_t bits = 0;
+            if (exp == 0)
+            {
+                const float value = (float)mant * (1.0f / 16777216.0f);
+                memcpy(&bits, &value, sizeof(bits));
+                bits |= sign;
+            }
+            else if (exp == 0x1F)
+            {
+                bits = sign | 0x7F800000 | (mant << 13);
+            }
+            else
+            {
+                bits = sign | ((exp + 112) << 23) | (mant << 13);
+            }
+            float value = 0;
+            memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+        // [in] rows: 每个特征的行起始地址, 按 FMPrecision 解释
+        // [in] weights: 每个特征的取值 x
+        // [in] count: 特征数量
+        // [in] factor: 隐向量维度
+        // [in/out] sum: 长度 factor
+        // [in/out] sqr: 长度 factor
+        using AccumulateFunc = void (*)(
+            const score_type *const *rows,
+            const score_type *weights,
+            const int count,
+            const int factor,
+            score_type *sum,
+            score_type *sqr);
+
+        inline void accumulate_scalar(
+            const score_type *const *rows,
+            const score_type *weights,
+            const int count,
+            const int factor,
+            score_type *sum,
+            score_type *sqr)
+        {
+            for (int idx = 0; idx < count; idx++)
+            {
+                const score_type *w2 = rows[idx];
+                const score_type x = weights[idx];
+                for (int f_idx = 0; f_idx < factor; ++f_idx)
+                {
+                    score_type d = w2[f_idx] * x;
+                    sum[f_idx] += d;
+                    sqr[f_idx] += (d * d);
+                }
+            }
+        }
+
+        // 量化存储的标量实现
+        template <FMPrecision PRECISION>
+        void accumulate_scalar_dequant(
+            const score_type *const *rows,
+            const score_type *weights,
+            const int count,
+            const int factor,
+            score_type *sum,
+            score_type *sqr)
+        {
+            static_assert(PRECISION != FMPrecision::FP32, "use accumulate_scalar");
+            const size_t scale_offset = W1Offset(factor, PRECISION) + 1;
+            for (int idx = 0; idx < count; idx++)
+            {
+                const score_type x = weights[idx];
+                for (int f_idx = 0; f_idx < factor; ++f_idx)
+                {
+                    score_type w2 = 0;
+                    if constexpr (PRECISION == FMPrecision::FP16)
+                    {
+                        w2 = HalfToFloat(reinterpret_cast<const uint16_t *>(rows[idx])[f_idx]);
+                    }
+                    else
+                    {
+                        w2 = (score_type)reinterpret_cast<const int8_t *>(rows[idx])[f_idx] * rows[idx][scale_offset];
+                    }
+                    score_type d = w2 * x;
+                    sum[f_idx] += d;
+                    sqr[f_idx] += (d * d);
+                }
+            }
+        }
+
+#if defined(__x86_64__)
+        template <int FACTOR, FMPrecision PRECISION = FMPrecision::FP32>
+        __attribute__((target("avx2,f16c"))) void accumulate_avx2(
+            const score_type *const *rows,
+            const score_type *weights,
+            const int count,
+            const int,
+            score_type *sum,
+            score_type *sqr)
+        {
+            static_assert(FACTOR % 8 == 0, "FACTOR must be multiple of 8");
+            constexpr int N = FACTOR / 8;
+            constexpr size_t SCALE_OFFSET = W1Offset(FACTOR, PRECISION) + 1;
+            __m256 acc_sum[N];
+            __m256 acc_sqr[N];
+            for (int n = 0; n < N; n++)
+            {
+                acc_sum[n] = _mm256_loadu_ps(sum + n * 8);
+                acc_sqr[n] = _mm256_loadu_ps(sqr + n * 8);
+            }
+            for (int idx = 0; idx < count; idx++)
+            {
+                const score_type *row = rows[idx];
+                const __m256 x = _mm256_set1_ps(weights[idx]);
+                for (int n = 0; n < N; n++)
+                {
+                    __m256 w2;
+                    if constexpr (PRECISION == FMPrecision::FP16)
+                    {
+                        w2 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(reinterpret_cast<const uint16_t *>(row) + n * 8)));
+                    }
+                    else if constexpr (PRECISION == FMPrecision::INT8)
+                    {
+                        const __m128i q = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(reinterpret_cast<const int8_t *>(row) + n * 8));
+                        w2 = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(q)), _mm256_set1_ps(row[SCALE_OFFSET]));
+                    }
+                    else
+                    {
+                        w2 = _mm256_loadu_ps(row + n * 8);
+                    }
+                    const __m256 d = _mm256_mul_ps(w2, x);
+                    acc_sum[n] = _mm256_add_ps(acc_sum[n], d);
+                    acc_sqr[n] = _mm256_add_ps(acc_sqr[n], _mm256_mul_ps(d, d));
+                }
+            }
+            for (int n = 0; n < N; n++)
+            {
+                _mm256_storeu_ps(sum + n * 8, acc_sum[n]);
+                _mm256_storeu_ps(sqr + n * 8, acc_sqr[n]);
+            }
+        }
+
+        template <int FACTOR, FMPrecision PRECISION = FMPrecision::FP32>
+        __attribute__((target("avx512f"))) void accumulate_avx512(
+            const score_type *const *rows,
+            const score_type *weights,
+            const int count,
+            const int,
+            score_type *sum,
+            score_type *sqr)
+        {
+            static_assert(FACTOR % 16 == 0, "FACTOR must be multiple of 16");
+            constexpr int N = FACTOR / 16;
+            constexpr size_t SCALE_OFFSET = W1Offset(FACTOR, PRECISION) + 1;
+            // GCC 的非掩码 AVX-512 内建函数以 _mm512_undefined_ps() 作为透传值, 会触发 -Wmaybe-uninitialized,
+            // 这里统一使用全掩码的 maskz 版本 (透传值为 _mm512_setzero_ps()), 结果与非掩码版本一致
+            constexpr __mmask16 ALL = 0xFFFF;
+            __m512 acc_sum[N];
+            __m512 acc_sqr[N];
+            for (int n = 0; n < N; n++)
+            {
+                acc_sum[n] = _mm512_loadu_ps(sum + n * 16);
+                acc_sqr[n] = _mm512_loadu_ps(sqr + n * 16);
+            }
+            for (int idx = 0; idx < count; idx++)
+            {
+                const score_type *row = rows[idx];
+                const __m512 x = _mm512_set1_ps(weights[idx]);
+                for (int n = 0; n < N; n++)
+                {
+                    // GCC 的 _mm512_mul_ps/_mm512_add_ps 是普通向量运算, 会被合并为 FMA, 这里使用带舍入参数的版本
+                    __m512 w2;
+                    if constexpr (PRECISION == FMPrecision::FP16)
+                    {
+                        w2 = _mm512_maskz_cvtph_ps(ALL, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(reinterpret_cast<const uint16_t *>(row) + n * 16)));
+                    }
+                    else if constexpr (PRECISION == FMPrecision::INT8)
+                    {
+                        const __m128i q = _mm_loadu_si128(reinterpret_cast<const __m128i *>(reinterpret_cast<const int8_t *>(row) + n * 16));
+                        w2 = _mm512_maskz_mul_round_ps(ALL, _mm512_maskz_cvtepi32_ps(ALL, _mm512_maskz_cvtepi8_epi32(ALL, q)), _mm512_set1_ps(row[SCALE_OFFSET]), _MM_FROUND_CUR_DIRECTION);
+                    }
+                    else
+                    {
+                        w2 = _mm512_loadu_ps(row + n * 16);
+                    }
+                    const __m512 d = _mm512_maskz_mul_round_ps(ALL, w2, x, _MM_FROUND_CUR_DIRECTION);
+                    acc_sum[n] = _mm512_maskz_add_round_ps(ALL, acc_sum[n], d, _MM_FROUND_CUR_DIRECTION);
+                    acc_sqr[n] = _mm512_maskz_add_round_ps(ALL, acc_sqr[n], _mm512_maskz_mul_round_ps(ALL, d, d, _MM_FROUND_CUR_DIRECTION), _MM_FROUND_CUR_DIRECTION);
+                }
+            }
+            for (int n = 0; n < N; n++)
+            {
+                _mm512_storeu_ps(sum + n * 16, acc_sum[n]);
+                _mm512_storeu_ps(sqr + n * 16, acc_sqr[n]);
+            }
+        }
+#endif
+
+        // 指令集级别
+        enum class ISA
+        {
+            Scalar = 0,
+            AVX2 = 1,
+            AVX512 = 2,
+        };
+
+        // 当前 CPU 支持的最高指令集, AVX2 级别同时要求 F16C(用于 FP16 反量化)
+        inline ISA DetectISA() noexcept
+        {
+#if defined(__x86_64__)
+            static const ISA isa = []()
+            {
+                __builtin_cpu_init();
+                if (__builtin_cpu_supports("avx512f"))
+                {
+                    return ISA::AVX512;
+                }
+                if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c"))
+                {
+                    return ISA::AVX2;
+                }
+                return ISA::Scalar;
+            }();
+            return isa;
+#else
+            return ISA::Scalar;
+#endif
+        }
+
+#if defined(__x86_64__)
+        template <FMPrecision PRECISION>
+        inline AccumulateFunc GetAccumulateSIMD(const int factor, const ISA isa) noexcept
+        {
+            if (isa >= ISA::AVX512)
+            {
+                switch (factor)
+                {
+                case 16:
+                    return accumulate_avx512<16, PRECISION>;
+                case 32:
+                    return accumulate_avx512<32, PRECISION>;
+                case 64:
+                    return accumulate_avx512<64, PRECISION>;
+                default:
+                    break;
+                }
+            }
+            if (isa >= ISA::AVX2)
+            {
+                switch (factor)
+                {
+                case 8:
+                    return accumulate_avx2<8, PRECISION>;
+                case 16:
+                    return accumulate_avx2<16, PRECISION>;
+                case 32:
+                    return accumulate_avx2<32, PRECISION>;
+                case 64:
+                    return accumulate_avx2<64, PRECISION>;
+                default:
+                    break;
+                }
+            }
+            return nullptr;
+        }
+#endif
+
+        // 按维度, 存储精度与指令集选择实现, max_isa 用于测试或强制降级
+        inline AccumulateFunc GetAccumulate(
+            const int factor,
+            ISA max_isa = ISA::AVX512,
+            const FMPrecision precision = FMPrecision::FP32) noexcept
+        {
+            AccumulateFunc func = nullptr;
+#if defined(__x86_64__)
+            const ISA isa = std::min(DetectISA(), max_isa);
+            switch (precision)
+            {
+            case FMPrecision::FP16:
+                func = GetAccumulateSIMD<FMPrecision::FP16>(factor, isa);
+                break;
+            case FMPrecision::INT8:
+                func = GetAccumulateSIMD<FMPrecision::INT8>(factor, isa);
+                break;
+            default:
+                func = GetAccumulateSIMD<FMPrecision::FP32>(factor, isa);
+                break;
+            }
+#endif
+            if (func != nullptr)
+            {
+                return func;
+            }
+            switch (precision)
+            {
+            case FMPrecision::FP16:
+                return accumulate_scalar_dequant<FMPrecision::FP16>;
+            case FMPrecision::INT8:
+                return accumulate_scalar_dequant<FMPrecision::INT8>;
+            default:
+                return accumulate_scalar;
+            }
+        }
+    }
+}
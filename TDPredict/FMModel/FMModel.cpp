@@ -1,43 +1,376 @@
 #include "FMModel.h"
 #include "FMTrans.h"
 #include <cmath>
+#include <algorithm>
+#include <shared_mutex>
 #include "glog/logging.h"
+#include "Common/Clock.h"
 #include "Common/Function.h"
+#include "Common/Arena.h"
 using namespace TDPredict;
 
 bool FMModel::Init(
     int factor,
     const std::string &model_file_path,
-    const std::string &filter_file_path)
+    const std::string &filter_file_path,
+    FMPrecision precision)
 {
-    return Update(factor, model_file_path, filter_file_path);
+    return Update(factor, model_file_path, filter_file_path, precision);
 }
 
 bool FMModel::Update(
     int factor,
     const std::string &model_file_path,
-    const std::string &filter_file_path)
+    const std::string &filter_file_path,
+    FMPrecision precision)
 {
     std::lock_guard<std::mutex> lg(m_updateModelLock);
+    auto spVersion = DoStage(factor, model_file_path, filter_file_path, precision, m_spGolden);
+    if (spVersion == nullptr)
+    {
+        return false;
+    }
+    DoPublish(std::move(spVersion));
+    return true;
+}
 
-    // 缓存下标
-    int data_idx = (m_modelDataIdx + 1) % 2;
-    if (!m_modelData[data_idx].LoadModelFile(factor, model_file_path))
+std::shared_ptr<const FMModel::Version> FMModel::Stage(
+    int factor,
+    const std::string &model_file_path,
+    const std::string &filter_file_path,
+    FMPrecision precision,
+    std::shared_ptr<const std::vector<FMGoldenRequest>> spGolden)
+{
+    std::lock_guard<std::mutex> lg(m_updateModelLock);
+    return DoStage(factor, model_file_path, filter_file_path, precision,
+                   spGolden != nullptr ? std::move(spGolden) : m_spGolden);
+}
+
+bool FMModel::Publish(std::shared_ptr<const Version> spVersion)
+{
+    if (spVersion == nullptr)
     {
-        m_modelData[data_idx].Clear();
+        LOG(ERROR) << "FMModel::Publish() Failed, spVersion == nullptr"
+                   << ", model_name = " << GetName();
         return false;
     }
+    std::lock_guard<std::mutex> lg(m_updateModelLock);
+    DoPublish(std::move(spVersion));
+    return true;
+}
+
+std::shared_ptr<const FMModel::Version> FMModel::DoStage(
+    int factor,
+    const std::string &model_file_path,
+    const std::string &filter_file_path,
+    FMPrecision precision,
+    std::shared_ptr<const std::vector<FMGoldenRequest>> spGolden)
+{
+    Reclaim();
+
+    auto stage_failed = [&](const std::string &error)
+    {
+        LOG(ERROR) << "FMModel::Update() Failed, keep current version"
+                   << ", model_name = " << GetName()
+                   << ", model_file_path = " << model_file_path
+                   << ", filter_file_path = " << filter_file_path
+                   << ", error = " << error;
+        std::lock_guard<std::mutex> lock(m_statsLock);
+        m_stats.fail_count++;
+        m_stats.last_error = error;
+        return nullptr;
+    };
+
+    // 1. 加载为独立版本, 正在服务的版本不受影响
+    Common::Stopwatch sw;
+    auto spVersion = std::make_shared<Version>();
+    spVersion->version = m_nextVersion++;
+    spVersion->model_file_path = model_file_path;
+    spVersion->spGolden = std::move(spGolden);
+    if (!spVersion->model_data.LoadModelFile(factor, model_file_path, precision))
+    {
+        return stage_failed("LoadModelFile Failed");
+    }
+    if (!spVersion->trans_data.LoadTransFile(filter_file_path))
+    {
+        return stage_failed("LoadTransFile Failed");
+    }
+    spVersion->load_ms = sw.elapsed_ms();
+
+    // 2. 校验, 样例请求同时用当前版本打分, 检查新旧模型分数差
+    sw.reset();
+    std::string error;
+    if (!Validate(*spVersion, Acquire().get(), factor, error))
+    {
+        return stage_failed(error);
+    }
+    spVersion->validate_ms = sw.elapsed_ms();
+
+    // 3. 预热
+    sw.reset();
+    Warm(*spVersion);
+    spVersion->warm_ms = sw.elapsed_ms();
+    return spVersion;
+}
+
+void FMModel::DoPublish(std::shared_ptr<const Version> spVersion)
+{
+    // 4. 发布, 被替换的版本保留用于回滚, 更早的版本等待回收
+    //    新版本的样例请求作为之后更新的样例请求
+    const uint64_t version = spVersion->version;
+    const std::string model_file_path = spVersion->model_file_path;
+    const double load_ms = spVersion->load_ms;
+    const double validate_ms = spVersion->validate_ms;
+    const double warm_ms = spVersion->warm_ms;
+    m_spGolden = spVersion->spGolden;
+    Common::Stopwatch sw;
+    auto spOldVersion = Swap(std::move(spVersion));
+    const double publish_us = sw.elapsed_ns() * 1e-3;
+    if (m_spPrevVersion != nullptr)
+    {
+        m_vecRetired.emplace_back(std::move(m_spPrevVersion));
+    }
+    m_spPrevVersion = std::move(spOldVersion);
+    Reclaim();
 
-    if (!m_transData[data_idx].LoadTransFile(filter_file_path))
     {
-        m_transData[data_idx].Clear();
+        std::lock_guard<std::mutex> lock(m_statsLock);
+        m_stats.version = version;
+        m_stats.succ_count++;
+        m_stats.load_ms = load_ms;
+        m_stats.validate_ms = validate_ms;
+        m_stats.warm_ms = warm_ms;
+        m_stats.publish_us = publish_us;
+    }
+    LOG(INFO) << "FMModel::Update() Succ"
+              << ", model_name = " << GetName()
+              << ", version = " << version
+              << ", model_file_path = " << model_file_path
+              << ", load_ms = " << load_ms
+              << ", validate_ms = " << validate_ms
+              << ", warm_ms = " << warm_ms
+              << ", publish_us = " << publish_us;
+}
+
+bool FMModel::Rollback()
+{
+    std::lock_guard<std::mutex> lg(m_updateModelLock);
+    if (m_spPrevVersion == nullptr)
+    {
+        LOG(ERROR) << "FMModel::Rollback() Failed, no previous version"
+                   << ", model_name = " << GetName();
         return false;
     }
 
-    m_modelDataIdx = data_idx;
+    const uint64_t version = m_spPrevVersion->version;
+    m_vecRetired.emplace_back(Swap(std::move(m_spPrevVersion)));
+    Reclaim();
+
+    {
+        std::lock_guard<std::mutex> lock(m_statsLock);
+        m_stats.version = version;
+        m_stats.rollback_count++;
+    }
+    LOG(INFO) << "FMModel::Rollback() Succ"
+              << ", model_name = " << GetName()
+              << ", version = " << version;
     return true;
 }
 
+void FMModel::SetGoldenRequests(std::vector<FMGoldenRequest> vecGolden)
+{
+    std::lock_guard<std::mutex> lg(m_updateModelLock);
+    m_spGolden = std::make_shared<const std::vector<FMGoldenRequest>>(std::move(vecGolden));
+}
+
+bool FMModel::LoadGoldenFile(const std::string &golden_file_path)
+{
+    std::vector<FMGoldenRequest> vecGolden;
+    if (!ReadGoldenFile(golden_file_path, vecGolden))
+    {
+        return false;
+    }
+    SetGoldenRequests(std::move(vecGolden));
+    return true;
+}
+
+bool FMModel::ReadGoldenFile(const std::string &golden_file_path, std::vector<FMGoldenRequest> &vecGolden)
+{
+    Common::MappedFile file;
+    if (!file.Open(golden_file_path))
+    {
+        LOG(ERROR) << "FMModel::ReadGoldenFile() MappedFile Open Failed"
+                   << ", golden_file_path = " << golden_file_path;
+        return false;
+    }
+
+    vecGolden.clear();
+    std::vector<std::string_view> strVec;
+    FMSample sample;
+    for (std::string_view line : file.lines())
+    {
+        line = Common::StripCR(line);
+        if (line.empty())
+        {
+            continue;
+        }
+        FMGoldenRequest golden;
+        if (!FMModelData::ParseSampleLine(line, strVec, golden.expect_score, sample))
+        {
+            LOG(ERROR) << "FMModel::ReadGoldenFile() ParseSampleLine Failed"
+                       << ", golden_file_path = " << golden_file_path;
+            return false;
+        }
+        golden.spFeatureData = std::make_shared<FeatureData>(FMModelData::ToFeatureData(sample));
+        vecGolden.emplace_back(std::move(golden));
+    }
+    return true;
+}
+
+void FMModel::SetSwapPolicy(const FMSwapPolicy &policy)
+{
+    std::lock_guard<std::mutex> lg(m_updateModelLock);
+    m_policy = policy;
+}
+
+FMSwapStats FMModel::GetSwapStats() const
+{
+    std::lock_guard<std::mutex> lock(m_statsLock);
+    return m_stats;
+}
+
+std::shared_ptr<const FMModel::Version> FMModel::Acquire() const noexcept
+{
+    std::shared_lock<Common::distributed_shared_mutex> lock(m_versionLock);
+    return m_spVersion;
+}
+
+std::shared_ptr<const FMModel::Version> FMModel::Swap(std::shared_ptr<const Version> spVersion)
+{
+    std::unique_lock<Common::distributed_shared_mutex> lock(m_versionLock);
+    m_spVersion.swap(spVersion);
+    return spVersion;
+}
+
+void FMModel::Reclaim()
+{
+    // 下线版本只在 m_vecRetired 中有引用时, 不会再被请求获取, 在这里释放
+    m_vecRetired.erase(std::remove_if(m_vecRetired.begin(), m_vecRetired.end(),
+                                      [](const std::shared_ptr<const Version> &spVersion)
+                                      { return spVersion.use_count() == 1; }),
+                       m_vecRetired.end());
+
+    std::lock_guard<std::mutex> lock(m_statsLock);
+    m_stats.retired_count = m_vecRetired.size();
+}
+
+bool FMModel::Validate(const Version &version, const Version *current, const int factor, std::string &error) const
+{
+    const auto &model_data = version.model_data;
+    const auto &table = model_data.m_table;
+    const auto &field_trans = version.trans_data.field_trans;
+
+    // 1. 维度与转换格式, 特征域范围已在加载时检查
+    if (model_data.m_factor != factor || table.factor() != factor || table.empty() || !std::isfinite(model_data.m_w0))
+    {
+        error = "model invalid, factor = " + std::to_string(model_data.m_factor) +
+                ", rows = " + std::to_string(table.size());
+        return false;
+    }
+    if (field_trans.empty())
+    {
+        error = "trans empty";
+        return false;
+    }
+
+    // 2. 均匀抽查参数, 训练发散或文件损坏时常见 nan/inf
+    if (m_policy.sanity_rows > 0)
+    {
+        std::vector<score_type> w2(factor);
+        const size_t step = std::max<size_t>(1, table.size() / m_policy.sanity_rows);
+        for (size_t row = 0; row < table.size(); row += step)
+        {
+            const score_type *data = table.Row(row);
+            table.Decode(data, w2.data());
+            bool finite = std::isfinite(table.W1(data));
+            for (int f_idx = 0; finite && f_idx < factor; f_idx++)
+            {
+                finite = std::isfinite(w2[f_idx]);
+            }
+            if (!finite)
+            {
+                error = "weight invalid, row = " + std::to_string(row);
+                return false;
+            }
+        }
+    }
+
+    // 3. 回放样例请求
+    if (version.spGolden == nullptr)
+    {
+        return true;
+    }
+    const auto &vecGolden = *version.spGolden;
+    double drift = 0.0;
+    for (size_t idx = 0; idx < vecGolden.size(); idx++)
+    {
+        const auto &golden = vecGolden[idx];
+        if (golden.spFeatureData == nullptr)
+        {
+            continue;
+        }
+        const score_type score = score_request(version, *golden.spFeatureData);
+        if (!std::isfinite(score) ||
+            (golden.expect_score >= 0 && std::fabs(score - golden.expect_score) > m_policy.golden_tolerance))
+        {
+            error = "golden request mismatch, idx = " + std::to_string(idx) +
+                    ", score = " + std::to_string(score) +
+                    ", expect_score = " + std::to_string(golden.expect_score);
+            return false;
+        }
+        if (current != nullptr)
+        {
+            drift += std::fabs(score - score_request(*current, *golden.spFeatureData));
+        }
+    }
+    if (current != nullptr && !vecGolden.empty() && drift / vecGolden.size() > m_policy.max_mean_drift)
+    {
+        error = "golden request drift too large, mean_drift = " + std::to_string(drift / vecGolden.size());
+        return false;
+    }
+    return true;
+}
+
+void FMModel::Warm(const Version &version) const
+{
+    // 样例请求覆盖的常用特征进入缓存
+    volatile score_type sink = 0;
+    if (version.spGolden != nullptr)
+    {
+        for (const auto &golden : *version.spGolden)
+        {
+            if (golden.spFeatureData != nullptr)
+            {
+                sink = score_request(version, *golden.spFeatureData);
+            }
+        }
+    }
+
+    // 映射的二进制模型只有校验扫描过的索引常驻, 每页读一次, 发布后的请求不再缺页
+    const auto &table = version.model_data.m_table;
+    if (m_policy.warm_pages && table.mapped())
+    {
+        constexpr size_t PAGE_FLOATS = 4096 / sizeof(score_type);
+        const volatile score_type *data = table.Data();
+        const size_t count = table.size() * table.stride();
+        for (size_t pos = 0; pos < count; pos += PAGE_FLOATS)
+        {
+            sink = data[pos];
+        }
+    }
+    (void)sink;
+}
+
 bool FMModel::predict(RankItem &item) const noexcept
 {
     if (item.spFeatureData == nullptr)
@@ -46,23 +379,111 @@ bool FMModel::predict(RankItem &item) const noexcept
         return false;
     }
 
-    // 获取转换数据
-    const int data_idx = m_modelDataIdx;
-    const auto &trans_data = m_transData[data_idx];
-    const auto &model_data = m_modelData[data_idx];
+    // 获取当前版本, 预测期间持有
+    const auto spVersion = Acquire();
+    if (spVersion == nullptr)
+    {
+        LOG(ERROR) << "predict() model not ready, model_name = " << GetName();
+        return false;
+    }
+    const auto &trans_format = spVersion->trans_data.field_trans;
+    const auto &model_data = spVersion->model_data;
     const int factor = model_data.m_factor;
 
     // 计算item0 common部分
     item.sup_score = model_data.m_w0;
     item.sup_vec_sum.assign(factor, 0.0);
     item.sup_vec_sum_sqr.assign(factor, 0.0);
-    predict_feature(item.spFeatureData->common_feature, trans_data.field_trans, data_idx, item);
-    predict_feature(item.spFeatureData->rank_feature, trans_data.field_trans, data_idx, item);
-    predict_score(item, data_idx);
+    predict_feature(item.spFeatureData->common_feature, trans_format, model_data,
+                    item.sup_score, item.sup_vec_sum.data(), item.sup_vec_sum_sqr.data());
+    predict_feature(item.spFeatureData->rank_feature, trans_format, model_data,
+                    item.sup_score, item.sup_vec_sum.data(), item.sup_vec_sum_sqr.data());
+    predict_score(item, factor);
 
     return true;
 }
 
+namespace
+{
+    // 批量预测时对特征去重, 特征 -> 去重后的下标
+    // 只在一次预测内使用, 内存从请求内存池分配
+    class FMFeatureDedup
+    {
+    public:
+        FMFeatureDedup(const size_t expect_size, std::pmr::memory_resource *mr)
+            : m_vecKey(mr), m_vecSlot(mr)
+        {
+            m_vecKey.reserve(expect_size);
+            Rehash(expect_size);
+        }
+
+        // 返回特征去重后的下标
+        uint32_t Insert(const long key)
+        {
+            if ((m_vecKey.size() + 1) * 2 > m_vecSlot.size())
+            {
+                Rehash(m_vecKey.size() + 1);
+            }
+
+            uint32_t &slot = Probe(key);
+            if (slot == EMPTY)
+            {
+                slot = m_vecKey.size();
+                m_vecKey.emplace_back(key);
+            }
+            return slot;
+        }
+
+        const std::pmr::vector<long> &Keys() const noexcept
+        {
+            return m_vecKey;
+        }
+
+    private:
+        static inline size_t Hash(const long key) noexcept
+        {
+            uint64_t h = (uint64_t)key * 0x9e3779b97f4a7c15ULL;
+            return h ^ (h >> 29);
+        }
+
+        uint32_t &Probe(const long key) noexcept
+        {
+            size_t pos = Hash(key) & m_mask;
+            while (m_vecSlot[pos] != EMPTY && m_vecKey[m_vecSlot[pos]] != key)
+            {
+                pos = (pos + 1) & m_mask;
+            }
+            return m_vecSlot[pos];
+        }
+
+        // 负载因子不超过 0.5
+        void Rehash(const size_t size)
+        {
+            size_t slots = 16;
+            while (slots < size * 2)
+            {
+                slots *= 2;
+            }
+            if (slots <= m_vecSlot.size())
+            {
+                return;
+            }
+            m_vecSlot.assign(slots, EMPTY);
+            m_mask = slots - 1;
+            for (uint32_t idx = 0; idx < m_vecKey.size(); idx++)
+            {
+                Probe(m_vecKey[idx]) = idx;
+            }
+        }
+
+    private:
+        static constexpr uint32_t EMPTY = UINT32_MAX;
+        std::pmr::vector<long> m_vecKey;
+        std::pmr::vector<uint32_t> m_vecSlot;
+        size_t m_mask = 0;
+    };
+}
+
 bool FMModel::predict(std::vector<RankItem> &vec_rank_item) const noexcept
 {
     if (vec_rank_item.empty())
@@ -70,45 +491,125 @@ bool FMModel::predict(std::vector<RankItem> &vec_rank_item) const noexcept
         return true;
     }
 
-    // 获取模型数据
-    const int data_idx = m_modelDataIdx;
-    const auto &trans_data = m_transData[data_idx];
-    const auto &model_data = m_modelData[data_idx];
+    // 获取当前版本, 预测期间持有
+    const auto spVersion = Acquire();
+    if (spVersion == nullptr)
+    {
+        LOG(ERROR) << "predict() model not ready, model_name = " << GetName();
+        return false;
+    }
+    const auto &trans_format = spVersion->trans_data.field_trans;
+    const auto &model_data = spVersion->model_data;
+    const auto &table = model_data.m_table;
     const int factor = model_data.m_factor;
+    const auto accumulate = model_data.m_accumulate;
+    std::pmr::memory_resource *mr = Common::CurrentResource();
 
-    auto &item0 = vec_rank_item[0];
-    if (item0.spFeatureData == nullptr)
+    for (int idx = 0, size = vec_rank_item.size(); idx != size; idx++)
     {
-        LOG(ERROR) << "predict() spFeatureData == nullptr";
-        return false;
+        if (vec_rank_item[idx].spFeatureData == nullptr)
+        {
+            LOG(ERROR) << "predict() spFeatureData == nullptr, idx = " << idx;
+            return false;
+        }
     }
 
-    // 计算item0 common部分
-    item0.sup_score = model_data.m_w0;
-    item0.sup_vec_sum.assign(factor, 0.0);
-    item0.sup_vec_sum_sqr.assign(factor, 0.0);
-    predict_feature(item0.spFeatureData->common_feature, trans_data.field_trans, data_idx, item0);
+    // 1. common 部分只计算一次, 各 item 从该结果开始累加, 不再复制到每个 item
+    score_type common_score = model_data.m_w0;
+    std::pmr::vector<score_type> common_sum(factor, 0.0, mr);
+    std::pmr::vector<score_type> common_sqr(factor, 0.0, mr);
+    predict_feature(vec_rank_item[0].spFeatureData->common_feature, trans_format, model_data,
+                    common_score, common_sum.data(), common_sqr.data());
 
-    // item1~n common结果从item0复制
-    for (int idx = 1, size = vec_rank_item.size(); idx != size; idx++)
+    // 2. 收集所有 item 的 rank 特征, 同一批 item 的城市/价格段/标签等特征大量重复, 相同特征只保留一份
+    //    item_offset[i] ~ item_offset[i + 1] 为第 i 个 item 的特征
+    const size_t expect_count = vec_rank_item.size() * trans_format.size();
+    FMFeatureDedup dedup(expect_count / 4, mr);
+    std::pmr::vector<uint32_t> item_offset(mr);
+    std::pmr::vector<uint32_t> feature_unique(mr);
+    std::pmr::vector<score_type> feature_weight(mr);
+    item_offset.reserve(vec_rank_item.size() + 1);
+    feature_unique.reserve(expect_count);
+    feature_weight.reserve(expect_count);
+    item_offset.emplace_back(0);
+    for (const auto &item : vec_rank_item)
     {
-        vec_rank_item[idx].sup_score = item0.sup_score;
-        vec_rank_item[idx].sup_vec_sum = item0.sup_vec_sum;
-        vec_rank_item[idx].sup_vec_sum_sqr = item0.sup_vec_sum_sqr;
+        const auto &rank_feature = item.spFeatureData->rank_feature;
+        for (const auto &pr_trans : trans_format)
+        {
+            const auto &field_item_list = rank_feature[pr_trans.first];
+            const int use_count = std::min(pr_trans.second, (int)field_item_list.size());
+            for (int idx = 0; idx < use_count; idx++)
+            {
+                feature_unique.emplace_back(dedup.Insert(field_item_list[idx].field_value.field_value()));
+                feature_weight.emplace_back(field_item_list[idx].weight);
+            }
+        }
+        item_offset.emplace_back(feature_unique.size());
     }
 
-    // 计算rank部分
-    for (int idx = 0, size = vec_rank_item.size(); idx != size; idx++)
+    // 3. 每个特征只查一次模型, 命中的行拷贝到连续内存, 打分时只访问这一小块内存
+    //    查找前预取后面第 PREFETCH_DISTANCE 个特征的哈希槽, 隐藏高基数特征的缓存未命中
+    constexpr size_t PREFETCH_DISTANCE = 8;
+    const size_t stride = table.stride();
+    const auto &vecKey = dedup.Keys();
+    std::pmr::vector<const score_type *> unique_row(vecKey.size(), nullptr, mr);
+    std::pmr::vector<score_type> gathered(mr);
+    gathered.reserve(vecKey.size() * stride);
+    std::pmr::vector<uint32_t> hit_unique(mr);
+    for (size_t idx = 0; idx < vecKey.size(); idx++)
     {
-        auto &item = vec_rank_item[idx];
-        if (item.spFeatureData == nullptr)
+        if (idx + PREFETCH_DISTANCE < vecKey.size())
         {
-            LOG(ERROR) << "predict() spFeatureData == nullptr, idx = " << idx;
-            return false;
+            table.Prefetch(vecKey[idx + PREFETCH_DISTANCE]);
+        }
+        const score_type *row = table.Find(vecKey[idx]);
+        if (row != nullptr)
+        {
+            hit_unique.emplace_back(idx);
+            gathered.insert(gathered.end(), row, row + stride);
         }
+    }
+    for (size_t hit = 0; hit < hit_unique.size(); hit++)
+    {
+        unique_row[hit_unique[hit]] = gathered.data() + hit * stride;
+    }
 
-        predict_feature(item.spFeatureData->rank_feature, trans_data.field_trans, data_idx, item);
-        predict_score(item, data_idx);
+    // 4. 逐个 item 打分, 累加顺序与逐个预测相同, 结果逐位一致
+    constexpr int BATCH_SIZE = 64;
+    const score_type *rows[BATCH_SIZE];
+    score_type weights[BATCH_SIZE];
+    std::pmr::vector<score_type> sum(factor, 0.0, mr);
+    std::pmr::vector<score_type> sqr(factor, 0.0, mr);
+    const std::string model_name = GetName();
+    for (size_t item_idx = 0; item_idx < vec_rank_item.size(); item_idx++)
+    {
+        score_type score = common_score;
+        std::copy(common_sum.begin(), common_sum.end(), sum.begin());
+        std::copy(common_sqr.begin(), common_sqr.end(), sqr.begin());
+
+        int count = 0;
+        for (uint32_t pos = item_offset[item_idx], end = item_offset[item_idx + 1]; pos < end; pos++)
+        {
+            const score_type *row = unique_row[feature_unique[pos]];
+            if (row != nullptr)
+            {
+                score += table.W1(row) * feature_weight[pos];
+                rows[count] = row;
+                weights[count] = feature_weight[pos];
+                if (++count == BATCH_SIZE)
+                {
+                    accumulate(rows, weights, count, factor, sum.data(), sqr.data());
+                    count = 0;
+                }
+            }
+        }
+        if (count > 0)
+        {
+            accumulate(rows, weights, count, factor, sum.data(), sqr.data());
+        }
+
+        vec_rank_item[item_idx].setModelScore(model_name, calc_score(score, sum.data(), sqr.data(), factor));
     }
     return true;
 }
@@ -116,13 +617,20 @@ bool FMModel::predict(std::vector<RankItem> &vec_rank_item) const noexcept
 void FMModel::predict_feature(
     const TDPredict::FeatureItem &feature_item,
     const FMTransFormat &trans_format,
-    const int data_idx,
-    RankItem &item) const noexcept
+    const FMModelData &model_data,
+    score_type &sup_score,
+    score_type *sup_vec_sum,
+    score_type *sup_vec_sum_sqr) noexcept
 {
-    const auto &model_data = m_modelData[data_idx];
-    const auto iter_w1_end = model_data.m_w1.end();
-    const auto iter_w2_end = model_data.m_w2.end();
+    const auto &table = model_data.m_table;
     const int factor = model_data.m_factor;
+    const auto accumulate = model_data.m_accumulate;
+
+    // 命中的特征先攒一批再交给累加内核, 累加结果整批保存在寄存器中
+    constexpr int BATCH_SIZE = 64;
+    const score_type *rows[BATCH_SIZE];
+    score_type weights[BATCH_SIZE];
+    int count = 0;
 
     for (const auto &pr_trans : trans_format)
     {
@@ -139,47 +647,72 @@ void FMModel::predict_feature(
         for (int idx = 0; idx < use_count; idx++)
         {
             const auto &field_item = field_item_list[idx];
-            const auto iter_w1 = model_data.m_w1.find(field_item.field_value.field_value());
-            if (iter_w1 != iter_w1_end)
-            {
-                item.sup_score += iter_w1->second * field_item.weight;
-            }
-
-            const auto iter_w2 = model_data.m_w2.find(field_item.field_value.field_value());
-            if (iter_w2 != iter_w2_end)
+            const score_type *row = table.Find(field_item.field_value.field_value());
+            if (row != nullptr)
             {
-                const auto &vec_w2 = iter_w2->second;
-                for (int f_idx = 0; f_idx < factor; ++f_idx)
+                sup_score += table.W1(row) * field_item.weight;
+                rows[count] = row;
+                weights[count] = field_item.weight;
+                if (++count == BATCH_SIZE)
                 {
-                    score_type d = vec_w2[f_idx] * field_item.weight;
-                    item.sup_vec_sum[f_idx] += d;
-                    item.sup_vec_sum_sqr[f_idx] += (d * d);
+                    accumulate(rows, weights, count, factor, sup_vec_sum, sup_vec_sum_sqr);
+                    count = 0;
                 }
             }
         }
     }
+
+    if (count > 0)
+    {
+        accumulate(rows, weights, count, factor, sup_vec_sum, sup_vec_sum_sqr);
+    }
 }
 
 void FMModel::predict_score(
     RankItem &item,
-    const int data_idx) const noexcept
+    const int factor) const noexcept
+{
+    item.setModelScore(GetName(), calc_score(item.sup_score, item.sup_vec_sum.data(), item.sup_vec_sum_sqr.data(), factor));
+}
+
+score_type FMModel::score_request(const Version &version, const FeatureData &feature_data) noexcept
+{
+    return Score(version.model_data, version.trans_data.field_trans, feature_data);
+}
+
+score_type FMModel::Score(
+    const FMModelData &model_data,
+    const FMTransFormat &trans_format,
+    const FeatureData &feature_data) noexcept
 {
-    const auto &model_data = m_modelData[data_idx];
     const int factor = model_data.m_factor;
 
-    score_type result = item.sup_score;
+    // 累加顺序与 predict(RankItem &) 相同
+    score_type score = model_data.m_w0;
+    std::vector<score_type> sum(factor, 0.0);
+    std::vector<score_type> sqr(factor, 0.0);
+    predict_feature(feature_data.common_feature, trans_format, model_data, score, sum.data(), sqr.data());
+    predict_feature(feature_data.rank_feature, trans_format, model_data, score, sum.data(), sqr.data());
+    return calc_score(score, sum.data(), sqr.data(), factor);
+}
+
+score_type FMModel::calc_score(
+    const score_type sup_score,
+    const score_type *sup_vec_sum,
+    const score_type *sup_vec_sum_sqr,
+    const int factor) noexcept
+{
+    score_type result = sup_score;
 
     // 计算最终结果
     auto tmp_result = 0.0;
     for (int f_idx = 0; f_idx < factor; ++f_idx)
     {
-        const auto &tmp_sum = item.sup_vec_sum[f_idx];
-        tmp_result += (tmp_sum * tmp_sum - item.sup_vec_sum_sqr[f_idx]);
+        const auto &tmp_sum = sup_vec_sum[f_idx];
+        tmp_result += (tmp_sum * tmp_sum - sup_vec_sum_sqr[f_idx]);
     }
     result += (tmp_result * 0.5);
     result = exp(-result);
     result = 1.0 / (1.0 + result);
-
-    // 分数
-    item.setModelScore(GetName(), result);
+    return result;
 }
@@ -3,13 +3,46 @@
 #include <vector>
 #include <atomic>
 #include <mutex>
+#include <memory>
 #include <unordered_map>
 #include "../Interface/ModelInterface.h"
+#include "Common/Lock.h"
 #include "FMTrans.h"
 #include "FMModelData.h"
 
 namespace TDPredict
 {
+    // 上线前回放的样例请求
+    struct FMGoldenRequest
+    {
+        std::shared_ptr<FeatureData> spFeatureData; // 请求特征
+        score_type expect_score = -1;               // 期望分数, 小于 0 时只检查分数有效
+    };
+
+    // 模型切换校验参数
+    struct FMSwapPolicy
+    {
+        score_type golden_tolerance = 0.01; // 样例请求分数与期望分数允许的误差
+        score_type max_mean_drift = 1.0;    // 样例请求新旧模型分数差绝对值均值上限, 1 表示不检查
+        size_t sanity_rows = 4096;          // 抽查参数是否有效的行数
+        bool warm_pages = true;             // 映射的二进制模型发布前预读全部行数据
+    };
+
+    // 模型切换统计
+    struct FMSwapStats
+    {
+        uint64_t version = 0;        // 当前服务的版本号, 0 表示还没有模型
+        uint64_t succ_count = 0;     // 切换成功次数
+        uint64_t fail_count = 0;     // 加载或校验失败次数, 失败时继续使用原模型
+        uint64_t rollback_count = 0; // 回滚次数
+        uint64_t retired_count = 0;  // 已下线但仍有请求在使用, 等待回收的版本数
+        double load_ms = 0;          // 最近一次切换: 加载耗时
+        double validate_ms = 0;      // 最近一次切换: 校验耗时
+        double warm_ms = 0;          // 最近一次切换: 预热耗时
+        double publish_us = 0;       // 最近一次切换: 发布耗时(写锁内)
+        std::string last_error;      // 最近一次失败原因
+    };
+
     class FMModel final : public ModelInterface
     {
     public:
@@ -20,40 +53,152 @@ namespace TDPredict
         virtual bool predict(RankItem &item) const noexcept override;
 
         // 批量预测函数
+        // 公共特征只计算一次; 所有 item 的排序特征去重后每个只查一次模型, 命中的参数拷贝到连续内存后再逐个打分.
+        // 结果与逐个预测逐位一致, 批量预测不再填充 item 的 sup_score/sup_vec_sum/sup_vec_sum_sqr.
         virtual bool predict(std::vector<RankItem> &vec_item) const noexcept override;
 
+        // 用指定模型与转换格式对单个请求打分, 不修改请求
+        // 按转换格式选择特征域并限制每个域的特征个数, 与 predict(RankItem &) 的计算一致, 离线评估(见 FMQuantEval.h)也使用该函数
+        static score_type Score(
+            const FMModelData &model_data,
+            const FMTransFormat &trans_format,
+            const FeatureData &feature_data) noexcept;
+
+        // 一个完整的模型版本, 发布后只读
+        struct Version
+        {
+            uint64_t version = 0;
+            FMModelData model_data;
+            FMTransData trans_data;
+            std::string model_file_path;
+            std::shared_ptr<const std::vector<FMGoldenRequest>> spGolden; // 校验该版本回放的样例请求
+            double load_ms = 0;                                           // 加载耗时
+            double validate_ms = 0;                                       // 校验耗时
+            double warm_ms = 0;                                           // 预热耗时
+        };
+
     protected:
-        void predict_feature(
+        // 累加特征的一阶项与二阶项辅助结果
+        static void predict_feature(
             const TDPredict::FeatureItem &feature_item,
             const FMTransFormat &trans_format,
-            const int data_idx,
-            RankItem &item) const noexcept;
+            const FMModelData &model_data,
+            score_type &sup_score,
+            score_type *sup_vec_sum,
+            score_type *sup_vec_sum_sqr) noexcept;
+
+        void predict_score(RankItem &item, const int factor) const noexcept;
 
-        void predict_score(RankItem &item, const int data_idx) const noexcept;
+        // 由辅助结果计算最终分数
+        static score_type calc_score(
+            const score_type sup_score,
+            const score_type *sup_vec_sum,
+            const score_type *sup_vec_sum_sqr,
+            const int factor) noexcept;
+
+        // 用指定版本对单个请求打分, 不修改请求
+        static score_type score_request(const Version &version, const FeatureData &feature_data) noexcept;
 
     public:
         // 初始化函数
         // [in] factor: 模型位数
-        // [in] model_file_path: 模型文件地址
+        // [in] model_file_path: 模型文件地址, 支持文本格式与二进制格式(见 FMBinaryFormat.h)
         // [in] filter_file_path: 转换格式地址
+        // [in] precision: 隐向量存储精度, 默认 FP32
         bool Init(
             int factor,
             const std::string &model_file_path,
-            const std::string &filter_file_path);
+            const std::string &filter_file_path,
+            FMPrecision precision = FMPrecision::FP32);
 
         // 更新模型文件
+        // 新模型在调用线程上加载为独立版本, 依次经过 校验 -> 预热 -> 发布:
+        //   校验: 维度/转换格式/抽样参数有效, 回放样例请求(见 SetGoldenRequests)分数符合预期
+        //   预热: 回放样例请求, 映射的二进制模型预读全部行数据, 发布后的请求不再触发缺页
+        //   发布: 写锁内只交换版本指针; 正在预测的请求继续使用自己持有的旧版本, 不会读到半更新的数据
+        // 任一步骤失败时新版本直接丢弃, 继续使用原模型并返回 false.
+        // 下线的版本在没有请求引用后由更新线程释放, 预测线程不会承担大块内存的释放.
         // [in] factor: 模型位数
-        // [in] model_file_path: 模型文件地址
+        // [in] model_file_path: 模型文件地址, 支持文本格式与二进制格式(见 FMBinaryFormat.h)
         // [in] filter_file_path: 转换格式地址
+        // [in] precision: 隐向量存储精度, 默认 FP32
         bool Update(
             int factor,
             const std::string &model_file_path,
-            const std::string &filter_file_path);
+            const std::string &filter_file_path,
+            FMPrecision precision = FMPrecision::FP32);
+
+        // 只加载并校验新版本(Update 的 加载 -> 校验 -> 预热), 不发布, 用于多个模型整体切换:
+        // 所有模型都 Stage 成功后再依次 Publish, 任一模型失败时丢弃全部新版本, 正在服务的版本不受影响.
+        // [in] spGolden: 新版本回放的样例请求, 为空时使用当前的样例请求; 发布后成为之后更新使用的样例请求
+        // [ret] 新版本, 失败返回 nullptr
+        std::shared_ptr<const Version> Stage(
+            int factor,
+            const std::string &model_file_path,
+            const std::string &filter_file_path,
+            FMPrecision precision = FMPrecision::FP32,
+            std::shared_ptr<const std::vector<FMGoldenRequest>> spGolden = nullptr);
+
+        // 发布 Stage 得到的版本, 被替换的版本保留用于回滚
+        bool Publish(std::shared_ptr<const Version> spVersion);
+
+        // 回滚到上一个版本, 用于发布后线上指标异常; 只保留一个历史版本, 没有历史版本时返回 false
+        bool Rollback();
+
+        // 设置样例请求, 之后每次更新都会回放
+        void SetGoldenRequests(std::vector<FMGoldenRequest> vecGolden);
+
+        // 从文件加载样例请求, 格式见 ReadGoldenFile
+        bool LoadGoldenFile(const std::string &golden_file_path);
+
+        // 读取样例请求文件
+        // 每行: expect_score field_value[:weight] field_value[:weight] ...
+        //   expect_score: 期望分数, 小于 0 时只检查分数有效
+        //   field_value: 与模型文件第一列一致, 按 FMModelData::ParseSampleLine 解析, weight 缺省为 1, 均作为排序特征
+        static bool ReadGoldenFile(const std::string &golden_file_path, std::vector<FMGoldenRequest> &vecGolden);
+
+        // 设置校验参数
+        void SetSwapPolicy(const FMSwapPolicy &policy);
+
+        // 切换统计
+        FMSwapStats GetSwapStats() const;
 
     private:
-        std::mutex m_updateModelLock; // 更新锁
-        std::atomic<int> m_modelDataIdx = 0;
-        FMModelData m_modelData[2];
-        FMTransData m_transData[2];
+        // 获取当前版本, 持有期间该版本不会被释放
+        std::shared_ptr<const Version> Acquire() const noexcept;
+
+        bool Validate(const Version &version, const Version *current, const int factor, std::string &error) const;
+        void Warm(const Version &version) const;
+
+        // 调用方持有 m_updateModelLock
+        std::shared_ptr<const Version> DoStage(
+            int factor,
+            const std::string &model_file_path,
+            const std::string &filter_file_path,
+            FMPrecision precision,
+            std::shared_ptr<const std::vector<FMGoldenRequest>> spGolden);
+        void DoPublish(std::shared_ptr<const Version> spVersion);
+
+        // 交换当前版本, 返回被替换的版本
+        std::shared_ptr<const Version> Swap(std::shared_ptr<const Version> spVersion);
+
+        // 释放已没有请求引用的下线版本
+        void Reclaim();
+
+    private:
+        std::mutex m_updateModelLock; // 更新锁, 保护以下版本管理成员
+        uint64_t m_nextVersion = 1;
+        std::shared_ptr<const std::vector<FMGoldenRequest>> m_spGolden; // 样例请求
+        FMSwapPolicy m_policy;
+        std::shared_ptr<const Version> m_spPrevVersion;            // 上一个版本, 用于回滚
+        std::vector<std::shared_ptr<const Version>> m_vecRetired; // 已下线, 等待回收
+
+        // 当前版本, 读者只在拷贝指针时持有读锁
+        mutable Common::distributed_shared_mutex m_versionLock;
+        std::shared_ptr<const Version> m_spVersion;
+
+        // 更新期间也可以查询统计, 单独加锁
+        mutable std::mutex m_statsLock;
+        FMSwapStats m_stats;
     };
 }
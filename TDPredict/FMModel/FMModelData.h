@@ -1,57 +1,114 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_map>
+#include <utility>
+#include <algorithm>
 #include "../Interface/FieldValue.h"
 #include "../Interface/ModelInterface.h"
+#include "FMEmbeddingTable.h"
+#include "FMKernel.h"
+#include "FMBinaryFormat.h"
 #include "glog/logging.h"
-#include "Common/Function.h"
+#include "Common/Tokenizer.h"
+#include "Common/MappedFile.h"
 
 namespace TDPredict
 {
+    // 样本特征 [(field_value, weight)]
+    using FMSample = std::vector<std::pair<long, score_type>>;
+
     struct FMModelData
     {
-        int m_factor;
-        score_type m_w0;
-        std::unordered_map<long, score_type> m_w1;
-        std::unordered_map<long, std::vector<score_type>> m_w2;
+        int m_factor = 0;
+        score_type m_w0 = 0;
+        FMEmbeddingTable m_table; // 一阶权重与隐向量
+        FMKernel::AccumulateFunc m_accumulate = FMKernel::accumulate_scalar; // 按 factor 选择的二阶项累加内核
 
         void Clear()
         {
             m_factor = 0;
             m_w0 = 0;
-            m_w1.clear();
-            m_w2.clear();
+            m_table.Clear();
+            m_accumulate = FMKernel::accumulate_scalar;
         }
 
-        bool LoadModelFile(int factor, const std::string &model_file_path)
+        // 加载模型文件, 按文件头自动识别文本格式与二进制格式(见 FMBinaryFormat.h)
+        // 二进制格式直接映射文件用于预测, 不做解析与拷贝
+        // [in] precision: 隐向量存储精度, 文本格式加载时量化, 二进制格式须与文件一致
+        bool LoadModelFile(int factor, const std::string &model_file_path, FMPrecision precision = FMPrecision::FP32)
         {
-            std::string buffer;
-            if (!Common::FastReadFile(model_file_path, buffer, false))
+            Common::MappedFile file;
+            if (!file.Open(model_file_path))
             {
-                LOG(ERROR) << "FMModelData::LoadModelFile() FastReadFile Failed"
+                LOG(ERROR) << "FMModelData::LoadModelFile() MappedFile Open Failed"
                            << ", factor = " << factor
                            << ", model_file_path = " << model_file_path;
                 return false;
             }
-            return LoadModelBuffer(factor, buffer);
+
+            if (IsFMBinary(file.data()))
+            {
+                Clear();
+                file.Advise(false); // 预测时按特征随机访问
+                if (!MapFMBinary(std::move(file), factor, precision, m_w0, m_table))
+                {
+                    LOG(ERROR) << "FMModelData::LoadModelFile() MapFMBinary Failed"
+                               << ", factor = " << factor
+                               << ", model_file_path = " << model_file_path;
+                    Clear();
+                    return false;
+                }
+                m_factor = factor;
+                m_accumulate = FMKernel::GetAccumulate(m_factor, FMKernel::ISA::AVX512, precision);
+                return true;
+            }
+            return LoadModelBuffer(factor, file.data(), precision);
+        }
+
+        // 保存为二进制格式
+        bool SaveBinaryFile(const std::string &binary_file_path) const
+        {
+            return WriteFMBinary(binary_file_path, m_w0, m_table);
+        }
+
+        // 文本格式模型转换为二进制格式
+        // [in] factor: 隐向量维度
+        // [in] model_file_path: 文本格式模型文件
+        // [in] binary_file_path: 输出的二进制格式模型文件
+        // [in] precision: 隐向量存储精度
+        static bool ConvertToBinary(
+            int factor,
+            const std::string &model_file_path,
+            const std::string &binary_file_path,
+            FMPrecision precision = FMPrecision::FP32)
+        {
+            FMModelData model_data;
+            if (!model_data.LoadModelFile(factor, model_file_path, precision))
+            {
+                LOG(ERROR) << "FMModelData::ConvertToBinary() LoadModelFile Failed"
+                           << ", model_file_path = " << model_file_path;
+                return false;
+            }
+            return model_data.SaveBinaryFile(binary_file_path);
         }
 
         //加载模型
-        bool LoadModelBuffer(int factor, const std::string &buffer)
+        bool LoadModelBuffer(int factor, std::string_view buffer, FMPrecision precision = FMPrecision::FP32)
         {
             Clear();
 
-            std::string line;
-            std::stringstream ss(buffer);
-            if (!getline(ss, line, '\n'))
+            Common::LineRange lines(buffer);
+            auto iter = lines.begin();
+            if (iter == lines.end())
             {
-                LOG(ERROR) << "FMModelData::LoadModelBuffer() Failed, getline line = " << line;
+                LOG(ERROR) << "FMModelData::LoadModelBuffer() Failed, buffer empty";
                 return false;
             }
 
-            std::vector<std::string> strVec;
-            Common::SplitString(line, ' ', strVec);
+            std::vector<std::string_view> strVec;
+            std::string_view line = Common::StripCR(*iter);
+            Common::SplitView(line, ' ', strVec);
             if (strVec.size() != 4)
             {
                 LOG(ERROR) << "FMModelData::LoadModelBuffer() Failed, getline strVec.size() != 4"
@@ -59,15 +116,26 @@ namespace TDPredict
                            << ", line = " << line;
                 return false;
             }
-            m_w0 = std::atof(strVec[1].c_str());
+            if (!Common::ParseNumber(strVec[1], m_w0))
+            {
+                LOG(ERROR) << "FMModelData::LoadModelBuffer() Failed, w0 invalid"
+                           << ", line = " << line;
+                return false;
+            }
             m_factor = factor;
+            m_accumulate = FMKernel::GetAccumulate(m_factor, FMKernel::ISA::AVX512, precision);
+
+            // 按行数预分配, 避免加载过程中扩容
+            m_table.Reset(m_factor, std::count(buffer.begin(), buffer.end(), '\n'), precision);
 
             size_t validSize = (3 * m_factor + 4);
             strVec.reserve(validSize);
-            while (getline(ss, line, '\n'))
+            score_type w1 = 0;
+            std::vector<score_type> tmp_w2_value(m_factor, 0);
+            for (++iter; iter != lines.end(); ++iter)
             {
-                strVec.clear();
-                Common::SplitString(line, ' ', strVec);
+                line = Common::StripCR(*iter);
+                Common::SplitView(line, ' ', strVec);
                 if (strVec.size() != validSize)
                 {
                     LOG(ERROR) << "FMModelData::LoadModelBuffer() Failed, getline strVec.size() != validSize"
@@ -79,38 +147,110 @@ namespace TDPredict
 
                 FieldValue fv;
                 {
-                    const long index = std::atol(strVec[0].c_str());
-                    const int field = index >> 32;
-                    if (field == 0)
-                    {
-                        // 前32位都是0, 对应旧方案[32][8][24], 中间8位是field, 后24位是value
-                        fv.set_feild_value((index >> 24) & 0xFF, index & 0xFFFFFF);
-                    }
-                    else if (0 < field && field < FIELD_MAX)
+                    long index = 0;
+                    if (!Common::ParseNumber(strVec[0], index))
                     {
-                        // 新field有效, 新方案[32][32], 此时Index不需要做任何修改
-                        fv.set_feild_value(index);
+                        LOG(ERROR) << "FMModelData::LoadModelBuffer() Failed, index invalid"
+                                   << ", line = " << line;
+                        return false;
                     }
-                    else
+                    if (!ParseIndex(index, fv))
                     {
                         LOG(ERROR) << "FMModelData::LoadModelBuffer() Failed, field invalid"
                                    << ", index = " << index
-                                   << ", field = " << field
+                                   << ", field = " << (index >> 32)
                                    << ", line = " << line;
                         return false;
                     }
                 }
 
-                m_w1[fv.field_value()] = std::atof(strVec[1].c_str());
-                std::vector<score_type> tmp_w2_value;
-                tmp_w2_value.reserve(m_factor);
-                for (int i = 2, end = m_factor + 2; i < end; i++)
+                bool valid = Common::ParseNumber(strVec[1], w1);
+                for (int i = 0; valid && i < m_factor; i++)
                 {
-                    tmp_w2_value.emplace_back(std::atof(strVec[i].c_str()));
+                    valid = Common::ParseNumber(strVec[i + 2], tmp_w2_value[i]);
                 }
-                m_w2[fv.field_value()] = std::move(tmp_w2_value);
+                if (!valid)
+                {
+                    LOG(ERROR) << "FMModelData::LoadModelBuffer() Failed, weight invalid"
+                               << ", line = " << line;
+                    return false;
+                }
+                m_table.Add(fv.field_value(), w1, tmp_w2_value.data());
             }
             return true;
         }
+
+        // 模型文件第一列转为 FieldValue
+        static bool ParseIndex(const long index, FieldValue &fv) noexcept
+        {
+            const int field = index >> 32;
+            if (field == 0)
+            {
+                // 前32位都是0, 对应旧方案[32][8][24], 中间8位是field, 后24位是value
+                fv.set_feild_value((index >> 24) & 0xFF, index & 0xFFFFFF);
+                return true;
+            }
+            if (0 < field && field < FIELD_MAX)
+            {
+                // 新field有效, 新方案[32][32], 此时Index不需要做任何修改
+                fv.set_feild_value(index);
+                return true;
+            }
+            return false;
+        }
+
+        // 解析样本行: head index[:weight] index[:weight] ...
+        // index 与模型文件第一列相同, 按 ParseIndex 转换后存入 sample, weight 缺省为 1
+        // 量化评估样本(head 为 label)与样例请求(head 为期望分数)都使用这个格式
+        template <typename T>
+        static bool ParseSampleLine(std::string_view line, std::vector<std::string_view> &strVec, T &head, FMSample &sample)
+        {
+            sample.clear();
+            Common::SplitView(line, ' ', strVec);
+            if (!Common::ParseNumber(strVec[0], head))
+            {
+                LOG(ERROR) << "FMModelData::ParseSampleLine() Failed, head invalid"
+                           << ", line = " << line;
+                return false;
+            }
+            for (size_t idx = 1; idx < strVec.size(); idx++)
+            {
+                if (strVec[idx].empty())
+                {
+                    continue;
+                }
+                Common::Tokenizer tokenizer(strVec[idx], ':');
+                std::string_view token;
+                long index = 0;
+                score_type weight = 1;
+                bool valid = tokenizer.next(token) && Common::ParseNumber(token, index);
+                if (valid && tokenizer.next(token))
+                {
+                    valid = Common::ParseNumber(token, weight);
+                }
+                FieldValue fv;
+                if (!valid || !ParseIndex(index, fv))
+                {
+                    LOG(ERROR) << "FMModelData::ParseSampleLine() Failed, feature invalid"
+                               << ", feature = " << strVec[idx]
+                               << ", line = " << line;
+                    return false;
+                }
+                sample.emplace_back(fv.field_value(), weight);
+            }
+            return true;
+        }
+
+        // 样本转为请求特征, 全部作为排序特征, 同一域内按出现顺序使用
+        static FeatureData ToFeatureData(const FMSample &sample)
+        {
+            FeatureData feature_data;
+            for (const auto &pr : sample)
+            {
+                const FieldValue fv(pr.first);
+                feature_data.rank_feature[fv.field()].emplace_back(fv.field(), fv.value(), pr.second);
+            }
+            return feature_data;
+        }
     };
 }
\ No newline at end of file
@@ -0,0 +1,222 @@
+#pragma once
+#include <cmath>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include "FMModel.h"
+#include "glog/logging.h"
+#include "Common/Tokenizer.h"
+#include "Common/MappedFile.h"
+
+namespace TDPredict
+{
+    // 量化评估结果
+    struct FMQuantReport
+    {
+        size_t samples = 0;          // 样本数
+        double mean_abs_delta = 0;   // 分数差绝对值均值
+        double max_abs_delta = 0;    // 分数差绝对值最大值
+        double auc_fp32 = 0;         // FP32 模型 AUC
+        double auc_quant = 0;        // 量化模型 AUC
+        size_t row_bytes_fp32 = 0;   // FP32 每行字节数
+        size_t row_bytes_quant = 0;  // 量化后每行字节数
+    };
+
+    // FM 隐向量量化离线评估
+    // 用 FP32 模型与量化模型分别对本地样本打分, 输出分数差与 AUC 变化, 用于上线前确认量化精度
+    // 打分与线上 FMModel 一致: 只使用转换文件中的特征域, 每个域最多使用转换文件配置的特征个数
+    // 打分直接调用 FMModel::Score, 使用时需要链接 TDPredict 库
+    //
+    // 样本文件每行: label index[:weight] index[:weight] ...
+    //   label: 0 或 1
+    //   index: 与模型文件第一列一致, 兼容旧方案 [8位field][24位value], weight 缺省为 1, 均作为排序特征, 同一域内按出现顺序使用
+    //
+    // Example:
+    // TDPredict::FMQuantReport report;
+    // if (TDPredict::FMQuantEval::Evaluate(16, "fm_model", "fm_trans", "sample.txt", TDPredict::FMPrecision::INT8, report))
+    // {
+    //     LOG(INFO) << TDPredict::FMQuantEval::ToString(report);
+    // }
+    class FMQuantEval
+    {
+    public:
+        using Sample = FMSample;
+
+        // [in] factor: 隐向量维度
+        // [in] model_file_path: FP32 模型文件, 文本格式或 FP32 二进制格式
+        // [in] filter_file_path: 转换格式地址, 与线上 FMModel::Init 使用的相同
+        // [in] sample_file_path: 样本文件
+        // [in] precision: 量化精度
+        // [out] report: 评估结果
+        // [ret] 返回成功or失败
+        static bool Evaluate(
+            const int factor,
+            const std::string &model_file_path,
+            const std::string &filter_file_path,
+            const std::string &sample_file_path,
+            const FMPrecision precision,
+            FMQuantReport &report)
+        {
+            FMModelData fp32_data;
+            if (!fp32_data.LoadModelFile(factor, model_file_path))
+            {
+                LOG(ERROR) << "FMQuantEval::Evaluate() LoadModelFile Failed"
+                           << ", model_file_path = " << model_file_path;
+                return false;
+            }
+            FMModelData quant_data;
+            Quantize(fp32_data, precision, quant_data);
+
+            FMTransData trans_data;
+            if (!trans_data.LoadTransFile(filter_file_path))
+            {
+                LOG(ERROR) << "FMQuantEval::Evaluate() LoadTransFile Failed"
+                           << ", filter_file_path = " << filter_file_path;
+                return false;
+            }
+            const auto &trans_format = trans_data.field_trans;
+
+            std::vector<Sample> vecSample;
+            std::vector<int> vecLabel;
+            if (!LoadSampleFile(sample_file_path, vecSample, vecLabel))
+            {
+                return false;
+            }
+
+            report = FMQuantReport();
+            report.samples = vecSample.size();
+            report.row_bytes_fp32 = fp32_data.m_table.stride() * sizeof(score_type);
+            report.row_bytes_quant = quant_data.m_table.stride() * sizeof(score_type);
+
+            std::vector<score_type> vecFP32Score;
+            std::vector<score_type> vecQuantScore;
+            vecFP32Score.reserve(vecSample.size());
+            vecQuantScore.reserve(vecSample.size());
+            for (const auto &sample : vecSample)
+            {
+                const FeatureData feature_data = FMModelData::ToFeatureData(sample);
+                vecFP32Score.emplace_back(FMModel::Score(fp32_data, trans_format, feature_data));
+                vecQuantScore.emplace_back(FMModel::Score(quant_data, trans_format, feature_data));
+                const double delta = std::fabs((double)vecFP32Score.back() - vecQuantScore.back());
+                report.mean_abs_delta += delta;
+                report.max_abs_delta = std::max(report.max_abs_delta, delta);
+            }
+            if (!vecSample.empty())
+            {
+                report.mean_abs_delta /= vecSample.size();
+            }
+            report.auc_fp32 = AUC(vecFP32Score, vecLabel);
+            report.auc_quant = AUC(vecQuantScore, vecLabel);
+            return true;
+        }
+
+        // 按 FP32 模型生成量化模型
+        static void Quantize(const FMModelData &fp32_data, const FMPrecision precision, FMModelData &quant_data)
+        {
+            const auto &table = fp32_data.m_table;
+            quant_data.Clear();
+            quant_data.m_factor = fp32_data.m_factor;
+            quant_data.m_w0 = fp32_data.m_w0;
+            quant_data.m_accumulate = FMKernel::GetAccumulate(quant_data.m_factor, FMKernel::ISA::AVX512, precision);
+            quant_data.m_table.Reset(quant_data.m_factor, table.size(), precision);
+
+            std::vector<score_type> w2(table.factor());
+            const auto vecKey = table.Keys();
+            for (size_t row = 0; row < vecKey.size(); row++)
+            {
+                table.Decode(table.Row(row), w2.data());
+                quant_data.m_table.Add(vecKey[row], table.W1(table.Row(row)), w2.data());
+            }
+        }
+
+        // 对单个样本打分, 与 FMModel 的计算方式一致
+        static score_type Score(const FMModelData &model_data, const FMTransFormat &trans_format, const Sample &sample)
+        {
+            return FMModel::Score(model_data, trans_format, FMModelData::ToFeatureData(sample));
+        }
+
+        // AUC, 分数相同的样本取平均排名
+        static double AUC(const std::vector<score_type> &vecScore, const std::vector<int> &vecLabel)
+        {
+            std::vector<size_t> vecIdx(vecScore.size());
+            for (size_t idx = 0; idx < vecIdx.size(); idx++)
+            {
+                vecIdx[idx] = idx;
+            }
+            std::sort(vecIdx.begin(), vecIdx.end(), [&](size_t a, size_t b)
+                      { return vecScore[a] < vecScore[b]; });
+
+            double positive_rank_sum = 0;
+            size_t positive = 0;
+            for (size_t begin = 0; begin < vecIdx.size();)
+            {
+                size_t end = begin;
+                while (end < vecIdx.size() && vecScore[vecIdx[end]] == vecScore[vecIdx[begin]])
+                {
+                    end++;
+                }
+                const double rank = (begin + 1 + end) / 2.0; // 排名从 1 开始
+                for (size_t idx = begin; idx < end; idx++)
+                {
+                    if (vecLabel[vecIdx[idx]] > 0)
+                    {
+                        positive_rank_sum += rank;
+                        positive++;
+                    }
+                }
+                begin = end;
+            }
+            const size_t negative = vecIdx.size() - positive;
+            if (positive == 0 || negative == 0)
+            {
+                return 0.5;
+            }
+            return (positive_rank_sum - positive * (positive + 1) / 2.0) / ((double)positive * negative);
+        }
+
+        static std::string ToString(const FMQuantReport &report)
+        {
+            char buffer[256];
+            snprintf(buffer, sizeof(buffer),
+                     "samples = %zu, mean_abs_delta = %.3g, max_abs_delta = %.3g, auc_fp32 = %.6f, auc_quant = %.6f"
+                     ", auc_drift = %+.6f, row_bytes = %zu -> %zu",
+                     report.samples, report.mean_abs_delta, report.max_abs_delta, report.auc_fp32, report.auc_quant,
+                     report.auc_quant - report.auc_fp32, report.row_bytes_fp32, report.row_bytes_quant);
+            return buffer;
+        }
+
+    private:
+        static bool LoadSampleFile(const std::string &sample_file_path, std::vector<Sample> &vecSample, std::vector<int> &vecLabel)
+        {
+            Common::MappedFile file;
+            if (!file.Open(sample_file_path))
+            {
+                LOG(ERROR) << "FMQuantEval::LoadSampleFile() MappedFile Open Failed"
+                           << ", sample_file_path = " << sample_file_path;
+                return false;
+            }
+
+            std::vector<std::string_view> strVec;
+            Sample sample;
+            for (std::string_view line : file.lines())
+            {
+                line = Common::StripCR(line);
+                if (line.empty())
+                {
+                    continue;
+                }
+                int label = 0;
+                if (!FMModelData::ParseSampleLine(line, strVec, label, sample))
+                {
+                    LOG(ERROR) << "FMQuantEval::LoadSampleFile() ParseSampleLine Failed"
+                               << ", sample_file_path = " << sample_file_path;
+                    return false;
+                }
+                vecSample.emplace_back(std::move(sample));
+                vecLabel.emplace_back(label);
+            }
+            return true;
+        }
+    };
+}
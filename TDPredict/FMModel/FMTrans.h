@@ -1,12 +1,14 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 #include <atomic>
 #include <unordered_set>
 #include <unordered_map>
 
 #include "glog/logging.h"
-#include "Common/Function.h"
+#include "Common/Tokenizer.h"
+#include "Common/MappedFile.h"
 #include "../Interface/ModelInterface.h"
 
 namespace TDPredict
@@ -27,41 +29,47 @@ namespace TDPredict
         // 加载FM转换数据
         bool LoadTransFile(const std::string &format_file_path)
         {
-            std::string buffer;
-            if (true == Common::FastReadFile(format_file_path, buffer, false))
+            Common::MappedFile file;
+            if (true == file.Open(format_file_path))
             {
-                return LoadTransBuffer(buffer);
+                return LoadTransBuffer(file.data());
             }
             else
             {
-                LOG(ERROR) << "FMTransData::LoadTransBuffer() FastReadFile Failed"
+                LOG(ERROR) << "FMTransData::LoadTransBuffer() MappedFile Open Failed"
                            << ", format_file_path = " << format_file_path;
             }
             return false;
         }
 
-        bool LoadTransBuffer(const std::string &buffer)
+        bool LoadTransBuffer(std::string_view buffer)
         {
             Clear();
 
-            std::string line;
-            std::stringstream ss(buffer);
-            if (!getline(ss, line, '\n'))
+            Common::LineRange lines(buffer);
+            auto iter = lines.begin();
+            if (iter == lines.end())
             {
-                LOG(ERROR) << "FMTransData::LoadTransBuffer() Failed, getline line = " << line;
+                LOG(ERROR) << "FMTransData::LoadTransBuffer() Failed, buffer empty";
                 return false;
             }
 
             // 第一行是一个数字, 标识最大特征维度
-            all_field_count = atoi(line.c_str());
+            std::string_view line = Common::StripCR(*iter);
+            if (!Common::ParseNumber(line, all_field_count))
+            {
+                LOG(ERROR) << "FMTransData::LoadTransBuffer() Failed, all_field_count invalid"
+                           << ", line = " << line;
+                return false;
+            }
 
             int cur_index = 0;
             field_trans.clear();
-            std::vector<std::string> str_vec;
-            while (getline(ss, line, '\n'))
+            std::vector<std::string_view> str_vec;
+            for (++iter; iter != lines.end(); ++iter)
             {
-                str_vec.clear();
-                Common::SplitString(line, ' ', str_vec);
+                line = Common::StripCR(*iter);
+                Common::SplitView(line, ' ', str_vec);
                 if (str_vec.size() != 2)
                 {
                     LOG(ERROR) << "FMTransData::LoadTransBuffer() Failed"
@@ -70,8 +78,15 @@ namespace TDPredict
                     return false;
                 }
 
-                const int field = std::atoi(str_vec[0].c_str());
-                const int count = std::atoi(str_vec[1].c_str());
+                int field = 0;
+                int count = 0;
+                if (!Common::ParseNumber(str_vec[0], field) || !Common::ParseNumber(str_vec[1], count))
+                {
+                    LOG(ERROR) << "FMTransData::LoadTransBuffer() Failed, number invalid"
+                               << ", line = " << line;
+                    return false;
+                }
+
                 if (0 < field && field < FIELD_MAX)
                 {
                     field_trans[field] = count;
@@ -3,7 +3,9 @@
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <memory_resource>
 #include <ostream>
+#include "Common/Arena.h"
 #include "FieldValue.h"
 #include "Eigen/Dense"
 
@@ -30,6 +32,42 @@ namespace TDPredict
         T_0 = 1,     // T+0新用户
     };
 
+    // TensorFlow GRPC 分批策略
+    // TargetBatchMs > 0 时按观测到的单 item 耗时自适应批大小, 并按副本数拆分, 在途批次不超过副本数;
+    // 否则固定按 MaxBatchSize 分批
+    struct TFBatchPolicy
+    {
+        int MinBatchSize = 64;  // 自适应时的最小批大小
+        int MaxBatchSize = 256; // 最大批大小, 不自适应时即为固定批大小
+        int MaxInFlight = 16;   // 单次预测同时在途的批次上限
+        int TargetBatchMs = 0;  // 单批目标耗时(ms), 应大于单次调用的固定开销; 0 为不自适应
+    };
+
+    // TensorFlow GRPC 对冲请求策略, 需要至少两个 TFS 地址
+    // 请求超过最近耗时的 Percentile 分位数(不小于 MinDelayMs)仍未返回时, 向另一个副本补发一次, 先返回者生效
+    struct TFHedgePolicy
+    {
+        int Percentile = 0;     // 对冲延迟取最近请求耗时的分位数, 0 为不对冲
+        int MinDelayMs = 1;     // 对冲延迟下限(ms)
+        int BudgetPercent = 5;  // 对冲请求数不超过主请求数的百分比
+    };
+
+    // TensorFlow GRPC 跨请求合并策略, 仅用于 predict_score
+    // 同一模型的并发请求在 WindowUs 内(或累计到 MaxMergeItems 个 item)合并为一次预测, 结果再按请求拆回
+    struct TFMergePolicy
+    {
+        int WindowUs = 0;          // 首个请求等待后续请求加入的时间(us), 0 为不合并
+        int MaxMergeItems = 1024;  // 合并后 item 数上限, 达到即发送; 单个请求超过上限时不合并
+    };
+
+    // FM 隐向量存储精度
+    enum class FMPrecision : uint32_t
+    {
+        FP32 = 0, // float
+        FP16 = 1, // IEEE 半精度
+        INT8 = 2, // 每行一个缩放系数的 int8
+    };
+
     // 排序层类型
     enum RankType : int32_t
     {
@@ -101,11 +139,12 @@ namespace TDPredict
     };
 
     // 计算单元
+    // 内部容器使用 pmr 分配器, 默认构造时从当前线程的请求内存池(Common::ArenaScope)分配
     struct RankItem
     {
         // 模型 - 分数
-        std::unordered_map<RankType, score_type> type2model_score;    // 模型层对应分数
-        std::unordered_map<std::string, score_type> name2model_score; // 模型名称对应分数
+        std::pmr::unordered_map<RankType, score_type> type2model_score;    // 模型层对应分数
+        std::pmr::unordered_map<std::string, score_type> name2model_score; // 模型名称对应分数
 
         // 仅用于模型计算完毕后, 排序比较
         score_type cmp_score = 0;
@@ -113,36 +152,52 @@ namespace TDPredict
         // 特征
         TFModelUserType user_type = TFModelUserType::Default; // 用户类型
         std::shared_ptr<FeatureData> spFeatureData = nullptr;
-        std::unordered_map<std::string, std::shared_ptr<FeatureData>> name2spFeatureData;
+        std::pmr::unordered_map<std::string, std::shared_ptr<FeatureData>> name2spFeatureData;
 
         // FM辅助计算
         score_type sup_score = 0;
-        std::vector<score_type> sup_vec_sum;
-        std::vector<score_type> sup_vec_sum_sqr;
+        std::pmr::vector<score_type> sup_vec_sum;
+        std::pmr::vector<score_type> sup_vec_sum_sqr;
 
         // 其他参数
-        std::unordered_map<std::string, long> long_params;
-        std::unordered_map<std::string, double> double_params;
-        std::unordered_map<std::string, std::string> string_params;
-
-        RankItem() {}
-
-        RankItem(RankItem &&item)
+        std::pmr::unordered_map<std::string, long> long_params;
+        std::pmr::unordered_map<std::string, double> double_params;
+        std::pmr::unordered_map<std::string, std::string> string_params;
+
+        RankItem() : RankItem(Common::CurrentResource()) {}
+
+        explicit RankItem(std::pmr::memory_resource *mr)
+            : type2model_score(mr),
+              name2model_score(mr),
+              name2spFeatureData(mr),
+              sup_vec_sum(mr),
+              sup_vec_sum_sqr(mr),
+              long_params(mr),
+              double_params(mr),
+              string_params(mr) {}
+
+        // 移动构造与默认构造一样使用当前线程的内存资源:
+        // 与原对象的内存资源相同时直接接管, 不同时(例如移出 ArenaScope)逐个元素移动到当前内存资源,
+        // 移出的对象不再引用原请求内存池
+        RankItem(RankItem &&item) : RankItem(std::move(item), Common::CurrentResource()) {}
+
+        RankItem(RankItem &&item, std::pmr::memory_resource *mr)
+            : type2model_score(std::move(item.type2model_score), mr),
+              name2model_score(std::move(item.name2model_score), mr),
+              name2spFeatureData(std::move(item.name2spFeatureData), mr),
+              sup_vec_sum(std::move(item.sup_vec_sum), mr),
+              sup_vec_sum_sqr(std::move(item.sup_vec_sum_sqr), mr),
+              long_params(std::move(item.long_params), mr),
+              double_params(std::move(item.double_params), mr),
+              string_params(std::move(item.string_params), mr)
         {
             this->cmp_score = item.cmp_score;
-            this->type2model_score = std::move(item.type2model_score);
-            this->name2model_score = std::move(item.name2model_score);
             this->user_type = item.user_type;
             this->spFeatureData = std::move(item.spFeatureData);
-            this->name2spFeatureData = std::move(item.name2spFeatureData);
             this->sup_score = item.sup_score;
-            this->sup_vec_sum = std::move(item.sup_vec_sum);
-            this->sup_vec_sum_sqr = std::move(item.sup_vec_sum_sqr);
-            this->long_params = std::move(item.long_params);
-            this->double_params = std::move(item.double_params);
-            this->string_params = std::move(item.string_params);
         };
 
+        // 移动赋值保留本对象的内存资源, 资源不同时 pmr 容器逐个元素移动
         RankItem &operator=(RankItem &&item)
         {
             this->cmp_score = item.cmp_score;
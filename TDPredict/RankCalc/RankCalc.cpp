@@ -2,6 +2,7 @@
 #include <algorithm>
 #include "glog/logging.h"
 #include "Common/Function.h"
+#include "Common/Clock.h"
 
 #include "../Config/ModelConfig.h"
 #include "../Config/RankExpConfig.h"
@@ -20,6 +21,9 @@ void TDPredict::RankCalc::Calc(
         TDPredict::RankType::ReRank,
     };
 
+    // 请求内存池, 策略计算中新建的 RankItem 等临时对象从中分配
+    Common::ArenaScope arena_scope(m_arena != nullptr ? m_arena : Common::CurrentArena());
+
     const auto &rank_exp_config = RankExpConfig::GetInstance();
     for (const auto &rank_type : vec_rank_type)
     {
@@ -44,7 +48,7 @@ void TDPredict::RankCalc::Calc(
         for (const auto &strategy : strategyList)
         {
 #ifdef DEBUG
-            const auto begin_time = Common::get_ms_time();
+            const auto begin_time = Common::mono_ms();
 #endif
 
             if (m_spPrometheusReport != nullptr)
@@ -65,7 +69,7 @@ void TDPredict::RankCalc::Calc(
             }
 
 #ifdef DEBUG
-            const auto end_time = Common::get_ms_time();
+            const auto end_time = Common::mono_ms();
             LOG(INFO) << "[DEBUG] Calc() CalcSteategyTime"
                       << ", uuid = " << m_uuid
                       << ", rank_type = " << rank_type
@@ -160,6 +164,16 @@ bool TDPredict::RankCalc::SetNewUserWhitelist(const std::unordered_set<long> &Wh
     return true;
 }
 
+bool TDPredict::RankCalc::SetArena(Common::MonotonicArena *arena)
+{
+    if (arena != nullptr)
+    {
+        this->m_arena = arena;
+        return true;
+    }
+    return false;
+}
+
 bool TDPredict::RankCalc::SetPrometheusReport(const PrometheusReportPtr &spReport)
 {
     if (spReport != nullptr)
@@ -388,7 +402,7 @@ bool TDPredict::RankCalc::PrintRankLog(
                 {
                     strParam += ", ";
                 }
-                strParam += pr.first + " = " + std::to_string(pr.second);
+                strParam.append(pr.first).append(" = ").append(std::to_string(pr.second));
             }
             for (const auto &pr : item.double_params)
             {
@@ -396,7 +410,7 @@ bool TDPredict::RankCalc::PrintRankLog(
                 {
                     strParam += ", ";
                 }
-                strParam += pr.first + " = " + std::to_string(pr.second);
+                strParam.append(pr.first).append(" = ").append(std::to_string(pr.second));
             }
             for (const auto &pr : item.string_params)
             {
@@ -404,7 +418,7 @@ bool TDPredict::RankCalc::PrintRankLog(
                 {
                     strParam += ", ";
                 }
-                strParam += pr.first + " = " + pr.second;
+                strParam.append(pr.first).append(" = ").append(pr.second);
             }
         }
 
@@ -460,7 +474,7 @@ bool TDPredict::RankCalc::PrintRankLog(
                     {
                         for (const auto &field_item : feature_list)
                         {
-                            strFeature += std::to_string(field_item.field_value.field_value()) + ":" + std::to_string(field_item.weight) + " ";
+                            strFeature.append(std::to_string(field_item.field_value.field_value())).append(":").append(std::to_string(field_item.weight)).append(" ");
                         }
                     }
 
@@ -469,7 +483,7 @@ bool TDPredict::RankCalc::PrintRankLog(
                     {
                         for (const auto &field_item : feature_list)
                         {
-                            strFeature += std::to_string(field_item.field_value.field_value()) + ":" + std::to_string(field_item.weight) + " ";
+                            strFeature.append(std::to_string(field_item.field_value.field_value())).append(":").append(std::to_string(field_item.weight)).append(" ");
                         }
                     }
                 }
@@ -6,6 +6,7 @@
 #include <unordered_set>
 #include <unordered_map>
 #include "PrometheusClient/PrometheusClient.h"
+#include "Common/Arena.h"
 
 namespace TDPredict
 {
@@ -28,6 +29,7 @@ namespace TDPredict
         bool SetNewUserWhitelist(const std::unordered_set<long> &Whitelist);
         bool SetPrometheusReport(const PrometheusReportPtr &spReport);
         bool SetInitData(const std::any init_data);
+        bool SetArena(Common::MonotonicArena *arena);
 
     private:
         bool CalcSteategy(
@@ -48,5 +50,6 @@ namespace TDPredict
         long m_UserRegisterTimestamp = 0;                   // 用户注册时间戳
         std::unordered_set<long> m_NewUserWhitelist;        // 新用户白名单
         PrometheusReportPtr m_spPrometheusReport = nullptr; // 普罗米修斯上报
+        Common::MonotonicArena *m_arena = nullptr;          // 请求内存池
     };
 } // namespace TDPredict
@@ -12,7 +12,10 @@ bool TFModel::Update(
     const int version,
     const TFModelMethodType request_method,
     const std::string &output_name,
-    const bool use_user_type) noexcept
+    const bool use_user_type,
+    const TFBatchPolicy &batch_policy,
+    const TFHedgePolicy &hedge_policy,
+    const TFMergePolicy &merge_policy) noexcept
 {
     std::lock_guard<std::mutex> lg(m_updateLock);
     int data_idx = (m_dataIdx + 1) % 2;
@@ -26,10 +29,11 @@ bool TFModel::Update(
     }
     else if (TFModelMethodType::GRPC == request_method)
     {
-        // 仅在GRPC模式下使用 output_name 字段
+        // 仅在GRPC模式下使用 output_name 与 batch_policy/hedge_policy/merge_policy 字段
         m_spTFModelGrpc[data_idx] = std::make_shared<TFModelGrpc>(
             vec_tfs_addrs, signature_name, GetName(),
-            timeout, use_dropout_keep, version, output_name, use_user_type);
+            timeout, use_dropout_keep, version, output_name, use_user_type,
+            batch_policy, hedge_policy, merge_policy);
     }
     else
     {
@@ -27,7 +27,10 @@ namespace TDPredict
             const int version,
             const TFModelMethodType request_method,
             const std::string &output_name,
-            const bool use_user_type) noexcept;
+            const bool use_user_type,
+            const TFBatchPolicy &batch_policy = TFBatchPolicy(),
+            const TFHedgePolicy &hedge_policy = TFHedgePolicy(),
+            const TFMergePolicy &merge_policy = TFMergePolicy()) noexcept;
 
         // 预测函数
         virtual bool predict(RankItem &item) const noexcept override;
@@ -5,6 +5,7 @@
 #include "rapidjson/writer.h"
 #include "rapidjson/stringbuffer.h"
 #include "HTTPClient/HTTPClient.h"
+#include "AsyncLog/AsyncLog.h"
 
 using namespace TDPredict;
 
@@ -77,9 +78,9 @@ bool TFModelBase::predict_base(
         bool add_succ = HTTPClient::GetInstance()->add_post_request(post_url, {}, post_msg, m_Timeout, client_code, json_result);
         if (!add_succ)
         {
-            LOG(ERROR) << "predict() HTTPClient add_post_request Failed"
-                       << ", batch_idx = " << batch_idx
-                       << ", post_url = " << post_url;
+            LOG_LIMIT(ERROR, 10) << "predict() HTTPClient add_post_request Failed"
+                                 << ", batch_idx = " << batch_idx
+                                 << ", post_url = " << post_url;
             continue;
         }
 
@@ -119,9 +120,9 @@ bool TFModelBase::predict_base(
         int32_t errCode = future.get();
         if (errCode != CURLE_OK)
         {
-            LOG(ERROR) << "predict() post_request failed"
-                       << ", post_url = " << vec_post_url[batch_idx]
-                       << ", code = " << errCode;
+            LOG_LIMIT(ERROR, 10) << "predict() post_request failed"
+                                 << ", post_url = " << vec_post_url[batch_idx]
+                                 << ", code = " << errCode;
             continue;
         }
 
@@ -1,9 +1,80 @@
 #include "TFModelGrpc.h"
 #include "TFTrans.h"
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <condition_variable>
+#include "google/protobuf/arena.h"
 #include "glog/logging.h"
+#include "AsyncLog/AsyncLog.h"
+#include "Common/Clock.h"
 
 using namespace TDPredict;
 
+namespace
+{
+    // 校验 float 输出 [batch] 或 [batch, array], 返回按行紧密排列的数据起始位置
+    // 数据在 tensor_content(整块字节) 或 float_val 中, 两者内存布局相同, 调用方统一按字节拷贝
+    // [ret] dtype/shape/数据长度不符时返回 nullptr
+    const char *FloatOutputData(
+        const tensorflow::TensorProto &tensor,
+        const int request_count,
+        int &array_size,
+        const char *func_name)
+    {
+        static_assert(sizeof(score_type) == sizeof(float), "DT_FLOAT requires float score_type");
+        if (tensor.dtype() != tensorflow::DataType::DT_FLOAT)
+        {
+            LOG(ERROR) << func_name << " dtype check failed, dtype = " << tensor.dtype();
+            return nullptr;
+        }
+
+        const auto &tensorShape = tensor.tensor_shape();
+        const int dim_size = tensorShape.dim_size();
+        if (dim_size != 1 && dim_size != 2)
+        {
+            LOG(ERROR) << func_name << " dim_size check failed, dim_size = " << dim_size;
+            return nullptr;
+        }
+        const int64_t dim_batch_size = tensorShape.dim(0).size();
+        const int64_t dim_array_size = (dim_size == 2) ? tensorShape.dim(1).size() : 1;
+        if (dim_batch_size != request_count || dim_array_size <= 0 || dim_array_size > INT32_MAX / request_count)
+        {
+            LOG(ERROR) << func_name << " request_count check failed"
+                       << ", request_count = " << request_count
+                       << ", dim_batch_size = " << dim_batch_size
+                       << ", dim_array_size = " << dim_array_size;
+            return nullptr;
+        }
+        array_size = dim_array_size;
+
+        const size_t val_count = static_cast<size_t>(request_count) * array_size;
+        const std::string &content = tensor.tensor_content();
+        if (!content.empty())
+        {
+            if (content.size() != val_count * sizeof(float))
+            {
+                LOG(ERROR) << func_name << " tensor_content size check failed"
+                           << ", content_size = " << content.size()
+                           << ", val_count = " << val_count;
+                return nullptr;
+            }
+            return content.data();
+        }
+
+        if (static_cast<size_t>(tensor.float_val_size()) != val_count)
+        {
+            LOG(ERROR) << func_name << " float_val_size check failed"
+                       << ", float_val_size = " << tensor.float_val_size()
+                       << ", val_count = " << val_count;
+            return nullptr;
+        }
+        return reinterpret_cast<const char *>(tensor.float_val().data());
+    }
+}
+
 bool TFModelGrpc::CallBackScoreFunc(
     const grpc::Status status,
     ResponseProto &response,
@@ -24,11 +95,11 @@ bool TFModelGrpc::CallBackScoreFunc(
 
     if (!status.ok())
     {
-        LOG(ERROR) << "CallBackScoreFunc() Request Failed"
-                   << ", ModelName = " << spData->obj->m_ModelName
-                   << ", Version = " << spData->obj->m_Version
-                   << ", status.error_code() = " << status.error_code()
-                   << ", status.error_message() = " << status.error_message();
+        LOG_LIMIT(ERROR, 10) << "CallBackScoreFunc() Request Failed"
+                             << ", ModelName = " << spData->obj->m_ModelName
+                             << ", Version = " << spData->obj->m_Version
+                             << ", status.error_code() = " << status.error_code()
+                             << ", status.error_message() = " << status.error_message();
         return false;
     }
 
@@ -65,62 +136,30 @@ bool TFModelGrpc::CallBackScoreFunc(
         return false;
     }
 
-    const auto &tensorProto = iter->second;
-    const auto &tensorShape = tensorProto.tensor_shape();
-    const int dim_size = tensorShape.dim_size();
-    if (dim_size == 1)
+    const int begin = spData->begin;
+    const int request_count = spData->end - begin;
+    int array_size = 0;
+    const char *val_data = FloatOutputData(iter->second, request_count, array_size, "CallBackScoreFunc()");
+    if (val_data == nullptr)
     {
-        const int request_count = spData->end - spData->begin;
-        const int dim_batch_size = tensorShape.dim(0).size();
-        const int float_val_size = tensorProto.float_val_size();
-        if (float_val_size != dim_batch_size ||
-            request_count != dim_batch_size)
-        {
-            LOG(ERROR) << "CallBackScoreFunc() request_count check failed"
-                       << ", request_count = " << request_count
-                       << ", float_val_size = " << float_val_size
-                       << ", dim_batch_size = " << dim_batch_size;
-            return false;
-        }
-
-        const int begin = spData->begin;
-        for (int batch_idx = 0; batch_idx < dim_batch_size; batch_idx++)
-        {
-            vec_score[batch_idx + begin] = tensorProto.float_val(batch_idx);
-        }
-        return true;
+        LOG(ERROR) << "CallBackScoreFunc() output check failed, ModelName = " << spData->obj->m_ModelName;
+        return false;
     }
-    else if (dim_size == 2)
-    {
-        const int request_count = spData->end - spData->begin;
-        const int dim_batch_size = tensorShape.dim(0).size();
-        const int dim_array_size = tensorShape.dim(1).size();
-        const int float_val_size = tensorProto.float_val_size();
-        if (float_val_size != dim_batch_size * dim_array_size ||
-            request_count != dim_batch_size)
-        {
-            LOG(ERROR) << "CallBackEmbFunc() request_count check failed"
-                       << ", request_count = " << request_count
-                       << ", float_val_size = " << float_val_size
-                       << ", dim_batch_size = " << dim_batch_size
-                       << ", dim_array_size = " << dim_array_size;
-            return false;
-        }
 
-        const int begin = spData->begin;
-        for (int val_idx = 0, batch_idx = 0; batch_idx < dim_batch_size;
-             batch_idx++, val_idx += dim_array_size)
-        {
-            // 取每个数组的第一个元素作为分数
-            vec_score[batch_idx + begin] = tensorProto.float_val(val_idx);
-        }
-        return true;
+    if (array_size == 1)
+    {
+        memcpy(vec_score.data() + begin, val_data, request_count * sizeof(score_type));
     }
     else
     {
-        LOG(ERROR) << "CallBackScoreFunc() dim_size check failed, dim_size = " << dim_size;
-        return false;
+        // 取每个数组的第一个元素作为分数
+        const size_t row_bytes = array_size * sizeof(score_type);
+        for (int batch_idx = 0; batch_idx < request_count; batch_idx++, val_data += row_bytes)
+        {
+            memcpy(&vec_score[batch_idx + begin], val_data, sizeof(score_type));
+        }
     }
+    return true;
 }
 
 bool TFModelGrpc::CallBackEmbFunc(
@@ -143,18 +182,18 @@ bool TFModelGrpc::CallBackEmbFunc(
 
     if (!status.ok())
     {
-        LOG(ERROR) << "CallBackEmbFunc() Request Failed"
-                   << ", ModelName = " << spData->obj->m_ModelName
-                   << ", Version = " << spData->obj->m_Version
-                   << ", status.error_code() = " << status.error_code()
-                   << ", status.error_message() = " << status.error_message();
+        LOG_LIMIT(ERROR, 10) << "CallBackEmbFunc() Request Failed"
+                             << ", ModelName = " << spData->obj->m_ModelName
+                             << ", Version = " << spData->obj->m_Version
+                             << ", status.error_code() = " << status.error_code()
+                             << ", status.error_message() = " << status.error_message();
         return false;
     }
 
     const std::string output_name = spData->obj->m_OutputName;
-    auto outputs = response.mutable_outputs();
-    auto iter = outputs->find(output_name);
-    if (iter == outputs->end())
+    const OutputMap &outputs = response.outputs();
+    const auto iter = outputs.find(output_name);
+    if (iter == outputs.end())
     {
         LOG(ERROR) << "CallBackEmbFunc() outputs.find() Failed"
                    << ", ModelName = " << spData->obj->m_ModelName
@@ -181,37 +220,27 @@ bool TFModelGrpc::CallBackEmbFunc(
     }
 
     // 获取批量数及分组数
-    auto &tensorProto = iter->second;
-    const auto &tensorShape = tensorProto.tensor_shape();
-    const int dim_size = tensorShape.dim_size();
-    if (dim_size != 2)
+    if (iter->second.tensor_shape().dim_size() != 2)
     {
         LOG(ERROR) << "CallBackEmbFunc() dim_size == 2 check failed.";
         return false;
     }
 
-    const int request_count = end - begin;
-    const int dim_batch_size = tensorShape.dim(0).size();
-    const int dim_array_size = tensorShape.dim(1).size();
-    const int float_val_size = tensorProto.float_val_size();
-    if (float_val_size != dim_batch_size * dim_array_size ||
-        request_count != dim_batch_size)
+    int array_size = 0;
+    const char *val_data = FloatOutputData(iter->second, end - begin, array_size, "CallBackEmbFunc()");
+    if (val_data == nullptr)
     {
-        LOG(ERROR) << "CallBackEmbFunc() val_size == batch_size * array_size check failed"
-                   << ", request_count = " << request_count
-                   << ", float_val_size = " << float_val_size
-                   << ", dim_batch_size = " << dim_batch_size
-                   << ", dim_array_size = " << dim_array_size;
+        LOG(ERROR) << "CallBackEmbFunc() output check failed, ModelName = " << spData->obj->m_ModelName;
         return false;
     }
 
-    auto val_data_ptr = tensorProto.mutable_float_val()->mutable_data();
-    for (int idx = begin; idx < end; idx++)
+    // 每行整块拷贝进 emb, 不再逐元素读取
+    const size_t row_bytes = array_size * sizeof(score_type);
+    for (int idx = begin; idx < end; idx++, val_data += row_bytes)
     {
-        // Eigen::Map是将一段连续的内存空间映射成Eigen中Matrix的方法;
-        // 可以直接使用相关的矩阵运算, 极大的节省了内存占用, 提升了计算处理效率。
-        vec_emb_any[idx] = Eigen::Map<emb_any_type, Eigen::Unaligned>(val_data_ptr, dim_array_size);
-        val_data_ptr += dim_array_size;
+        auto &emb = vec_emb_any[idx];
+        emb.resize(array_size);
+        memcpy(emb.data(), val_data, row_bytes);
     }
     return true;
 }
@@ -224,10 +253,14 @@ TFModelGrpc::TFModelGrpc(
     const bool use_dropout_keep,
     const int version,
     const std::string &output_name,
-    const bool use_user_type)
-    : client(vec_tfs_addrs)
+    const bool use_user_type,
+    const TFBatchPolicy &batch_policy,
+    const TFHedgePolicy &hedge_policy,
+    const TFMergePolicy &merge_policy)
+    : client(vec_tfs_addrs, hedge_policy)
 {
     // 更新数据
+    m_TFSAddrList = vec_tfs_addrs;
     m_Timeout = timeout;
     m_ModelName = model_name;
     m_SignatureName = signature_name;
@@ -235,8 +268,168 @@ TFModelGrpc::TFModelGrpc(
     m_Version = version;
     m_OutputName = output_name;
     m_UseUserType = use_user_type;
+    m_BatchPolicy = batch_policy;
+    m_MergePolicy = merge_policy;
 }
 
+namespace
+{
+    // 设置 [rows, cols] 形状并分配 tensor_content, 返回写入位置
+    // tensor_content 按本机字节序紧密排列, 与 TensorFlow 在小端机器上的内存布局一致
+    char *PackTensor(
+        tensorflow::TensorProto &tensor,
+        const tensorflow::DataType dtype,
+        const int rows,
+        const int cols,
+        const size_t elem_size)
+    {
+        tensor.set_dtype(dtype);
+        auto *shape = tensor.mutable_tensor_shape();
+        shape->add_dim()->set_size(rows);
+        shape->add_dim()->set_size(cols);
+        std::string *content = tensor.mutable_tensor_content();
+        content->resize(elem_size * rows * cols);
+        return content->data();
+    }
+
+    // 请求消息所在的 Arena, 首块按批量大小预估, 请求内的消息对象与 map 节点一次分配
+    google::protobuf::ArenaOptions RequestArenaOptions(const int batch_count)
+    {
+        google::protobuf::ArenaOptions options;
+        options.start_block_size = 1024 * std::max(batch_count, 1);
+        return options;
+    }
+
+    // 经共用 CQ 轮询线程发出的批次的完成计数, 回调在轮询线程上更新, 调用方线程等待
+    // 回调持有 shared_ptr, 调用方返回后仍在收尾的回调不会访问已释放的对象
+    struct BatchRecvState
+    {
+        std::mutex mutex;
+        std::condition_variable cv;
+        int done_count = 0;
+        int recv_count = 0;
+        bool succ = true;
+    };
+    using BatchRecvStatePtr = std::shared_ptr<BatchRecvState>;
+
+    const TFSInputData &InputAt(const std::vector<TFSInputData> &inputs, const int idx)
+    {
+        return inputs[idx];
+    }
+
+    const TFSInputData &InputAt(const std::vector<const TFSInputData *> &inputs, const int idx)
+    {
+        return *inputs[idx];
+    }
+}
+
+template <typename Inputs>
+bool TFModelGrpc::FillRequestProto(
+    const Inputs &inputs,
+    const int begin, const int end,
+    RequestProto &request) const noexcept
+{
+    if (inputs.empty() || begin < 0 || end > (int)inputs.size() || begin >= end)
+    {
+        return false;
+    }
+
+    request.mutable_model_spec()->set_name(m_ModelName);
+    request.mutable_model_spec()->set_signature_name(m_SignatureName);
+    if (m_Version > 0)
+    {
+        request.mutable_model_spec()->mutable_version()->set_value(m_Version);
+    }
+
+    const int batch_size = end - begin;
+    const int input_size = InputAt(inputs, begin).index.size();
+    for (int batch_idx = begin; batch_idx < end; batch_idx++)
+    {
+        const auto &tfs_input = InputAt(inputs, batch_idx);
+        if ((int)tfs_input.index.size() != input_size || (int)tfs_input.value.size() != input_size)
+        {
+            return false;
+        }
+    }
+
+    // 各输入直接在 map 中构造(与 request 在同一个 Arena 上), 数据以 tensor_content 整块写入
+    InputMap &request_inputs = *request.mutable_inputs();
+    if (m_UseDropoutKeep)
+    {
+        char *content = PackTensor(request_inputs["dropout_keep"], tensorflow::DataType::DT_FLOAT,
+                                   batch_size, 1, sizeof(float));
+        const float keep = 1;
+        for (int batch_idx = 0; batch_idx < batch_size; batch_idx++)
+        {
+            memcpy(content + batch_idx * sizeof(float), &keep, sizeof(float));
+        }
+    }
+
+    if (m_UseUserType)
+    {
+        char *content = PackTensor(request_inputs["user_type"], tensorflow::DataType::DT_INT32,
+                                   batch_size, 1, sizeof(int32_t));
+        for (int batch_idx = 0; batch_idx < batch_size; batch_idx++)
+        {
+            const int32_t user_type = InputAt(inputs, begin + batch_idx).user_type;
+            memcpy(content + batch_idx * sizeof(int32_t), &user_type, sizeof(int32_t));
+        }
+    }
+
+    // input_index
+    {
+        static_assert(sizeof(int) == sizeof(int32_t), "DT_INT32 requires 32-bit int");
+        const size_t row_bytes = input_size * sizeof(int32_t);
+        char *content = PackTensor(request_inputs["input_index"], tensorflow::DataType::DT_INT32,
+                                   batch_size, input_size, sizeof(int32_t));
+        for (int batch_idx = begin; batch_idx < end; batch_idx++, content += row_bytes)
+        {
+            memcpy(content, InputAt(inputs, batch_idx).index.data(), row_bytes);
+        }
+    }
+
+    // input_value
+    {
+        static_assert(sizeof(score_type) == sizeof(float), "DT_FLOAT requires float score_type");
+        const size_t row_bytes = input_size * sizeof(float);
+        char *content = PackTensor(request_inputs["input_value"], tensorflow::DataType::DT_FLOAT,
+                                   batch_size, input_size, sizeof(float));
+        for (int batch_idx = begin; batch_idx < end; batch_idx++, content += row_bytes)
+        {
+            memcpy(content, InputAt(inputs, batch_idx).value.data(), row_bytes);
+        }
+    }
+    return true;
+}
+
+bool TFModelGrpc::GenerateRequestProto(
+    const std::vector<TFSInputData> &vec_tfs_input,
+    const int begin, const int end,
+    RequestProto &request) const noexcept
+{
+    return FillRequestProto(vec_tfs_input, begin, end, request);
+}
+
+// 合并组: 首个加入的请求为发送方, 等待窗口结束(或 item 数达到上限)后发送整组, 再把分数拆回各请求
+// 其它请求只登记输入与结果位置, 阻塞到发送方完成; 组内指针指向各请求自己的输入与结果, 它们在完成前一直有效
+struct TFModelGrpc::MergeGroup
+{
+    struct Member
+    {
+        std::vector<TDPredict::score_type> *vec_score;
+        int begin;
+        int count;
+    };
+
+    std::vector<const TFSInputData *> inputs;
+    std::vector<Member> members;
+    int input_size = 0;
+    bool closed = false; // 不再接受新请求
+    bool done = false;
+    bool succ = false;
+    std::condition_variable cv; // 与 m_MergeLock 配合使用
+};
+
 // 批量预测函数
 bool TFModelGrpc::predict_score(
     const std::vector<TFSInputData> &vec_tfs_inputs,
@@ -248,53 +441,129 @@ bool TFModelGrpc::predict_score(
         return true;
     }
 
-    const int vec_tfs_inputs_size = vec_tfs_inputs.size();
-    if (vec_tfs_inputs_size <= per_batch_size)
+    // 结果数组不足时不合并, 单独发送并在回调中报错
+    const int item_count = vec_tfs_inputs.size();
+    if (m_MergePolicy.WindowUs > 0 && item_count < m_MergePolicy.MaxMergeItems &&
+        (int)vec_tfs_results.size() >= item_count)
     {
-        // 获取模型基础数据
-        RequestProto request_proto;
-        GenerateRequestProto(vec_tfs_inputs, 0, vec_tfs_inputs_size, request_proto);
+        return MergePredictScore(vec_tfs_inputs, vec_tfs_results);
+    }
+    return SendScore(vec_tfs_inputs, vec_tfs_results);
+}
 
+bool TFModelGrpc::SendScore(
+    const std::vector<TFSInputData> &vec_tfs_inputs,
+    std::vector<TDPredict::score_type> &vec_tfs_results) const noexcept
+{
+    auto make_request = [this, &vec_tfs_inputs](const int begin, const int end, RequestProto &request)
+    {
+        return GenerateRequestProto(vec_tfs_inputs, begin, end, request);
+    };
+    auto make_data = [this, &vec_tfs_results](const int begin, const int end) -> std::any
+    {
         ScoreDataPtr spData = std::make_shared<ScoreData>();
         spData->obj = this;
         spData->vec_score = &vec_tfs_results;
-        spData->begin = 0;
-        spData->end = vec_tfs_inputs_size;
-        return client.Send(request_proto, m_Timeout, CallBackScoreFunc, spData);
+        spData->begin = begin;
+        spData->end = end;
+        return spData;
+    };
+    return SendBatches(vec_tfs_inputs.size(), make_request, CallBackScoreFunc, make_data);
+}
+
+bool TFModelGrpc::MergePredictScore(
+    const std::vector<TFSInputData> &vec_tfs_inputs,
+    std::vector<TDPredict::score_type> &vec_tfs_results) const noexcept
+{
+    const int item_count = vec_tfs_inputs.size();
+    const int input_size = vec_tfs_inputs.front().index.size();
+    std::unique_lock<std::mutex> ul(m_MergeLock);
+    std::shared_ptr<MergeGroup> spGroup = m_spMergeGroup;
+    if (spGroup != nullptr && (int)spGroup->inputs.size() + item_count > m_MergePolicy.MaxMergeItems)
+    {
+        // 放不下: 当前组立即发送, 本请求另起一组
+        spGroup->closed = true;
+        spGroup->cv.notify_all();
+        m_spMergeGroup = nullptr;
+        spGroup = nullptr;
     }
-    else
+
+    const bool sender = (spGroup == nullptr);
+    if (sender)
     {
-        // 分批调用
-        const int batch_count = (vec_tfs_inputs_size / per_batch_size) + ((vec_tfs_inputs_size % per_batch_size == 0) ? 0 : 1);
-        std::vector<RequestProto> vec_request_proto(batch_count);
-        std::vector<ScoreDataPtr> vec_response_data(batch_count);
-        grpc::CompletionQueue cq;
-        for (int batch_idx = 0; batch_idx < batch_count; batch_idx++)
-        {
-            const int begin = batch_idx * per_batch_size;
-            const int end = std::min(vec_tfs_inputs_size, begin + per_batch_size);
-            auto &request_proto = vec_request_proto[batch_idx];
-            GenerateRequestProto(vec_tfs_inputs, begin, end, request_proto);
-
-            vec_response_data[batch_idx] = std::make_shared<ScoreData>();
-            auto &spData = vec_response_data[batch_idx];
-            spData->obj = this;
-            spData->vec_score = &vec_tfs_results;
-            spData->begin = begin;
-            spData->end = end;
-            client.PipeSend(&cq, request_proto, m_Timeout, CallBackScoreFunc, spData);
-        }
+        spGroup = std::make_shared<MergeGroup>();
+        spGroup->input_size = input_size;
+        m_spMergeGroup = spGroup;
+    }
+    else if (spGroup->input_size != input_size)
+    {
+        // 输入长度不同的请求不能拼进同一个 tensor, 单独发送
+        ul.unlock();
+        return SendScore(vec_tfs_inputs, vec_tfs_results);
+    }
+
+    spGroup->members.push_back({&vec_tfs_results, (int)spGroup->inputs.size(), item_count});
+    for (const auto &tfs_input : vec_tfs_inputs)
+    {
+        spGroup->inputs.push_back(&tfs_input);
+    }
+    if ((int)spGroup->inputs.size() >= m_MergePolicy.MaxMergeItems)
+    {
+        spGroup->closed = true;
+        spGroup->cv.notify_all();
+    }
 
-        // 接收处理返回结果
-        for (int batch_idx = 0; batch_idx < batch_count; batch_idx++)
+    if (!sender)
+    {
+        spGroup->cv.wait(ul, [&spGroup]()
+                         { return spGroup->done; });
+        return spGroup->succ;
+    }
+
+    // 发送方: 等待窗口结束或组满, 之后不再接受新请求
+    spGroup->cv.wait_for(ul, std::chrono::microseconds(m_MergePolicy.WindowUs), [&spGroup]()
+                         { return spGroup->closed; });
+    spGroup->closed = true;
+    if (m_spMergeGroup == spGroup)
+    {
+        m_spMergeGroup = nullptr;
+    }
+    ul.unlock();
+
+    const auto &inputs = spGroup->inputs;
+    std::vector<TDPredict::score_type> vec_score(inputs.size());
+    auto make_request = [this, &inputs](const int begin, const int end, RequestProto &request)
+    {
+        return FillRequestProto(inputs, begin, end, request);
+    };
+    auto make_data = [this, &vec_score](const int begin, const int end) -> std::any
+    {
+        ScoreDataPtr spData = std::make_shared<ScoreData>();
+        spData->obj = this;
+        spData->vec_score = &vec_score;
+        spData->begin = begin;
+        spData->end = end;
+        return spData;
+    };
+    const bool succ = SendBatches(inputs.size(), make_request, CallBackScoreFunc, make_data);
+    if (succ)
+    {
+        for (const auto &member : spGroup->members)
         {
-            client.PipeRecv(&cq);
+            std::copy_n(vec_score.begin() + member.begin, member.count, member.vec_score->begin());
         }
     }
-    return true;
+    m_MergeSent.fetch_add(1, std::memory_order_relaxed);
+    m_MergeRequests.fetch_add(spGroup->members.size(), std::memory_order_relaxed);
+
+    ul.lock();
+    spGroup->succ = succ;
+    spGroup->done = true;
+    spGroup->cv.notify_all();
+    return succ;
 }
 
-// 批量预测函数
+// 批量预测Emb函数
 bool TFModelGrpc::predict_emb(
     const std::vector<TFSInputData> &vec_tfs_inputs,
     std::vector<TDPredict::emb_any_type> &vec_emb_any) const noexcept
@@ -305,141 +574,165 @@ bool TFModelGrpc::predict_emb(
         return true;
     }
 
-    const int vec_tfs_inputs_size = vec_tfs_inputs.size();
-    if (vec_tfs_inputs_size <= per_batch_size)
+    auto make_request = [this, &vec_tfs_inputs](const int begin, const int end, RequestProto &request)
+    {
+        return GenerateRequestProto(vec_tfs_inputs, begin, end, request);
+    };
+    auto make_data = [this, &vec_emb_any](const int begin, const int end) -> std::any
     {
-        // 获取模型基础数据
-        RequestProto request;
-        GenerateRequestProto(vec_tfs_inputs, 0, vec_tfs_inputs_size, request);
-
         EmbAnyDataPtr spData = std::make_shared<EmbAnyData>();
         spData->obj = this;
         spData->vec_emb_any = &vec_emb_any;
-        spData->begin = 0;
-        spData->end = vec_tfs_inputs_size;
-        return client.Send(request, m_Timeout, CallBackEmbFunc, spData);
-    }
-    else
+        spData->begin = begin;
+        spData->end = end;
+        return spData;
+    };
+    return SendBatches(vec_tfs_inputs.size(), make_request, CallBackEmbFunc, make_data);
+}
+
+int TFModelGrpc::GetBatchSize(const int item_count) const noexcept
+{
+    const TFBatchPolicy &policy = m_BatchPolicy;
+    if (policy.TargetBatchMs <= 0)
     {
-        // 分批调用
-        const int batch_count = (vec_tfs_inputs_size / per_batch_size) + ((vec_tfs_inputs_size % per_batch_size == 0) ? 0 : 1);
-        std::vector<RequestProto> vec_request_proto(batch_count);
-        std::vector<EmbAnyDataPtr> vec_response_data(batch_count);
-        grpc::CompletionQueue cq;
-        for (int batch_idx = 0; batch_idx < batch_count; batch_idx++)
-        {
-            const int begin = batch_idx * per_batch_size;
-            const int end = std::min(vec_tfs_inputs_size, begin + per_batch_size);
-            auto &request_proto = vec_request_proto[batch_idx];
-            GenerateRequestProto(vec_tfs_inputs, begin, end, request_proto);
-
-            vec_response_data[batch_idx] = std::make_shared<EmbAnyData>();
-            auto &spData = vec_response_data[batch_idx];
-            spData->obj = this;
-            spData->vec_emb_any = &vec_emb_any;
-            spData->begin = begin;
-            spData->end = end;
-            client.PipeSend(&cq, request_proto, m_Timeout, CallBackEmbFunc, spData);
-        }
+        return std::max(1, policy.MaxBatchSize);
+    }
 
-        // 接收处理返回结果
-        for (int batch_idx = 0; batch_idx < batch_count; batch_idx++)
-        {
-            client.PipeRecv(&cq);
-        }
+    // 按单 item 耗时估计目标耗时内能算完的批大小
+    double target_size = policy.MaxBatchSize;
+    const double item_cost_us = m_ItemCostUs.load(std::memory_order_relaxed);
+    if (item_cost_us > 0)
+    {
+        target_size = std::min(target_size, policy.TargetBatchMs * 1000.0 / item_cost_us);
     }
-    return true;
+    target_size = std::max<double>(target_size, std::max(1, policy.MinBatchSize));
+
+    // 每轮每个副本一批, 轮数取最少, 再把 item 均分到 轮数 * 并行数 个批次上
+    const int parallel = GetMaxInFlight();
+    const double rounds = std::ceil(item_count / (parallel * target_size));
+    int batch_size = std::ceil(item_count / (rounds * parallel));
+    batch_size = std::max(batch_size, policy.MinBatchSize);
+    return std::max(1, std::min(batch_size, policy.MaxBatchSize));
 }
 
-bool TFModelGrpc::GenerateRequestProto(
-    const std::vector<TFSInputData> &vec_tfs_input,
-    const int begin, const int end,
-    RequestProto &request) const noexcept
+int TFModelGrpc::GetMaxInFlight() const noexcept
 {
-    if (vec_tfs_input.empty())
+    // 自适应时每个副本同时只处理本次预测的一批, 超出副本数的批次只会在服务端排队, 且排队时间会计入单 item 耗时
+    const int max_in_flight = std::max(1, m_BatchPolicy.MaxInFlight);
+    if (m_BatchPolicy.TargetBatchMs > 0)
     {
-        return false;
+        return std::max(1, std::min<int>(m_TFSAddrList.size(), max_in_flight));
     }
+    return max_in_flight;
+}
 
-    request.mutable_model_spec()->set_name(m_ModelName);
-    request.mutable_model_spec()->set_signature_name(m_SignatureName);
-    if (m_Version > 0)
-    {
-        request.mutable_model_spec()->mutable_version()->set_value(m_Version);
-    }
+double TFModelGrpc::GetItemCostUs() const noexcept
+{
+    return m_ItemCostUs.load(std::memory_order_relaxed);
+}
 
-    const int batch_size = end - begin;
-    const int input_size = vec_tfs_input[0].index.size();
+void TFModelGrpc::UpdateItemCost(const int item_count, const double cost_ms) const noexcept
+{
+    // 指数滑动平均; 并发更新时可能丢失个别样本, 不影响估计
+    constexpr double alpha = 0.2;
+    const double item_cost_us = cost_ms * 1000.0 / item_count;
+    const double old_cost_us = m_ItemCostUs.load(std::memory_order_relaxed);
+    const double new_cost_us = (old_cost_us > 0) ? old_cost_us + alpha * (item_cost_us - old_cost_us) : item_cost_us;
+    m_ItemCostUs.store(new_cost_us, std::memory_order_relaxed);
+}
 
-    InputMap &inputs = *request.mutable_inputs();
-    if (m_UseDropoutKeep)
+GrpcCallBackFunc TFModelGrpc::ObserveFunc(const GrpcCallBackFunc &func, const int item_count) const
+{
+    // 从发送前开始计时, 成功返回的批次计入单 item 耗时
+    Common::Stopwatch sw;
+    return [this, func, item_count, sw](const grpc::Status status, ResponseProto &response, std::any data)
     {
-        tensorflow::TensorProto dropout_keep;
-        dropout_keep.set_dtype(tensorflow::DataType::DT_FLOAT);
-        for (int batch_idx = begin; batch_idx < end; batch_idx++)
+        const bool ret = func(status, response, std::move(data));
+        if (ret)
         {
-            dropout_keep.add_float_val(1);
+            UpdateItemCost(item_count, sw.elapsed_ms());
         }
-        dropout_keep.mutable_tensor_shape()->add_dim()->set_size(batch_size);
-        dropout_keep.mutable_tensor_shape()->add_dim()->set_size(1);
-        inputs["dropout_keep"] = dropout_keep;
-    }
+        return ret;
+    };
+}
 
-    if (m_UseUserType)
+bool TFModelGrpc::SendBatches(
+    const int vec_tfs_inputs_size,
+    const std::function<bool(const int, const int, RequestProto &)> &make_request,
+    const GrpcCallBackFunc &func,
+    const std::function<std::any(const int, const int)> &make_data) const noexcept
+{
+    const int batch_size = GetBatchSize(vec_tfs_inputs_size);
+    const int batch_count = (vec_tfs_inputs_size + batch_size - 1) / batch_size;
+    google::protobuf::Arena arena(RequestArenaOptions(batch_count));
+    if (batch_count == 1 && !client.HedgeEnabled())
     {
-        tensorflow::TensorProto user_type;
-        user_type.set_dtype(tensorflow::DataType::DT_INT32);
-        for (int batch_idx = begin; batch_idx < end; batch_idx++)
+        auto *request_proto = google::protobuf::Arena::CreateMessage<RequestProto>(&arena);
+        if (!make_request(0, vec_tfs_inputs_size, *request_proto))
         {
-            user_type.add_int_val(vec_tfs_input[batch_idx].user_type);
+            LOG(ERROR) << "SendBatches() GenerateRequestProto Failed, ModelName = " << m_ModelName;
+            return false;
         }
-        user_type.mutable_tensor_shape()->add_dim()->set_size(batch_size);
-        user_type.mutable_tensor_shape()->add_dim()->set_size(1);
-        inputs["user_type"] = user_type;
+        return client.Send(*request_proto, m_Timeout, ObserveFunc(func, vec_tfs_inputs_size),
+                           make_data(0, vec_tfs_inputs_size));
     }
 
-    // input_index
+    // 分批调用, 同时在途的批次不超过 GetMaxInFlight(), 每收到一批再补发一批
+    // 任一批次失败则不再发送, 等在途批次全部返回后整体失败; 请求在 arena 析构前全部完成
+    // 批次经 client 共用的 CQ 轮询线程完成, 回调在轮询线程上执行, 本线程只等待完成计数, 不再每次新建 CQ
+    // 开启对冲时(单批也)经 HedgedAsyncSend 发送, 慢的批次由轮询线程补发到另一个副本
+    BatchRecvStatePtr spState = std::make_shared<BatchRecvState>();
+    auto pipe_send = [&](RequestProto &request, GrpcCallBackFunc batch_func, std::any data)
     {
-        tensorflow::TensorProto input_index;
-        input_index.set_dtype(tensorflow::DataType::DT_INT32);
-        for (int batch_idx = begin; batch_idx < end; batch_idx++)
+        auto done_func = [spState, batch_func](const grpc::Status status, ResponseProto &response, std::any data)
         {
-            const auto &index = vec_tfs_input[batch_idx].index;
-            const int index_size = index.size();
-            if (index_size != input_size)
+            const bool ret = batch_func(status, response, std::move(data));
             {
-                return false;
+                std::lock_guard<std::mutex> lg(spState->mutex);
+                spState->done_count++;
+                spState->succ = spState->succ && ret;
             }
-            for (int idx = 0; idx < index_size; idx++)
+            spState->cv.notify_one();
+            return ret;
+        };
+        client.HedgedAsyncSend(request, m_Timeout, std::move(done_func), std::move(data));
+    };
+    // 每次取走一个完成的批次, 返回目前为止是否全部成功
+    auto pipe_recv = [&]()
+    {
+        std::unique_lock<std::mutex> ul(spState->mutex);
+        spState->cv.wait(ul, [&spState]()
+                         { return spState->done_count > spState->recv_count; });
+        spState->recv_count++;
+        return spState->succ;
+    };
+
+    const int max_in_flight = GetMaxInFlight();
+    int send_count = 0;
+    int recv_count = 0;
+    bool succ = true;
+    while (recv_count < send_count || (succ && send_count < batch_count))
+    {
+        while (succ && send_count < batch_count && send_count - recv_count < max_in_flight)
+        {
+            const int begin = send_count * batch_size;
+            const int end = std::min(vec_tfs_inputs_size, begin + batch_size);
+            auto *request_proto = google::protobuf::Arena::CreateMessage<RequestProto>(&arena);
+            if (!make_request(begin, end, *request_proto))
             {
-                input_index.add_int_val(index[idx]);
+                LOG(ERROR) << "SendBatches() GenerateRequestProto Failed, ModelName = " << m_ModelName;
+                succ = false;
+                break;
             }
+            pipe_send(*request_proto, ObserveFunc(func, end - begin), make_data(begin, end));
+            send_count++;
         }
-        input_index.mutable_tensor_shape()->add_dim()->set_size(batch_size);
-        input_index.mutable_tensor_shape()->add_dim()->set_size(input_size);
-        inputs["input_index"] = input_index;
-    }
 
-    // input_value
-    {
-        tensorflow::TensorProto input_value;
-        input_value.set_dtype(tensorflow::DataType::DT_FLOAT);
-        for (int batch_idx = begin; batch_idx < end; batch_idx++)
+        if (recv_count < send_count)
         {
-            const auto &value = vec_tfs_input[batch_idx].value;
-            const int value_size = value.size();
-            if (value_size != input_size)
-            {
-                return false;
-            }
-            for (int idx = 0; idx < value_size; idx++)
-            {
-                input_value.add_float_val(value[idx]);
-            }
+            succ = pipe_recv() && succ;
+            recv_count++;
         }
-        input_value.mutable_tensor_shape()->add_dim()->set_size(batch_size);
-        input_value.mutable_tensor_shape()->add_dim()->set_size(input_size);
-        inputs["input_value"] = input_value;
     }
-    return true;
+    return succ;
 }
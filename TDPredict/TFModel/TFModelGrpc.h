@@ -3,26 +3,16 @@
 #include <vector>
 #include <any>
 #include <future>
+#include <atomic>
+#include <mutex>
+#include <functional>
 
 #include "Interface/ModelInterface.h"
+#include "TFTrans.h"
 #include "TFServingClient.hpp"
 
 namespace TDPredict
 {
-    struct TFSInputData
-    {
-        std::vector<int> index;
-        std::vector<score_type> value;
-        TFModelUserType user_type;
-
-        void clear()
-        {
-            index.clear();
-            value.clear();
-            user_type = TFModelUserType::Default;
-        }
-    };
-
     class TFModelGrpc final
     {
     public:
@@ -53,11 +43,14 @@ namespace TDPredict
             const bool use_dropout_keep,
             const int version,
             const std::string &output_name,
-            const bool use_user_type);
+            const bool use_user_type,
+            const TFBatchPolicy &batch_policy = TFBatchPolicy(),
+            const TFHedgePolicy &hedge_policy = TFHedgePolicy(),
+            const TFMergePolicy &merge_policy = TFMergePolicy());
 
         virtual ~TFModelGrpc(){};
 
-        // 批量预测分数函数
+        // 批量预测分数函数, 开启合并时与同一模型的并发请求合并发送
         bool predict_score(
             const std::vector<TFSInputData> &vec_tfs_inputs,
             std::vector<TDPredict::score_type> &vec_tfs_results) const noexcept;
@@ -67,12 +60,63 @@ namespace TDPredict
             const std::vector<TFSInputData> &vec_tfs_inputs,
             std::vector<TDPredict::emb_any_type> &vec_emb_any) const noexcept;
 
-    private:
+        // 由 [begin, end) 的输入构造请求, 输入以 tensor_content 整块编码
+        // request 建议在 protobuf Arena 上创建, 各输入 tensor 直接在其 inputs 中构造
+        // [ret] 输入为空或各 item 输入长度不一致时返回 false
         bool GenerateRequestProto(
             const std::vector<TFSInputData> &vec_tfs_input,
             const int begin, const int end,
             RequestProto &request) const noexcept;
 
+        // 按分批策略与观测到的单 item 耗时, 计算 item_count 个输入的批大小
+        int GetBatchSize(const int item_count) const noexcept;
+
+        // 单次预测同时在途的批次上限, 自适应时不超过副本数
+        int GetMaxInFlight() const noexcept;
+
+        // 观测到的单 item 耗时(us), 尚无观测时为 0
+        double GetItemCostUs() const noexcept;
+
+        const TFservingClient &GetClient() const noexcept { return client; }
+
+        // 合并发送的次数, 以及其中包含的原始请求数
+        long GetMergeSentCount() const noexcept { return m_MergeSent.load(std::memory_order_relaxed); }
+        long GetMergeRequestCount() const noexcept { return m_MergeRequests.load(std::memory_order_relaxed); }
+
+    private:
+        // 一次合并发送的请求组, 定义见 TFModelGrpc.cpp
+        struct MergeGroup;
+
+        // 不合并, 直接分批发送并预测分数
+        bool SendScore(
+            const std::vector<TFSInputData> &vec_tfs_inputs,
+            std::vector<TDPredict::score_type> &vec_tfs_results) const noexcept;
+
+        // 按 m_MergePolicy 与其它并发请求合并后预测分数
+        bool MergePredictScore(
+            const std::vector<TFSInputData> &vec_tfs_inputs,
+            std::vector<TDPredict::score_type> &vec_tfs_results) const noexcept;
+
+        // 由 inputs 中 [begin, end) 的输入构造请求, inputs 为 TFSInputData 或其指针的数组
+        template <typename Inputs>
+        bool FillRequestProto(
+            const Inputs &inputs,
+            const int begin, const int end,
+            RequestProto &request) const noexcept;
+
+        // 按批大小把 item_count 个输入拆分成请求并发送, 多批时经 client 共用的 CQ 轮询线程并发,
+        // 在途批次不超过 GetMaxInFlight(); make_request 构造 [begin, end) 的请求
+        bool SendBatches(
+            const int item_count,
+            const std::function<bool(const int, const int, RequestProto &)> &make_request,
+            const GrpcCallBackFunc &func,
+            const std::function<std::any(const int, const int)> &make_data) const noexcept;
+
+        // 包装回调, 请求成功时记录该批耗时
+        GrpcCallBackFunc ObserveFunc(const GrpcCallBackFunc &func, const int item_count) const;
+
+        void UpdateItemCost(const int item_count, const double cost_ms) const noexcept;
+
         static bool CallBackScoreFunc(
             const grpc::Status status,
             ResponseProto &response,
@@ -84,7 +128,6 @@ namespace TDPredict
             std::any data);
 
     private:
-        static constexpr int per_batch_size = 256; // 分批调用, 每一批次数量
         const TFservingClient client;
         std::vector<std::string> m_TFSAddrList;
         std::string m_ModelName;
@@ -94,6 +137,13 @@ namespace TDPredict
         bool m_UseDropoutKeep;
         std::string m_OutputName;
         bool m_UseUserType;
+        TFBatchPolicy m_BatchPolicy;
+        mutable std::atomic<double> m_ItemCostUs = 0; // 单 item 耗时(us)的滑动平均
+        TFMergePolicy m_MergePolicy;
+        mutable std::mutex m_MergeLock;
+        mutable std::shared_ptr<MergeGroup> m_spMergeGroup; // 正在等待其它请求加入的组
+        mutable std::atomic<long> m_MergeSent = 0;
+        mutable std::atomic<long> m_MergeRequests = 0;
     };
 
 } // namespace TDPredict
@@ -9,10 +9,12 @@
 
 namespace TDPredict
 {
+    // 按转换文件把特征写入 index/value, 两者均为 all_field_count 长度, 未命中的位置保持原值
     inline void TransTFSFeature(
         const TDPredict::FeatureItem &feature_item,
         const TFTransData &trans_data,
-        TDPredict::TFSInputData &tfs_input) noexcept
+        int *index,
+        score_type *value) noexcept
     {
         if (feature_item.size() != FIELD_MAX)
         {
@@ -48,8 +50,8 @@ namespace TDPredict
                     auto iter_tm = trans_data.trans_mapping.find(field_item.field_value.field_value());
                     if (iter_tm != trans_data.trans_mapping.end())
                     {
-                        tfs_input.index[field_begin + idx] = iter_tm->second;
-                        tfs_input.value[field_begin + idx] = field_item.weight;
+                        index[field_begin + idx] = iter_tm->second;
+                        value[field_begin + idx] = field_item.weight;
                     }
                 }
             }
@@ -62,8 +64,8 @@ namespace TDPredict
                     auto iter_tm = trans_data.trans_mapping.find(field_item.field_value.field_value());
                     if (iter_tm != trans_data.trans_mapping.end())
                     {
-                        tfs_input.index[field_begin + push_count] = iter_tm->second;
-                        tfs_input.value[field_begin + push_count] = field_item.weight;
+                        index[field_begin + push_count] = iter_tm->second;
+                        value[field_begin + push_count] = field_item.weight;
                         push_count += 1;
                         if (push_count >= use_count)
                         {
@@ -75,6 +77,14 @@ namespace TDPredict
         }
     }
 
+    inline void TransTFSFeature(
+        const TDPredict::FeatureItem &feature_item,
+        const TFTransData &trans_data,
+        TDPredict::TFSInputData &tfs_input) noexcept
+    {
+        TransTFSFeature(feature_item, trans_data, tfs_input.index.data(), tfs_input.value.data());
+    }
+
     inline bool get_tfs_result(
         const std::string &tfs_result,
         TDPredict::score_type &tfs_result_score) noexcept
@@ -1,9 +1,20 @@
+#pragma once
 #include <string>
+#include <vector>
 #include <memory>
 #include <any>
+#include <future>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
 
+#include "Common/Clock.h"
 #include "Common/Function.h"
+#include "ClientManager/GrpcCQLoop.h"
+#include "Interface/ModelInterface.h"
 #include "grpcpp/grpcpp.h"
+#include "grpcpp/alarm.h"
 #include "grpc/support/log.h"
 #include "tensorflow_serving/apis/prediction_service.grpc.pb.h"
 
@@ -21,12 +32,24 @@ namespace TDPredict
         ResponseProto &response,
         std::any data)>;
 
+    struct TFSReply
+    {
+        grpc::Status status;
+        ResponseProto response;
+    };
+
     class TFservingClient
     {
     public:
         // addr = ipv4:address[:port][,address[:port],...]
         // see: https://github.com/grpc/grpc/blob/master/doc/naming.md
-        explicit TFservingClient(const std::vector<std::string> &vec_addr)
+        // [in] spLoop: 完成异步请求的 CQ 轮询线程, 为空时使用进程内共用的 DefaultLoop()
+        explicit TFservingClient(
+            const std::vector<std::string> &vec_addr,
+            const TFHedgePolicy &hedge_policy = TFHedgePolicy(),
+            std::shared_ptr<GrpcCQLoop> spLoop = nullptr)
+            : m_spLoop(spLoop != nullptr ? std::move(spLoop) : DefaultLoop()),
+              m_hedgePolicy(hedge_policy)
         {
             std::string addr = "ipv4:";
             addr.reserve(vec_addr.size() * 20);
@@ -41,43 +64,87 @@ namespace TDPredict
             args.SetCompressionAlgorithm(GRPC_COMPRESS_GZIP);
             args.SetLoadBalancingPolicyName("round_robin");
             stub_ = Service::NewStub(grpc::CreateCustomChannel(addr, grpc::InsecureChannelCredentials(), args));
+
+            // 对冲请求要发往另一个副本, 每个地址单独建连, 由客户端轮询选择副本
+            if (m_hedgePolicy.Percentile > 0 && vec_addr.size() > 1)
+            {
+                for (auto &item : vec_addr)
+                {
+                    hedge_stubs_.push_back(Service::NewStub(grpc::CreateCustomChannel(
+                        "ipv4:" + item, grpc::InsecureChannelCredentials(), args)));
+                }
+            }
         }
 
-        // 异步请求接口, 当请求完成后调用回调函数
-        void AsyncSend(
-            RequestProto &request,
+        // 进程内各 TFservingClient 共用的 CQ 轮询线程, 首次使用时创建
+        static std::shared_ptr<GrpcCQLoop> DefaultLoop()
+        {
+            static const std::shared_ptr<GrpcCQLoop> spLoop = []()
+            {
+                auto spLoop = std::make_shared<GrpcCQLoop>();
+                spLoop->Init(default_loop_threads);
+                return spLoop;
+            }();
+            return spLoop;
+        }
+
+        // 是否开启对冲, 需要配置 Percentile 且至少两个地址
+        bool HedgeEnabled() const noexcept { return !hedge_stubs_.empty(); }
+
+        // 当前对冲延迟(ms), 样本不足时为 -1, 不对冲
+        double GetHedgeDelayMs() const noexcept { return m_hedgeDelayMs.load(std::memory_order_relaxed); }
+
+        // 已发出的对冲请求数, 以及其中先于主请求成功返回的数量
+        long GetHedgeSentCount() const noexcept { return m_hedgeSent.load(std::memory_order_relaxed); }
+        long GetHedgeWonCount() const noexcept { return m_hedgeWon.load(std::memory_order_relaxed); }
+
+        // 对冲异步请求, 与 AsyncSend 一样在共用的 CQ 轮询线程上完成并调用回调, 调用方不需要 CQ, 也不阻塞
+        // 请求发出后超过对冲延迟仍未返回时, 由轮询线程上的定时器在预算内向另一个副本补发一次,
+        // 先成功返回的生效, 另一个取消; 未开启对冲(HedgeEnabled() 为 false)时退化为 AsyncSend
+        // request 需保持有效直到回调被调用(补发时才序列化第二份)
+        void HedgedAsyncSend(
+            const RequestProto &request,
             const long timeout_ms,
             GrpcCallBackFunc func,
             std::any data) const
         {
-            AsyncClientCall *call = new AsyncClientCall;
-            call->data = data;
-            call->func = func;
-
-            if (timeout_ms > 0)
+            if (!HedgeEnabled())
             {
-                gpr_timespec timespec;
-                timespec.tv_sec = timeout_ms / 1000;
-                timespec.tv_nsec = (timeout_ms % 1000) * 1000 * 1000;
-                timespec.clock_type = GPR_TIMESPAN;
-                call->context.set_deadline(timespec);
+                AsyncSend(request, timeout_ms, std::move(func), std::move(data));
+                return;
             }
 
-            call->response_reader = stub_->PrepareAsyncPredict(&call->context, request, &cq_);
-            call->response_reader->StartCall();
-            call->response_reader->Finish(&call->response, &call->status, (void *)call);
+            HedgedCall *call = new HedgedCall(*this);
+            call->request = &request;
+            call->timeout_ms = timeout_ms;
+            call->func = std::move(func);
+            call->data = std::move(data);
+            call->backend = m_nextBackend.fetch_add(1, std::memory_order_relaxed) % hedge_stubs_.size();
+            AddHedgeBudget();
+
+            std::lock_guard<std::mutex> lg(call->mutex);
+            call->StartAttempt(call->backend, timeout_ms);
+            const double hedge_ms = GetHedgeDelayMs();
+            if (hedge_ms >= 0)
+            {
+                call->outstanding++;
+                call->alarm.Set(m_spLoop->GetCQ(),
+                                std::chrono::system_clock::now() + std::chrono::microseconds(static_cast<long>(hedge_ms * 1000)),
+                                static_cast<GrpcCQTag *>(&call->alarm_tag));
+            }
         }
 
-        void PipeSend(
-            grpc::CompletionQueue *cq,
-            RequestProto &request,
+        // 异步请求接口, 请求挂在共用的 CQ 轮询线程上, 完成后在轮询线程上调用回调函数
+        // 回调应尽快返回, 不要在其中做阻塞操作; request 在函数返回后即可释放
+        void AsyncSend(
+            const RequestProto &request,
             const long timeout_ms,
             GrpcCallBackFunc func,
             std::any data) const
         {
             AsyncClientCall *call = new AsyncClientCall;
-            call->data = data;
-            call->func = func;
+            call->data = std::move(data);
+            call->func = std::move(func);
 
             if (timeout_ms > 0)
             {
@@ -88,45 +155,26 @@ namespace TDPredict
                 call->context.set_deadline(timespec);
             }
 
-            call->response_reader = stub_->AsyncPredict(&call->context, request, cq);
-            call->response_reader->Finish(&call->response, &call->status, (void *)call);
-        }
-
-        bool PipeRecv(grpc::CompletionQueue *cq) const
-        {
-            // P.s> 需要注意这里不保证Pipe的顺序
-            // 故实际的方案是, 调用几次Send, 就调用对应次数的Recv
-            // 比如调用Send顺序 [1,2,3,4], 处理Recv顺序可能是 [2,3,1,4]
-            // 这种情况下需要自行知道返回结果的顺序
-            if (cq == nullptr)
-            {
-                return false;
-            }
-
-            bool ret = false;
-            {
-                void *got_tag;
-                bool ok = false;
-                GPR_ASSERT(cq->Next(&got_tag, &ok));
-                GPR_ASSERT(ok);
-                AsyncClientCall *call = static_cast<AsyncClientCall *>(got_tag);
-                ret = call->func(call->status, call->response, call->data);
-                delete call;
-            }
-            return ret;
+            call->response_reader = stub_->PrepareAsyncPredict(&call->context, request, m_spLoop->GetCQ());
+            call->response_reader->StartCall();
+            call->response_reader->Finish(&call->response, &call->status, static_cast<GrpcCQTag *>(call));
         }
 
-        void AsyncCompleteRpc()
+        // 异步请求接口, 结果经 future 返回
+        std::future<TFSReply> AsyncPredict(const RequestProto &request, const long timeout_ms) const
         {
-            void *got_tag;
-            bool ok = false;
-            while (cq_.Next(&got_tag, &ok))
+            auto spPromise = std::make_shared<std::promise<TFSReply>>();
+            std::future<TFSReply> future = spPromise->get_future();
+            auto func = [spPromise](const grpc::Status status, ResponseProto &response, std::any)
             {
-                GPR_ASSERT(ok);
-                AsyncClientCall *call = static_cast<AsyncClientCall *>(got_tag);
-                call->func(call->status, call->response, call->data);
-                delete call;
-            }
+                TFSReply reply;
+                reply.status = status;
+                reply.response.Swap(&response);
+                spPromise->set_value(std::move(reply));
+                return true;
+            };
+            AsyncSend(request, timeout_ms, func, std::any());
+            return future;
         }
 
         // 同步接口, 请求结束后调用func
@@ -151,8 +199,72 @@ namespace TDPredict
             return func(status, response, data);
         }
 
+        // 准备异步调用, 由调用方 StartCall 并在 cq 上等待结果
+        std::unique_ptr<grpc::ClientAsyncResponseReader<ResponseProto>> PrepareAsyncPredict(
+            grpc::ClientContext *context,
+            const RequestProto &request,
+            grpc::CompletionQueue *cq) const
+        {
+            return stub_->PrepareAsyncPredict(context, request, cq);
+        }
+
     private:
-        struct AsyncClientCall
+        // 记录成功请求的耗时, 每 16 个样本重新计算一次对冲延迟
+        void RecordLatency(const double cost_ms) const
+        {
+            constexpr size_t window_size = 256;
+            constexpr size_t min_samples = 16;
+            std::lock_guard<std::mutex> lg(m_latencyLock);
+            if (m_latencyMs.size() < window_size)
+            {
+                m_latencyMs.push_back(cost_ms);
+            }
+            else
+            {
+                m_latencyMs[m_latencyPos] = cost_ms;
+            }
+            m_latencyPos = (m_latencyPos + 1) % window_size;
+            if (++m_latencyCount % min_samples != 0)
+            {
+                return;
+            }
+
+            std::vector<double> vecLatency(m_latencyMs);
+            const size_t nth = std::min(vecLatency.size() - 1, vecLatency.size() * m_hedgePolicy.Percentile / 100);
+            std::nth_element(vecLatency.begin(), vecLatency.begin() + nth, vecLatency.end());
+            m_hedgeDelayMs.store(std::max<double>(vecLatency[nth], m_hedgePolicy.MinDelayMs), std::memory_order_relaxed);
+        }
+
+        // 预算以 1/100 个请求计: 每个主请求累积 BudgetPercent, 每个对冲请求消耗 100
+        void AddHedgeBudget() const
+        {
+            constexpr int max_tokens = 100 * 10; // 最多攒下 10 个对冲请求
+            int tokens = m_hedgeTokens.load(std::memory_order_relaxed);
+            while (tokens < max_tokens &&
+                   !m_hedgeTokens.compare_exchange_weak(tokens, std::min(max_tokens, tokens + m_hedgePolicy.BudgetPercent)))
+            {
+            }
+        }
+
+        bool AcquireHedgeToken() const
+        {
+            int tokens = m_hedgeTokens.load(std::memory_order_relaxed);
+            while (tokens >= 100)
+            {
+                if (m_hedgeTokens.compare_exchange_weak(tokens, tokens - 100))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    private:
+        // 共用 CQ 轮询线程数, 压测中 1 个线程即可维持 256 个在途请求(见 Test_TFModelGrpc.hpp CQLoopBenchmark),
+        // 多留 1 个, 避免个别较慢的回调(大批量解析)阻塞其它请求的完成
+        static constexpr int default_loop_threads = 2;
+
+        struct AsyncClientCall final : public GrpcCQTag
         {
             grpc::ClientContext context;
             std::unique_ptr<grpc::ClientAsyncResponseReader<ResponseProto>> response_reader;
@@ -160,9 +272,173 @@ namespace TDPredict
             ResponseProto response;
             GrpcCallBackFunc func;
             std::any data;
+
+            // 在 CQ 轮询线程上完成 AsyncSend 发出的请求
+            void Proceed(bool ok) override
+            {
+                if (!ok && status.ok())
+                {
+                    status = grpc::Status(grpc::StatusCode::CANCELLED, "completion queue shutdown");
+                }
+                func(status, response, std::move(data));
+                delete this;
+            }
         };
 
+        // 一个对冲请求, 最多两次尝试(主请求与对冲请求)加一个对冲定时器, 各自作为标签挂在共用 CQ 上
+        // 不同标签可能在不同轮询线程上同时完成, 状态由 mutex 保护; 所有标签都返回后释放
+        struct HedgedCall
+        {
+            struct Attempt final : public GrpcCQTag
+            {
+                HedgedCall *call = nullptr;
+                grpc::ClientContext context;
+                std::unique_ptr<grpc::ClientAsyncResponseReader<ResponseProto>> response_reader;
+                grpc::Status status;
+                ResponseProto response;
+                bool finished = false;
+
+                void Proceed(bool ok) override { call->OnAttempt(*this, ok); }
+            };
+
+            struct AlarmTag final : public GrpcCQTag
+            {
+                HedgedCall *call = nullptr;
+                void Proceed(bool ok) override { call->OnAlarm(ok); }
+            };
+
+            explicit HedgedCall(const TFservingClient &client) : client(client)
+            {
+                attempts[0].call = this;
+                attempts[1].call = this;
+                alarm_tag.call = this;
+            }
+
+            // 调用方持有 mutex
+            void StartAttempt(const size_t backend, const long attempt_timeout_ms)
+            {
+                Attempt &attempt = attempts[started++];
+                if (attempt_timeout_ms > 0)
+                {
+                    attempt.context.set_deadline(std::chrono::system_clock::now() + std::chrono::milliseconds(attempt_timeout_ms));
+                }
+                attempt.response_reader = client.hedge_stubs_[backend]->PrepareAsyncPredict(
+                    &attempt.context, *request, client.m_spLoop->GetCQ());
+                attempt.response_reader->StartCall();
+                attempt.response_reader->Finish(&attempt.response, &attempt.status, static_cast<GrpcCQTag *>(&attempt));
+                outstanding++;
+            }
+
+            // 定时器到期: 主请求仍未返回时补发, 对冲请求沿用主请求的截止时间
+            void OnAlarm(const bool fired)
+            {
+                std::unique_lock<std::mutex> ul(mutex);
+                outstanding--;
+                if (fired && !done && started == 1)
+                {
+                    long attempt_timeout_ms = 0;
+                    if (timeout_ms > 0)
+                    {
+                        attempt_timeout_ms = timeout_ms - static_cast<long>(sw.elapsed_ms());
+                    }
+                    if (timeout_ms <= 0 || attempt_timeout_ms > 0)
+                    {
+                        if (client.AcquireHedgeToken())
+                        {
+                            client.m_hedgeSent.fetch_add(1, std::memory_order_relaxed);
+                            StartAttempt((backend + 1) % client.hedge_stubs_.size(), attempt_timeout_ms);
+                        }
+                    }
+                }
+                ReleaseIfIdle(ul);
+            }
+
+            void OnAttempt(Attempt &attempt, const bool ok)
+            {
+                std::unique_lock<std::mutex> ul(mutex);
+                outstanding--;
+                attempt.finished = true;
+                if (!ok && attempt.status.ok())
+                {
+                    attempt.status = grpc::Status(grpc::StatusCode::CANCELLED, "completion queue shutdown");
+                }
+                finished++;
+                // 已有结果(这是被取消的一方), 或失败但另一次尝试仍在途
+                if (done || (!attempt.status.ok() && finished < started))
+                {
+                    ReleaseIfIdle(ul);
+                    return;
+                }
+
+                done = true;
+                for (int idx = 0; idx < started; idx++)
+                {
+                    if (!attempts[idx].finished)
+                    {
+                        attempts[idx].context.TryCancel();
+                    }
+                }
+                alarm.Cancel();
+                if (attempt.status.ok())
+                {
+                    client.RecordLatency(sw.elapsed_ms());
+                    if (&attempt != &attempts[0])
+                    {
+                        client.m_hedgeWon.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+
+                // 回调在锁外执行, 期间被取消的一方可能返回; 回调返回前本对象不会释放
+                ul.unlock();
+                func(attempt.status, attempt.response, std::move(data));
+                ul.lock();
+                callback_done = true;
+                ReleaseIfIdle(ul);
+            }
+
+            // 所有标签都已返回且回调已执行时释放自身
+            void ReleaseIfIdle(std::unique_lock<std::mutex> &ul)
+            {
+                if (outstanding > 0 || (done && !callback_done))
+                {
+                    return;
+                }
+                ul.unlock();
+                delete this;
+            }
+
+            const TFservingClient &client;
+            std::mutex mutex;
+            const RequestProto *request = nullptr;
+            long timeout_ms = 0;
+            GrpcCallBackFunc func;
+            std::any data;
+            Common::Stopwatch sw;
+            size_t backend = 0; // 主请求的副本
+            Attempt attempts[2];
+            AlarmTag alarm_tag;
+            grpc::Alarm alarm;
+            int started = 0;
+            int finished = 0;
+            int outstanding = 0; // 尚未返回的标签数
+            bool done = false;
+            bool callback_done = false;
+        };
+
+        std::shared_ptr<GrpcCQLoop> m_spLoop;
         std::unique_ptr<Service::Stub> stub_;
-        mutable grpc::CompletionQueue cq_;
+
+        // 对冲请求
+        const TFHedgePolicy m_hedgePolicy;
+        std::vector<std::unique_ptr<Service::Stub>> hedge_stubs_; // 每个地址一个连接, 未开启对冲时为空
+        mutable std::atomic<size_t> m_nextBackend = 0;
+        mutable std::atomic<int> m_hedgeTokens = 0;
+        mutable std::atomic<double> m_hedgeDelayMs = -1;
+        mutable std::atomic<long> m_hedgeSent = 0;
+        mutable std::atomic<long> m_hedgeWon = 0;
+        mutable std::mutex m_latencyLock;
+        mutable std::vector<double> m_latencyMs; // 最近成功请求的耗时(ms), 环形窗口
+        mutable size_t m_latencyPos = 0;
+        mutable size_t m_latencyCount = 0;
     };
 }
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+#include "ClientManager/GrpcCoroutine.h"
+#include "TFServingClient.hpp"
+
+// TFServing 协程接口, 需要 C++20
+// 请求挂在 GrpcCoLoop 的 CQ 上, 完成后恢复等待的协程
+//
+// Example:
+// Common::Task<void> Foo(GrpcCoLoop &loop, TDPredict::TFservingClient &client, TDPredict::RequestProto &request)
+// {
+//     auto reply = co_await TDPredict::CoPredict(loop, client, request, 50);
+//     if (reply.status.ok()) { ... reply.response ... }
+// }
+namespace TDPredict
+{
+    // request 的生命周期必须覆盖 co_await 表达式
+    inline auto CoPredict(
+        GrpcCoLoop &loop,
+        const TFservingClient &client,
+        const RequestProto &request,
+        const long timeout_ms)
+    {
+        auto prepare = [&client, &request](grpc::ClientContext *context, grpc::CompletionQueue *cq)
+        {
+            return client.PrepareAsyncPredict(context, request, cq);
+        };
+        return CoGrpcCall<ResponseProto>(loop, timeout_ms, prepare);
+    }
+}
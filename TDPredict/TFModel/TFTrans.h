@@ -1,10 +1,13 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_set>
 #include <unordered_map>
 #include <atomic>
 #include "Common/Function.h"
+#include "Common/Tokenizer.h"
+#include "Common/MappedFile.h"
 #include "glog/logging.h"
 #include "../Interface/ModelInterface.h"
 
@@ -36,45 +39,59 @@ namespace TDPredict
         // 加载TF转换数据
         bool LoadTransFile(const std::string &trans_file_path)
         {
-            std::string buffer;
-            if (true == Common::FastReadFile(trans_file_path, buffer, false))
+            Common::MappedFile file;
+            if (true == file.Open(trans_file_path))
             {
-                return LoadTransBuffer(buffer);
+                return LoadTransBuffer(file.data());
             }
             else
             {
-                LOG(ERROR) << "TFTransData::LoadTransFile() FastReadFile Failed"
+                LOG(ERROR) << "TFTransData::LoadTransFile() MappedFile Open Failed"
                            << ", trans_file_path = " << trans_file_path;
             }
             return false;
         }
 
-        bool LoadTransBuffer(const std::string &buffer)
+        bool LoadTransBuffer(std::string_view buffer)
         {
             Clear();
 
-            std::string line;
-            std::stringstream ss(buffer);
-            if (!getline(ss, line, '\n'))
+            Common::LineRange lines(buffer);
+            auto iter = lines.begin();
+            if (iter == lines.end())
             {
-                LOG(ERROR) << "TFTransData::LoadTransBuffer() Failed, getline line = " << line;
+                LOG(ERROR) << "TFTransData::LoadTransBuffer() Failed, buffer empty";
                 return false;
             }
 
             // 第一行是一个数字, 标识最大特征维度
-            all_field_count = atoi(line.c_str());
+            std::string_view line = Common::StripCR(*iter);
+            if (!Common::ParseNumber(line, all_field_count))
+            {
+                LOG(ERROR) << "TFTransData::LoadTransBuffer() Failed, all_field_count invalid"
+                           << ", line = " << line;
+                return false;
+            }
 
             int cur_index = 0;
             field_trans.clear();
             trans_mapping.clear();
-            while (getline(ss, line, '\n'))
+            std::vector<std::string_view> str_vec;
+            for (++iter; iter != lines.end(); ++iter)
             {
-                std::vector<std::string> str_vec;
-                Common::SplitString(line, ' ', str_vec);
+                line = Common::StripCR(*iter);
+                Common::SplitView(line, ' ', str_vec);
                 if (str_vec.size() == 2)
                 {
-                    long field = std::atol(str_vec[0].c_str());
-                    int count = std::atoi(str_vec[1].c_str());
+                    long field = 0;
+                    int count = 0;
+                    if (!Common::ParseNumber(str_vec[0], field) || !Common::ParseNumber(str_vec[1], count))
+                    {
+                        LOG(ERROR) << "TFTransData::LoadTransBuffer() Failed, number invalid"
+                                   << ", line = " << line;
+                        return false;
+                    }
+
                     if (0 < field && field < FIELD_MAX)
                     {
                         field_trans.emplace(field, FieldFormat(cur_index, count));
@@ -90,10 +107,18 @@ namespace TDPredict
                 }
                 else if (str_vec.size() == 3)
                 {
-                    // long field_8_value_24 = std::atol(str_vec[0].c_str());
-                    int field = std::atoi(str_vec[0].c_str());
-                    int value = std::atoi(str_vec[1].c_str());
-                    int index = std::atoi(str_vec[2].c_str());
+                    int field = 0;
+                    int value = 0;
+                    int index = 0;
+                    if (!Common::ParseNumber(str_vec[0], field) ||
+                        !Common::ParseNumber(str_vec[1], value) ||
+                        !Common::ParseNumber(str_vec[2], index))
+                    {
+                        LOG(ERROR) << "TFTransData::LoadTransBuffer() Failed, number invalid"
+                                   << ", line = " << line;
+                        return false;
+                    }
+
                     if (0 < field && field < FIELD_MAX)
                     {
                         FieldValue fv(field, value);
@@ -128,4 +153,19 @@ namespace TDPredict
         }
     };
 
+    // 一个 item 的模型输入, 按转换文件排列的 all_field_count 个 (index, value)
+    struct TFSInputData
+    {
+        std::vector<int> index;
+        std::vector<score_type> value;
+        TFModelUserType user_type;
+
+        void clear()
+        {
+            index.clear();
+            value.clear();
+            user_type = TFModelUserType::Default;
+        }
+    };
+
 } // namespace TDPredict
@@ -0,0 +1,56 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <utility>
+#include "glog/logging.h"
+#include "Common/Tokenizer.h"
+#include "FMModel/FMQuantEval.h"
+
+// FM 隐向量量化离线评估工具, 对本地样本输出 FP32 与量化模型的分数差与 AUC 变化
+// 样本文件格式见 FMQuantEval.h
+//
+// Usage: FMQuantEval factor model_file trans_file sample_file [fp16|int8]
+//   不指定精度时依次评估 fp16 与 int8
+int main(int argc, char **argv)
+{
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_logtostderr = true;
+
+    int factor = 0;
+    if ((argc != 5 && argc != 6) || !Common::ParseNumber(argv[1], factor) || factor <= 0)
+    {
+        fprintf(stderr, "Usage: %s factor model_file trans_file sample_file [fp16|int8]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<std::pair<const char *, TDPredict::FMPrecision>> vecPrecision = {
+        {"fp16", TDPredict::FMPrecision::FP16},
+        {"int8", TDPredict::FMPrecision::INT8},
+    };
+    if (argc == 6)
+    {
+        auto iter = vecPrecision.begin();
+        while (iter != vecPrecision.end() && strcmp(iter->first, argv[5]) != 0)
+        {
+            ++iter;
+        }
+        if (iter == vecPrecision.end())
+        {
+            fprintf(stderr, "unknown precision: %s, expect fp16 or int8\n", argv[5]);
+            return 1;
+        }
+        vecPrecision = {*iter};
+    }
+
+    for (const auto &precision : vecPrecision)
+    {
+        TDPredict::FMQuantReport report;
+        if (!TDPredict::FMQuantEval::Evaluate(factor, argv[2], argv[3], argv[4], precision.second, report))
+        {
+            return 1;
+        }
+        printf("%s: %s\n", precision.first, TDPredict::FMQuantEval::ToString(report).c_str());
+    }
+    return 0;
+}
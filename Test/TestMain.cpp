@@ -0,0 +1,10 @@
+#include "gtest/gtest.h"
+
+// 测试集头文件由 CMakeLists.txt 按测试程序指定
+#include TEST_SUITE_HEADER
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
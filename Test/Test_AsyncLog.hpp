@@ -0,0 +1,3 @@
+#pragma once
+
+#include "Test_AsyncLog/Test_AsyncLog.hpp"
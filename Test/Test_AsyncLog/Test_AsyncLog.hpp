@@ -0,0 +1,221 @@
+#pragma once
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+#include "gtest/gtest.h"
+#include "AsyncLog/AsyncLog.h"
+
+// 日志输出到临时目录, 关闭 stderr 输出
+static const std::string &InitTestLogging()
+{
+    static const std::string log_dir = []()
+    {
+        std::string dir = std::filesystem::temp_directory_path().string() + "/test_async_log/";
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+        google::InitGoogleLogging("test_async_log");
+        FLAGS_stderrthreshold = google::FATAL;
+        google::SetLogDestination(google::INFO, (dir + "INFO.").c_str());
+        google::SetLogDestination(google::WARNING, (dir + "WARNING.").c_str());
+        google::SetLogDestination(google::ERROR, (dir + "ERROR.").c_str());
+        return dir;
+    }();
+    return log_dir;
+}
+
+// 统计日志目录下 prefix 级别文件中包含 tag 的行数
+static long CountLogLines(const std::string &tag, const std::string &prefix = "INFO.")
+{
+    long count = 0;
+    for (const auto &entry : std::filesystem::directory_iterator(InitTestLogging()))
+    {
+        const std::string name = entry.path().filename().string();
+        if (name.rfind(prefix, 0) != 0 || entry.is_symlink())
+        {
+            continue;
+        }
+        std::ifstream ifs(entry.path());
+        std::string line;
+        while (std::getline(ifs, line))
+        {
+            count += line.find(tag) != std::string::npos ? 1 : 0;
+        }
+    }
+    return count;
+}
+
+// 等待后台线程写入, 超时返回实际行数
+static long WaitLogLines(const std::string &tag, const std::string &prefix, const long expect, const int timeout_ms = 5000)
+{
+    long count = CountLogLines(tag, prefix);
+    for (int waited = 0; count < expect && waited < timeout_ms; waited += 10)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        count = CountLogLines(tag, prefix);
+    }
+    return count;
+}
+
+TEST(AsyncLogTest, AllLinesWritten)
+{
+    InitTestLogging();
+    ASSERT_TRUE(AsyncLog::GetInstance()->Init(1 << 20, 10, 0));
+
+    constexpr int THREADS = 4;
+    constexpr int LINES = 2000;
+    std::vector<std::thread> vecThread;
+    for (int idx = 0; idx < THREADS; idx++)
+    {
+        vecThread.emplace_back([idx]()
+                               {
+            for (int i = 0; i < LINES; i++)
+            {
+                LOG(INFO) << "AllLinesWritten thread = " << idx << ", line = " << i;
+            } });
+    }
+    for (auto &thread : vecThread)
+    {
+        thread.join();
+    }
+    AsyncLog::GetInstance()->ShutDown();
+
+    EXPECT_EQ(0, AsyncLog::GetInstance()->GetDroppedCount());
+    EXPECT_EQ(THREADS * LINES, CountLogLines("AllLinesWritten"));
+}
+
+TEST(AsyncLogTest, BufferFullDrop)
+{
+    InitTestLogging();
+    // 缓冲区 4KB, 写入间隔 1s, 超出部分丢弃
+    ASSERT_TRUE(AsyncLog::GetInstance()->Init(4096, 1000, 0));
+    const int64_t dropped = AsyncLog::GetInstance()->GetDroppedCount();
+    for (int i = 0; i < 1000; i++)
+    {
+        LOG(INFO) << "BufferFullDrop line = " << i;
+    }
+    EXPECT_GT(AsyncLog::GetInstance()->GetDroppedCount(), dropped);
+    AsyncLog::GetInstance()->ShutDown();
+    EXPECT_EQ(1000, CountLogLines("BufferFullDrop") + AsyncLog::GetInstance()->GetDroppedCount() - dropped);
+}
+
+// 级别 > FLAGS_logbuflevel 的日志唤醒后台线程写入之前所有缓冲数据, 显式 Flush 同步写入
+TEST(AsyncLogTest, ForceFlush)
+{
+    InitTestLogging();
+    const int logbuflevel = FLAGS_logbuflevel;
+    FLAGS_logbuflevel = google::WARNING;
+    // 写入间隔 100s, 期间只有强制落盘会写文件
+    ASSERT_TRUE(AsyncLog::GetInstance()->Init(1 << 20, 100000, 0));
+
+    LOG(INFO) << "ForceFlush info";
+    LOG(WARNING) << "ForceFlush warning";
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(0, CountLogLines("ForceFlush", "INFO."));
+    EXPECT_EQ(0, CountLogLines("ForceFlush", "WARNING."));
+
+    LOG(ERROR) << "ForceFlush error";
+    EXPECT_EQ(1, WaitLogLines("ForceFlush", "ERROR.", 1));
+    EXPECT_EQ(1, CountLogLines("ForceFlush", "INFO."));
+    EXPECT_EQ(1, CountLogLines("ForceFlush", "WARNING."));
+
+    LOG(INFO) << "ForceFlush sync";
+    AsyncLog::GetInstance()->Flush();
+    EXPECT_EQ(1, CountLogLines("ForceFlush sync", "INFO."));
+
+    AsyncLog::GetInstance()->ShutDown();
+    FLAGS_logbuflevel = logbuflevel;
+}
+
+TEST(AsyncLogTest, LogLimit)
+{
+    LogLimiter limiter(10);
+    int pass = 0;
+    for (int i = 0; i < 1000; i++)
+    {
+        pass += limiter.pass() ? 1 : 0;
+    }
+    // 可能跨越一个秒边界
+    EXPECT_GE(pass, 10);
+    EXPECT_LE(pass, 20);
+
+    std::ostringstream oss;
+    oss << limiter;
+    EXPECT_EQ("[suppressed " + std::to_string(1000 - pass) + " lines] ", oss.str());
+
+    InitTestLogging();
+    const int64_t suppressed = LogLimiter::TotalSuppressed().sum();
+    for (int i = 0; i < 100; i++)
+    {
+        LOG_LIMIT(INFO, 5) << "LogLimit line = " << i;
+    }
+    EXPECT_GE(LogLimiter::TotalSuppressed().sum() - suppressed, 80);
+}
+
+// 请求线程单条日志耗时, 同步为 glog 默认写文件(ERROR 级别每条 fflush), 异步为 AsyncLog
+static void BenchLogCost(const int thread_num, const int lines, double &avg_ns, double &p99_ns)
+{
+    std::vector<std::vector<long>> vecCost(thread_num);
+    std::vector<std::thread> vecThread;
+    for (int idx = 0; idx < thread_num; idx++)
+    {
+        vecThread.emplace_back([&, idx]()
+                               {
+            auto &costs = vecCost[idx];
+            costs.reserve(lines);
+            for (int i = 0; i < lines; i++)
+            {
+                long begin = Common::mono_ns();
+                LOG(ERROR) << "BenchLogCost() Request Failed, ModelName = fm_rank_v1, Version = 20231019"
+                           << ", status.error_code() = 14, status.error_message() = failed to connect to all addresses"
+                           << ", line = " << i;
+                costs.emplace_back(Common::mono_ns() - begin);
+            } });
+    }
+    for (auto &thread : vecThread)
+    {
+        thread.join();
+    }
+
+    std::vector<long> all;
+    for (auto &costs : vecCost)
+    {
+        all.insert(all.end(), costs.begin(), costs.end());
+    }
+    std::sort(all.begin(), all.end());
+    double sum = 0;
+    for (auto cost : all)
+    {
+        sum += cost;
+    }
+    avg_ns = sum / all.size();
+    p99_ns = all[all.size() * 99 / 100];
+}
+
+// 同步与异步写日志的单条耗时, 异步模式下 ERROR 日志唤醒后台线程写入
+// 单核虚拟机参考结果 (ns/line, 两次运行的范围):
+// threads  sync avg           sync p99            async avg       async p99
+// 1        13561 ~ 23440      20792 ~ 108531      2749 ~ 4041     20217 ~ 34271
+// 4        64247 ~ 86493      141536 ~ 4024789    5459 ~ 9091     15879 ~ 16801
+// 16       203544 ~ 250353    33379 ~ 39644       9162 ~ 11539    3023 ~ 3586
+TEST(AsyncLogTest, DISABLED_Benchmark)
+{
+    InitTestLogging();
+    constexpr int TOTAL = 40000;
+    printf("threads\tsync avg\tsync p99\tasync avg\tasync p99\n");
+    for (int thread_num = 1; thread_num <= 16; thread_num *= 4)
+    {
+        double sync_avg, sync_p99, async_avg, async_p99;
+        BenchLogCost(thread_num, TOTAL / thread_num, sync_avg, sync_p99);
+
+        AsyncLog::GetInstance()->Init(16 << 20, 100, 0);
+        BenchLogCost(thread_num, TOTAL / thread_num, async_avg, async_p99);
+        AsyncLog::GetInstance()->ShutDown();
+
+        printf("%d\t%.0f\t%.0f\t%.0f\t%.0f\n", thread_num, sync_avg, sync_p99, async_avg, async_p99);
+    }
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "Common/AdaptiveLimiter.h"
+
+// 模拟下游服务: 同时只能处理 WORKERS 个请求, 每个请求耗时 SERVICE_MS, 超出部分先进先出排队
+class SyntheticHandler
+{
+public:
+    static constexpr int WORKERS = 4;
+    static constexpr int SERVICE_MS = 2;
+
+    void Handle()
+    {
+        {
+            std::unique_lock<std::mutex> ul(m_mutex);
+            const long ticket = m_ticket++;
+            m_cv.wait(ul, [this, ticket]
+                      { return ticket < m_done + WORKERS; });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(SERVICE_MS));
+        {
+            std::lock_guard<std::mutex> lg(m_mutex);
+            m_done++;
+        }
+        m_cv.notify_all();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    long m_ticket = 0; // 已排队请求数
+    long m_done = 0;   // 已完成请求数
+};
+
+// 64 个客户端持续请求, 每个请求超时 DEADLINE_MS, 返回在超时内完成的请求数(goodput)
+static int RunOverload(AdaptiveLimiter *limiter, const int cost_ms, int *shed = nullptr)
+{
+    constexpr int CLIENTS = 64;
+    constexpr long DEADLINE_MS = 10;
+
+    SyntheticHandler handler;
+    std::atomic<int> good = 0;
+    std::atomic<int> rejected = 0;
+    std::atomic<bool> stop = false;
+    std::vector<std::thread> vecThread;
+    for (int idx = 0; idx < CLIENTS; idx++)
+    {
+        vecThread.emplace_back([&]()
+                               {
+            while (!stop.load())
+            {
+                if (limiter != nullptr && !limiter->try_acquire())
+                {
+                    // 快速失败, 客户端退避后重试
+                    rejected++;
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    continue;
+                }
+
+                auto begin = std::chrono::steady_clock::now();
+                handler.Handle();
+                auto cost = std::chrono::steady_clock::now() - begin;
+                bool succ = cost <= std::chrono::milliseconds(DEADLINE_MS);
+                if (limiter != nullptr)
+                {
+                    limiter->release(std::chrono::duration_cast<std::chrono::nanoseconds>(cost).count(), succ);
+                }
+                if (succ)
+                {
+                    good++;
+                }
+            } });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(cost_ms));
+    stop = true;
+    for (auto &thread : vecThread)
+    {
+        thread.join();
+    }
+
+    if (shed != nullptr)
+    {
+        *shed = rejected.load();
+    }
+    return good.load();
+}
+
+TEST(AdaptiveLimiterTest, Acquire)
+{
+    AdaptiveLimiter limiter(2, 1, 2);
+    EXPECT_TRUE(limiter.try_acquire());
+    EXPECT_TRUE(limiter.try_acquire());
+    EXPECT_FALSE(limiter.try_acquire());
+    EXPECT_EQ(2, limiter.inflight());
+
+    limiter.release(1000);
+    EXPECT_TRUE(limiter.try_acquire());
+    limiter.release(1000);
+    limiter.release(1000);
+    EXPECT_EQ(0, limiter.inflight());
+}
+
+TEST(AdaptiveLimiterTest, DropDecrease)
+{
+    AdaptiveLimiter limiter(100, 1, 100, 1);
+    for (int i = 0; i < 20; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        for (int j = 0; j < 10; j++)
+        {
+            ASSERT_TRUE(limiter.try_acquire());
+            limiter.release(1000000, false);
+        }
+    }
+    EXPECT_LT(limiter.limit(), 100);
+}
+
+// 过载时, 不限制并发的请求全部排队超时; 自适应限制后 goodput 接近下游容量
+TEST(AdaptiveLimiterTest, GoodputUnderOverload)
+{
+    constexpr int COST_MS = 2000;
+    const int capacity = COST_MS / SyntheticHandler::SERVICE_MS * SyntheticHandler::WORKERS;
+
+    int good_unlimited = RunOverload(nullptr, COST_MS);
+
+    AdaptiveLimiter limiter(200, 1, 20, 50);
+    int shed = 0;
+    int good_limited = RunOverload(&limiter, COST_MS, &shed);
+
+    printf("capacity %d, goodput unlimited %d, adaptive %d (limit %d, shed %d)\n",
+           capacity, good_unlimited, good_limited, limiter.limit(), shed);
+    EXPECT_GT(good_limited, good_unlimited);
+    EXPECT_GT(good_limited, capacity / 2);
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "Common/Arena.h"
+
+// RankItem 相关的内存池测试见 Test_TDPredict/Test_RankItemArena.hpp
+TEST(ArenaTest, Scope)
+{
+    EXPECT_EQ(nullptr, Common::CurrentArena());
+    EXPECT_EQ(std::pmr::new_delete_resource(), Common::CurrentResource());
+    {
+        Common::MonotonicArena arena;
+        Common::ArenaScope scope(&arena);
+        EXPECT_EQ(&arena, Common::CurrentArena());
+        EXPECT_EQ(arena.resource(), Common::CurrentResource());
+
+        std::pmr::vector<std::pmr::string> vec(Common::CurrentResource());
+        vec.emplace_back("a string longer than the small string buffer");
+        EXPECT_EQ(arena.resource(), vec.get_allocator().resource());
+        EXPECT_EQ(arena.resource(), vec.back().get_allocator().resource());
+
+        // 嵌套作用域结束后恢复外层内存池
+        {
+            Common::MonotonicArena inner;
+            Common::ArenaScope inner_scope(&inner);
+            EXPECT_EQ(&inner, Common::CurrentArena());
+        }
+        EXPECT_EQ(&arena, Common::CurrentArena());
+    }
+    EXPECT_EQ(nullptr, Common::CurrentArena());
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <chrono>
+#include <thread>
+#include <time.h>
+#include <sys/time.h>
+#include "gtest/gtest.h"
+#include "Common/Clock.h"
+
+TEST(ClockTest, Monotonic)
+{
+    long last = Common::mono_ns();
+    for (int i = 0; i < 100000; i++)
+    {
+        long cur = Common::mono_ns();
+        ASSERT_GE(cur, last);
+        last = cur;
+    }
+}
+
+TEST(ClockTest, MatchClockMonotonic)
+{
+    // 与 CLOCK_MONOTONIC 的偏差不超过 1%
+    long mono_begin = Common::get_mono_ns();
+    long begin = Common::mono_ns();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    long mono_cost = Common::get_mono_ns() - mono_begin;
+    long cost = Common::mono_ns() - begin;
+    EXPECT_NEAR(double(cost), double(mono_cost), mono_cost * 0.01);
+}
+
+TEST(ClockTest, Stopwatch)
+{
+    double cost_ms = 0;
+    {
+        Common::ScopedStopwatch sw([&](double ms)
+                                   { cost_ms = ms; });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        EXPECT_GE(sw.stopwatch().elapsed_ms(), 20);
+    }
+    EXPECT_GE(cost_ms, 20);
+    EXPECT_LT(cost_ms, 100);
+}
+
+// 各时钟源单次调用开销
+//
+// 单核虚拟机参考结果 (invariant tsc):
+// Common::mono_ns          22.7 ns/call
+// CLOCK_MONOTONIC          41.9 ns/call
+// CLOCK_MONOTONIC_COARSE   8.9 ns/call (精度为 jiffy, 不适合统计耗时)
+// gettimeofday             39.1 ns/call
+// system_clock::now        38.1 ns/call
+// steady_clock::now        41.0 ns/call
+template <typename Func>
+static double BenchClock(Func func)
+{
+    constexpr int LOOP = 1 << 22;
+    long sum = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < LOOP; i++)
+    {
+        sum += func();
+    }
+    auto cost = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+    EXPECT_NE(sum, 0);
+    return cost / LOOP;
+}
+
+TEST(ClockTest, DISABLED_Benchmark)
+{
+    printf("tsc: %s, ticks/ns: %.3f\n",
+           Common::TscClock::Instance().tsc() ? "invariant" : "fallback",
+           Common::TscClock::Instance().ticks_per_ns());
+
+    printf("Common::mono_ns          %.1f ns/call\n", BenchClock([]
+                                                                  { return Common::mono_ns(); }));
+    printf("CLOCK_MONOTONIC          %.1f ns/call\n", BenchClock([]
+                                                                  { return Common::get_mono_ns(); }));
+    printf("CLOCK_MONOTONIC_COARSE   %.1f ns/call\n", BenchClock([]
+                                                                  {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return ts.tv_nsec + 1; }));
+    printf("gettimeofday             %.1f ns/call\n", BenchClock([]
+                                                                  { return Common::get_ns_timestamp(); }));
+    printf("system_clock::now        %.1f ns/call\n", BenchClock([]
+                                                                  { return (long)std::chrono::system_clock::now().time_since_epoch().count(); }));
+    printf("steady_clock::now        %.1f ns/call\n", BenchClock([]
+                                                                  { return (long)std::chrono::steady_clock::now().time_since_epoch().count(); }));
+}
@@ -0,0 +1,228 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iostream>
+#include <filesystem>
+#include "gtest/gtest.h"
+#include "Common/Function.h"
+#include "Common/MappedFile.h"
+
+namespace
+{
+    std::string WriteTempFile(const std::string &name, const std::string &data)
+    {
+        std::string path = (std::filesystem::temp_directory_path() / name).string();
+        FILE *pFile = fopen(path.c_str(), "w");
+        fwrite(data.data(), 1, data.size(), pFile);
+        fclose(pFile);
+        return path;
+    }
+
+    std::vector<std::string> GetLines(const std::string &data)
+    {
+        std::vector<std::string> vecLine;
+        std::string line;
+        std::stringstream ss(data);
+        while (getline(ss, line, '\n'))
+        {
+            vecLine.emplace_back(line);
+        }
+        return vecLine;
+    }
+}
+
+// 行遍历与 getline 一致
+TEST(MappedFileTest, LineRange)
+{
+    for (const std::string data : {"", "\n", "a", "a\n", "a\nb", "a\n\nb\n", "\n\na b\n c\n"})
+    {
+        std::vector<std::string> vecLine;
+        for (std::string_view line : Common::LineRange(data))
+        {
+            vecLine.emplace_back(line);
+        }
+        EXPECT_EQ(GetLines(data), vecLine) << "data = " << data;
+    }
+}
+
+// 字段遍历与 SplitString 一致
+TEST(MappedFileTest, FieldRange)
+{
+    for (const std::string data : {"", " ", "a", "a b", " a  b ", "1 0.5 -0.25"})
+    {
+        std::vector<std::string> vecExpect;
+        Common::SplitString(data, ' ', vecExpect);
+        std::vector<std::string> vecField;
+        for (std::string_view field : Common::FieldRange(data, ' '))
+        {
+            vecField.emplace_back(field);
+        }
+        EXPECT_EQ(vecExpect, vecField) << "data = " << data;
+    }
+}
+
+// 按行切分后拼接等于原数据, 且每块以完整行结束
+TEST(MappedFileTest, SplitByLine)
+{
+    std::string data;
+    for (int idx = 0; idx < 1000; idx++)
+    {
+        data.append(std::to_string(idx * 7919)).append(idx % 3 == 0 ? "\n\n" : "\n");
+    }
+    data.append("last");
+
+    for (size_t chunk_num : {1, 2, 3, 7, 64, 5000})
+    {
+        auto vecChunk = Common::SplitByLine(data, chunk_num);
+        EXPECT_LE(vecChunk.size(), chunk_num);
+        std::string joined;
+        for (size_t idx = 0; idx < vecChunk.size(); idx++)
+        {
+            EXPECT_FALSE(vecChunk[idx].empty());
+            if (idx + 1 < vecChunk.size())
+            {
+                EXPECT_EQ('\n', vecChunk[idx].back());
+            }
+            joined.append(vecChunk[idx]);
+        }
+        EXPECT_EQ(data, joined);
+    }
+}
+
+TEST(MappedFileTest, OpenAndParallel)
+{
+    Common::MappedFile file;
+    EXPECT_FALSE(file.Open("/not/exist/file"));
+    EXPECT_FALSE(file.Open(std::filesystem::temp_directory_path().string()));
+
+    std::string empty_path = WriteTempFile("mapped_file_empty.txt", "");
+    EXPECT_TRUE(file.Open(empty_path, true, true));
+    EXPECT_TRUE(file.empty());
+    EXPECT_EQ(file.lines().begin(), file.lines().end());
+
+    std::string data;
+    long expect_sum = 0;
+    for (int idx = 0; idx < 100000; idx++)
+    {
+        data.append(std::to_string(idx)).append(" x\n");
+        expect_sum += idx;
+    }
+    std::string path = WriteTempFile("mapped_file_test.txt", data);
+    ASSERT_TRUE(file.Open(path));
+    EXPECT_EQ(data, file.data());
+
+    // 每个线程写各自的局部结果
+    constexpr int THREADS = 4;
+    std::vector<long> vecSum(THREADS, 0);
+    EXPECT_TRUE(Common::ParallelForEachLine(file.data(), THREADS, [&](size_t chunk_idx, std::string_view line)
+                                            {
+        vecSum[chunk_idx] += std::atol(std::string(*Common::FieldRange(line, ' ').begin()).c_str());
+        return true; }));
+    long sum = 0;
+    for (auto value : vecSum)
+    {
+        sum += value;
+    }
+    EXPECT_EQ(expect_sum, sum);
+
+    // 返回 false 停止
+    EXPECT_FALSE(Common::ParallelForEachLine(file.data(), THREADS, [](size_t, std::string_view line)
+                                             { return line != "500 x"; }));
+
+    // move 后原对象为空
+    Common::MappedFile other(std::move(file));
+    EXPECT_TRUE(file.empty());
+    EXPECT_EQ(data.size(), other.size());
+
+    std::filesystem::remove(empty_path);
+    std::filesystem::remove(path);
+}
+
+// 读取+按行遍历吞吐对比, 文件已在 page cache 中
+//
+// 单核虚拟机参考结果 (256MB FM 模型格式文本, GB/s):
+// FastReadFile              0.89 ~ 0.97  (fread 拷贝到 std::string)
+// FastReadFile+getline      0.43 ~ 0.46  (再拷贝到 stringstream 并逐行拷贝)
+// MappedFile(touch pages)   107 ~ 115    (只建立映射并逐页访问, 无拷贝)
+// MappedFile+LineRange      5.3 ~ 5.8    (逐行 string_view, 主要是 memchr 开销)
+// ParallelForEachLine       5.4 ~ 6.3    (4 块, 单核下与串行相同, 多核下按核数提升)
+TEST(MappedFileTest, DISABLED_Benchmark)
+{
+    // FM 模型格式: index w1 v1..v8 ...
+    std::string line = "4294967297 0.012345";
+    for (int idx = 0; idx < 8 * 3 + 2; idx++)
+    {
+        line.append(" -0.0123456");
+    }
+    line.append("\n");
+    std::string data;
+    data.reserve(256 << 20);
+    while (data.size() + line.size() <= (256 << 20))
+    {
+        data.append(line);
+    }
+    std::string path = WriteTempFile("mapped_file_bench.txt", data);
+    const double gb = data.size() / 1e9;
+    std::string().swap(data);
+
+    auto bench = [&](const char *name, auto func)
+    {
+        func(); // 预热 page cache
+        auto begin = std::chrono::steady_clock::now();
+        size_t result = func();
+        double cost = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        printf("%-24s %6.2f GB/s (%zu)\n", name, gb / cost, result);
+    };
+
+    bench("FastReadFile", [&]()
+          {
+        std::string buffer;
+        Common::FastReadFile(path, buffer, false);
+        return buffer.size(); });
+    bench("FastReadFile+getline", [&]()
+          {
+        std::string buffer;
+        Common::FastReadFile(path, buffer, false);
+        std::stringstream ss(buffer);
+        size_t count = 0;
+        while (getline(ss, line, '\n'))
+        {
+            count++;
+        }
+        return count; });
+    bench("MappedFile(touch pages)", [&]()
+          {
+        Common::MappedFile file;
+        file.Open(path);
+        size_t sum = 0;
+        for (size_t pos = 0; pos < file.size(); pos += 4096)
+        {
+            sum += file.data()[pos];
+        }
+        return sum; });
+    bench("MappedFile+LineRange", [&]()
+          {
+        Common::MappedFile file;
+        file.Open(path);
+        size_t count = 0;
+        for (std::string_view line : file.lines())
+        {
+            count += !line.empty();
+        }
+        return count; });
+    bench("ParallelForEachLine", [&]()
+          {
+        Common::MappedFile file;
+        file.Open(path);
+        std::vector<size_t> vecCount(4, 0);
+        Common::ParallelForEachLine(file.data(), 4, [&](size_t chunk_idx, std::string_view line)
+                                    {
+            vecCount[chunk_idx] += !line.empty();
+            return true; });
+        return vecCount[0] + vecCount[1] + vecCount[2] + vecCount[3]; });
+
+    std::filesystem::remove(path);
+}
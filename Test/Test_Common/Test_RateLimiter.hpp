@@ -0,0 +1,148 @@
+#pragma once
+#include <ctime>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "Common/RateLimiter.h"
+#include "Common/ShardedRateLimiter.h"
+
+TEST(ShardedRateLimiterTest, CacheLimit)
+{
+    // 初始没有令牌, 等待补满后最多取出 cache 个
+    ShardedRateLimiter limiter(1000, 10);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    int succ = 0;
+    for (int i = 0; i < 100; i++)
+    {
+        succ += limiter.try_pass() ? 1 : 0;
+    }
+    EXPECT_GE(succ, 10);
+    EXPECT_LE(succ, 12);
+}
+
+TEST(ShardedRateLimiterTest, ZeroCache)
+{
+    // cache 为 0 时桶大小按 1 处理, 仍按 qps 放行
+    ShardedRateLimiter limiter(1000, 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_TRUE(limiter.try_pass());
+    EXPECT_TRUE(limiter.acquire(50));
+}
+
+TEST(ShardedRateLimiterTest, Qps)
+{
+    constexpr int QPS = 1000;
+    constexpr int COST_MS = 300;
+    ShardedRateLimiter limiter(QPS, 10);
+
+    std::atomic<int> succ = 0;
+    std::atomic<bool> stop = false;
+    std::vector<std::thread> vecThread;
+    for (int idx = 0; idx < 4; idx++)
+    {
+        vecThread.emplace_back([&]()
+                               {
+            while (!stop.load())
+            {
+                if (limiter.acquire(5))
+                {
+                    succ++;
+                }
+            } });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(COST_MS));
+    stop = true;
+    for (auto &thread : vecThread)
+    {
+        thread.join();
+    }
+
+    EXPECT_GE(succ.load(), QPS * COST_MS / 1000 * 8 / 10);
+    EXPECT_LE(succ.load(), QPS * COST_MS / 1000 * 12 / 10 + 10);
+}
+
+TEST(ShardedRateLimiterTest, AcquireTimeout)
+{
+    ShardedRateLimiter limiter(1, 1);
+    auto begin = std::chrono::steady_clock::now();
+    EXPECT_FALSE(limiter.acquire(50));
+    auto cost = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+    EXPECT_GE(cost, 50);
+    EXPECT_LT(cost, 200);
+}
+
+// 性能对比
+// 1. 不限流(qps=1e9)时 try_pass 的单次开销
+// 2. 过载(qps=2000)时 pass 阻塞等待消耗的CPU时间
+//
+// 单核虚拟机参考结果:
+// threads  try_pass ns/op(old)  try_pass ns/op(sharded)  overload cores(old)  overload cores(sharded)
+// 1        62.0                 18.0                     0.49                 0.03
+// 8        88.0                 17.4                     0.72                 0.07
+// 64       114.8                21.6                     0.85                 0.23
+template <typename Limiter>
+static double BenchTryPass(const int thread_num, const int total)
+{
+    Limiter limiter(1000000000, 1000000000);
+    std::vector<std::thread> vecThread;
+    auto begin = std::chrono::steady_clock::now();
+    for (int idx = 0; idx < thread_num; idx++)
+    {
+        vecThread.emplace_back([&]()
+                               {
+            for (int i = 0; i < total / thread_num; i++)
+            {
+                limiter.try_pass();
+            } });
+    }
+    for (auto &thread : vecThread)
+    {
+        thread.join();
+    }
+    auto cost = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+    return cost / total;
+}
+
+template <typename Limiter>
+static double BenchOverloadCpu(const int thread_num, const int total)
+{
+    Limiter limiter(2000, 10);
+    std::vector<std::thread> vecThread;
+    auto cpu_begin = std::clock();
+    auto begin = std::chrono::steady_clock::now();
+    for (int idx = 0; idx < thread_num; idx++)
+    {
+        vecThread.emplace_back([&]()
+                               {
+            for (int i = 0; i < total / thread_num; i++)
+            {
+                limiter.pass();
+            } });
+    }
+    for (auto &thread : vecThread)
+    {
+        thread.join();
+    }
+    auto cost = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    auto cpu = double(std::clock() - cpu_begin) / CLOCKS_PER_SEC;
+    return cpu / cost; // 平均占用核数
+}
+
+TEST(ShardedRateLimiterTest, DISABLED_Benchmark)
+{
+    constexpr int TRY_TOTAL = 1 << 21;
+    constexpr int PASS_TOTAL = 256;
+    printf("threads\ttry_pass ns/op(old)\ttry_pass ns/op(sharded)\toverload cores(old)\toverload cores(sharded)\n");
+    for (int thread_num = 1; thread_num <= 64; thread_num *= 2)
+    {
+        printf("%d\t%.1f\t%.1f\t%.2f\t%.2f\n",
+               thread_num,
+               BenchTryPass<RateLimiter>(thread_num, TRY_TOTAL),
+               BenchTryPass<ShardedRateLimiter>(thread_num, TRY_TOTAL),
+               BenchOverloadCpu<RateLimiter>(thread_num, PASS_TOTAL),
+               BenchOverloadCpu<ShardedRateLimiter>(thread_num, PASS_TOTAL));
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "Common/AtomicSequence.h"
+#include "Common/ShardedCounter.h"
+
+TEST(ShardedCounterTest, Sum)
+{
+    constexpr int THREADS = 8;
+    constexpr int TOTAL = 100000;
+    Common::ShardedCounter counter;
+    std::vector<std::thread> vecThread;
+    for (int idx = 0; idx < THREADS; idx++)
+    {
+        vecThread.emplace_back([&]()
+                               {
+            for (int i = 0; i < TOTAL; i++)
+            {
+                counter.add(2);
+                counter.sub(1);
+            } });
+    }
+    for (auto &thread : vecThread)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(THREADS * TOTAL, counter.sum());
+}
+
+TEST(ShardedCounterTest, Exchange)
+{
+    Common::ShardedCounter counter;
+    counter.add(10);
+    counter.add(5);
+    EXPECT_EQ(15, counter.exchange());
+    EXPECT_EQ(0, counter.sum());
+    counter.add(3);
+    EXPECT_EQ(3, counter.exchange());
+}
+
+TEST(ShardedCounterTest, Approx)
+{
+    Common::ShardedCounter counter;
+    counter.add(1);
+    EXPECT_EQ(1, counter.approx());
+
+    // 缓存过期后重新汇总
+    counter.add(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_EQ(2, counter.approx());
+}
+
+// 多线程计数吞吐对比
+//
+// 单核虚拟机参考结果 (Mops/s), 单核没有缓存行争抢, 分片多出的 sched_getcpu 开销占主导;
+// 多核下 std::atomic 随线程数增加而下降, ShardedCounter 基本保持单线程吞吐:
+// threads  std::atomic  AtomicSequence  ShardedCounter
+// 1        99.2         97.8            83.4
+// 8        82.7         73.1            67.5
+// 64       103.6        85.1            73.6
+template <typename Func>
+static double BenchIncrement(const int thread_num, const int total, Func &&func)
+{
+    std::vector<std::thread> vecThread;
+    auto begin = std::chrono::steady_clock::now();
+    for (int idx = 0; idx < thread_num; idx++)
+    {
+        vecThread.emplace_back([&]()
+                               {
+            for (int i = 0; i < total / thread_num; i++)
+            {
+                func();
+            } });
+    }
+    for (auto &thread : vecThread)
+    {
+        thread.join();
+    }
+    auto cost = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+    return total / cost;
+}
+
+TEST(ShardedCounterTest, DISABLED_Benchmark)
+{
+    constexpr int TOTAL = 1 << 22;
+    printf("threads\tstd::atomic\tAtomicSequence\tShardedCounter\n");
+    for (int thread_num = 1; thread_num <= 64; thread_num *= 2)
+    {
+        std::atomic<int64_t> atomic_count = 0;
+        AtomicSequence sequence;
+        Common::ShardedCounter sharded;
+        double atomic_mops = BenchIncrement(thread_num, TOTAL, [&]()
+                                            { atomic_count.fetch_add(1, std::memory_order_relaxed); });
+        double sequence_mops = BenchIncrement(thread_num, TOTAL, [&]()
+                                              { sequence.fetch_add(1); });
+        double sharded_mops = BenchIncrement(thread_num, TOTAL, [&]()
+                                             { sharded.add(1); });
+        printf("%d\t%.1f\t%.1f\t%.1f\n", thread_num, atomic_mops, sequence_mops, sharded_mops);
+        EXPECT_EQ(TOTAL / thread_num * thread_num, sharded.sum());
+    }
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+#include <iostream>
+#include "gtest/gtest.h"
+#include "Common/Startup.h"
+
+// 模拟组件: 睡眠 cost_ms 后返回 succ, 并记录完成顺序
+class StartupTest : public ::testing::Test
+{
+protected:
+    Common::Startup::InitFunc Component(const std::string &name, const int cost_ms, const bool succ = true)
+    {
+        return [this, name, cost_ms, succ]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(cost_ms));
+            std::lock_guard<std::mutex> lg(m_mutex);
+            m_vecFinish.emplace_back(name);
+            return succ;
+        };
+    }
+
+    int FinishPos(const std::string &name)
+    {
+        for (size_t idx = 0; idx < m_vecFinish.size(); idx++)
+        {
+            if (m_vecFinish[idx] == name)
+            {
+                return idx;
+            }
+        }
+        return -1;
+    }
+
+    std::mutex m_mutex;
+    std::vector<std::string> m_vecFinish;
+};
+
+// 无依赖的组件并行初始化, 总耗时接近最长依赖链而不是耗时之和
+TEST_F(StartupTest, Parallel)
+{
+    Common::Startup startup;
+    EXPECT_TRUE(startup.Add("ModelConfig", Component("ModelConfig", 50)));
+    EXPECT_TRUE(startup.Add("SENetConfig", Component("SENetConfig", 50)));
+    EXPECT_TRUE(startup.Add("HTTPClient", Component("HTTPClient", 50)));
+    EXPECT_TRUE(startup.Add("GrpcClient", Component("GrpcClient", 50)));
+    EXPECT_TRUE(startup.Add("Cache", Component("Cache", 50), {"ModelConfig"}));
+    EXPECT_TRUE(startup.Add("Register", Component("Register", 10), {"Cache", "HTTPClient", "GrpcClient"}));
+    EXPECT_FALSE(startup.Add("Cache", Component("Cache", 50))); // 重复
+
+    auto begin = std::chrono::steady_clock::now();
+    EXPECT_TRUE(startup.Run(4));
+    auto cost = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+    std::cout << startup.Report() << std::endl;
+
+    // 串行 260ms, 关键路径 ModelConfig -> Cache -> Register 110ms
+    EXPECT_LT(cost, 200);
+    EXPECT_TRUE(startup.IsReady());
+    EXPECT_TRUE(startup.WaitReady(1));
+    EXPECT_LT(FinishPos("ModelConfig"), FinishPos("Cache"));
+    EXPECT_EQ(5, FinishPos("Register"));
+    EXPECT_NE(std::string::npos, startup.Report().find("ModelConfig -> Cache -> Register"));
+
+    // Run 只能调用一次
+    EXPECT_FALSE(startup.Run(4));
+}
+
+// 依赖失败时跳过, 非必需组件失败不影响就绪
+TEST_F(StartupTest, Failure)
+{
+    Common::Startup startup;
+    startup.Add("Kafka", Component("Kafka", 10, false), {}, false);
+    startup.Add("KafkaReport", Component("KafkaReport", 10), {"Kafka"}, false);
+    startup.Add("Config", Component("Config", 10));
+    EXPECT_TRUE(startup.Run(2));
+    EXPECT_TRUE(startup.IsReady());
+
+    auto vecTiming = startup.GetTiming();
+    ASSERT_EQ(3u, vecTiming.size());
+    EXPECT_EQ(Common::Startup::Status::Failed, vecTiming[0].status);
+    EXPECT_EQ(Common::Startup::Status::Skipped, vecTiming[1].status);
+    EXPECT_EQ(Common::Startup::Status::Succ, vecTiming[2].status);
+    EXPECT_EQ(-1, FinishPos("KafkaReport"));
+
+    // 必需组件失败(包括抛异常)
+    Common::Startup startup2;
+    startup2.Add("Config", []() -> bool
+                 { throw std::runtime_error("parse failed"); });
+    startup2.Add("Cache", Component("Cache", 10), {"Config"});
+    EXPECT_FALSE(startup2.Run(2));
+    EXPECT_FALSE(startup2.IsReady());
+    EXPECT_EQ(Common::Startup::Status::Skipped, startup2.GetTiming()[1].status);
+}
+
+// 依赖不存在或存在环时不执行任何初始化
+TEST_F(StartupTest, InvalidGraph)
+{
+    Common::Startup startup;
+    startup.Add("A", Component("A", 1), {"B"});
+    startup.Add("B", Component("B", 1), {"C"});
+    startup.Add("C", Component("C", 1), {"A"});
+    startup.Add("D", Component("D", 1));
+    EXPECT_FALSE(startup.Run(2));
+    EXPECT_FALSE(startup.GetError().empty());
+    EXPECT_TRUE(m_vecFinish.empty());
+
+    Common::Startup startup2;
+    startup2.Add("A", Component("A", 1), {"Unknown"});
+    EXPECT_FALSE(startup2.Run(2));
+    EXPECT_NE(std::string::npos, startup2.GetError().find("Unknown"));
+    EXPECT_TRUE(m_vecFinish.empty());
+}
+
+// 就绪门: 其他线程等待启动完成
+TEST_F(StartupTest, ReadyGate)
+{
+    Common::Startup startup;
+    startup.Add("Config", Component("Config", 50));
+
+    std::thread waiter([&]()
+                       { EXPECT_TRUE(startup.WaitReady()); });
+    EXPECT_FALSE(startup.IsReady());
+    EXPECT_FALSE(startup.WaitReady(10)); // 超时
+    EXPECT_TRUE(startup.Run(1));
+    waiter.join();
+    EXPECT_TRUE(startup.IsReady());
+}
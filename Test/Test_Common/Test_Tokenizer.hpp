@@ -0,0 +1,192 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <random>
+#include "gtest/gtest.h"
+#include "Common/Function.h"
+#include "Common/Tokenizer.h"
+#include "Common/MappedFile.h"
+
+TEST(TokenizerTest, FindChar)
+{
+    std::string data(100, 'a');
+    for (size_t pos = 0; pos < data.size(); pos++)
+    {
+        data[pos] = ' ';
+        for (size_t begin = 0; begin < data.size(); begin += 7)
+        {
+            const void *expect = memchr(data.data() + begin, ' ', data.size() - begin);
+            const char *found = Common::FindChar(data.data() + begin, data.data() + data.size(), ' ');
+            EXPECT_EQ(expect == nullptr ? data.data() + data.size() : expect, found);
+        }
+        data[pos] = 'a';
+    }
+    EXPECT_EQ(std::string_view::npos, Common::FindChar(data, ' '));
+    EXPECT_EQ(std::string_view::npos, Common::FindChar("a b", ' ', 3));
+    EXPECT_EQ(1u, Common::FindChar("a b", ' ', 1));
+}
+
+// 切分结果与 SplitString 一致
+TEST(TokenizerTest, SplitView)
+{
+    std::vector<std::string_view> vecView;
+    for (const std::string data : {"", " ", "a", "a b", " a  b ", "1 0.5 -0.25", "0123456789abcdefghij 0123456789abcdefghij"})
+    {
+        std::vector<std::string> vecExpect;
+        Common::SplitString(data, ' ', vecExpect);
+        EXPECT_EQ(vecExpect.size(), Common::SplitView(data, ' ', vecView));
+        EXPECT_EQ(vecExpect, std::vector<std::string>(vecView.begin(), vecView.end())) << "data = " << data;
+    }
+
+    Common::Tokenizer tokenizer("a,b,c", ',');
+    std::string_view token;
+    EXPECT_TRUE(tokenizer.next(token));
+    EXPECT_EQ("a", token);
+    EXPECT_EQ("b,c", tokenizer.rest());
+
+    EXPECT_EQ("a", Common::StripCR("a\r"));
+    EXPECT_EQ("", Common::StripCR(""));
+}
+
+TEST(TokenizerTest, ParseNumber)
+{
+    int i = 0;
+    EXPECT_TRUE(Common::ParseNumber("123", i));
+    EXPECT_EQ(123, i);
+    EXPECT_TRUE(Common::ParseNumber("+7", i));
+    EXPECT_EQ(7, i);
+    EXPECT_TRUE(Common::ParseNumber("-7", i));
+    EXPECT_EQ(-7, i);
+    EXPECT_FALSE(Common::ParseNumber("", i));
+    EXPECT_FALSE(Common::ParseNumber("+", i));
+    EXPECT_FALSE(Common::ParseNumber("+-1", i));
+    EXPECT_FALSE(Common::ParseNumber("12a", i));
+    EXPECT_FALSE(Common::ParseNumber(" 12", i));
+    EXPECT_FALSE(Common::ParseNumber("1.5", i));
+    EXPECT_FALSE(Common::ParseNumber("99999999999", i)); // 溢出
+    EXPECT_EQ(-7, i);                                     // 失败不修改
+
+    long l = 0;
+    EXPECT_TRUE(Common::ParseNumber("4294967297", l));
+    EXPECT_EQ(4294967297L, l);
+
+    float f = 0;
+    EXPECT_TRUE(Common::ParseNumber("0.125", f));
+    EXPECT_FLOAT_EQ(0.125f, f);
+    EXPECT_TRUE(Common::ParseNumber("-1.5e-3", f));
+    EXPECT_FLOAT_EQ(-1.5e-3f, f);
+    EXPECT_TRUE(Common::ParseNumber("+2", f));
+    EXPECT_FLOAT_EQ(2.0f, f);
+    EXPECT_TRUE(Common::ParseNumber("1e-50", f)); // 与 atof 一致, 下溢为 0
+    EXPECT_FLOAT_EQ((float)atof("1e-50"), f);
+    EXPECT_FALSE(Common::ParseNumber("0.5x", f));
+    EXPECT_FALSE(Common::ParseNumber("abc", f));
+
+    double d = 0;
+    EXPECT_TRUE(Common::ParseNumber("0.1", d));
+    EXPECT_DOUBLE_EQ(atof("0.1"), d);
+
+    EXPECT_EQ(5, Common::ToNumber<int>("5"));
+    EXPECT_EQ(-1, Common::ToNumber<int>("x", -1));
+}
+
+// FM 模型行解析吞吐对比
+//
+// 单核虚拟机参考结果 (20万行, factor = 8, 每行 28 个字段):
+// SplitString + atof/atol        44 ~ 55 MB/s     0.16 ~ 0.20 Mlines/s
+// SplitView + ParseNumber       169 ~ 209 MB/s    0.63 ~ 0.78 Mlines/s
+// 只查找分隔符 memchr           1082 ~ 1242 MB/s
+// 只查找分隔符 FindChar(SSE2)   1309 ~ 1520 MB/s  (字段短, 省掉函数调用与对齐处理)
+TEST(TokenizerTest, DISABLED_Benchmark)
+{
+    constexpr int LINES = 200000;
+    constexpr int FACTOR = 8;
+    const size_t fields = 3 * FACTOR + 4;
+
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<float> dist(-1, 1);
+    std::string data;
+    char buffer[32];
+    for (int idx = 0; idx < LINES; idx++)
+    {
+        data.append(std::to_string(4294967296L + idx));
+        for (size_t field = 1; field < fields; field++)
+        {
+            snprintf(buffer, sizeof(buffer), " %.6f", dist(gen));
+            data.append(buffer);
+        }
+        data.append("\n");
+    }
+    const double mb = data.size() / 1e6;
+
+    auto bench = [&](const char *name, auto func)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        double result = func();
+        double cost = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        printf("%-32s %8.1f MB/s %8.2f Mlines/s (%.3f)\n", name, mb / cost, LINES / cost / 1e6, result);
+        return result;
+    };
+
+    double expect = bench("SplitString + atof/atol", [&]()
+                          {
+        double sum = 0;
+        std::vector<std::string> strVec;
+        for (std::string_view line : Common::LineRange(data))
+        {
+            Common::SplitString(std::string(line), ' ', strVec);
+            sum += std::atol(strVec[0].c_str()) & 0xFF;
+            for (size_t i = 1; i < strVec.size(); i++)
+            {
+                sum += (float)std::atof(strVec[i].c_str());
+            }
+        }
+        return sum; });
+
+    double result = bench("SplitView + ParseNumber", [&]()
+                          {
+        double sum = 0;
+        std::vector<std::string_view> strVec;
+        for (std::string_view line : Common::LineRange(data))
+        {
+            Common::SplitView(line, ' ', strVec);
+            long index = 0;
+            Common::ParseNumber(strVec[0], index);
+            sum += index & 0xFF;
+            for (size_t i = 1; i < strVec.size(); i++)
+            {
+                float value = 0;
+                Common::ParseNumber(strVec[i], value);
+                sum += value;
+            }
+        }
+        return sum; });
+    EXPECT_DOUBLE_EQ(expect, result);
+
+    bench("memchr split", [&]()
+          {
+        size_t count = 0;
+        const char *cur = data.data();
+        const char *end = data.data() + data.size();
+        while (cur < end)
+        {
+            const void *pos = memchr(cur, ' ', end - cur);
+            cur = pos == nullptr ? end : static_cast<const char *>(pos) + 1;
+            count++;
+        }
+        return (double)count; });
+    bench("FindChar split", [&]()
+          {
+        size_t count = 0;
+        const char *cur = data.data();
+        const char *end = data.data() + data.size();
+        while (cur < end)
+        {
+            cur = Common::FindChar(cur, end, ' ') + 1;
+            count++;
+        }
+        return (double)count; });
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 // include 顺序, 即测试顺序
+// 性能基准测试命名为 DISABLED_*, 默认不运行, 需要时加 --gtest_also_run_disabled_tests
 // #include "Test_Common/Test_Common_Pool_Long.hpp"
 // #include "Test_Common/Test_Common_Pool_String.hpp"
 // #include "Test_Common/Test_Common_Pool_Struct.hpp"
@@ -13,4 +14,18 @@
 
 #include "Test_Common/Test_Cache_LRU.hpp"
 #include "Test_Common/Test_Cache_LFU.hpp"
-#include "Test_Common/Test_Cache_ARC.hpp"
\ No newline at end of file
+#include "Test_Common/Test_Cache_ARC.hpp"
+
+#include "Test_Common/Test_Lock.hpp"
+
+#include "Test_Common/Test_RateLimiter.hpp"
+#include "Test_Common/Test_AdaptiveLimiter.hpp"
+#include "Test_Common/Test_Clock.hpp"
+#include "Test_Common/Test_Arena.hpp"
+#include "Test_Common/Test_ShardedCounter.hpp"
+#include "Test_Common/Test_Startup.hpp"
+#include "Test_Common/Test_MappedFile.hpp"
+#include "Test_Common/Test_Tokenizer.hpp"
+
+// 需要额外链接的测试集各自独立成测试程序, 见 CMakeLists.txt:
+// Test_AsyncLog.hpp, Test_TDPredict.hpp, Test_Coroutine.hpp
@@ -0,0 +1,5 @@
+#pragma once
+
+// 需要 -std=c++20
+#include "Test_Coroutine/Test_CoGrpc.hpp"
+#include "Test_Coroutine/Test_CoHttp.hpp"
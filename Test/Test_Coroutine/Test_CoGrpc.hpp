@@ -0,0 +1,165 @@
+#pragma once
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <vector>
+#include "gtest/gtest.h"
+#include "Common/Coroutine.h"
+#include "ClientManager/GrpcCoroutine.h"
+
+// 协程 vs 阻塞线程 吞吐对比, 需要 -std=c++20
+// 本地起一个 UnifiedService 桩服务, 每个请求固定延迟 STUB_LATENCY_MS,
+// 模拟下游 TFServing/远程服务的 IO 等待.
+// - 阻塞模式: BLOCK_THREADS 个线程, 每个线程同步 CallService
+// - 协程模式: 1 个 CoScheduler 线程 + 1 个 CQ 轮询线程, 同时挂起 CO_INFLIGHT 个请求
+
+#define STUB_ADDR "127.0.0.1:50777"
+#define STUB_LATENCY_MS 5
+#define BENCH_REQUESTS 2000
+#define BLOCK_THREADS 8
+#define CO_INFLIGHT 64
+
+class CoStubService final : public GrpcProtos::UnifiedService::Service
+{
+public:
+    grpc::Status CallService(
+        grpc::ServerContext *,
+        const GrpcProtos::UnifiedRequest *request,
+        GrpcProtos::UnifiedResponse *response) override
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(STUB_LATENCY_MS));
+        response->set_result(GrpcProtos::ResultType::OK);
+        response->set_response(request->request());
+        return grpc::Status::OK;
+    }
+};
+
+class CoGrpcTest : public testing::Test
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        grpc::ServerBuilder builder;
+        builder.AddListeningPort(STUB_ADDR, grpc::InsecureServerCredentials());
+        builder.RegisterService(&service);
+        builder.SetSyncServerOption(grpc::ServerBuilder::SyncServerOption::MIN_POLLERS, 4);
+        builder.SetSyncServerOption(grpc::ServerBuilder::SyncServerOption::MAX_POLLERS, CO_INFLIGHT * 2);
+        server = builder.BuildAndStart();
+    }
+
+    static void TearDownTestSuite()
+    {
+        server->Shutdown();
+        server = nullptr;
+    }
+
+    static GrpcSender *NewSender()
+    {
+        auto sender = new GrpcSender();
+        sender->Init(STUB_ADDR, grpc::CreateChannel(STUB_ADDR, grpc::InsecureChannelCredentials()));
+        return sender;
+    }
+
+    inline static CoStubService service;
+    inline static std::unique_ptr<grpc::Server> server = nullptr;
+};
+
+TEST_F(CoGrpcTest, CallService)
+{
+    std::unique_ptr<GrpcSender> sender(NewSender());
+    GrpcCoLoop loop;
+    ASSERT_TRUE(loop.Init());
+
+    auto reply = Common::SyncWait(CoCallService(loop, sender.get(), 1, "hello", 1000));
+    EXPECT_TRUE(reply.succ);
+    EXPECT_EQ(GrpcProtos::ResultType::OK, reply.result);
+    EXPECT_EQ("hello", reply.response);
+    EXPECT_EQ(STUB_ADDR, reply.addr);
+
+    // 超时错误码与同步接口一致
+    reply = Common::SyncWait(CoCallService(loop, sender.get(), 1, "hello", 1));
+    EXPECT_FALSE(reply.succ);
+    EXPECT_EQ(GrpcProtos::ResultType::ERR_Service_Timeout, reply.result);
+
+    reply = Common::SyncWait(CoCallService(loop, nullptr, 1, "hello", 1000));
+    EXPECT_EQ(GrpcProtos::ResultType::ERR_NO_Server, reply.result);
+}
+
+TEST_F(CoGrpcTest, DISABLED_Throughput)
+{
+    std::unique_ptr<GrpcSender> sender(NewSender());
+
+    // 阻塞线程
+    double block_qps = 0;
+    {
+        std::atomic<int> next = 0;
+        std::atomic<int> succ = 0;
+        auto begin = std::chrono::steady_clock::now();
+        std::vector<std::thread> vecThread;
+        for (int idx = 0; idx < BLOCK_THREADS; idx++)
+        {
+            vecThread.emplace_back([&]()
+                                   {
+                int result;
+                std::string response;
+                while (next.fetch_add(1) < BENCH_REQUESTS)
+                {
+                    if (sender->CallService(1, "bench", 1000, result, response))
+                    {
+                        succ++;
+                    }
+                } });
+        }
+        for (auto &thread : vecThread)
+        {
+            thread.join();
+        }
+        auto cost = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        EXPECT_EQ(BENCH_REQUESTS, succ.load());
+        block_qps = BENCH_REQUESTS / cost;
+    }
+
+    // 协程
+    double co_qps = 0;
+    {
+        GrpcCoLoop loop;
+        Common::CoScheduler scheduler;
+        ASSERT_TRUE(loop.Init());
+        ASSERT_TRUE(scheduler.Init());
+
+        int next = 0; // 仅在调度线程上访问
+        std::atomic<int> succ = 0;
+        std::atomic<int> done = 0;
+        auto worker = [&]() -> Common::Task<void>
+        {
+            while (next++ < BENCH_REQUESTS)
+            {
+                auto reply = co_await CoCallService(loop, sender.get(), 1, "bench", 1000);
+                if (reply.succ)
+                {
+                    succ++;
+                }
+            }
+            done++;
+        };
+
+        auto begin = std::chrono::steady_clock::now();
+        for (int idx = 0; idx < CO_INFLIGHT; idx++)
+        {
+            scheduler.Spawn(worker());
+        }
+        while (done.load() < CO_INFLIGHT)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        auto cost = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        EXPECT_EQ(BENCH_REQUESTS, succ.load());
+        co_qps = BENCH_REQUESTS / cost;
+
+        scheduler.ShutDown();
+        loop.ShutDown();
+    }
+
+    printf("latency %dms, requests %d: block(%d threads) %.0f qps, coroutine(1 thread, %d inflight) %.0f qps\n",
+           STUB_LATENCY_MS, BENCH_REQUESTS, BLOCK_THREADS, block_qps, CO_INFLIGHT, co_qps);
+}
@@ -0,0 +1,251 @@
+#pragma once
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <strings.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "gtest/gtest.h"
+#include "Common/Coroutine.h"
+#include "HTTPClient/HTTPCoroutine.h"
+
+// HTTP 协程 vs 阻塞线程 吞吐对比, 需要 -std=c++20
+// 本地起一个 HTTP/1.1 桩服务, 原样返回 POST 内容, 每个请求固定延迟 CO_HTTP_LATENCY_MS,
+// 模拟下游 TFServing REST 接口的 IO 等待.
+// - 阻塞模式: CO_HTTP_BLOCK_THREADS 个线程, 每个线程同步 post_request
+// - 协程模式: 1 个 CoScheduler 线程, HTTPClient 工作线程驱动 curl-multi, 同时挂起 CO_HTTP_INFLIGHT 个请求
+namespace
+{
+    constexpr int CO_HTTP_PORT = 50778;
+    constexpr int CO_HTTP_LATENCY_MS = 5;
+    constexpr int CO_HTTP_REQUESTS = 2000;
+    constexpr int CO_HTTP_BLOCK_THREADS = 8;
+    constexpr int CO_HTTP_INFLIGHT = 64;
+
+    // 每个连接一个线程, 支持 keep-alive
+    class HttpStubServer
+    {
+    public:
+        bool Start(const int port, const int latency_ms)
+        {
+            m_latencyMs = latency_ms;
+            m_listenFd = socket(AF_INET, SOCK_STREAM, 0);
+            int opt = 1;
+            setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+            if (bind(m_listenFd, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(m_listenFd, 1024) != 0)
+            {
+                close(m_listenFd);
+                return false;
+            }
+            m_acceptThread = std::thread(&HttpStubServer::AcceptFunc, this);
+            return true;
+        }
+
+        void Stop()
+        {
+            m_stop = true;
+            shutdown(m_listenFd, SHUT_RDWR);
+            m_acceptThread.join();
+            close(m_listenFd);
+
+            std::lock_guard<std::mutex> lg(m_mutex);
+            for (int fd : m_vecFd)
+            {
+                shutdown(fd, SHUT_RDWR);
+            }
+            for (auto &thread : m_vecConn)
+            {
+                thread.join();
+            }
+        }
+
+    private:
+        void AcceptFunc()
+        {
+            while (!m_stop)
+            {
+                int fd = accept(m_listenFd, nullptr, nullptr);
+                if (fd < 0)
+                {
+                    continue;
+                }
+                std::lock_guard<std::mutex> lg(m_mutex);
+                m_vecFd.push_back(fd);
+                m_vecConn.emplace_back(&HttpStubServer::ConnFunc, this, fd);
+            }
+        }
+
+        void ConnFunc(const int fd)
+        {
+            std::string buffer;
+            char data[4096];
+            for (;;)
+            {
+                // 请求头结束后按 Content-Length 读取请求体
+                size_t header_end = buffer.find("\r\n\r\n");
+                size_t body_len = 0;
+                if (header_end != std::string::npos)
+                {
+                    for (size_t pos = buffer.find("\r\n"); pos < header_end; pos = buffer.find("\r\n", pos + 2))
+                    {
+                        if (strncasecmp(buffer.c_str() + pos + 2, "Content-Length:", 15) == 0)
+                        {
+                            body_len = std::stoul(buffer.substr(pos + 17));
+                        }
+                    }
+                    if (buffer.size() >= header_end + 4 + body_len)
+                    {
+                        std::string body = buffer.substr(header_end + 4, body_len);
+                        buffer.erase(0, header_end + 4 + body_len);
+                        std::this_thread::sleep_for(std::chrono::milliseconds(m_latencyMs));
+                        std::string response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: " +
+                                               std::to_string(body.size()) + "\r\n\r\n" + body;
+                        if (send(fd, response.data(), response.size(), MSG_NOSIGNAL) != (ssize_t)response.size())
+                        {
+                            break;
+                        }
+                        continue;
+                    }
+                }
+
+                ssize_t len = recv(fd, data, sizeof(data), 0);
+                if (len <= 0)
+                {
+                    break;
+                }
+                buffer.append(data, len);
+            }
+            close(fd);
+        }
+
+    private:
+        int m_latencyMs = 0;
+        int m_listenFd = -1;
+        std::atomic<bool> m_stop = false;
+        std::thread m_acceptThread;
+        std::mutex m_mutex;
+        std::vector<int> m_vecFd;
+        std::vector<std::thread> m_vecConn;
+    };
+}
+
+class CoHttpTest : public testing::Test
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        ASSERT_TRUE(server.Start(CO_HTTP_PORT, CO_HTTP_LATENCY_MS));
+        HTTPClient::GetInstance()->Init();
+    }
+
+    static void TearDownTestSuite()
+    {
+        HTTPClient::GetInstance()->ShutDown();
+        server.Stop();
+    }
+
+    inline static HttpStubServer server;
+    inline static const std::string url = "http://127.0.0.1:" + std::to_string(CO_HTTP_PORT) + "/v1/models/bench:predict";
+};
+
+TEST_F(CoHttpTest, PostRequest)
+{
+    const std::string post_msg = "{\"instances\": [1, 2, 3]}";
+    auto reply = Common::SyncWait([&]() -> Common::Task<HttpCoReply>
+                                  { co_return co_await CoPostRequest(url, {}, post_msg, 1000); }());
+    EXPECT_EQ(CURLE_OK, reply.code);
+    EXPECT_EQ(post_msg, reply.result);
+
+    // 超时错误码与 promise 接口一致
+    reply = Common::SyncWait([&]() -> Common::Task<HttpCoReply>
+                             { co_return co_await CoPostRequest(url, {}, post_msg, 1); }());
+    EXPECT_EQ(CURLE_OPERATION_TIMEDOUT, reply.code);
+}
+
+// 单核虚拟机参考结果 (latency 5ms, 2000 个请求, 四次运行的范围):
+// block(8 threads)                1310 ~ 1350 qps, 接近 8 / 5ms = 1600 的上限
+// coroutine(1 thread, 64 inflight) 6690 ~ 8320 qps, 受限于同机桩服务的连接线程
+TEST_F(CoHttpTest, DISABLED_Throughput)
+{
+    const std::string post_msg = "{\"instances\": [1, 2, 3]}";
+
+    // 阻塞线程
+    double block_qps = 0;
+    {
+        std::atomic<int> next = 0;
+        std::atomic<int> succ = 0;
+        auto begin = std::chrono::steady_clock::now();
+        std::vector<std::thread> vecThread;
+        for (int idx = 0; idx < CO_HTTP_BLOCK_THREADS; idx++)
+        {
+            vecThread.emplace_back([&]()
+                                   {
+                std::string result;
+                while (next.fetch_add(1) < CO_HTTP_REQUESTS)
+                {
+                    result.clear();
+                    if (HTTPClient::post_request(url, {}, post_msg, 1000, result) && result == post_msg)
+                    {
+                        succ++;
+                    }
+                } });
+        }
+        for (auto &thread : vecThread)
+        {
+            thread.join();
+        }
+        auto cost = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        EXPECT_EQ(CO_HTTP_REQUESTS, succ.load());
+        block_qps = CO_HTTP_REQUESTS / cost;
+    }
+
+    // 协程
+    double co_qps = 0;
+    {
+        Common::CoScheduler scheduler;
+        ASSERT_TRUE(scheduler.Init());
+
+        int next = 0; // 仅在调度线程上访问
+        std::atomic<int> succ = 0;
+        std::atomic<int> done = 0;
+        auto worker = [&]() -> Common::Task<void>
+        {
+            while (next++ < CO_HTTP_REQUESTS)
+            {
+                auto reply = co_await CoPostRequest(url, {}, post_msg, 1000);
+                if (reply.code == CURLE_OK && reply.result == post_msg)
+                {
+                    succ++;
+                }
+            }
+            done++;
+        };
+
+        auto begin = std::chrono::steady_clock::now();
+        for (int idx = 0; idx < CO_HTTP_INFLIGHT; idx++)
+        {
+            scheduler.Spawn(worker());
+        }
+        while (done.load() < CO_HTTP_INFLIGHT)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        auto cost = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        EXPECT_EQ(CO_HTTP_REQUESTS, succ.load());
+        co_qps = CO_HTTP_REQUESTS / cost;
+
+        scheduler.ShutDown();
+    }
+
+    printf("latency %dms, requests %d: block(%d threads) %.0f qps, coroutine(1 thread, %d inflight) %.0f qps\n",
+           CO_HTTP_LATENCY_MS, CO_HTTP_REQUESTS, CO_HTTP_BLOCK_THREADS, block_qps, CO_HTTP_INFLIGHT, co_qps);
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+// include 顺序, 即测试顺序
+#include "Test_TDPredict/Test_FMEmbeddingTable.hpp"
+#include "Test_TDPredict/Test_FMKernel.hpp"
+#include "Test_TDPredict/Test_FMBinaryModel.hpp"
+#include "Test_TDPredict/Test_FMQuantEval.hpp"
+#include "Test_TDPredict/Test_FMModelBatch.hpp"
+#include "Test_TDPredict/Test_FMModelSwap.hpp"
+#include "Test_TDPredict/Test_DNNModel.hpp"
+#include "Test_TDPredict/Test_DNNModelTFS.hpp"
+#include "Test_TDPredict/Test_TFModelGrpc.hpp"
+#include "Test_TDPredict/Test_RankItemArena.hpp"
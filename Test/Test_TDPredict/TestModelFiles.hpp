@@ -0,0 +1,135 @@
+#pragma once
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <memory>
+#include <filesystem>
+#include "TDPredict/Interface/ModelInterface.h"
+
+// TDPredict 各测试共用的随机模型文件、转换文件与特征生成
+namespace TestModelFiles
+{
+    using TDPredict::score_type;
+
+    // 临时目录下的文件路径
+    inline std::string TempPath(const std::string &name)
+    {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    // 模型文件第一列: [32位field][32位value]
+    inline long FMKey(const long field, const long value)
+    {
+        return (field << 32) | value;
+    }
+
+    // 生成文本格式 FM 模型文件: 首行 w0, 之后每个 key 一行, 参数依次由 weight() 生成
+    // bad_row >= 0 时该行第一个隐向量参数写为 nan (不消耗 weight())
+    template <typename Weight>
+    void WriteFMModel(
+        const std::string &file_path,
+        const int factor,
+        const double w0,
+        const std::vector<long> &vecKey,
+        Weight &&weight,
+        const long bad_row = -1)
+    {
+        FILE *pFile = fopen(file_path.c_str(), "w");
+        fprintf(pFile, "w0 %g 0 0\n", w0);
+        for (size_t row = 0; row < vecKey.size(); row++)
+        {
+            fprintf(pFile, "%ld", vecKey[row]);
+            for (int col = 1; col < 3 * factor + 4; col++)
+            {
+                if ((long)row == bad_row && col == 2)
+                {
+                    fprintf(pFile, " nan");
+                }
+                else
+                {
+                    fprintf(pFile, " %.6f", weight());
+                }
+            }
+            fprintf(pFile, "\n");
+        }
+        fclose(pFile);
+    }
+
+    // 均匀分布 [-0.1, 0.1) 参数的 FM 模型文件
+    inline void WriteUniformFMModel(
+        const std::string &file_path,
+        const int factor,
+        const double w0,
+        const std::vector<long> &vecKey,
+        const int seed = 1,
+        const long bad_row = -1)
+    {
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<float> dist(-0.1, 0.1);
+        WriteFMModel(file_path, factor, w0, vecKey, [&]()
+                     { return dist(gen); }, bad_row);
+    }
+
+    // 生成 FM 转换文件: 首行总特征个数(各特征域个数之和), 之后每个特征域取 count 个特征
+    inline void WriteFMTrans(const std::string &file_path, const int all_field_count, const std::vector<int> &vecField, const int count = 1)
+    {
+        FILE *pFile = fopen(file_path.c_str(), "w");
+        fprintf(pFile, "%d\n", all_field_count);
+        for (int field : vecField)
+        {
+            fprintf(pFile, "%d %d\n", field, count);
+        }
+        fclose(pFile);
+    }
+
+    // DNN 测试特征: 特征域 1 ~ 12, 1 ~ 6 作为公共特征, 7 ~ 12 作为排序特征, 3 的倍数的域占 2 维
+    constexpr int DNN_FIELDS = 12;
+
+    inline int DNNInputSize()
+    {
+        int size = 0;
+        for (int field = 1; field <= DNN_FIELDS; field++)
+        {
+            size += (field % 3 == 0) ? 2 : 1;
+        }
+        return size;
+    }
+
+    // 生成 DNN/TF 转换文件, 每个域 values 个取值, 依次映射到行号 1 ~ DNN_FIELDS * values
+    inline void WriteDNNTrans(const std::string &file_path, const int values, const int all_field_count = DNNInputSize())
+    {
+        FILE *pFile = fopen(file_path.c_str(), "w");
+        fprintf(pFile, "%d\n", all_field_count);
+        for (int field = 1; field <= DNN_FIELDS; field++)
+        {
+            fprintf(pFile, "%d %d\n", field, (field % 3 == 0) ? 2 : 1);
+        }
+        int index = 1;
+        for (int field = 1; field <= DNN_FIELDS; field++)
+        {
+            for (int value = 0; value < values; value++)
+            {
+                fprintf(pFile, "%d %d %d\n", field, value, index++);
+            }
+        }
+        fclose(pFile);
+    }
+
+    // 随机 DNN 特征, 取值 values 不在转换文件中, 用于构造缺失特征
+    inline std::shared_ptr<TDPredict::FeatureData> CreateDNNFeature(std::mt19937 &gen, const int values, const bool common)
+    {
+        auto spFeatureData = std::make_shared<TDPredict::FeatureData>();
+        std::uniform_real_distribution<score_type> dist(0.5, 1.5);
+        for (int field = common ? 1 : 7; field <= (common ? 6 : DNN_FIELDS); field++)
+        {
+            auto &feature = common ? spFeatureData->common_feature : spFeatureData->rank_feature;
+            const int count = gen() % 4;
+            for (int idx = 0; idx < count; idx++)
+            {
+                feature[field].emplace_back(field, gen() % (values + 1), dist(gen));
+            }
+        }
+        return spFeatureData;
+    }
+}
@@ -0,0 +1,331 @@
+#pragma once
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include "gtest/gtest.h"
+#include "TDPredict/DNNModel/DNNModel.h"
+#include "TDPredict/TFModel/TFSCommon.hpp"
+#include "Test_TDPredict/TestModelFiles.hpp"
+
+using TDPredict::score_type;
+using TDPredict::DNNType;
+
+namespace
+{
+    using TestModelFiles::CreateDNNFeature;
+    using TestModelFiles::DNN_FIELDS;
+    using TestModelFiles::DNNInputSize;
+    using TestModelFiles::WriteDNNTrans;
+
+    // 随机生成模型, 行号 0 留给缺失特征
+    TDPredict::DNNModelData CreateDNNModel(
+        const DNNType type,
+        const int emb_size,
+        const int vocab,
+        const std::vector<int> &vecHidden,
+        const int seed = 1)
+    {
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<score_type> dist(-1, 1);
+        TDPredict::DNNModelData model_data;
+        model_data.m_type = type;
+        model_data.m_fields = DNNInputSize();
+        model_data.m_embSize = emb_size;
+        model_data.m_output = TDPredict::DNNActivation::Sigmoid;
+        model_data.m_embedding = TDPredict::DNNMatrix::NullaryExpr(vocab, emb_size, [&]()
+                                                                   { return dist(gen) * 0.3f; });
+        if (type == DNNType::DeepFM)
+        {
+            model_data.m_bias = 0.1f;
+            model_data.m_linear = TDPredict::DNNVector::NullaryExpr(vocab, [&]()
+                                                                    { return dist(gen) * 0.1f; });
+        }
+
+        int in = model_data.m_fields * emb_size;
+        std::vector<int> vecOut = vecHidden;
+        vecOut.emplace_back(1);
+        for (size_t idx = 0; idx < vecOut.size(); idx++)
+        {
+            const score_type scale = 1.0f / std::sqrt((score_type)in);
+            TDPredict::DNNDenseLayer layer;
+            layer.kernel = TDPredict::DNNMatrix::NullaryExpr(in, vecOut[idx], [&]()
+                                                             { return dist(gen) * scale; });
+            layer.bias = TDPredict::DNNVector::NullaryExpr(vecOut[idx], [&]()
+                                                           { return dist(gen) * 0.1f; });
+            layer.activation = (idx + 1 == vecOut.size()) ? TDPredict::DNNActivation::None
+                                                           : TDPredict::DNNActivation(1 + idx % 3);
+            model_data.m_vecDense.emplace_back(std::move(layer));
+            in = vecOut[idx];
+        }
+        return model_data;
+    }
+
+    // 按定义逐项计算的参考实现, double 精度
+    double DNNReferenceScore(const TDPredict::DNNModelData &model_data, const int *index, const score_type *value)
+    {
+        const int fields = model_data.m_fields;
+        const int emb_size = model_data.m_embSize;
+        std::vector<double> input(fields * emb_size, 0);
+        double first = model_data.m_bias;
+        std::vector<double> sum(emb_size, 0), sqr(emb_size, 0);
+        for (int field = 0; field < fields; field++)
+        {
+            if (index[field] < 0 || index[field] >= model_data.vocab())
+            {
+                continue;
+            }
+            for (int k = 0; k < emb_size; k++)
+            {
+                const double emb = (double)model_data.m_embedding(index[field], k) * value[field];
+                input[field * emb_size + k] = emb;
+                sum[k] += emb;
+                sqr[k] += emb * emb;
+            }
+            if (model_data.m_type == DNNType::DeepFM)
+            {
+                first += (double)model_data.m_linear[index[field]] * value[field];
+            }
+        }
+
+        for (const auto &layer : model_data.m_vecDense)
+        {
+            std::vector<double> output(layer.kernel.cols(), 0);
+            for (int col = 0; col < layer.kernel.cols(); col++)
+            {
+                double h = layer.bias[col];
+                for (int row = 0; row < layer.kernel.rows(); row++)
+                {
+                    h += input[row] * layer.kernel(row, col);
+                }
+                switch (layer.activation)
+                {
+                case TDPredict::DNNActivation::ReLU:
+                    h = std::max(h, 0.0);
+                    break;
+                case TDPredict::DNNActivation::Sigmoid:
+                    h = 1.0 / (1.0 + std::exp(-h));
+                    break;
+                case TDPredict::DNNActivation::Tanh:
+                    h = std::tanh(h);
+                    break;
+                default:
+                    break;
+                }
+                output[col] = h;
+            }
+            input.swap(output);
+        }
+
+        double logit = input[0];
+        if (model_data.m_type == DNNType::DeepFM)
+        {
+            logit += first;
+            for (int k = 0; k < emb_size; k++)
+            {
+                logit += 0.5 * (sum[k] * sum[k] - sqr[k]);
+            }
+        }
+        return 1.0 / (1.0 + std::exp(-logit));
+    }
+
+    void ExpectSameModel(const TDPredict::DNNModelData &expect, const TDPredict::DNNModelData &actual)
+    {
+        EXPECT_EQ(expect.m_type, actual.m_type);
+        EXPECT_EQ(expect.m_fields, actual.m_fields);
+        EXPECT_EQ(expect.m_embSize, actual.m_embSize);
+        EXPECT_EQ(expect.m_output, actual.m_output);
+        EXPECT_EQ(expect.m_bias, actual.m_bias);
+        EXPECT_TRUE(expect.m_embedding == actual.m_embedding);
+        EXPECT_TRUE(expect.m_linear == actual.m_linear);
+        ASSERT_EQ(expect.m_vecDense.size(), actual.m_vecDense.size());
+        for (size_t idx = 0; idx < expect.m_vecDense.size(); idx++)
+        {
+            EXPECT_TRUE(expect.m_vecDense[idx].kernel == actual.m_vecDense[idx].kernel);
+            EXPECT_TRUE(expect.m_vecDense[idx].bias == actual.m_vecDense[idx].bias);
+            EXPECT_EQ(expect.m_vecDense[idx].activation, actual.m_vecDense[idx].activation);
+        }
+    }
+}
+
+// 保存后重新加载参数逐位一致, 文件损坏时加载失败
+TEST(DNNModelTest, SaveLoad)
+{
+    const std::string model_path = TestModelFiles::TempPath("dnn_model_save");
+    for (DNNType type : {DNNType::MLP, DNNType::DeepFM})
+    {
+        auto model_data = CreateDNNModel(type, 4, 50, {16, 8});
+        ASSERT_TRUE(model_data.SaveModelFile(model_path));
+        TDPredict::DNNModelData load_data;
+        ASSERT_TRUE(load_data.LoadModelFile(model_path));
+        ExpectSameModel(model_data, load_data);
+    }
+
+    std::string data;
+    {
+        std::ifstream in(model_path);
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    auto load = [&](const std::string &content)
+    {
+        TDPredict::DNNModelData model_data;
+        return model_data.LoadModelBuffer(content);
+    };
+    auto replace = [&](const std::string &from, const std::string &to)
+    {
+        std::string content = data;
+        content.replace(content.find(from), from.size(), to);
+        return content;
+    };
+
+    EXPECT_TRUE(load(data));
+    EXPECT_FALSE(load(data.substr(0, data.size() - 4)));                  // 没有结束标记
+    EXPECT_FALSE(load(data.substr(0, data.size() / 2) + "\nend\n"));      // 中间被截断
+    EXPECT_FALSE(load(replace("dnn 1", "dnn 2")));                        // 版本不支持
+    EXPECT_FALSE(load(replace("type deepfm", "type wide")));              // 结构不支持
+    EXPECT_FALSE(load(replace("dense 16 8 sigmoid", "dense 16 8 gelu"))); // 激活函数不支持
+    EXPECT_FALSE(load(replace("dense 8 1 none", "dense 8 2 none")));      // 最后一层输出不为 1
+    EXPECT_FALSE(load(replace("bias 0.100000001\nembedding", "embedding")));
+
+    std::filesystem::remove(model_path);
+}
+
+// 前向计算与参考实现一致, 覆盖跨 DNN_BLOCK_ROWS 的批量与越界行号
+TEST(DNNModelTest, Parity)
+{
+    constexpr int VOCAB = 1000;
+    for (DNNType type : {DNNType::MLP, DNNType::DeepFM})
+    {
+        auto model_data = CreateDNNModel(type, 8, VOCAB, {64, 32});
+        const int fields = model_data.m_fields;
+        for (int batch : {1, 7, TDPredict::DNN_BLOCK_ROWS, 700})
+        {
+            std::mt19937 gen(batch);
+            std::uniform_real_distribution<score_type> dist(0, 2);
+            std::vector<int> vecIndex(batch * fields);
+            std::vector<score_type> vecValue(batch * fields);
+            for (size_t idx = 0; idx < vecIndex.size(); idx++)
+            {
+                vecIndex[idx] = (idx % 17 == 0) ? 0 : gen() % VOCAB;
+                vecValue[idx] = (idx % 17 == 0) ? 0 : dist(gen);
+            }
+            vecIndex[0] = -1;
+            vecIndex[fields] = VOCAB;
+
+            std::vector<score_type> vecScore(batch, -1);
+            model_data.Forward(vecIndex.data(), vecValue.data(), batch, vecScore.data());
+            for (int row = 0; row < batch; row++)
+            {
+                const double expect = DNNReferenceScore(model_data, &vecIndex[row * fields], &vecValue[row * fields]);
+                ASSERT_NEAR(expect, vecScore[row], 1e-5)
+                    << "type = " << (int)type << ", batch = " << batch << ", row = " << row;
+            }
+        }
+    }
+}
+
+// DNNModel 按转换文件生成输入, 批量预测与单个预测一致; 转换文件与模型不一致时更新失败, 继续使用原模型
+TEST(DNNModelTest, Predict)
+{
+    constexpr int VALUES = 100;
+    const std::string model_path = TestModelFiles::TempPath("dnn_model_predict");
+    const std::string trans_path = TestModelFiles::TempPath("dnn_trans_predict");
+    const std::string bad_trans_path = TestModelFiles::TempPath("dnn_trans_predict_bad");
+    auto model_data = CreateDNNModel(DNNType::DeepFM, 8, 1 + DNN_FIELDS * VALUES, {32, 16});
+    ASSERT_TRUE(model_data.SaveModelFile(model_path));
+    WriteDNNTrans(trans_path, VALUES);
+    WriteDNNTrans(bad_trans_path, VALUES, DNNInputSize() + 1);
+
+    TDPredict::DNNModel model("dnn");
+    TDPredict::RankItem empty_item;
+    empty_item.spFeatureData = std::make_shared<TDPredict::FeatureData>();
+    EXPECT_FALSE(model.predict(empty_item));
+    ASSERT_TRUE(model.Init(model_path, trans_path));
+
+    TDPredict::TFTransData trans_data;
+    ASSERT_TRUE(trans_data.LoadTransFile(trans_path));
+
+    std::mt19937 gen(1);
+    auto spCommon = CreateDNNFeature(gen, VALUES, true);
+    std::vector<TDPredict::RankItem> vecItem(300);
+    std::vector<double> vecExpect;
+    for (auto &item : vecItem)
+    {
+        item.spFeatureData = CreateDNNFeature(gen, VALUES, false);
+        item.spFeatureData->common_feature = spCommon->common_feature;
+
+        std::vector<int> index(trans_data.all_field_count, 0);
+        std::vector<score_type> value(trans_data.all_field_count, 0);
+        TDPredict::TransTFSFeature(item.spFeatureData->common_feature, trans_data, index.data(), value.data());
+        TDPredict::TransTFSFeature(item.spFeatureData->rank_feature, trans_data, index.data(), value.data());
+        vecExpect.emplace_back(DNNReferenceScore(model_data, index.data(), value.data()));
+    }
+
+    ASSERT_TRUE(model.predict(vecItem));
+    for (size_t idx = 0; idx < vecItem.size(); idx++)
+    {
+        ASSERT_NEAR(vecExpect[idx], vecItem[idx].getModelScore("dnn"), 1e-5) << "idx = " << idx;
+        TDPredict::RankItem item;
+        item.spFeatureData = vecItem[idx].spFeatureData;
+        ASSERT_TRUE(model.predict(item));
+        ASSERT_NEAR(vecExpect[idx], item.getModelScore("dnn"), 1e-5) << "idx = " << idx;
+    }
+
+    EXPECT_FALSE(model.Update(model_path, bad_trans_path));
+    TDPredict::RankItem item;
+    item.spFeatureData = vecItem[0].spFeatureData;
+    ASSERT_TRUE(model.predict(item));
+    EXPECT_NEAR(vecExpect[0], item.getModelScore("dnn"), 1e-5);
+
+    // Stage 只加载校验, Publish 后才能预测
+    EXPECT_EQ(nullptr, model.Stage(model_path, bad_trans_path));
+    TDPredict::DNNModel staged_model("dnn");
+    auto spVersion = staged_model.Stage(model_path, trans_path);
+    ASSERT_NE(nullptr, spVersion);
+    EXPECT_FALSE(staged_model.predict(item));
+    ASSERT_TRUE(staged_model.Publish(spVersion));
+    ASSERT_TRUE(staged_model.predict(item));
+    EXPECT_NEAR(vecExpect[0], item.getModelScore("dnn"), 1e-5);
+
+    std::filesystem::remove(model_path);
+    std::filesystem::remove(trans_path);
+    std::filesystem::remove(bad_trans_path);
+}
+
+// 进程内前向计算耗时
+TEST(DNNModelTest, DISABLED_Benchmark)
+{
+    constexpr int VOCAB = 100000;
+    constexpr int TIMES = 50;
+    printf("%-8s %8s %12s %14s\n", "type", "batch", "us/batch", "ns/item");
+    for (DNNType type : {DNNType::MLP, DNNType::DeepFM})
+    {
+        auto model_data = CreateDNNModel(type, 16, VOCAB, {256, 128, 64});
+        const int fields = model_data.m_fields;
+        for (int batch : {50, 200, 1000})
+        {
+            std::mt19937 gen(batch);
+            std::vector<int> vecIndex(batch * fields);
+            std::vector<score_type> vecValue(batch * fields, 1.0f);
+            for (auto &index : vecIndex)
+            {
+                index = gen() % VOCAB;
+            }
+            std::vector<score_type> vecScore(batch);
+            model_data.Forward(vecIndex.data(), vecValue.data(), batch, vecScore.data());
+
+            auto begin = std::chrono::steady_clock::now();
+            for (int times = 0; times < TIMES; times++)
+            {
+                model_data.Forward(vecIndex.data(), vecValue.data(), batch, vecScore.data());
+            }
+            double cost = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+            printf("%-8s %8d %12.1f %14.1f\n", type == DNNType::MLP ? "mlp" : "deepfm", batch,
+                   cost / TIMES + vecScore[0] * 0, cost * 1000 / TIMES / batch);
+        }
+    }
+}
@@ -0,0 +1,218 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include <cmath>
+#include <malloc.h>
+#include <unordered_map>
+#include "gtest/gtest.h"
+#include "TDPredict/FMModel/FMEmbeddingTable.h"
+
+using TDPredict::score_type;
+
+TEST(FMEmbeddingTableTest, AddFind)
+{
+    constexpr int FACTOR = 8;
+    TDPredict::FMEmbeddingTable table;
+    table.Reset(FACTOR, 10); // 预计行数偏小, 测试扩容
+    EXPECT_EQ(16u, table.stride());
+    EXPECT_EQ(nullptr, table.Find(1));
+
+    std::mt19937_64 gen(1);
+    std::unordered_map<long, std::vector<score_type>> mapExpect;
+    std::vector<score_type> w2(FACTOR);
+    for (int idx = 0; idx < 10000; idx++)
+    {
+        const long key = (long)(gen() % 5000) | (1L << 32); // 有重复, 后写入的覆盖
+        for (auto &value : w2)
+        {
+            value = (score_type)(gen() % 1000) / 1000;
+        }
+        table.Add(key, (score_type)idx, w2.data());
+        auto &expect = mapExpect[key];
+        expect = w2;
+        expect.emplace_back((score_type)idx);
+    }
+
+    EXPECT_EQ(mapExpect.size(), table.size());
+    for (const auto &pr : mapExpect)
+    {
+        const score_type *row = table.Find(pr.first);
+        ASSERT_NE(nullptr, row);
+        EXPECT_EQ(0u, (uintptr_t)row % 64); // 每行缓存行对齐
+        EXPECT_EQ(pr.second.back(), table.W1(row));
+        EXPECT_EQ(std::vector<score_type>(pr.second.begin(), pr.second.end() - 1), std::vector<score_type>(row, row + FACTOR));
+    }
+    EXPECT_EQ(nullptr, table.Find(12345));
+
+    // Keys 与行号对应
+    auto vecKey = table.Keys();
+    for (size_t row = 0; row < vecKey.size(); row++)
+    {
+        EXPECT_EQ(table.Row(row), table.Find(vecKey[row]));
+    }
+
+    table.Reset(16);
+    EXPECT_EQ(32u, table.stride());
+    EXPECT_TRUE(table.empty());
+}
+
+// 量化存储: 行大小与反量化误差
+TEST(FMEmbeddingTableTest, Quantized)
+{
+    using TDPredict::FMPrecision;
+    EXPECT_EQ(80u, TDPredict::FMEmbeddingTable::Stride(64, FMPrecision::FP32));
+    EXPECT_EQ(48u, TDPredict::FMEmbeddingTable::Stride(64, FMPrecision::FP16));
+    EXPECT_EQ(32u, TDPredict::FMEmbeddingTable::Stride(64, FMPrecision::INT8));
+    EXPECT_EQ(16u, TDPredict::FMEmbeddingTable::Stride(8, FMPrecision::INT8));
+
+    constexpr int FACTOR = 24;
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<score_type> dist(-1, 1);
+    std::vector<score_type> w2(FACTOR), decode(FACTOR);
+    for (FMPrecision precision : {FMPrecision::FP32, FMPrecision::FP16, FMPrecision::INT8})
+    {
+        TDPredict::FMEmbeddingTable table;
+        table.Reset(FACTOR, 100, precision);
+        EXPECT_EQ(precision, table.precision());
+        for (long key = 0; key < 100; key++)
+        {
+            score_type max_abs = 0;
+            for (auto &value : w2)
+            {
+                value = dist(gen) * (key + 1);
+                max_abs = std::max(max_abs, std::fabs(value));
+            }
+            table.Add(key, (score_type)key, w2.data());
+
+            const score_type *row = table.Find(key);
+            ASSERT_TRUE(row != nullptr);
+            EXPECT_EQ((score_type)key, table.W1(row)); // w1 不量化
+            table.Decode(row, decode.data());
+            for (int f_idx = 0; f_idx < FACTOR; f_idx++)
+            {
+                const score_type error = std::fabs(decode[f_idx] - w2[f_idx]);
+                if (precision == FMPrecision::FP32)
+                {
+                    EXPECT_EQ(w2[f_idx], decode[f_idx]);
+                }
+                else if (precision == FMPrecision::FP16)
+                {
+                    EXPECT_LE(error, std::max(std::fabs(w2[f_idx]) / 2048, 3e-8f));
+                }
+                else
+                {
+                    EXPECT_LE(error, max_abs / 127 / 2 * 1.001f);
+                }
+            }
+        }
+    }
+
+    // 全 0 行
+    TDPredict::FMEmbeddingTable table;
+    table.Reset(FACTOR, 1, FMPrecision::INT8);
+    std::vector<score_type> zero(FACTOR, 0);
+    table.Add(1, 0.5f, zero.data());
+    table.Decode(table.Find(1), decode.data());
+    EXPECT_EQ(zero, decode);
+}
+
+// predict_feature 查找+累加耗时与内存对比
+//
+// 单核虚拟机参考结果 (100万特征, factor = 8, 每次预测 200 个特征, 90% 命中):
+// layout           memory      predict
+// unordered_map    128.0 MB    96 ~ 98 us
+// FMEmbeddingTable  97.6 MB    40 ~ 49 us  (其中索引 2M 槽 * 16B = 33.5MB, 负载因子 0.5)
+TEST(FMEmbeddingTableTest, DISABLED_Benchmark)
+{
+    constexpr int FACTOR = 8;
+    constexpr int FEATURES = 1000000;
+    constexpr int PREDICT_FEATURES = 200;
+    constexpr int PREDICT_TIMES = 20000;
+
+    std::mt19937_64 gen(1);
+    std::vector<long> vecKey;
+    for (int idx = 0; idx < FEATURES; idx++)
+    {
+        vecKey.emplace_back(((long)(gen() % 500 + 1) << 32) | (long)(gen() % 100000000));
+    }
+    std::vector<long> vecQuery;
+    for (int idx = 0; idx < PREDICT_FEATURES * 1000; idx++)
+    {
+        vecQuery.emplace_back(gen() % 10 == 0 ? (long)gen() : vecKey[gen() % FEATURES]);
+    }
+    std::vector<score_type> w2(FACTOR, 0.01f);
+
+    auto bench = [&](const char *name, size_t memory, auto find)
+    {
+        std::vector<score_type> vec_sum(FACTOR), vec_sum_sqr(FACTOR);
+        score_type score = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for (int times = 0; times < PREDICT_TIMES; times++)
+        {
+            const long *query = &vecQuery[(times % 1000) * PREDICT_FEATURES];
+            for (int idx = 0; idx < PREDICT_FEATURES; idx++)
+            {
+                find(query[idx], score, vec_sum.data(), vec_sum_sqr.data());
+            }
+        }
+        double cost = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+        printf("%-18s %8.1f MB %8.2f us/predict (%.1f)\n", name, memory / 1e6, cost / PREDICT_TIMES, score + vec_sum[0]);
+    };
+
+    {
+        size_t before = mallinfo2().uordblks;
+        std::unordered_map<long, score_type> m_w1;
+        std::unordered_map<long, std::vector<score_type>> m_w2;
+        for (auto key : vecKey)
+        {
+            m_w1[key] = 0.01f;
+            m_w2[key] = w2;
+        }
+        size_t memory = mallinfo2().uordblks - before;
+        bench("unordered_map", memory, [&](long key, score_type &score, score_type *vec_sum, score_type *vec_sum_sqr)
+              {
+            const auto iter_w1 = m_w1.find(key);
+            if (iter_w1 != m_w1.end())
+            {
+                score += iter_w1->second;
+            }
+            const auto iter_w2 = m_w2.find(key);
+            if (iter_w2 != m_w2.end())
+            {
+                const auto &vec_w2 = iter_w2->second;
+                for (int f_idx = 0; f_idx < FACTOR; ++f_idx)
+                {
+                    score_type d = vec_w2[f_idx];
+                    vec_sum[f_idx] += d;
+                    vec_sum_sqr[f_idx] += d * d;
+                }
+            } });
+    }
+
+    {
+        size_t before = mallinfo2().uordblks;
+        TDPredict::FMEmbeddingTable table;
+        table.Reset(FACTOR, FEATURES);
+        for (auto key : vecKey)
+        {
+            table.Add(key, 0.01f, w2.data());
+        }
+        size_t memory = mallinfo2().uordblks - before;
+        EXPECT_NEAR(table.MemoryBytes(), memory, 4096); // malloc 头部开销
+        bench("FMEmbeddingTable", memory, [&](long key, score_type &score, score_type *vec_sum, score_type *vec_sum_sqr)
+              {
+            const score_type *row = table.Find(key);
+            if (row != nullptr)
+            {
+                score += table.W1(row);
+                for (int f_idx = 0; f_idx < FACTOR; ++f_idx)
+                {
+                    score_type d = row[f_idx];
+                    vec_sum[f_idx] += d;
+                    vec_sum_sqr[f_idx] += d * d;
+                }
+            } });
+    }
+}
@@ -0,0 +1,219 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <limits>
+#include <cmath>
+#include "gtest/gtest.h"
+#include "TDPredict/FMModel/FMKernel.h"
+#include "TDPredict/FMModel/FMEmbeddingTable.h"
+
+using TDPredict::score_type;
+using TDPredict::FMPrecision;
+using TDPredict::FMKernel::ISA;
+
+namespace
+{
+    // 随机生成 rows 个特征的模型表与查询
+    struct FMKernelData
+    {
+        TDPredict::FMEmbeddingTable table;
+        std::vector<const score_type *> vecRow;
+        std::vector<score_type> vecWeight;
+
+        FMKernelData(const int factor, const int rows, const int features, const FMPrecision precision = FMPrecision::FP32)
+        {
+            std::mt19937 gen(factor);
+            std::uniform_real_distribution<score_type> dist(-1, 1);
+            std::vector<score_type> w2(factor);
+            table.Reset(factor, rows, precision);
+            for (int row = 0; row < rows; row++)
+            {
+                for (auto &value : w2)
+                {
+                    value = dist(gen);
+                }
+                table.Add(row, dist(gen), w2.data());
+            }
+            for (int idx = 0; idx < features; idx++)
+            {
+                vecRow.emplace_back(table.Find(gen() % rows));
+                vecWeight.emplace_back(idx % 3 == 0 ? 1.0f : dist(gen));
+            }
+        }
+    };
+
+    __attribute__((target("f16c"))) uint16_t F16CFloatToHalf(const float value)
+    {
+        return _cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT);
+    }
+
+    __attribute__((target("f16c"))) float F16CHalfToFloat(const uint16_t half)
+    {
+        return _cvtsh_ss(half);
+    }
+}
+
+// 半精度转换与 F16C 指令一致
+TEST(FMKernelTest, HalfConvert)
+{
+    std::mt19937 gen(1);
+    std::vector<float> vecValue = {0.0f, -0.0f, 1.0f, -1.0f, 65504.0f, 65519.0f, 65520.0f, 1e10f, -1e10f,
+                                   6.1035156e-05f, 6.0e-08f, 2.98e-08f, 2.99e-08f, 1e-10f,
+                                   std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity()};
+    for (int idx = 0; idx < 1000000; idx++)
+    {
+        uint32_t bits = gen();
+        float value = 0;
+        memcpy(&value, &bits, sizeof(value));
+        if (!std::isnan(value))
+        {
+            vecValue.emplace_back(value);
+        }
+    }
+    std::uniform_real_distribution<float> dist(-1, 1);
+    for (int idx = 0; idx < 100000; idx++)
+    {
+        vecValue.emplace_back(dist(gen));
+    }
+
+    for (float value : vecValue)
+    {
+        const uint16_t half = TDPredict::FMKernel::FloatToHalf(value);
+        if (TDPredict::FMKernel::DetectISA() >= ISA::AVX2)
+        {
+            ASSERT_EQ(F16CFloatToHalf(value), half) << "value = " << value;
+            ASSERT_EQ(F16CHalfToFloat(half), TDPredict::FMKernel::HalfToFloat(half)) << "half = " << half;
+        }
+        if (std::fabs(value) <= 65504.0f && std::fabs(value) >= 6.1035156e-05f)
+        {
+            ASSERT_NEAR(value, TDPredict::FMKernel::HalfToFloat(half), std::fabs(value) / 2048) << "value = " << value;
+        }
+    }
+    EXPECT_TRUE(std::isnan(TDPredict::FMKernel::HalfToFloat(TDPredict::FMKernel::FloatToHalf(NAN))));
+}
+
+// 各指令集实现与标量实现逐位一致
+TEST(FMKernelTest, BitExact)
+{
+    for (FMPrecision precision : {FMPrecision::FP32, FMPrecision::FP16, FMPrecision::INT8})
+    for (int factor : {4, 8, 16, 24, 32, 64})
+    {
+        FMKernelData data(factor, 1000, 300, precision);
+        std::vector<score_type> expect_sum(factor, 0.5f), expect_sqr(factor, 0.25f);
+        TDPredict::FMKernel::GetAccumulate(factor, ISA::Scalar, precision)(
+            data.vecRow.data(), data.vecWeight.data(), data.vecRow.size(), factor, expect_sum.data(), expect_sqr.data());
+
+        // 标量实现与先反量化再按 FP32 累加一致
+        std::vector<std::vector<score_type>> vecDecode(data.vecRow.size(), std::vector<score_type>(factor));
+        std::vector<const score_type *> vecDecodeRow;
+        for (size_t idx = 0; idx < data.vecRow.size(); idx++)
+        {
+            data.table.Decode(data.vecRow[idx], vecDecode[idx].data());
+            vecDecodeRow.emplace_back(vecDecode[idx].data());
+        }
+        std::vector<score_type> decode_sum(factor, 0.5f), decode_sqr(factor, 0.25f);
+        TDPredict::FMKernel::accumulate_scalar(vecDecodeRow.data(), data.vecWeight.data(), data.vecRow.size(), factor,
+                                               decode_sum.data(), decode_sqr.data());
+        EXPECT_EQ(0, memcmp(expect_sum.data(), decode_sum.data(), factor * sizeof(score_type))) << "factor = " << factor;
+        EXPECT_EQ(0, memcmp(expect_sqr.data(), decode_sqr.data(), factor * sizeof(score_type))) << "factor = " << factor;
+
+        for (ISA isa : {ISA::Scalar, ISA::AVX2, ISA::AVX512})
+        {
+            auto accumulate = TDPredict::FMKernel::GetAccumulate(factor, isa, precision);
+            std::vector<score_type> sum(factor, 0.5f), sqr(factor, 0.25f);
+            // 分批调用与一次调用结果相同
+            for (size_t begin = 0; begin < data.vecRow.size(); begin += 64)
+            {
+                const int count = std::min<size_t>(64, data.vecRow.size() - begin);
+                accumulate(&data.vecRow[begin], &data.vecWeight[begin], count, factor, sum.data(), sqr.data());
+            }
+            EXPECT_EQ(0, memcmp(expect_sum.data(), sum.data(), factor * sizeof(score_type)))
+                << "factor = " << factor << ", isa = " << (int)isa << ", precision = " << (int)precision;
+            EXPECT_EQ(0, memcmp(expect_sqr.data(), sqr.data(), factor * sizeof(score_type)))
+                << "factor = " << factor << ", isa = " << (int)isa << ", precision = " << (int)precision;
+        }
+    }
+}
+
+// 单次预测(200 个命中特征)二阶项累加耗时
+//
+// 单核虚拟机参考结果 (ns/predict, 模型 10 万行, 行数据大多在 L2/L3):
+// factor   scalar    avx2    avx512
+// 8         4400      300      280
+// 16       11700     1000      800
+// 32       24400     3700     1300
+// 64       63000     8900     6400
+// 标量实现每个特征都要读写 sum/sqr 内存, SIMD 实现整批累加在寄存器中;
+// factor = 64 时 AVX2 需要 16 个累加寄存器, 超过寄存器数量后有溢出, AVX-512 只需要 8 个.
+TEST(FMKernelTest, DISABLED_Benchmark)
+{
+    constexpr int FEATURES = 200;
+    constexpr int TIMES = 20000;
+    printf("factor %10s %10s %10s  (ISA = %d)\n", "scalar", "avx2", "avx512", (int)TDPredict::FMKernel::DetectISA());
+    for (int factor : {8, 16, 32, 64})
+    {
+        FMKernelData data(factor, 100000, FEATURES * 64);
+        printf("%-6d", factor);
+        for (ISA isa : {ISA::Scalar, ISA::AVX2, ISA::AVX512})
+        {
+            auto accumulate = TDPredict::FMKernel::GetAccumulate(factor, isa);
+            std::vector<score_type> sum(factor, 0), sqr(factor, 0);
+            auto begin = std::chrono::steady_clock::now();
+            for (int times = 0; times < TIMES; times++)
+            {
+                const size_t offset = (times % 64) * FEATURES;
+                for (int idx = 0; idx < FEATURES; idx += 64)
+                {
+                    accumulate(&data.vecRow[offset + idx], &data.vecWeight[offset + idx], std::min(64, FEATURES - idx),
+                               factor, sum.data(), sqr.data());
+                }
+            }
+            double cost = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+            printf(" %10.1f", cost / TIMES + sum[0] * 0);
+        }
+        printf("\n");
+    }
+}
+
+// 量化存储的单次预测(200 个命中特征)二阶项累加耗时与每行字节数
+// 模型 200 万行, 行数据远大于缓存, 每个特征的读取基本都是内存访问, 使用当前 CPU 支持的最快实现
+//
+// 单核虚拟机参考结果 (ns/predict, 两次运行的范围, 虚拟机内存带宽波动较大):
+// factor   fp32 (行字节)            fp16                     int8
+// 16        6300 ~ 6500 (128B)      5700 ~ 5900 ( 64B)       5000 ~ 6200 ( 64B)
+// 32        8000 ~ 9100 (192B)      8900 ~ 9800 (128B)       6900 ~ 10800 ( 64B)
+// 64       18500 ~ 32700 (320B)    16800 ~ 20500 (192B)     19600 ~ 20000 (128B)
+// 收益主要来自内存占用与带宽: 同样内存可以放下 1.7 ~ 2.5 倍的特征, 反量化的额外计算被访存延迟掩盖.
+TEST(FMKernelTest, DISABLED_QuantizedBenchmark)
+{
+    constexpr int ROWS = 2000000;
+    constexpr int FEATURES = 200;
+    constexpr int TIMES = 5000;
+    printf("factor %16s %16s %16s\n", "fp32", "fp16", "int8");
+    for (int factor : {16, 32, 64})
+    {
+        printf("%-6d", factor);
+        for (FMPrecision precision : {FMPrecision::FP32, FMPrecision::FP16, FMPrecision::INT8})
+        {
+            FMKernelData data(factor, ROWS, FEATURES * TIMES, precision);
+            auto accumulate = TDPredict::FMKernel::GetAccumulate(factor, ISA::AVX512, precision);
+            std::vector<score_type> sum(factor, 0), sqr(factor, 0);
+            auto begin = std::chrono::steady_clock::now();
+            for (int times = 0; times < TIMES; times++)
+            {
+                const size_t offset = times * FEATURES;
+                for (int idx = 0; idx < FEATURES; idx += 64)
+                {
+                    accumulate(&data.vecRow[offset + idx], &data.vecWeight[offset + idx], std::min(64, FEATURES - idx),
+                               factor, sum.data(), sqr.data());
+                }
+            }
+            double cost = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+            printf(" %8.1f (%3zuB)", cost / TIMES + sum[0] * 0, data.table.stride() * sizeof(score_type));
+        }
+        printf("\n");
+    }
+}
@@ -0,0 +1,392 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <filesystem>
+#include "gtest/gtest.h"
+#include "TDPredict/FMModel/FMModel.h"
+#include "Test_TDPredict/TestModelFiles.hpp"
+
+using TDPredict::score_type;
+
+namespace
+{
+    constexpr int FM_SWAP_FACTOR = 8;
+    constexpr int FM_SWAP_FIELDS = 20; // 特征域 1 ~ 20, 1 ~ 10 作为公共特征, 11 ~ 20 作为排序特征
+
+    // 生成 FM 模型文件, 每个特征域 values 个取值, bad_row >= 0 时该行参数为 nan
+    void WriteSwapModel(const std::string &file_path, const int seed, const long values, const long bad_row = -1)
+    {
+        std::vector<long> vecKey;
+        vecKey.reserve(FM_SWAP_FIELDS * values);
+        for (long field = 1; field <= FM_SWAP_FIELDS; field++)
+        {
+            for (long value = 0; value < values; value++)
+            {
+                vecKey.push_back(TestModelFiles::FMKey(field, value));
+            }
+        }
+        TestModelFiles::WriteUniformFMModel(file_path, FM_SWAP_FACTOR, 0.1, vecKey, seed, bad_row);
+    }
+
+    void WriteSwapTrans(const std::string &file_path, const int max_field = FM_SWAP_FIELDS)
+    {
+        std::vector<int> vecField;
+        for (int field = 1; field <= FM_SWAP_FIELDS; field++)
+        {
+            vecField.push_back(field);
+        }
+        if (max_field > FM_SWAP_FIELDS)
+        {
+            vecField.push_back(max_field);
+        }
+        TestModelFiles::WriteFMTrans(file_path, max_field, vecField);
+    }
+
+    std::shared_ptr<TDPredict::FeatureData> CreateSwapFeature(std::mt19937 &gen, const long values)
+    {
+        auto spFeatureData = std::make_shared<TDPredict::FeatureData>();
+        for (int field = 1; field <= FM_SWAP_FIELDS; field++)
+        {
+            auto &feature = field <= 10 ? spFeatureData->common_feature : spFeatureData->rank_feature;
+            feature[field].emplace_back(field, gen() % values, 1.0f);
+        }
+        return spFeatureData;
+    }
+
+    score_type PredictSwap(TDPredict::FMModel &model, const std::shared_ptr<TDPredict::FeatureData> &spFeatureData)
+    {
+        TDPredict::RankItem item;
+        item.spFeatureData = spFeatureData;
+        return model.predict(item) ? item.getModelScore(model.GetName()) : -1;
+    }
+}
+
+// 校验失败的版本不发布, 继续使用原模型; 回滚恢复上一个版本
+TEST(FMModelSwapTest, ValidateAndRollback)
+{
+    const std::string model_a = TestModelFiles::TempPath("fm_swap_a.txt");
+    const std::string model_b = TestModelFiles::TempPath("fm_swap_b.txt");
+    const std::string model_nan = TestModelFiles::TempPath("fm_swap_nan.txt");
+    const std::string trans = TestModelFiles::TempPath("fm_swap_trans.txt");
+    const std::string trans_bad = TestModelFiles::TempPath("fm_swap_trans_bad.txt");
+    const std::string golden = TestModelFiles::TempPath("fm_swap_golden.txt");
+    WriteSwapModel(model_a, 1, 100);
+    WriteSwapModel(model_b, 2, 100);
+    WriteSwapModel(model_nan, 2, 100, 0);
+    WriteSwapTrans(trans);
+    WriteSwapTrans(trans_bad, TDPredict::FIELD_MAX);
+
+    TDPredict::FMModel model("fm_swap");
+    std::mt19937 gen(3);
+    auto spFeatureData = CreateSwapFeature(gen, 100);
+    EXPECT_EQ(-1, PredictSwap(model, spFeatureData)); // 初始化前预测失败
+
+    TDPredict::FMSwapPolicy policy;
+    policy.sanity_rows = 1000000; // 抽查全部行
+    model.SetSwapPolicy(policy);
+    ASSERT_TRUE(model.Init(FM_SWAP_FACTOR, model_a, trans));
+    const score_type score_a = PredictSwap(model, spFeatureData);
+    EXPECT_GT(score_a, 0.0f);
+    EXPECT_EQ(1u, model.GetSwapStats().version);
+
+    // 参数中有 nan / 转换格式特征域越界 / 文件不存在, 都继续使用版本 1
+    EXPECT_FALSE(model.Update(FM_SWAP_FACTOR, model_nan, trans));
+    EXPECT_FALSE(model.Update(FM_SWAP_FACTOR, model_b, trans_bad));
+    EXPECT_FALSE(model.Update(FM_SWAP_FACTOR, model_b + ".none", trans));
+    EXPECT_EQ(score_a, PredictSwap(model, spFeatureData));
+    EXPECT_EQ(3u, model.GetSwapStats().fail_count);
+    EXPECT_EQ(1u, model.GetSwapStats().version);
+
+    // 样例请求期望版本 1 的分数, 版本 B 分数不同, 发布失败
+    {
+        FILE *pFile = fopen(golden.c_str(), "w");
+        fprintf(pFile, "%.9g", score_a);
+        for (int field = 1; field <= FM_SWAP_FIELDS; field++)
+        {
+            const auto &feature = field <= 10 ? spFeatureData->common_feature : spFeatureData->rank_feature;
+            fprintf(pFile, " %ld", feature[field][0].field_value.field_value());
+        }
+        fprintf(pFile, "\n-1 %ld:0.5\n", (1L << 32) | 7);
+        fclose(pFile);
+    }
+    ASSERT_TRUE(model.LoadGoldenFile(golden));
+    policy.golden_tolerance = 1e-6;
+    model.SetSwapPolicy(policy);
+    EXPECT_FALSE(model.Update(FM_SWAP_FACTOR, model_b, trans));
+    EXPECT_EQ(score_a, PredictSwap(model, spFeatureData));
+
+    // 只限制新旧模型分数差时, 版本 B 可以发布
+    model.SetGoldenRequests({{spFeatureData, -1}});
+    policy.max_mean_drift = 0.5;
+    model.SetSwapPolicy(policy);
+    ASSERT_TRUE(model.Update(FM_SWAP_FACTOR, model_b, trans));
+    const score_type score_b = PredictSwap(model, spFeatureData);
+    EXPECT_NE(score_a, score_b);
+    auto stats = model.GetSwapStats();
+    EXPECT_EQ(6u, stats.version); // 失败的更新也占用版本号
+    EXPECT_EQ(2u, stats.succ_count);
+    EXPECT_GT(stats.publish_us, 0.0);
+
+    // 回滚到版本 1, 只保留一个历史版本
+    ASSERT_TRUE(model.Rollback());
+    EXPECT_EQ(score_a, PredictSwap(model, spFeatureData));
+    EXPECT_EQ(1u, model.GetSwapStats().version);
+    EXPECT_FALSE(model.Rollback());
+
+    for (const auto &path : {model_a, model_b, model_nan, trans, trans_bad, golden})
+    {
+        std::filesystem::remove(path);
+    }
+}
+
+// Stage 只加载校验, Publish 后才切换; 样例请求跟随新版本, 校验失败时不影响模型当前的样例请求
+TEST(FMModelSwapTest, StageAndPublish)
+{
+    const std::string model_a = TestModelFiles::TempPath("fm_stage_a.txt");
+    const std::string model_b = TestModelFiles::TempPath("fm_stage_b.txt");
+    const std::string trans = TestModelFiles::TempPath("fm_stage_trans.txt");
+    WriteSwapModel(model_a, 1, 100);
+    WriteSwapModel(model_b, 2, 100);
+    WriteSwapTrans(trans);
+
+    TDPredict::FMModel model("fm_stage");
+    std::mt19937 gen(3);
+    auto spFeatureData = CreateSwapFeature(gen, 100);
+    ASSERT_TRUE(model.Init(FM_SWAP_FACTOR, model_a, trans));
+    const score_type score_a = PredictSwap(model, spFeatureData);
+
+    // 期望分数不可能达到的样例请求, Stage 失败, 模型的样例请求不变, 之后的 Update 不受影响
+    using GoldenList = std::vector<TDPredict::FMGoldenRequest>;
+    auto spBadGolden = std::make_shared<const GoldenList>(GoldenList{{spFeatureData, 2.0f}});
+    EXPECT_EQ(nullptr, model.Stage(FM_SWAP_FACTOR, model_b, trans, TDPredict::FMPrecision::FP32, spBadGolden));
+
+    // Stage 成功不切换, 继续服务版本 1
+    auto spGolden = std::make_shared<const GoldenList>(GoldenList{{spFeatureData, -1}});
+    auto spVersion = model.Stage(FM_SWAP_FACTOR, model_b, trans, TDPredict::FMPrecision::FP32, spGolden);
+    ASSERT_NE(nullptr, spVersion);
+    EXPECT_EQ(score_a, PredictSwap(model, spFeatureData));
+    EXPECT_EQ(1u, model.GetSwapStats().version);
+
+    // 丢弃暂存版本后仍可正常更新
+    ASSERT_TRUE(model.Update(FM_SWAP_FACTOR, model_a, trans));
+    EXPECT_EQ(score_a, PredictSwap(model, spFeatureData));
+
+    ASSERT_TRUE(model.Publish(spVersion));
+    EXPECT_NE(score_a, PredictSwap(model, spFeatureData));
+    EXPECT_EQ(spVersion->version, model.GetSwapStats().version);
+    EXPECT_FALSE(model.Publish(nullptr));
+
+    // 回滚到 Publish 前的版本
+    ASSERT_TRUE(model.Rollback());
+    EXPECT_EQ(score_a, PredictSwap(model, spFeatureData));
+
+    for (const auto &path : {model_a, model_b, trans})
+    {
+        std::filesystem::remove(path);
+    }
+}
+
+// 预测期间反复切换, 每次预测的分数只能来自某一个完整版本; 下线的版本由更新线程回收
+TEST(FMModelSwapTest, Concurrent)
+{
+    const std::string model_a = TestModelFiles::TempPath("fm_swap_ca.txt");
+    const std::string model_b = TestModelFiles::TempPath("fm_swap_cb.txt");
+    const std::string trans = TestModelFiles::TempPath("fm_swap_ctrans.txt");
+    WriteSwapModel(model_a, 1, 2000);
+    WriteSwapModel(model_b, 2, 2000);
+    WriteSwapTrans(trans);
+
+    TDPredict::FMModel model_ref_a("fm_swap"), model_ref_b("fm_swap"), model("fm_swap");
+    ASSERT_TRUE(model_ref_a.Init(FM_SWAP_FACTOR, model_a, trans));
+    ASSERT_TRUE(model_ref_b.Init(FM_SWAP_FACTOR, model_b, trans));
+    ASSERT_TRUE(model.Init(FM_SWAP_FACTOR, model_a, trans));
+
+    std::mt19937 gen(5);
+    std::vector<std::shared_ptr<TDPredict::FeatureData>> vecFeature;
+    std::vector<score_type> vecScoreA, vecScoreB;
+    for (int idx = 0; idx < 64; idx++)
+    {
+        vecFeature.emplace_back(CreateSwapFeature(gen, 2000));
+        vecFeature.back()->common_feature = vecFeature[0]->common_feature; // 批量预测时公共特征相同
+        vecScoreA.emplace_back(PredictSwap(model_ref_a, vecFeature.back()));
+        vecScoreB.emplace_back(PredictSwap(model_ref_b, vecFeature.back()));
+    }
+
+    std::atomic<bool> stop = false;
+    std::atomic<long> predict_count = 0, mismatch = 0;
+    std::vector<std::thread> vecThread;
+    for (int t = 0; t < 3; t++)
+    {
+        vecThread.emplace_back([&]()
+                               {
+            while (!stop)
+            {
+                std::vector<TDPredict::RankItem> vecItem(vecFeature.size());
+                for (size_t idx = 0; idx < vecFeature.size(); idx++)
+                {
+                    vecItem[idx].spFeatureData = vecFeature[idx];
+                }
+                if (!model.predict(vecItem))
+                {
+                    mismatch++;
+                    continue;
+                }
+                // 同一批 item 必须来自同一个版本
+                const bool is_a = vecItem[0].getModelScore("fm_swap") == vecScoreA[0];
+                for (size_t idx = 0; idx < vecItem.size(); idx++)
+                {
+                    const score_type expect = is_a ? vecScoreA[idx] : vecScoreB[idx];
+                    if (vecItem[idx].getModelScore("fm_swap") != expect)
+                    {
+                        mismatch++;
+                    }
+                }
+                predict_count++;
+            } });
+    }
+
+    for (int times = 0; times < 20; times++)
+    {
+        ASSERT_TRUE(model.Update(FM_SWAP_FACTOR, times % 2 == 0 ? model_b : model_a, trans));
+    }
+    stop = true;
+    for (auto &thread : vecThread)
+    {
+        thread.join();
+    }
+    EXPECT_GT(predict_count.load(), 0);
+    EXPECT_EQ(0, mismatch.load());
+
+    // 预测线程都已退出, 下一次更新时下线版本全部回收
+    ASSERT_TRUE(model.Update(FM_SWAP_FACTOR, model_b, trans));
+    EXPECT_EQ(0u, model.GetSwapStats().retired_count);
+
+    for (const auto &path : {model_a, model_b, trans})
+    {
+        std::filesystem::remove(path);
+    }
+}
+
+// 切换耗时与切换前后预测延迟
+// 两个二进制模型交替更新(各 100 万行, factor = 8, 文件已在 page cache 中), 预测线程持续单条预测
+//   update ms: 加载 + 校验 + 预热耗时, 期间新旧版本都在内存中, 预测不受阻塞
+//   publish us: 发布时写锁内的耗时, 即预测线程可能被阻塞的最长时间
+//   steady: 不在更新期间的请求; update: 更新进行中的请求, 单核机器上与更新线程争抢 CPU
+//   post: 发布后 5ms 内的请求
+//
+// 单核虚拟机参考结果 (两次运行的范围, 预测延迟单位 us):
+// warm_pages  update ms   publish us   steady p99    update p99    post p99    post max
+// true        37.0 ~ 37.8  1.7 ~ 3.0   8.9 ~ 15.9    7.6 ~ 18.3    6.4 ~ 7.1   344 ~ 638
+// false       38.2 ~ 38.7  2.1 ~ 2.3   8.2 ~ 17.1    15.7 ~ 18.9   6.5 ~ 7.7   74 ~ 77
+// 发布前后 p99 没有可观测的抖动; post max 两种设置都是单核调度造成的偶发值.
+// 文件在 page cache 中时缺页只是建立映射, 内核每次缺页还会顺带映射相邻页, 预读的收益在这里测不出来;
+// 冷文件(刚下载的模型)首次访问需要读盘, 预读把这部分耗时留在发布前.
+TEST(FMModelSwapTest, DISABLED_Benchmark)
+{
+    constexpr long VALUES = 50000;
+    constexpr int SWAPS = 10;
+    const std::string text = TestModelFiles::TempPath("fm_swap_bench.txt");
+    const std::string binary[2] = {TestModelFiles::TempPath("fm_swap_bench_a.bin"), TestModelFiles::TempPath("fm_swap_bench_b.bin")};
+    const std::string trans = TestModelFiles::TempPath("fm_swap_bench_trans.txt");
+    WriteSwapTrans(trans);
+    for (int idx = 0; idx < 2; idx++)
+    {
+        WriteSwapModel(text, idx + 1, VALUES);
+        ASSERT_TRUE(TDPredict::FMModelData::ConvertToBinary(FM_SWAP_FACTOR, text, binary[idx]));
+    }
+
+    std::mt19937 gen(7);
+    std::vector<std::shared_ptr<TDPredict::FeatureData>> vecFeature;
+    for (int idx = 0; idx < 4096; idx++)
+    {
+        vecFeature.emplace_back(CreateSwapFeature(gen, VALUES));
+    }
+
+    auto p99 = [](std::vector<double> &vecCost)
+    {
+        if (vecCost.empty())
+        {
+            return 0.0;
+        }
+        std::sort(vecCost.begin(), vecCost.end());
+        return vecCost[vecCost.size() * 99 / 100];
+    };
+
+    printf("warm_pages %10s %10s %12s %12s %10s %10s\n", "update ms", "publish us", "steady p99", "update p99", "post p99", "post max");
+    for (bool warm_pages : {true, false})
+    {
+        TDPredict::FMModel model("fm_swap");
+        TDPredict::FMSwapPolicy policy;
+        policy.warm_pages = warm_pages;
+        model.SetSwapPolicy(policy);
+        ASSERT_TRUE(model.Init(FM_SWAP_FACTOR, binary[0], trans));
+
+        // 预测线程记录 (开始时间, 耗时)
+        std::atomic<bool> stop = false;
+        std::vector<std::pair<long, double>> vecRecord;
+        vecRecord.reserve(1 << 22);
+        std::thread reader([&]()
+                           {
+            for (size_t idx = 0; !stop; idx++)
+            {
+                const auto begin = std::chrono::steady_clock::now();
+                PredictSwap(model, vecFeature[idx % vecFeature.size()]);
+                const auto end = std::chrono::steady_clock::now();
+                vecRecord.emplace_back(begin.time_since_epoch().count(),
+                                       std::chrono::duration<double, std::micro>(end - begin).count());
+            } });
+
+        // 更新区间 [开始, 发布完成]
+        std::vector<std::pair<long, long>> vecUpdate;
+        double publish_us = 0, update_ms = 0;
+        for (int times = 0; times < SWAPS; times++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            const long begin = std::chrono::steady_clock::now().time_since_epoch().count();
+            EXPECT_TRUE(model.Update(FM_SWAP_FACTOR, binary[(times + 1) % 2], trans));
+            const long end = std::chrono::steady_clock::now().time_since_epoch().count();
+            vecUpdate.emplace_back(begin, end);
+            const auto stats = model.GetSwapStats();
+            publish_us = std::max(publish_us, stats.publish_us);
+            update_ms += (stats.load_ms + stats.validate_ms + stats.warm_ms) / SWAPS;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        stop = true;
+        reader.join();
+
+        constexpr long POST_NS = 5 * 1000 * 1000;
+        std::vector<double> vecSteady, vecDuring, vecPost;
+        for (const auto &record : vecRecord)
+        {
+            int phase = 0;
+            for (const auto &update : vecUpdate)
+            {
+                if (record.first >= update.first && record.first < update.second)
+                {
+                    phase = 1;
+                }
+                else if (record.first >= update.second && record.first < update.second + POST_NS)
+                {
+                    phase = 2;
+                }
+            }
+            (phase == 0 ? vecSteady : phase == 1 ? vecDuring
+                                                 : vecPost)
+                .emplace_back(record.second);
+        }
+        const double post_p99 = p99(vecPost);
+        printf("%-10s %10.1f %10.1f %12.1f %12.1f %10.1f %10.1f\n", warm_pages ? "true" : "false",
+               update_ms, publish_us, p99(vecSteady), p99(vecDuring), post_p99, vecPost.empty() ? 0.0 : vecPost.back());
+    }
+
+    for (const auto &path : {text, binary[0], binary[1], trans})
+    {
+        std::filesystem::remove(path);
+    }
+}
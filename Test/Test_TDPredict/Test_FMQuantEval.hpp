@@ -0,0 +1,149 @@
+#pragma once
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include "gtest/gtest.h"
+#include "TDPredict/FMModel/FMQuantEval.h"
+#include "Test_TDPredict/TestModelFiles.hpp"
+
+TEST(FMQuantEvalTest, AUC)
+{
+    using TDPredict::FMQuantEval;
+    EXPECT_DOUBLE_EQ(1.0, FMQuantEval::AUC({0.1f, 0.2f, 0.8f, 0.9f}, {0, 0, 1, 1}));
+    EXPECT_DOUBLE_EQ(0.0, FMQuantEval::AUC({0.1f, 0.2f, 0.8f, 0.9f}, {1, 1, 0, 0}));
+    EXPECT_DOUBLE_EQ(0.75, FMQuantEval::AUC({0.1f, 0.4f, 0.35f, 0.8f}, {0, 0, 1, 1}));
+    EXPECT_DOUBLE_EQ(0.5, FMQuantEval::AUC({0.5f, 0.5f, 0.5f, 0.5f}, {0, 1, 0, 1})); // 分数相同取平均排名
+    EXPECT_DOUBLE_EQ(0.5, FMQuantEval::AUC({0.1f, 0.2f}, {1, 1}));
+}
+
+// 样本行与模型文件使用同一套 index 规则, 旧方案 [8位field][24位value] 转为 [32位field][32位value]
+TEST(FMQuantEvalTest, ParseSampleLine)
+{
+    std::vector<std::string_view> strVec;
+    TDPredict::FMSample sample;
+    int label = 0;
+    const long legacy = (3L << 24) | 7;
+    const std::string line = "1 " + std::to_string(legacy) + ":0.5 " + std::to_string(TestModelFiles::FMKey(2, 9));
+    ASSERT_TRUE(TDPredict::FMModelData::ParseSampleLine(line, strVec, label, sample));
+    EXPECT_EQ(1, label);
+    ASSERT_EQ(2u, sample.size());
+    EXPECT_EQ(TestModelFiles::FMKey(3, 7), sample[0].first);
+    EXPECT_FLOAT_EQ(0.5f, sample[0].second);
+    EXPECT_EQ(TestModelFiles::FMKey(2, 9), sample[1].first);
+    EXPECT_FLOAT_EQ(1.0f, sample[1].second);
+
+    TDPredict::score_type expect_score = 0;
+    EXPECT_TRUE(TDPredict::FMModelData::ParseSampleLine("0.25 " + std::to_string(legacy), strVec, expect_score, sample));
+    EXPECT_FLOAT_EQ(0.25f, expect_score);
+    EXPECT_FALSE(TDPredict::FMModelData::ParseSampleLine("1 " + std::to_string(TestModelFiles::FMKey(TDPredict::FIELD_MAX, 0)), strVec, label, sample));
+    EXPECT_FALSE(TDPredict::FMModelData::ParseSampleLine("1 12:x", strVec, label, sample));
+    EXPECT_FALSE(TDPredict::FMModelData::ParseSampleLine("x 12", strVec, label, sample));
+}
+
+// 样本打分只使用转换文件中的特征域, 每个域最多使用配置的特征个数, 与 FMModel 一致
+TEST(FMQuantEvalTest, ScoreFollowsTrans)
+{
+    constexpr int FACTOR = 4;
+    const std::string model_path = TestModelFiles::TempPath("fm_quant_trans_model.txt");
+    const std::string trans_path = TestModelFiles::TempPath("fm_quant_trans.txt");
+    const std::vector<long> vecKey = {TestModelFiles::FMKey(1, 0), TestModelFiles::FMKey(1, 1), TestModelFiles::FMKey(3, 0)};
+    TestModelFiles::WriteUniformFMModel(model_path, FACTOR, 0.1, vecKey);
+    TDPredict::FMModelData model_data;
+    ASSERT_TRUE(model_data.LoadModelFile(FACTOR, model_path));
+
+    const TDPredict::FMQuantEval::Sample sample = {{vecKey[0], 1.0f}, {vecKey[1], 0.5f}, {vecKey[2], 1.0f}};
+    const TDPredict::FMQuantEval::Sample first = {{vecKey[0], 1.0f}};
+
+    // 只取特征域 1 的第 1 个特征, 等同于只有该特征的样本
+    TDPredict::FMTransData trans_data;
+    TestModelFiles::WriteFMTrans(trans_path, 1, {1});
+    ASSERT_TRUE(trans_data.LoadTransFile(trans_path));
+    const TDPredict::score_type limited = TDPredict::FMQuantEval::Score(model_data, trans_data.field_trans, sample);
+    EXPECT_FLOAT_EQ(TDPredict::FMQuantEval::Score(model_data, trans_data.field_trans, first), limited);
+
+    // 放开个数并加入特征域 3 后分数改变
+    TestModelFiles::WriteFMTrans(trans_path, 4, {1, 3}, 2);
+    ASSERT_TRUE(trans_data.LoadTransFile(trans_path));
+    EXPECT_NE(limited, TDPredict::FMQuantEval::Score(model_data, trans_data.field_trans, sample));
+
+    std::filesystem::remove(model_path);
+    std::filesystem::remove(trans_path);
+}
+
+// 量化前后分数差与 AUC 变化
+//
+// 参考结果 (factor = 16, 10万特征, 2万样本, 每个样本 40 个特征, 转换文件每个样本取 32 个, 权重服从 N(0, 0.1)):
+// precision   mean_abs_delta   max_abs_delta   auc_fp32    auc_quant   row_bytes
+// fp16        3.52e-05         0.000241        0.718237    0.718236    128 -> 64
+// int8        0.0008           0.00565         0.718237    0.718247    128 -> 64
+TEST(FMQuantEvalTest, Evaluate)
+{
+    constexpr int FACTOR = 16;
+    constexpr int FEATURES = 100000;
+    constexpr int SAMPLES = 20000;
+    constexpr int SAMPLE_FEATURES = 40;
+    constexpr int TRANS_COUNT = 32;
+    const std::string model_path = TestModelFiles::TempPath("fm_quant_model.txt");
+    const std::string trans_path = TestModelFiles::TempPath("fm_quant_trans.txt");
+    const std::string sample_path = TestModelFiles::TempPath("fm_quant_sample.txt");
+
+    std::mt19937 gen(1);
+    std::normal_distribution<float> dist(0, 0.1);
+    std::vector<long> vecKey(FEATURES);
+    for (long idx = 0; idx < FEATURES; idx++)
+    {
+        vecKey[idx] = TestModelFiles::FMKey(1, idx);
+    }
+    TestModelFiles::WriteFMModel(model_path, FACTOR, -0.5, vecKey, [&]()
+                                 { return dist(gen); });
+
+    // 按 FP32 模型的预测概率生成标签
+    TestModelFiles::WriteFMTrans(trans_path, TRANS_COUNT, {1}, TRANS_COUNT);
+    TDPredict::FMModelData model_data;
+    ASSERT_TRUE(model_data.LoadModelFile(FACTOR, model_path));
+    TDPredict::FMTransData trans_data;
+    ASSERT_TRUE(trans_data.LoadTransFile(trans_path));
+    std::uniform_real_distribution<float> uniform(0, 1);
+    FILE *pFile = fopen(sample_path.c_str(), "w");
+    for (int idx = 0; idx < SAMPLES; idx++)
+    {
+        TDPredict::FMQuantEval::Sample sample;
+        std::string line;
+        for (int feature = 0; feature < SAMPLE_FEATURES; feature++)
+        {
+            const long index = (1L << 32) | (gen() % FEATURES);
+            const float weight = feature % 4 == 0 ? uniform(gen) : 1.0f;
+            sample.emplace_back(index, weight);
+            line.append(" ").append(std::to_string(index));
+            if (weight != 1.0f)
+            {
+                line.append(":").append(std::to_string(weight));
+            }
+        }
+        const int label = uniform(gen) < TDPredict::FMQuantEval::Score(model_data, trans_data.field_trans, sample) ? 1 : 0;
+        fprintf(pFile, "%d%s\n", label, line.c_str());
+    }
+    fclose(pFile);
+
+    for (auto precision : {TDPredict::FMPrecision::FP16, TDPredict::FMPrecision::INT8})
+    {
+        TDPredict::FMQuantReport report;
+        ASSERT_TRUE(TDPredict::FMQuantEval::Evaluate(FACTOR, model_path, trans_path, sample_path, precision, report));
+        printf("%s: %s\n", precision == TDPredict::FMPrecision::FP16 ? "fp16" : "int8",
+               TDPredict::FMQuantEval::ToString(report).c_str());
+        EXPECT_EQ((size_t)SAMPLES, report.samples);
+        EXPECT_GT(report.auc_fp32, 0.6);
+        EXPECT_LT(std::fabs(report.auc_quant - report.auc_fp32), 0.005);
+        EXPECT_LT(report.mean_abs_delta, 0.01);
+    }
+
+    TDPredict::FMQuantReport report;
+    EXPECT_FALSE(TDPredict::FMQuantEval::Evaluate(FACTOR, model_path, trans_path, sample_path + ".none", TDPredict::FMPrecision::INT8, report));
+    EXPECT_FALSE(TDPredict::FMQuantEval::Evaluate(FACTOR, model_path, trans_path + ".none", sample_path, TDPredict::FMPrecision::INT8, report));
+
+    std::filesystem::remove(model_path);
+    std::filesystem::remove(trans_path);
+    std::filesystem::remove(sample_path);
+}
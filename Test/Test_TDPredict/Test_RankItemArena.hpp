@@ -0,0 +1,168 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <vector>
+#include "gtest/gtest.h"
+#include "Common/Arena.h"
+#include "Interface/ModelInterface.h"
+
+// 统计分配次数的内存资源
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+    long count() const { return m_count.load(); }
+
+private:
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        m_count++;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override
+    {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    std::atomic<long> m_count = 0;
+};
+
+// 模拟一次排序请求: 构造 item_count 个 RankItem, 写入参数/分数/FM辅助向量后排序
+// RankItem 使用当前线程的内存资源
+static void ReplayRankRequest(const int item_count)
+{
+    std::vector<TDPredict::RankItem> vec_rank_item;
+    vec_rank_item.reserve(item_count);
+    for (int idx = 0; idx < item_count; idx++)
+    {
+        TDPredict::RankItem item;
+        item.setParam("item_id", (long)idx);
+        item.setParam("author_id", (long)idx * 7);
+        item.setParam("ctr", 0.01 * idx);
+        item.setParam("source", std::string("recall"));
+        item.setRankScore(TDPredict::RankType::PreRank, idx * 0.1f);
+        item.setRankScore(TDPredict::RankType::Rank, idx * 0.2f);
+        item.setModelScore("fm_v1", idx * 0.3f);
+        item.sup_vec_sum.assign(16, 0.0f);
+        item.sup_vec_sum_sqr.assign(16, 0.0f);
+        vec_rank_item.emplace_back(std::move(item));
+    }
+
+    for (auto &item : vec_rank_item)
+    {
+        item.cmp_score = item.getModelScore("fm_v1");
+    }
+    std::sort(vec_rank_item.begin(), vec_rank_item.end(),
+              [](const TDPredict::RankItem &a, const TDPredict::RankItem &b)
+              { return a.cmp_score > b.cmp_score; });
+}
+
+// ArenaScope 内默认构造的 RankItem 从当前内存池分配
+TEST(RankItemArenaTest, Scope)
+{
+    Common::MonotonicArena arena;
+    Common::ArenaScope scope(&arena);
+
+    TDPredict::RankItem item;
+    EXPECT_EQ(arena.resource(), item.long_params.get_allocator().resource());
+
+    // 同一内存池内移动直接接管
+    TDPredict::RankItem moved(std::move(item));
+    EXPECT_EQ(arena.resource(), moved.long_params.get_allocator().resource());
+}
+
+// 移出 ArenaScope 的 RankItem 拷贝到当前内存资源, 内存池释放后仍然有效
+TEST(RankItemArenaTest, MoveOutOfScope)
+{
+    std::optional<TDPredict::RankItem> escaped;
+    TDPredict::RankItem assigned;
+    {
+        Common::MonotonicArena arena;
+        std::optional<TDPredict::RankItem> inner[2];
+        {
+            Common::ArenaScope scope(&arena);
+            for (auto &item : inner)
+            {
+                item.emplace();
+                item->setParam("item_id", 7L);
+                item->setParam("source", std::string("recall"));
+                item->setModelScore("fm_v1", 0.5f);
+                item->sup_vec_sum.assign(16, 1.0f);
+            }
+        }
+        escaped.emplace(std::move(*inner[0]));
+        assigned = std::move(*inner[1]);
+    }
+
+    for (auto *item : {&*escaped, &assigned})
+    {
+        EXPECT_EQ(std::pmr::new_delete_resource(), item->long_params.get_allocator().resource());
+        EXPECT_EQ(std::pmr::new_delete_resource(), item->sup_vec_sum.get_allocator().resource());
+        long item_id = 0;
+        std::string source;
+        EXPECT_TRUE(item->getParam("item_id", item_id));
+        EXPECT_TRUE(item->getParam("source", source));
+        EXPECT_EQ(7, item_id);
+        EXPECT_EQ("recall", source);
+        EXPECT_FLOAT_EQ(0.5f, item->getModelScore("fm_v1"));
+        EXPECT_EQ(std::vector<TDPredict::score_type>(16, 1.0f), std::vector<TDPredict::score_type>(item->sup_vec_sum.begin(), item->sup_vec_sum.end()));
+    }
+}
+
+// 回放排序请求, 对比分配次数与耗时分位数
+//
+// 单核虚拟机参考结果 (300 items/request, 五次运行的范围):
+// new/delete  allocs/request 4200  p50 0.370 ~ 0.606ms  p99 0.525 ~ 1.545ms
+// arena       allocs/request 2     p50 0.211 ~ 0.259ms  p99 0.293 ~ 3.000ms
+TEST(RankItemArenaTest, DISABLED_ReplayBenchmark)
+{
+    constexpr int REQUESTS = 1000;
+    constexpr int ITEMS = 300;
+
+    auto percentile = [](std::vector<double> &costs, double p)
+    {
+        std::sort(costs.begin(), costs.end());
+        return costs[std::min(costs.size() - 1, size_t(costs.size() * p))];
+    };
+
+    // 不使用内存池: RankItem 容器的每次分配都直接走 new/delete, 通过 pmr 默认内存资源计数
+    CountingResource heap_counter;
+    std::vector<double> heap_costs;
+    auto default_resource = std::pmr::set_default_resource(&heap_counter);
+    for (int i = 0; i < REQUESTS; i++)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        ReplayRankRequest(ITEMS);
+        heap_costs.emplace_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count());
+    }
+    std::pmr::set_default_resource(default_resource);
+
+    // 使用请求内存池: 每个请求一个 MonotonicArena, 只在 arena 扩容时向上游申请
+    CountingResource arena_counter;
+    std::vector<double> arena_costs;
+    for (int i = 0; i < REQUESTS; i++)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        {
+            Common::MonotonicArena arena(256 * 1024, &arena_counter);
+            Common::ArenaScope scope(&arena);
+            ReplayRankRequest(ITEMS);
+        }
+        arena_costs.emplace_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count());
+    }
+
+    double heap_allocs = double(heap_counter.count()) / REQUESTS;
+    double arena_allocs = double(arena_counter.count()) / REQUESTS;
+    printf("new/delete  allocs/request %.0f  p50 %.3fms  p99 %.3fms\n",
+           heap_allocs, percentile(heap_costs, 0.5), percentile(heap_costs, 0.99));
+    printf("arena       allocs/request %.0f  p50 %.3fms  p99 %.3fms\n",
+           arena_allocs, percentile(arena_costs, 0.5), percentile(arena_costs, 0.99));
+    EXPECT_LT(arena_allocs * 10, heap_allocs);
+}